@@ -9,6 +9,12 @@ INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include
 LINKER_FLAGS := -g -shared -lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
 DEFINES := -D_DEBUG -DKEXPORT
 
+# Allocation tracing adds work to every allocation, so is opt-in: make ... KMEMORY_TRACE=1
+# The engine and everything built against it must agree.
+ifeq ($(KMEMORY_TRACE),1)
+DEFINES += -DKMEMORY_TRACE_ENABLED=1
+endif
+
 # Make does not offer a recursive wildcard function, so here's one:
 #rwildcard=$(wildcard $1$2) $(foreach d,$(wildcard $1*),$(call rwildcard,$d/,$2))
 
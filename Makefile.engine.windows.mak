@@ -9,6 +9,12 @@ INCLUDE_FLAGS := -Iengine\src -I$(VULKAN_SDK)\include
 LINKER_FLAGS := -g -shared -luser32 -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine
 DEFINES := -D_DEBUG -DKEXPORT -D_CRT_SECURE_NO_WARNINGS
 
+# Allocation tracing adds work to every allocation, so is opt-in: make ... KMEMORY_TRACE=1
+# The engine and everything built against it must agree.
+ifeq ($(KMEMORY_TRACE),1)
+DEFINES += -DKMEMORY_TRACE_ENABLED=1
+endif
+
 # Make does not offer a recursive wildcard function, so here's one:
 rwildcard=$(wildcard $1$2) $(foreach d,$(wildcard $1*),$(call rwildcard,$d/,$2))
 
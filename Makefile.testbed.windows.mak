@@ -9,6 +9,12 @@ INCLUDE_FLAGS := -Iengine\src -Itestbed\src
 LINKER_FLAGS := -g -lengine.lib -L$(OBJ_DIR)\engine -L$(BUILD_DIR) #-Wl,-rpath,.
 DEFINES := -D_DEBUG -DKIMPORT
 
+# Allocation tracing adds work to every allocation, so is opt-in: make ... KMEMORY_TRACE=1
+# The engine and everything built against it must agree.
+ifeq ($(KMEMORY_TRACE),1)
+DEFINES += -DKMEMORY_TRACE_ENABLED=1
+endif
+
 # Make does not offer a recursive wildcard function, so here's one:
 rwildcard=$(wildcard $1$2) $(foreach d,$(wildcard $1*),$(call rwildcard,$d/,$2))
 
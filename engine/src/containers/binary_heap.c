@@ -0,0 +1,358 @@
+#include "binary_heap.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Takes a block from the given allocator, or from the global allocator if there is none.
+static void* allocate_block(darray_allocator* allocator, u64 size) {
+    return allocator ? allocator->allocate(allocator->state, size) : kallocate(size, MEMORY_TAG_ARRAY);
+}
+
+static void free_block(darray_allocator* allocator, void* block, u64 size) {
+    if (!allocator) {
+        kfree(block, size, MEMORY_TAG_ARRAY);
+    } else if (allocator->free) {
+        allocator->free(allocator->state, block, size);
+    }
+}
+
+/**
+ * Both sifts lift the element being placed into temp, then move elements into the hole
+ * it leaves until the hole reaches the element's place, so each level costs one copy
+ * rather than the three a swap would.
+ */
+static void heap_sift_up(binary_heap* heap, u32 index) {
+    u8* elements = heap->elements;
+    u64 stride = heap->stride;
+    kcopy_memory(heap->temp, elements + stride * index, stride);
+    while (index > 0) {
+        u32 parent = (index - 1) / 2;
+        if (!heap->less(heap->temp, elements + stride * parent, heap->user_data)) {
+            break;
+        }
+        kcopy_memory(elements + stride * index, elements + stride * parent, stride);
+        index = parent;
+    }
+    kcopy_memory(elements + stride * index, heap->temp, stride);
+}
+
+static void heap_sift_down(binary_heap* heap, u32 index, u32 length) {
+    u8* elements = heap->elements;
+    u64 stride = heap->stride;
+    kcopy_memory(heap->temp, elements + stride * index, stride);
+    while (true) {
+        u32 child = index * 2 + 1;
+        if (child >= length) {
+            break;
+        }
+        if (child + 1 < length && heap->less(elements + stride * (child + 1), elements + stride * child, heap->user_data)) {
+            child++;
+        }
+        if (!heap->less(elements + stride * child, heap->temp, heap->user_data)) {
+            break;
+        }
+        kcopy_memory(elements + stride * index, elements + stride * child, stride);
+        index = child;
+    }
+    kcopy_memory(elements + stride * index, heap->temp, stride);
+}
+
+b8 binary_heap_create(u64 stride, u32 capacity, pfn_heap_less less, void* user_data, darray_allocator* allocator, binary_heap* out_heap) {
+    if (!out_heap) {
+        KERROR("binary_heap_create requires a valid pointer to hold the heap.");
+        return false;
+    }
+    if (!stride || !less) {
+        KERROR("binary_heap_create requires a non-zero stride and a comparison function.");
+        return false;
+    }
+
+    kzero_memory(out_heap, sizeof(binary_heap));
+    out_heap->elements = _darray_create_with_allocator(capacity ? capacity : DARRAY_DEFAULT_CAPACITY, stride, allocator);
+    out_heap->temp = allocate_block(allocator, stride);
+    if (!out_heap->elements || !out_heap->temp) {
+        KERROR("binary_heap_create failed to allocate memory for the heap.");
+        return false;
+    }
+    out_heap->stride = stride;
+    out_heap->less = less;
+    out_heap->user_data = user_data;
+    return true;
+}
+
+void binary_heap_destroy(binary_heap* heap) {
+    if (heap) {
+        if (heap->elements) {
+            darray_allocator* allocator = (darray_allocator*)_darray_field_get(heap->elements, DARRAY_ALLOCATOR);
+            if (heap->temp) {
+                free_block(allocator, heap->temp, heap->stride);
+            }
+            darray_destroy(heap->elements);
+        }
+        kzero_memory(heap, sizeof(binary_heap));
+    }
+}
+
+b8 binary_heap_push(binary_heap* heap, const void* value) {
+    if (!heap || !heap->elements || !value) {
+        KERROR("binary_heap_push requires a valid heap and value.");
+        return false;
+    }
+
+    u64 length = darray_length(heap->elements);
+    heap->elements = _darray_push(heap->elements, value);
+    if (darray_length(heap->elements) == length) {
+        return false;
+    }
+    heap_sift_up(heap, (u32)length);
+    return true;
+}
+
+b8 binary_heap_pop(binary_heap* heap, void* out_value) {
+    if (!heap || !heap->elements) {
+        KERROR("binary_heap_pop requires a valid heap.");
+        return false;
+    }
+
+    u32 length = (u32)darray_length(heap->elements);
+    if (!length) {
+        return false;
+    }
+
+    u8* elements = heap->elements;
+    if (out_value) {
+        kcopy_memory(out_value, elements, heap->stride);
+    }
+    // Move the last element to the front, then sift it down to its place.
+    u32 last = length - 1;
+    darray_length_set(heap->elements, last);
+    if (last > 0) {
+        kcopy_memory(elements, elements + heap->stride * last, heap->stride);
+        heap_sift_down(heap, 0, last);
+    }
+    return true;
+}
+
+const void* binary_heap_peek(const binary_heap* heap) {
+    if (!heap || !heap->elements || !darray_length(heap->elements)) {
+        return 0;
+    }
+    return heap->elements;
+}
+
+b8 binary_heap_heapify(binary_heap* heap, const void* values, u32 count) {
+    if (!heap || !heap->elements || (count && !values)) {
+        KERROR("binary_heap_heapify requires a valid heap and values.");
+        return false;
+    }
+
+    u64 length = darray_length(heap->elements);
+    heap->elements = _darray_push_range(heap->elements, values, count);
+    if (darray_length(heap->elements) != length + count) {
+        return false;
+    }
+
+    // Sift down every element which has children, from the last up to the root. Most
+    // elements are near the bottom and move only a level or two, so this is O(n).
+    length += count;
+    for (u32 i = (u32)(length / 2); i > 0; --i) {
+        heap_sift_down(heap, i - 1, (u32)length);
+    }
+    return true;
+}
+
+void binary_heap_clear(binary_heap* heap) {
+    if (heap && heap->elements) {
+        darray_clear(heap->elements);
+    }
+}
+
+u32 binary_heap_length(const binary_heap* heap) {
+    return heap && heap->elements ? (u32)darray_length(heap->elements) : 0;
+}
+
+// The block contains the ids, then the positions, then the values.
+static u64 indexed_values_offset(u32 id_count) {
+    return get_aligned(sizeof(u32) * 2 * id_count, sizeof(u64));
+}
+
+static u64 indexed_block_size(u64 stride, u32 id_count) {
+    return indexed_values_offset(id_count) + stride * id_count;
+}
+
+KINLINE const void* indexed_value(const indexed_heap* heap, u32 id) {
+    return heap->values + heap->stride * id;
+}
+
+// Only ids move as the heap is reordered, so these work like the binary_heap sifts on u32s.
+static void indexed_sift_up(indexed_heap* heap, u32 position) {
+    u32 id = heap->ids[position];
+    const void* value = indexed_value(heap, id);
+    while (position > 0) {
+        u32 parent = (position - 1) / 2;
+        u32 parent_id = heap->ids[parent];
+        if (!heap->less(value, indexed_value(heap, parent_id), heap->user_data)) {
+            break;
+        }
+        heap->ids[position] = parent_id;
+        heap->positions[parent_id] = position;
+        position = parent;
+    }
+    heap->ids[position] = id;
+    heap->positions[id] = position;
+}
+
+static void indexed_sift_down(indexed_heap* heap, u32 position) {
+    u32 id = heap->ids[position];
+    const void* value = indexed_value(heap, id);
+    while (true) {
+        u32 child = position * 2 + 1;
+        if (child >= heap->length) {
+            break;
+        }
+        if (child + 1 < heap->length && heap->less(indexed_value(heap, heap->ids[child + 1]), indexed_value(heap, heap->ids[child]), heap->user_data)) {
+            child++;
+        }
+        u32 child_id = heap->ids[child];
+        if (!heap->less(indexed_value(heap, child_id), value, heap->user_data)) {
+            break;
+        }
+        heap->ids[position] = child_id;
+        heap->positions[child_id] = position;
+        position = child;
+    }
+    heap->ids[position] = id;
+    heap->positions[id] = position;
+}
+
+// Moves the id at the given position to wherever its element now belongs.
+static void indexed_sift(indexed_heap* heap, u32 position) {
+    u32 id = heap->ids[position];
+    indexed_sift_up(heap, position);
+    if (heap->positions[id] == position) {
+        indexed_sift_down(heap, position);
+    }
+}
+
+b8 indexed_heap_create(u64 stride, u32 id_count, pfn_heap_less less, void* user_data, darray_allocator* allocator, indexed_heap* out_heap) {
+    if (!out_heap) {
+        KERROR("indexed_heap_create requires a valid pointer to hold the heap.");
+        return false;
+    }
+    if (!stride || !id_count || !less) {
+        KERROR("indexed_heap_create requires a non-zero stride and id_count, and a comparison function.");
+        return false;
+    }
+
+    kzero_memory(out_heap, sizeof(indexed_heap));
+    u8* block = allocate_block(allocator, indexed_block_size(stride, id_count));
+    if (!block) {
+        KERROR("indexed_heap_create failed to allocate memory for the heap.");
+        return false;
+    }
+    out_heap->stride = stride;
+    out_heap->less = less;
+    out_heap->user_data = user_data;
+    out_heap->allocator = allocator;
+    out_heap->id_count = id_count;
+    out_heap->ids = (u32*)block;
+    out_heap->positions = out_heap->ids + id_count;
+    out_heap->values = block + indexed_values_offset(id_count);
+    kset_memory(out_heap->positions, 0xFF, sizeof(u32) * id_count);
+    return true;
+}
+
+void indexed_heap_destroy(indexed_heap* heap) {
+    if (heap) {
+        if (heap->ids) {
+            free_block(heap->allocator, heap->ids, indexed_block_size(heap->stride, heap->id_count));
+        }
+        kzero_memory(heap, sizeof(indexed_heap));
+    }
+}
+
+b8 indexed_heap_set(indexed_heap* heap, u32 id, const void* value) {
+    if (!heap || !heap->ids || !value) {
+        KERROR("indexed_heap_set requires a valid heap and value.");
+        return false;
+    }
+    if (id >= heap->id_count) {
+        KERROR("indexed_heap_set - id %u is out of range (id_count is %u).", id, heap->id_count);
+        return false;
+    }
+
+    kcopy_memory(heap->values + heap->stride * id, value, heap->stride);
+    u32 position = heap->positions[id];
+    if (position == INVALID_ID) {
+        position = heap->length++;
+        heap->ids[position] = id;
+        heap->positions[id] = position;
+        indexed_sift_up(heap, position);
+    } else {
+        indexed_sift(heap, position);
+    }
+    return true;
+}
+
+b8 indexed_heap_remove(indexed_heap* heap, u32 id) {
+    if (!heap || !heap->ids || id >= heap->id_count) {
+        return false;
+    }
+
+    u32 position = heap->positions[id];
+    if (position == INVALID_ID) {
+        return false;
+    }
+    heap->positions[id] = INVALID_ID;
+
+    // Move the last id into the hole, then to wherever it belongs from there.
+    u32 last = --heap->length;
+    if (position != last) {
+        heap->ids[position] = heap->ids[last];
+        heap->positions[heap->ids[position]] = position;
+        indexed_sift(heap, position);
+    }
+    return true;
+}
+
+b8 indexed_heap_pop(indexed_heap* heap, u32* out_id, void* out_value) {
+    if (!heap || !heap->ids) {
+        KERROR("indexed_heap_pop requires a valid heap.");
+        return false;
+    }
+    if (!heap->length) {
+        return false;
+    }
+
+    u32 id = heap->ids[0];
+    if (out_id) {
+        *out_id = id;
+    }
+    if (out_value) {
+        kcopy_memory(out_value, indexed_value(heap, id), heap->stride);
+    }
+    indexed_heap_remove(heap, id);
+    return true;
+}
+
+u32 indexed_heap_peek(const indexed_heap* heap) {
+    return heap && heap->length ? heap->ids[0] : INVALID_ID;
+}
+
+const void* indexed_heap_get(const indexed_heap* heap, u32 id) {
+    return indexed_heap_contains(heap, id) ? indexed_value(heap, id) : 0;
+}
+
+b8 indexed_heap_contains(const indexed_heap* heap, u32 id) {
+    return heap && heap->ids && id < heap->id_count && heap->positions[id] != INVALID_ID;
+}
+
+void indexed_heap_clear(indexed_heap* heap) {
+    if (heap && heap->ids) {
+        for (u32 i = 0; i < heap->length; ++i) {
+            heap->positions[heap->ids[i]] = INVALID_ID;
+        }
+        heap->length = 0;
+    }
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "defines.h"
+
+struct darray_allocator;
+
+/**
+ * @brief Orders the elements of a heap. Returns true if a should come out of the heap
+ * before b, i.e. for a min-heap of floats, *(f32*)a < *(f32*)b.
+ *
+ * @param a A pointer to the first element.
+ * @param b A pointer to the second element.
+ * @param user_data The user data given when the heap was created.
+ */
+typedef b8 (*pfn_heap_less)(const void* a, const void* b, void* user_data);
+
+/**
+ * @brief A priority queue of fixed-size elements, held as a binary heap in a darray.
+ * The element which is "least" by the heap's comparator is always at the front, and is
+ * the next to be popped. Pushing and popping are O(log n); building a heap from many
+ * elements at once with binary_heap_heapify is O(n).
+ *
+ * Elements of equal priority come out in no particular order. Members should not be
+ * modified outside the functions below.
+ */
+typedef struct binary_heap {
+    /** @brief The size of each element in bytes. */
+    u64 stride;
+    /** @brief Orders the elements. */
+    pfn_heap_less less;
+    /** @brief Passed to less. */
+    void* user_data;
+    /** @brief A darray of the elements, in heap order. */
+    void* elements;
+    /** @brief Room for one element, held while others are moved around it. */
+    void* temp;
+} binary_heap;
+
+/**
+ * @brief Creates a new heap.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The number of elements to make room for up front. The heap grows beyond this as needed.
+ * @param less The function which orders elements. Required.
+ * @param user_data Passed to less. Optional.
+ * @param allocator The allocator for the heap's darray, i.e. a frame allocator, or 0 to use the global allocator. Must outlive the heap.
+ * @param out_heap A pointer to hold the newly created heap.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 binary_heap_create(u64 stride, u32 capacity, pfn_heap_less less, void* user_data, struct darray_allocator* allocator, binary_heap* out_heap);
+
+/**
+ * @brief Destroys the given heap, freeing its memory.
+ *
+ * @param heap A pointer to the heap to be destroyed.
+ */
+KAPI void binary_heap_destroy(binary_heap* heap);
+
+/**
+ * @brief Adds a copy of the given element to the heap.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param value A pointer to the element to be copied. Required.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 binary_heap_push(binary_heap* heap, const void* value);
+
+/**
+ * @brief Removes the element at the front of the heap.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param out_value A pointer to hold the removed element. Optional.
+ * @return True on success; false if the heap is empty.
+ */
+KAPI b8 binary_heap_pop(binary_heap* heap, void* out_value);
+
+/**
+ * @brief Obtains the element at the front of the heap without removing it.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @return A pointer to the element, valid until the heap is next changed; or 0 if the heap is empty.
+ */
+KAPI const void* binary_heap_peek(const binary_heap* heap);
+
+/**
+ * @brief Adds copies of many elements at once, then restores the heap order in a single
+ * pass. Faster than pushing them one at a time when count is large next to the length.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param values A pointer to an array of count elements to be copied.
+ * @param count The number of elements.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 binary_heap_heapify(binary_heap* heap, const void* values, u32 count);
+
+/**
+ * @brief Removes all elements from the heap, keeping its memory.
+ *
+ * @param heap A pointer to the heap to be cleared.
+ */
+KAPI void binary_heap_clear(binary_heap* heap);
+
+/**
+ * @brief Obtains the number of elements in the heap.
+ *
+ * @param heap A pointer to the heap.
+ * @return The number of elements.
+ */
+KAPI u32 binary_heap_length(const binary_heap* heap);
+
+/**
+ * @brief A priority queue of elements identified by ids in [0, id_count), such as pool
+ * or slot indices. Unlike binary_heap, the element for an id may be changed while it is
+ * queued (i.e. to raise an asset's priority as it comes into view), or removed outright,
+ * both in O(log n).
+ *
+ * Elements are stored by id and only their ids are moved as the heap is reordered, so
+ * large elements cost no more to queue than small ones. Members should not be modified
+ * outside the functions below.
+ */
+typedef struct indexed_heap {
+    /** @brief The size of each element in bytes. */
+    u64 stride;
+    /** @brief Orders the elements. */
+    pfn_heap_less less;
+    /** @brief Passed to less. */
+    void* user_data;
+    /** @brief The allocator the block came from, or 0 if from the global allocator. */
+    struct darray_allocator* allocator;
+    /** @brief The number of ids, each of which may be queued once. */
+    u32 id_count;
+    /** @brief The number of ids queued. */
+    u32 length;
+    /** @brief The queued ids, in heap order. Also the start of the internally allocated block. */
+    u32* ids;
+    /** @brief For each id, its position in ids if queued; otherwise INVALID_ID. */
+    u32* positions;
+    /** @brief For each id, its element. */
+    u8* values;
+} indexed_heap;
+
+/**
+ * @brief Creates a new indexed heap.
+ *
+ * @param stride The size of each element in bytes.
+ * @param id_count The number of ids, which range from 0 to id_count - 1.
+ * @param less The function which orders elements. Required.
+ * @param user_data Passed to less. Optional.
+ * @param allocator The allocator for the heap's memory, i.e. a frame allocator, or 0 to use the global allocator. Must outlive the heap.
+ * @param out_heap A pointer to hold the newly created heap.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 indexed_heap_create(u64 stride, u32 id_count, pfn_heap_less less, void* user_data, struct darray_allocator* allocator, indexed_heap* out_heap);
+
+/**
+ * @brief Destroys the given heap, freeing its memory.
+ *
+ * @param heap A pointer to the heap to be destroyed.
+ */
+KAPI void indexed_heap_destroy(indexed_heap* heap);
+
+/**
+ * @brief Queues the given id with a copy of the given element, or if the id is already
+ * queued, replaces its element and moves it to its new place in the heap.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param id The id to be queued.
+ * @param value A pointer to the element to be copied. Required.
+ * @return True on success; otherwise false (i.e. the id is out of range).
+ */
+KAPI b8 indexed_heap_set(indexed_heap* heap, u32 id, const void* value);
+
+/**
+ * @brief Removes the given id from the heap, if it is queued.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param id The id to be removed.
+ * @return True if the id was queued; otherwise false.
+ */
+KAPI b8 indexed_heap_remove(indexed_heap* heap, u32 id);
+
+/**
+ * @brief Removes the id at the front of the heap.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param out_id A pointer to hold the removed id. Optional.
+ * @param out_value A pointer to hold the element of the removed id. Optional.
+ * @return True on success; false if the heap is empty.
+ */
+KAPI b8 indexed_heap_pop(indexed_heap* heap, u32* out_id, void* out_value);
+
+/**
+ * @brief Obtains the id at the front of the heap without removing it.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @return The id at the front of the heap; or INVALID_ID if the heap is empty.
+ */
+KAPI u32 indexed_heap_peek(const indexed_heap* heap);
+
+/**
+ * @brief Obtains the element of the given id, if it is queued.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param id The id of the element.
+ * @return A pointer to the element, which must not be modified other than through indexed_heap_set; or 0 if the id is not queued.
+ */
+KAPI const void* indexed_heap_get(const indexed_heap* heap, u32 id);
+
+/**
+ * @brief Indicates whether the given id is queued.
+ *
+ * @param heap A pointer to the heap. Required.
+ * @param id The id to be checked.
+ * @return True if the id is queued; otherwise false.
+ */
+KAPI b8 indexed_heap_contains(const indexed_heap* heap, u32 id);
+
+/**
+ * @brief Removes all ids from the heap.
+ *
+ * @param heap A pointer to the heap to be cleared.
+ */
+KAPI void indexed_heap_clear(indexed_heap* heap);
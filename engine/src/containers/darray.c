@@ -2,23 +2,105 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "memory/linear_allocator.h"
+#include "memory/scratch_allocator.h"
+
+#define DARRAY_HEADER_SIZE (DARRAY_FIELD_LENGTH * sizeof(u64))
+
+KINLINE u64* header_get(void* array) {
+    return (u64*)array - DARRAY_FIELD_LENGTH;
+}
+
+static void* linear_allocate(void* state, u64 size) {
+    return linear_allocator_allocate_aligned(state, size, 16);
+}
+
+static void* scratch_allocate(void* state, u64 size) {
+    return scratch_allocator_allocate(size, 16);
+}
+
+darray_allocator darray_allocator_linear(struct linear_allocator* allocator) {
+    darray_allocator a = {linear_allocate, 0, allocator};
+    return a;
+}
+
+darray_allocator darray_allocator_scratch() {
+    darray_allocator a = {scratch_allocate, 0, 0};
+    return a;
+}
+
+// Obtains a block for an array with the given header values, with its elements left uninitialized.
+static void* allocate_array(u64 capacity, u64 stride, darray_allocator* allocator) {
+    u64 size = DARRAY_HEADER_SIZE + capacity * stride;
+    u64* header;
+    if (allocator) {
+        header = allocator->allocate(allocator->state, size);
+        if (!header) {
+            KERROR("darray - Failed to allocate %llu bytes from the array's allocator.", size);
+            return 0;
+        }
+    } else {
+        header = kallocate_with_flags(size, 1, MEMORY_TAG_DARRAY, KALLOCATE_FLAG_UNINITIALIZED);
+    }
+    header[DARRAY_CAPACITY] = capacity;
+    header[DARRAY_LENGTH] = 0;
+    header[DARRAY_STRIDE] = stride;
+    header[DARRAY_ALLOCATOR] = (u64)allocator;
+    return header + DARRAY_FIELD_LENGTH;
+}
+
+/**
+ * Moves the array to a new block with room for at least min_capacity elements. Returns 0,
+ * leaving the array untouched, if the block could not be allocated.
+ */
+static void* grow(void* array, u64 min_capacity, b8 zero_new_elements) {
+    u64* header = header_get(array);
+    u64 length = header[DARRAY_LENGTH];
+    u64 stride = header[DARRAY_STRIDE];
+    u64 capacity = header[DARRAY_CAPACITY] * DARRAY_RESIZE_FACTOR;
+    if (capacity < min_capacity) {
+        capacity = min_capacity;
+    }
+    if (capacity < DARRAY_MIN_GROWN_CAPACITY) {
+        capacity = DARRAY_MIN_GROWN_CAPACITY;
+    }
+
+    void* temp = allocate_array(capacity, stride, (darray_allocator*)header[DARRAY_ALLOCATOR]);
+    if (!temp) {
+        return 0;
+    }
+    // The existing elements are copied over, so only the space after them needs zeroing.
+    kcopy_memory(temp, array, length * stride);
+    if (zero_new_elements) {
+        kzero_memory((u8*)temp + length * stride, (capacity - length) * stride);
+    }
+    header_get(temp)[DARRAY_LENGTH] = length;
+
+    _darray_destroy(array);
+    return temp;
+}
 
 void* _darray_create(u64 length, u64 stride) {
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 array_size = length * stride;
-    u64* new_array = kallocate(header_size + array_size, MEMORY_TAG_DARRAY);
-    kset_memory(new_array, 0, header_size + array_size);
-    new_array[DARRAY_CAPACITY] = length;
-    new_array[DARRAY_LENGTH] = 0;
-    new_array[DARRAY_STRIDE] = stride;
-    return (void*)(new_array + DARRAY_FIELD_LENGTH);
+    return _darray_create_with_allocator(length, stride, 0);
+}
+
+void* _darray_create_with_allocator(u64 length, u64 stride, darray_allocator* allocator) {
+    void* array = allocate_array(length, stride, allocator);
+    if (array) {
+        kzero_memory(array, length * stride);
+    }
+    return array;
 }
 
 void _darray_destroy(void* array) {
-    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 total_size = header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
-    kfree(header, total_size, MEMORY_TAG_DARRAY);
+    u64* header = header_get(array);
+    u64 total_size = DARRAY_HEADER_SIZE + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
+    darray_allocator* allocator = (darray_allocator*)header[DARRAY_ALLOCATOR];
+    if (!allocator) {
+        kfree(header, total_size, MEMORY_TAG_DARRAY);
+    } else if (allocator->free) {
+        allocator->free(allocator->state, header, total_size);
+    }
 }
 
 u64 _darray_field_get(void* array, u64 field) {
@@ -32,32 +114,86 @@ void _darray_field_set(void* array, u64 field, u64 value) {
 }
 
 void* _darray_resize(void* array) {
-    u64 length = darray_length(array);
-    u64 stride = darray_stride(array);
-    void* temp = _darray_create(
-        (DARRAY_RESIZE_FACTOR * darray_capacity(array)),
-        stride);
-    kcopy_memory(temp, array, length * stride);
-
-    _darray_field_set(temp, DARRAY_LENGTH, length);
-    _darray_destroy(array);
-    return temp;
+    void* temp = grow(array, 0, true);
+    return temp ? temp : array;
 }
 
 void* _darray_push(void* array, const void* value_ptr) {
-    u64 length = darray_length(array);
-    u64 stride = darray_stride(array);
-    if (length >= darray_capacity(array)) {
-        array = _darray_resize(array);
+    u64* header = header_get(array);
+    if (header[DARRAY_LENGTH] >= header[DARRAY_CAPACITY]) {
+        void* temp = grow(array, header[DARRAY_LENGTH] + 1, true);
+        if (!temp) {
+            return array;
+        }
+        array = temp;
+        header = header_get(array);
     }
 
-    u64 addr = (u64)array;
-    addr += (length * stride);
-    kcopy_memory((void*)addr, value_ptr, stride);
-    _darray_field_set(array, DARRAY_LENGTH, length + 1);
+    u64 stride = header[DARRAY_STRIDE];
+    kcopy_memory((u8*)array + header[DARRAY_LENGTH] * stride, value_ptr, stride);
+    header[DARRAY_LENGTH]++;
+    return array;
+}
+
+void* _darray_push_range(void* array, const void* values_ptr, u64 count) {
+    u64* header = header_get(array);
+    if (header[DARRAY_LENGTH] + count > header[DARRAY_CAPACITY]) {
+        void* temp = grow(array, header[DARRAY_LENGTH] + count, true);
+        if (!temp) {
+            return array;
+        }
+        array = temp;
+        header = header_get(array);
+    }
+
+    u64 stride = header[DARRAY_STRIDE];
+    kcopy_memory((u8*)array + header[DARRAY_LENGTH] * stride, values_ptr, count * stride);
+    header[DARRAY_LENGTH] += count;
+    return array;
+}
+
+void* _darray_reserve_more(void* array, u64 count) {
+    u64* header = header_get(array);
+    if (header[DARRAY_LENGTH] + count > header[DARRAY_CAPACITY]) {
+        void* temp = grow(array, header[DARRAY_LENGTH] + count, true);
+        return temp ? temp : array;
+    }
+    return array;
+}
+
+void* _darray_resize_uninit(void* array, u64 length) {
+    u64* header = header_get(array);
+    if (length > header[DARRAY_CAPACITY]) {
+        void* temp = grow(array, length, false);
+        if (!temp) {
+            return array;
+        }
+        array = temp;
+        header = header_get(array);
+    }
+    header[DARRAY_LENGTH] = length;
     return array;
 }
 
+void* _darray_shrink_to_fit(void* array) {
+    u64* header = header_get(array);
+    u64 length = header[DARRAY_LENGTH];
+    darray_allocator* allocator = (darray_allocator*)header[DARRAY_ALLOCATOR];
+    // Memory can't be given back to allocators which don't free, so shrinking would only waste more.
+    if (length == header[DARRAY_CAPACITY] || (allocator && !allocator->free)) {
+        return array;
+    }
+
+    void* temp = allocate_array(length, header[DARRAY_STRIDE], allocator);
+    if (!temp) {
+        return array;
+    }
+    kcopy_memory(temp, array, length * header[DARRAY_STRIDE]);
+    header_get(temp)[DARRAY_LENGTH] = length;
+    _darray_destroy(array);
+    return temp;
+}
+
 void _darray_pop(void* array, void* dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
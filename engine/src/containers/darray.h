@@ -7,6 +7,7 @@ Memory layout
 u64 capacity = number elements that can be held
 u64 length = number of elements currently contained
 u64 stride = size of each element in bytes
+u64 allocator = the darray_allocator the array came from, or 0 if from kallocate
 void* elements
 */
 
@@ -14,10 +15,43 @@ enum {
     DARRAY_CAPACITY,
     DARRAY_LENGTH,
     DARRAY_STRIDE,
+    DARRAY_ALLOCATOR,
     DARRAY_FIELD_LENGTH
 };
 
+struct linear_allocator;
+
+/**
+ * @brief Supplies the memory for darrays which should not come from the global allocator,
+ * such as those only needed for a frame or a single load. Must outlive any darray using it.
+ */
+typedef struct darray_allocator {
+    /** @brief Allocates a block of the given size. Returns 0 on failure. Required. */
+    void* (*allocate)(void* state, u64 size);
+    /**
+     * @brief Frees a block obtained from allocate. If 0, blocks are only reclaimed by the
+     * allocator itself (i.e. at the end of a frame or scratch scope), and darrays using
+     * it are never shrunk.
+     */
+    void (*free)(void* state, void* block, u64 size);
+    /** @brief Passed to the functions above, i.e. a linear_allocator. */
+    void* state;
+} darray_allocator;
+
+/**
+ * @brief Obtains a darray_allocator which takes blocks from the given linear allocator,
+ * such as the frame allocator. Blocks are reclaimed when the linear allocator is reset.
+ */
+KAPI darray_allocator darray_allocator_linear(struct linear_allocator* allocator);
+
+/**
+ * @brief Obtains a darray_allocator which takes blocks from the calling thread's scratch
+ * stack. Darrays using it must only be used within the current scratch scope.
+ */
+KAPI darray_allocator darray_allocator_scratch();
+
 KAPI void* _darray_create(u64 length, u64 stride);
+KAPI void* _darray_create_with_allocator(u64 length, u64 stride, darray_allocator* allocator);
 KAPI void _darray_destroy(void* array);
 
 KAPI u64 _darray_field_get(void* array, u64 field);
@@ -31,8 +65,15 @@ KAPI void _darray_pop(void* array, void* dest);
 KAPI void* _darray_pop_at(void* array, u64 index, void* dest);
 KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 
+KAPI void* _darray_push_range(void* array, const void* values_ptr, u64 count);
+KAPI void* _darray_reserve_more(void* array, u64 count);
+KAPI void* _darray_resize_uninit(void* array, u64 length);
+KAPI void* _darray_shrink_to_fit(void* array);
+
 #define DARRAY_DEFAULT_CAPACITY 1
 #define DARRAY_RESIZE_FACTOR 2
+// The smallest capacity an array grows to, so that small arrays skip the first few doublings.
+#define DARRAY_MIN_GROWN_CAPACITY 8
 
 #define darray_create(type) \
     _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type))
@@ -40,6 +81,10 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 #define darray_reserve(type, capacity) \
     _darray_create(capacity, sizeof(type))
 
+/** @brief Creates a darray whose memory comes from the given darray_allocator. */
+#define darray_create_with_allocator(type, capacity, allocator) \
+    _darray_create_with_allocator(capacity, sizeof(type), allocator)
+
 #define darray_destroy(array) _darray_destroy(array);
 
 #define darray_push(array, value)           \
@@ -54,6 +99,33 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 #define darray_pop(array, value_ptr) \
     _darray_pop(array, value_ptr)
 
+/** @brief Appends count elements copied from values_ptr, growing the array at most once. */
+#define darray_push_range(array, values_ptr, count)           \
+    {                                                         \
+        array = _darray_push_range(array, values_ptr, count); \
+    }
+
+/** @brief Makes room for at least count more elements, so that pushing them will not reallocate. */
+#define darray_reserve_more(array, count)           \
+    {                                               \
+        array = _darray_reserve_more(array, count); \
+    }
+
+/**
+ * @brief Sets the length of the array, growing it if needed. Elements added are left
+ * uninitialized, for the caller to fill in directly.
+ */
+#define darray_resize_uninit(array, length)           \
+    {                                                 \
+        array = _darray_resize_uninit(array, length); \
+    }
+
+/** @brief Reduces the capacity of the array to its length, releasing the rest of its memory. */
+#define darray_shrink_to_fit(array)           \
+    {                                         \
+        array = _darray_shrink_to_fit(array); \
+    }
+
 #define darray_insert_at(array, index, value)           \
     {                                                   \
         typeof(value) temp = value;                     \
@@ -77,4 +149,57 @@ KAPI void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 
 #define darray_length_set(array, value) \
     _darray_field_set(array, DARRAY_LENGTH, value)
-    
\ No newline at end of file
+    
+/**
+ * @brief Generates functions specialized for darrays of the given type, which must be a
+ * single identifier (use a typedef for pointers). Elements are moved with typed loads and
+ * stores of a known size rather than copies of a runtime stride, so the compiler can inline
+ * them. The arrays are ordinary darrays, so may be used with any other darray function.
+ *
+ * For example, DARRAY_DEFINE(vertex_3d) provides:
+ *  vertex_3d* darray_vertex_3d_create(u64 capacity);
+ *  vertex_3d* darray_vertex_3d_push(vertex_3d* array, vertex_3d value);
+ *  vertex_3d* darray_vertex_3d_push_range(vertex_3d* array, const vertex_3d* values, u64 count);
+ *  vertex_3d darray_vertex_3d_pop(vertex_3d* array);
+ *  u64 darray_vertex_3d_length(vertex_3d* array);
+ * Like _darray_push, the functions which may grow the array return its new address.
+ */
+#define DARRAY_DEFINE(type)                                                                  \
+    KINLINE type* darray_##type##_create(u64 capacity) {                                     \
+        return (type*)_darray_create(capacity, sizeof(type));                                \
+    }                                                                                        \
+    KINLINE u64 darray_##type##_length(type* array) {                                        \
+        return ((u64*)array - DARRAY_FIELD_LENGTH)[DARRAY_LENGTH];                           \
+    }                                                                                        \
+    KINLINE type* darray_##type##_push(type* array, type value) {                            \
+        u64* header = (u64*)array - DARRAY_FIELD_LENGTH;                                     \
+        if (header[DARRAY_LENGTH] >= header[DARRAY_CAPACITY]) {                              \
+            array = (type*)_darray_reserve_more(array, 1);                                   \
+            header = (u64*)array - DARRAY_FIELD_LENGTH;                                      \
+            if (header[DARRAY_LENGTH] >= header[DARRAY_CAPACITY]) {                          \
+                return array;                                                                \
+            }                                                                                \
+        }                                                                                    \
+        array[header[DARRAY_LENGTH]++] = value;                                              \
+        return array;                                                                        \
+    }                                                                                        \
+    KINLINE type* darray_##type##_push_range(type* array, const type* values, u64 count) {   \
+        u64* header = (u64*)array - DARRAY_FIELD_LENGTH;                                     \
+        if (header[DARRAY_LENGTH] + count > header[DARRAY_CAPACITY]) {                       \
+            array = (type*)_darray_reserve_more(array, count);                               \
+            header = (u64*)array - DARRAY_FIELD_LENGTH;                                      \
+            if (header[DARRAY_LENGTH] + count > header[DARRAY_CAPACITY]) {                   \
+                return array;                                                                \
+            }                                                                                \
+        }                                                                                    \
+        type* dest = array + header[DARRAY_LENGTH];                                          \
+        for (u64 i = 0; i < count; ++i) {                                                    \
+            dest[i] = values[i];                                                             \
+        }                                                                                    \
+        header[DARRAY_LENGTH] += count;                                                      \
+        return array;                                                                        \
+    }                                                                                        \
+    KINLINE type darray_##type##_pop(type* array) {                                          \
+        u64* header = (u64*)array - DARRAY_FIELD_LENGTH;                                     \
+        return array[--header[DARRAY_LENGTH]];                                               \
+    }
@@ -2,24 +2,259 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "math/kmath.h"
+
+/*
+ * The freelist is a two-level segregated fit (TLSF) allocator. Free ranges are
+ * binned by size: the first level splits sizes by power of two, and the second
+ * level splits each power of two into SL_INDEX_COUNT linear steps. A bitmap per
+ * level allows the smallest suitable non-empty bin to be found in constant time.
+ *
+ * Since the managed range may not be addressable (i.e. GPU memory), no headers are
+ * stored within it. Instead, each free range is described by a node held in the
+ * list's own memory, and two hash tables map the start and end offsets of every
+ * free range to its node. These allow the neighbours of a range being freed to be
+ * found, and coalesced with, in constant time. Room for the tables is reserved for the
+ * most nodes the list could ever use, but only a prefix sized to the nodes actually in
+ * use is touched, and it doubles as needed. Memory reserved from the OS is committed on
+ * first touch, so the tables only cost memory in proportion to the number of free ranges.
+ */
+
+#define SL_INDEX_COUNT_LOG2 4
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+// Sizes below SL_INDEX_COUNT all land in the first level. Every other first level
+// covers a single power of two, up to 2^63.
+#define FL_INDEX_COUNT (64 - SL_INDEX_COUNT_LOG2 + 1)
+
+// The number of slots each table starts out using.
+#define MIN_TABLE_CAPACITY 64
+
+// The most ranges checked in a bin which may hold ranges too small for a request.
+#define MAX_BIN_SCAN 8
 
 typedef struct freelist_node {
     u64 offset;
     u64 size;
-    struct freelist_node* next;
+    // Links within the node's bin. Unused nodes link through next.
+    u32 prev;
+    u32 next;
 } freelist_node;
 
 typedef struct internal_state {
     u64 total_size;
     u64 max_entries;
-    freelist_node* head;
+    u64 free_space;
+
+    u64 fl_bitmap;
+    u32 sl_bitmap[FL_INDEX_COUNT];
+    // The head node index of each bin, or INVALID_ID if empty.
+    u32 bins[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+    // Recycled nodes. Nodes beyond node_bump_index have never been used.
+    u32 node_free_head;
+    u32 node_bump_index;
+    // The number of nodes currently describing free ranges.
+    u32 node_count;
     freelist_node* nodes;
+
+    // Hash tables of node index + 1 (0 marks an empty slot), keyed by the
+    // start and end offsets of each free range respectively. Only the first
+    // table_capacity slots of each are in use, out of table_max_capacity reserved.
+    u64 table_capacity;
+    u64 table_max_capacity;
+    u32 table_shift;
+    u32* start_table;
+    u32* end_table;
 } internal_state;
 
-freelist_node* get_node(freelist* list);
-void return_node(freelist* list, freelist_node* node);
+static void mapping_insert(u64 size, u32* out_fl, u32* out_sl) {
+    if (size < SL_INDEX_COUNT) {
+        *out_fl = 0;
+        *out_sl = (u32)size;
+    } else {
+        u32 msb = highest_bit_index_u64(size);
+        *out_sl = (u32)(size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *out_fl = msb - (SL_INDEX_COUNT_LOG2 - 1);
+    }
+}
 
-void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+static void mapping_search(u64 size, u32* out_fl, u32* out_sl) {
+    // Round up to the next bin boundary, so that any range found in the resulting
+    // bin is guaranteed to fit.
+    if (size >= SL_INDEX_COUNT) {
+        u64 round = (1ULL << (highest_bit_index_u64(size) - SL_INDEX_COUNT_LOG2)) - 1;
+        if (size + round > size) {
+            size += round;
+        }
+    }
+    mapping_insert(size, out_fl, out_sl);
+}
+
+static u64 table_slot(internal_state* state, u64 key) {
+    // Fibonacci hashing.
+    return (key * 11400714819323198485ULL) >> state->table_shift;
+}
+
+static u64 node_key(internal_state* state, u32 index, b8 is_end) {
+    freelist_node* node = &state->nodes[index];
+    return is_end ? node->offset + node->size : node->offset;
+}
+
+static u32 table_get(internal_state* state, u32* table, u64 key, b8 is_end) {
+    u64 mask = state->table_capacity - 1;
+    for (u64 i = table_slot(state, key); table[i]; i = (i + 1) & mask) {
+        if (node_key(state, table[i] - 1, is_end) == key) {
+            return table[i] - 1;
+        }
+    }
+    return INVALID_ID;
+}
+
+static void table_insert(internal_state* state, u32* table, u32 index, b8 is_end) {
+    u64 mask = state->table_capacity - 1;
+    u64 i = table_slot(state, node_key(state, index, is_end));
+    while (table[i]) {
+        i = (i + 1) & mask;
+    }
+    table[i] = index + 1;
+}
+
+// NOTE: Must be called before the node's offset or size is changed.
+static void table_remove(internal_state* state, u32* table, u32 index, b8 is_end) {
+    u64 mask = state->table_capacity - 1;
+    u64 i = table_slot(state, node_key(state, index, is_end));
+    while (table[i] != index + 1) {
+        i = (i + 1) & mask;
+    }
+    table[i] = 0;
+
+    // Shift following entries of the same cluster back so no lookup chain is broken.
+    u64 j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (!table[j]) {
+            break;
+        }
+        u64 home = table_slot(state, node_key(state, table[j] - 1, is_end));
+        // The entry can fill the gap if its home slot is not cyclically within (i, j].
+        b8 stays = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            table[i] = table[j];
+            table[j] = 0;
+            i = j;
+        }
+    }
+}
+
+static u32 get_node(internal_state* state) {
+    if (state->node_free_head != INVALID_ID) {
+        u32 index = state->node_free_head;
+        state->node_free_head = state->nodes[index].next;
+        state->node_count++;
+        return index;
+    }
+    if (state->node_bump_index < state->max_entries) {
+        state->node_count++;
+        return state->node_bump_index++;
+    }
+
+    // Return nothing if no nodes are available.
+    return INVALID_ID;
+}
+
+static void return_node(internal_state* state, u32 index) {
+    freelist_node* node = &state->nodes[index];
+    node->offset = INVALID_ID;
+    node->size = INVALID_ID;
+    node->prev = INVALID_ID;
+    node->next = state->node_free_head;
+    state->node_free_head = index;
+    state->node_count--;
+}
+
+// Starts using the given number of slots of each table, emptying them.
+static void tables_reset(internal_state* state, u64 capacity) {
+    state->table_capacity = capacity;
+    state->table_shift = 64 - highest_bit_index_u64(capacity);
+    kzero_memory(state->start_table, sizeof(u32) * capacity);
+    kzero_memory(state->end_table, sizeof(u32) * capacity);
+}
+
+// Doubles the slots in use by the tables if they are getting too full for the nodes in use,
+// re-inserting every range. The node being added must not have been binned yet.
+static void tables_reserve(internal_state* state) {
+    // Keep the tables no more than 2/3 full, as get_table_capacity does for the maximum.
+    if ((u64)state->node_count * 3 <= state->table_capacity * 2 || state->table_capacity == state->table_max_capacity) {
+        return;
+    }
+    tables_reset(state, state->table_capacity * 2);
+    for (u32 fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+        for (u32 sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+            for (u32 i = state->bins[fl][sl]; i != INVALID_ID; i = state->nodes[i].next) {
+                table_insert(state, state->start_table, i, false);
+                table_insert(state, state->end_table, i, true);
+            }
+        }
+    }
+}
+
+static void bin_insert(internal_state* state, u32 index) {
+    freelist_node* node = &state->nodes[index];
+    u32 fl, sl;
+    mapping_insert(node->size, &fl, &sl);
+
+    u32 head = state->bins[fl][sl];
+    node->prev = INVALID_ID;
+    node->next = head;
+    if (head != INVALID_ID) {
+        state->nodes[head].prev = index;
+    }
+    state->bins[fl][sl] = index;
+    state->fl_bitmap |= (1ULL << fl);
+    state->sl_bitmap[fl] |= (1U << sl);
+}
+
+static void bin_remove(internal_state* state, u32 index) {
+    freelist_node* node = &state->nodes[index];
+    u32 fl, sl;
+    mapping_insert(node->size, &fl, &sl);
+
+    if (node->prev != INVALID_ID) {
+        state->nodes[node->prev].next = node->next;
+    } else {
+        state->bins[fl][sl] = node->next;
+        if (node->next == INVALID_ID) {
+            // The bin is now empty.
+            state->sl_bitmap[fl] &= ~(1U << sl);
+            if (!state->sl_bitmap[fl]) {
+                state->fl_bitmap &= ~(1ULL << fl);
+            }
+        }
+    }
+    if (node->next != INVALID_ID) {
+        state->nodes[node->next].prev = node->prev;
+    }
+    node->prev = node->next = INVALID_ID;
+}
+
+// Adds a new free range which is known not to touch any other free range.
+static b8 insert_range(internal_state* state, u64 offset, u64 size) {
+    u32 index = get_node(state);
+    if (index == INVALID_ID) {
+        KERROR("Freelist has run out of nodes to track free ranges. Range at offset %llu (%lluB) is lost.", offset, size);
+        return false;
+    }
+    tables_reserve(state);
+    freelist_node* node = &state->nodes[index];
+    node->offset = offset;
+    node->size = size;
+    table_insert(state, state->start_table, index, false);
+    table_insert(state, state->end_table, index, true);
+    bin_insert(state, index);
+    return true;
+}
+
+static u64 get_max_entries(u64 total_size) {
     // Enough space to hold state, plus array for all nodes.
     u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node)));  // NOTE: This might have a remainder, but that's ok.
 
@@ -28,14 +263,72 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
     if (max_entries < 20) {
         max_entries = 20;
     }
+    // Node indices are 32-bit.
+    if (max_entries >= INVALID_ID) {
+        max_entries = INVALID_ID - 1;
+    }
+    return max_entries;
+}
+
+static u64 get_table_capacity(u64 max_entries) {
+    // Keep the tables no more than ~2/3 full even if every node is in use.
+    u64 capacity = 1;
+    while (capacity < max_entries + (max_entries / 2)) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+static u64 get_memory_requirement(u64 max_entries, u64 table_capacity) {
+    return sizeof(internal_state) + (sizeof(freelist_node) * max_entries) + (sizeof(u32) * table_capacity * 2);
+}
+
+// Sets up an empty list (with no free space) in the given memory. The tables must be
+// zeroed; if the memory is not known to be zero already, the slots first used are cleared
+// here, and more as they come into use. The node array is never read before being
+// written, so it is left as-is either way.
+static internal_state* state_setup(void* memory, u64 total_size, b8 memory_zeroed) {
+    u64 max_entries = get_max_entries(total_size);
+    u64 table_max_capacity = get_table_capacity(max_entries);
+    kzero_memory(memory, sizeof(internal_state));
+
+    // The block's layout is state first, then the array of nodes, then the two tables.
+    internal_state* state = memory;
+    state->total_size = total_size;
+    state->max_entries = max_entries;
+    state->free_space = 0;
+    state->nodes = (void*)((u8*)memory + sizeof(internal_state));
+    state->table_max_capacity = table_max_capacity;
+    state->start_table = (void*)((u8*)state->nodes + sizeof(freelist_node) * max_entries);
+    state->end_table = state->start_table + table_max_capacity;
+    u64 table_capacity = table_max_capacity < MIN_TABLE_CAPACITY ? table_max_capacity : MIN_TABLE_CAPACITY;
+    if (memory_zeroed) {
+        state->table_capacity = table_capacity;
+        state->table_shift = 64 - highest_bit_index_u64(table_capacity);
+    } else {
+        tables_reset(state, table_capacity);
+    }
+    state->node_free_head = INVALID_ID;
+    state->node_bump_index = 0;
+    state->node_count = 0;
+    for (u32 fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+        for (u32 sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+            state->bins[fl][sl] = INVALID_ID;
+        }
+    }
+    return state;
+}
 
-    *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+static void create(u64 total_size, u64* memory_requirement, void* memory, b8 memory_zeroed, freelist* out_list) {
+    u64 max_entries = get_max_entries(total_size);
+    *memory_requirement = get_memory_requirement(max_entries, get_table_capacity(max_entries));
     if (!memory) {
         return;
     }
 
     // If the memory required is too small, should warn about it being wasteful to use.
-    u64 mem_min = (sizeof(internal_state) + sizeof(freelist_node)) * 8;
+    // NOTE: The bin tables alone make the state a few KiB, so compare against that.
+    u64 mem_min = sizeof(internal_state);
     if (total_size < mem_min) {
         KWARN(
             "Freelists are very inefficient with amounts of memory less than %iB; it is recommended to not use this structure in this case.",
@@ -43,151 +336,147 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
     }
 
     out_list->memory = memory;
+    internal_state* state = state_setup(memory, total_size, memory_zeroed);
+    if (total_size) {
+        insert_range(state, 0, total_size);
+        state->free_space = total_size;
+    }
+}
 
-    // The block's layout is head* first, then array of available nodes.
-    kzero_memory(out_list->memory, *memory_requirement);
-    internal_state* state = out_list->memory;
-    state->nodes = (void*)(out_list->memory + sizeof(internal_state));
-    state->max_entries = max_entries;
-    state->total_size = total_size;
-
-    state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = total_size;
-    state->head->next = 0;
+void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+    create(total_size, memory_requirement, memory, false, out_list);
+}
 
-    // Invalidate the offset and size for all but the first node. The invalid
-    // value will be checked for when seeking a new node from the list.
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
-    }
+void freelist_create_zeroed(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+    create(total_size, memory_requirement, memory, true, out_list);
 }
 
 void freelist_destroy(freelist* list) {
     if (list && list->memory) {
-        // Just zero out the memory before giving it back.
-        internal_state* state = list->memory;
-        kzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        // Just zero out the state before giving it back. The rest is left alone, so
+        // that pages never used are not committed just to be cleared.
+        kzero_memory(list->memory, sizeof(internal_state));
         list->memory = 0;
     }
 }
 
-b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
-    if (!list || !out_offset || !list->memory) {
+static b8 allocate_block(freelist* list, u64 size, u64* out_offset, b8 warn_on_failure) {
+    if (!list || !out_offset || !list->memory || !size) {
         return false;
     }
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = 0;
-    while (node) {
-        if (node->size == size) {
-            // Exact match. Just return the node.
-            *out_offset = node->offset;
-            freelist_node* node_to_return = 0;
-            if (previous) {
-                previous->next = node->next;
-                node_to_return = node;
-            } else {
-                // This node is the head of the list. Reassign the head
-                // and return the previous head node.
-                node_to_return = state->head;
-                state->head = node->next;
+
+    // Find the smallest non-empty bin guaranteed to fit the size.
+    u32 index = INVALID_ID;
+    u32 fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl < FL_INDEX_COUNT) {
+        u32 sl_map = state->sl_bitmap[fl] & (~0U << sl);
+        if (!sl_map) {
+            u64 fl_map = (fl + 1 < 64) ? state->fl_bitmap & (~0ULL << (fl + 1)) : 0;
+            if (fl_map) {
+                fl = count_trailing_zeros_u64(fl_map);
+                sl_map = state->sl_bitmap[fl];
+            }
+        }
+        if (sl_map) {
+            index = state->bins[fl][count_trailing_zeros_u32(sl_map)];
+        }
+    }
+
+    if (index == INVALID_ID) {
+        // Rounding up may have skipped over ranges in the size's own bin which still fit,
+        // such as a range of exactly the requested size. Check the first few of those before
+        // giving up, which keeps allocation constant time at the cost of possibly failing
+        // while a fitting range sits deeper in the bin. Such a range is at most 1/16 larger
+        // than the request, so this only matters when nearly all free space is in that bin.
+        mapping_insert(size, &fl, &sl);
+        u32 scanned = 0;
+        for (u32 i = state->bins[fl][sl]; i != INVALID_ID && scanned < MAX_BIN_SCAN; i = state->nodes[i].next, ++scanned) {
+            if (state->nodes[i].size >= size) {
+                index = i;
+                break;
             }
-            return_node(list, node_to_return);
-            return true;
-        } else if (node->size > size) {
-            // Node is larger. Deduct the memory from it and move the offset
-            // by that amount.
-            *out_offset = node->offset;
-            node->size -= size;
-            node->offset += size;
-            return true;
         }
+    }
+
+    if (index == INVALID_ID) {
+        if (warn_on_failure) {
+            KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, state->free_space);
+        }
+        return false;
+    }
 
-        previous = node;
-        node = node->next;
+    freelist_node* node = &state->nodes[index];
+    *out_offset = node->offset;
+    bin_remove(state, index);
+    if (node->size == size) {
+        // Exact match. The whole range is used.
+        table_remove(state, state->start_table, index, false);
+        table_remove(state, state->end_table, index, true);
+        return_node(state, index);
+    } else {
+        // Range is larger. Deduct the memory from the front of it. The end is unchanged.
+        table_remove(state, state->start_table, index, false);
+        node->offset += size;
+        node->size -= size;
+        table_insert(state, state->start_table, index, false);
+        bin_insert(state, index);
     }
+    state->free_space -= size;
+    return true;
+}
 
-    u64 free_space = freelist_free_space(list);
-    KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, free_space);
-    return false;
+b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
+    return allocate_block(list, size, out_offset, true);
+}
+
+b8 freelist_try_allocate_block(freelist* list, u64 size, u64* out_offset) {
+    return allocate_block(list, size, out_offset, false);
 }
 
 b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
-     if (!list || !list->memory || !size) {
+    if (!list || !list->memory || !size) {
         return false;
     }
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = 0;
-
-    if (!node) {
-        // Check for the case where the entire thing is allocated.
-        // In this case a new node is needed at the head.
-        freelist_node* new_node = get_node(list);
-        new_node->offset = offset;
-        new_node->size = size;
-        new_node->next = 0;
-        state->head = new_node;
-        return true;
-    } else {
-        while (node) {
-            if (node->offset == offset) {
-                // Can just be appended to this node.
-                node->size += size;
-
-                // Check if this then connects the range between this and the next
-                // node, and if so, combine them and return the second node..
-                if (node->next && node->next->offset == node->offset + node->size) {
-                    node->size += node->next->size;
-                    freelist_node* next = node->next;
-                    node->next = node->next->next;
-                    return_node(list, next);
-                }
-                return true;
-            } else if (node->offset > offset) {
-                // Iterated beyond the space to be freed. Need a new node.
-                freelist_node* new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-
-                // If there is a previous node, the new node should be inserted between this and it.
-                if (previous) {
-                    previous->next = new_node;
-                    new_node->next = node;
-                } else {
-                    // Otherwise, the new node becomes the head.
-                    new_node->next = node;
-                    state->head = new_node;
-                }
-
-                // Double-check next node to see if it can be joined.
-                if (new_node->next && new_node->offset + new_node->size == new_node->next->offset) {
-                    new_node->size += new_node->next->size;
-                    freelist_node* rubbish = new_node->next;
-                    new_node->next = rubbish->next;
-                    return_node(list, rubbish);
-                }
-
-                // Double-check previous node to see if the new_node can be joined to it.
-                if (previous && previous->offset + previous->size == new_node->offset) {
-                    previous->size += new_node->size;
-                    freelist_node* rubbish = new_node;
-                    previous->next = rubbish->next;
-                    return_node(list, rubbish);
-                }
-
-                return true;
-            }
+    if (offset + size > state->total_size || table_get(state, state->start_table, offset, false) != INVALID_ID) {
+        KWARN("Unable to find block to be freed. Corruption possible?");
+        return false;
+    }
 
-            previous = node;
-            node = node->next;
+    // Free ranges ending where this one starts, and starting where this one ends.
+    u32 previous = table_get(state, state->end_table, offset, true);
+    u32 next = table_get(state, state->start_table, offset + size, false);
+
+    if (previous != INVALID_ID) {
+        // Extend the previous range over this one, and the next range as well if there is one.
+        bin_remove(state, previous);
+        table_remove(state, state->end_table, previous, true);
+        state->nodes[previous].size += size;
+        if (next != INVALID_ID) {
+            bin_remove(state, next);
+            table_remove(state, state->start_table, next, false);
+            table_remove(state, state->end_table, next, true);
+            state->nodes[previous].size += state->nodes[next].size;
+            return_node(state, next);
         }
+        table_insert(state, state->end_table, previous, true);
+        bin_insert(state, previous);
+    } else if (next != INVALID_ID) {
+        // Extend the next range backward over this one.
+        bin_remove(state, next);
+        table_remove(state, state->start_table, next, false);
+        state->nodes[next].offset = offset;
+        state->nodes[next].size += size;
+        table_insert(state, state->start_table, next, false);
+        bin_insert(state, next);
+    } else if (!insert_range(state, offset, size)) {
+        return false;
     }
 
-    KWARN("Unable to find block to be freed. Corruption possible?");
-    return false;
+    state->free_space += size;
+    return true;
 }
 
 b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory) {
@@ -195,91 +484,33 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
         return false;
     }
 
-    // Enough space to hold state, plus array for all nodes.
-    u64 max_entries = (new_size / sizeof(void*));  // NOTE: This might have a remainder, but that's ok.
-
-    // Catch an edge case of having a really small amount of memory to manage, and only having a
-    // super small number of entries. Always make sure we have at least a decent amount, like 20 or so.
-    if (max_entries < 20) {
-        max_entries = 20;
-    }
-    
-    *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+    u64 max_entries = get_max_entries(new_size);
+    *memory_requirement = get_memory_requirement(max_entries, get_table_capacity(max_entries));
     if (!new_memory) {
         return true;
     }
 
     // Assign the old memory pointer so it can be freed.
     *out_old_memory = list->memory;
-
-    // Copy over the old state to the new.
     internal_state* old_state = (internal_state*)list->memory;
-    u64 size_diff = new_size - old_state->total_size;
 
-    // Setup the new memory
+    // Setup the new state, then carry over every free range of the old one.
     list->memory = new_memory;
-
-    // The block's layout is head* first, then array of available nodes.
-    kzero_memory(list->memory, *memory_requirement);
-
-    // Setup the new state.
-    internal_state* state = (internal_state*)list->memory;
-    state->nodes = (void*)(list->memory + sizeof(internal_state));
-    state->max_entries = max_entries;
-    state->total_size = new_size;
-
-    // Invalidate the offset and size for all but the first node. The invalid
-    // value will be checked for when seeking a new node from the list.
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
-    }
-
-    state->head = &state->nodes[0];
-
-    // Copy over the nodes.
-    freelist_node* new_list_node = state->head;
-    freelist_node* old_node = old_state->head;
-    if (!old_node) {
-        // If there is no head, then the entire list is allocated. In this case,
-        // the head should be set to the difference of the space now available, and
-        // at the end of the list.
-        state->head->offset = old_state->total_size;
-        state->head->size = size_diff;
-        state->head->next = 0;
-    } else {
-        // Iterate the old nodes.
-        while (old_node) {
-            // Get a new node, copy the offset/size, and set next to it.
-            freelist_node* new_node = get_node(list);
-            new_node->offset = old_node->offset;
-            new_node->size = old_node->size;
-            new_node->next = 0;
-            new_list_node->next = new_node;
-            // Move to the next entry.
-            new_list_node = new_list_node->next;
-
-            if (old_node->next) {
-                // If there is another node, move on.
-                old_node = old_node->next;
-            } else {
-                // Reached the end of the list.
-                // Check if it extends to the end of the block. If so,
-                // just append to the size. Otherwise, create a new node and
-                // attach to it.
-                if (old_node->offset + old_node->size == old_state->total_size) {
-                    new_node->size += size_diff;
-                } else {
-                    freelist_node* new_node_end = get_node(list);
-                    new_node_end->offset = old_state->total_size;
-                    new_node_end->size = size_diff;
-                    new_node_end->next = 0;
-                    new_node->next = new_node_end;
-                }
-                break;
+    internal_state* state = state_setup(new_memory, new_size, false);
+    for (u32 fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+        for (u32 sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+            for (u32 i = old_state->bins[fl][sl]; i != INVALID_ID; i = old_state->nodes[i].next) {
+                insert_range(state, old_state->nodes[i].offset, old_state->nodes[i].size);
             }
         }
     }
+    state->free_space = old_state->free_space;
+
+    // The new space at the end joins whatever range may be at the end of the old space.
+    u64 size_diff = new_size - old_state->total_size;
+    if (size_diff) {
+        freelist_free_block(list, size_diff, old_state->total_size);
+    }
 
     return true;
 }
@@ -289,18 +520,14 @@ void freelist_clear(freelist* list) {
         return;
     }
 
+    // Reset to a single range occupying the entire thing.
     internal_state* state = list->memory;
-    // Invalidate the offset and size for all but the first node. The invalid
-    // value will be checked for when seeking a new node from the list.
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        state->nodes[i].offset = INVALID_ID;
-        state->nodes[i].size = INVALID_ID;
+    u64 total_size = state->total_size;
+    state = state_setup(list->memory, total_size, false);
+    if (total_size) {
+        insert_range(state, 0, total_size);
+        state->free_space = total_size;
     }
-
-    // Reset the head to occupy the entire thing.
-    state->head->offset = 0;
-    state->head->size = state->total_size;
-    state->head->next = 0;
 }
 
 u64 freelist_free_space(freelist* list) {
@@ -308,31 +535,27 @@ u64 freelist_free_space(freelist* list) {
         return 0;
     }
 
-    u64 running_total = 0;
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    while (node) {
-        running_total += node->size;
-        node = node->next;
-    }
-
-    return running_total;
+    return state->free_space;
 }
 
-freelist_node* get_node(freelist* list) {
+u64 freelist_largest_free_block(freelist* list) {
+    if (!list || !list->memory) {
+        return 0;
+    }
+
+    // The largest range is in the highest non-empty bin, though not necessarily first in it.
     internal_state* state = list->memory;
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        if (state->nodes[i].offset == INVALID_ID) {
-            return &state->nodes[i];
+    if (!state->fl_bitmap) {
+        return 0;
+    }
+    u32 fl = highest_bit_index_u64(state->fl_bitmap);
+    u32 sl = highest_bit_index_u64(state->sl_bitmap[fl]);
+    u64 largest = 0;
+    for (u32 i = state->bins[fl][sl]; i != INVALID_ID; i = state->nodes[i].next) {
+        if (state->nodes[i].size > largest) {
+            largest = state->nodes[i].size;
         }
     }
-
-    // Return nothing if no nodes are available.
-    return 0;
+    return largest;
 }
-
-void return_node(freelist* list, freelist_node* node) {
-    node->offset = INVALID_ID;
-    node->size = INVALID_ID;
-    node->next = 0;
-}
\ No newline at end of file
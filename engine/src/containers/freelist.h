@@ -4,7 +4,10 @@
 
 /**
  * @brief A data structure to be used alongside an allocator for dynamic memory
- * allocation. Tracks free ranges of memory.
+ * allocation. Tracks free ranges of memory. Allocations and frees are performed in
+ * constant time, regardless of how fragmented the tracked range is. No data is
+ * written to the tracked range itself, so it may be used for non-addressable
+ * memory such as that of the GPU.
  */
 typedef struct freelist {
     /** @breif The internal state of the freelist. */
@@ -23,6 +26,18 @@ typedef struct freelist {
  */
 KAPI void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
 
+/**
+ * @brief Same as freelist_create, but for a block of memory which is known to be
+ * zeroed already, such as fresh pages from the OS. Only a small, fixed-size part of
+ * the block is written, so the pages holding the rest are not committed until used.
+ *
+ * @param total_size The total size in bytes that the free list should track.
+ * @param memory_requirement A pointer to hold memory requirement for the free list itself.
+ * @param memory 0, or a pre-allocated, zeroed block of memory for the free list to use.
+ * @param out_list A pointer to hold the created free list.
+ */
+KAPI void freelist_create_zeroed(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
+
 /**
  * @brief Destroys the provided list.
  * 
@@ -40,6 +55,17 @@ KAPI void freelist_destroy(freelist* list);
  */
 KAPI b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset);
 
+/**
+ * @brief Same as freelist_allocate_block, but does not warn if no block is found.
+ * For callers with somewhere else to turn in that case.
+ *
+ * @param list A pointer to the list to search.
+ * @param size The size to allocate.
+ * @param out_offset A pointer to hold the offset to the allocated memory.
+ * @return b8 True if a block of memory was found and allocated; otherwise false.
+ */
+KAPI b8 freelist_try_allocate_block(freelist* list, u64 size, u64* out_offset);
+
 /**
  * @brief Attempts to resize the provided freelist to the given size. Internal data is copied to the new
  * block of memory. The old block must be freed after this call.
@@ -75,11 +101,20 @@ KAPI b8 freelist_free_block(freelist* list, u64 size, u64 offset);
 KAPI void freelist_clear(freelist* list);
 
 /**
- * @brief Returns the amount of free space in this list. NOTE: Since this has
- * to iterate the entire internal list, this can be an expensive operation.
- * Use sparingly.
+ * @brief Returns the amount of free space in this list.
  * 
  * @param list A pointer to the list to obtain from.
  * @return The amount of free space in bytes.
  */
-KAPI u64 freelist_free_space(freelist* list);
\ No newline at end of file
+KAPI u64 freelist_free_space(freelist* list);
+
+/**
+ * @brief Returns the size of the largest free range in this list, i.e. the largest
+ * block which could currently be allocated. Compared against the free space, this
+ * gives a measure of fragmentation. Only walks the single bin holding the largest
+ * ranges, but is not constant time, so is best kept to diagnostics.
+ * 
+ * @param list A pointer to the list to obtain from.
+ * @return The size of the largest free range in bytes, or 0 if there is none.
+ */
+KAPI u64 freelist_largest_free_block(freelist* list);
\ No newline at end of file
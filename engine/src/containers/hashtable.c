@@ -1,30 +1,185 @@
 #include "hashtable.h"
 
 #include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/khash.h"
 #include "core/logger.h"
 
-u64 hash_name(const char* name, u32 element_count)
+// The table grows once more than this fraction of its slots (in quarters) are in use.
+#define HASHTABLE_MAX_LOAD_QUARTERS 3
+#define HASHTABLE_MIN_SLOT_COUNT 8
+
+/**
+ * The slots are held in a single block, as parallel arrays of hashes, names and
+ * values, followed by the fill value. A hash of 0 marks an empty slot.
+ */
+typedef struct hashtable_slots
+{
+    u64* hashes;
+    char** names;
+    u8* values;
+    u8* fill_value;
+} hashtable_slots;
+
+static u64 slots_size(u64 element_size, u32 slot_count)
+{
+    return (sizeof(u64) + sizeof(char*) + element_size) * slot_count + element_size;
+}
+
+static hashtable_slots get_slots(void* memory, u64 element_size, u32 slot_count)
 {
-    // A multipler to use when generating a hash. Prime to hopefully avoid collisions
-    static const u64 multipler = 97;
+    hashtable_slots slots;
+    slots.hashes = memory;
+    slots.names = (char**)(slots.hashes + slot_count);
+    slots.values = (u8*)(slots.names + slot_count);
+    slots.fill_value = slots.values + element_size * slot_count;
+    return slots;
+}
+
+static u64 hash_name(const char* name)
+{
+    u64 hash = khash_string(name);
+    // 0 is reserved for empty slots.
+    return hash ? hash : 1;
+}
+
+// The distance of the entry in the given slot from the slot it hashes to.
+KINLINE u32 probe_distance(u64 hash, u32 slot, u32 mask)
+{
+    return (slot - (u32)(hash & mask)) & mask;
+}
+
+static void copy_slot(hashtable_slots* slots, u64 element_size, u32 dest, u32 source)
+{
+    slots->hashes[dest] = slots->hashes[source];
+    slots->names[dest] = slots->names[source];
+    kcopy_memory(slots->values + element_size * dest, slots->values + element_size * source, element_size);
+}
+
+/**
+ * Finds the slot holding the given name. Returns INVALID_ID if it isn't present. Entries
+ * are ordered by probe distance, so the search can stop as soon as it passes an entry
+ * closer to its own slot than the name would be.
+ */
+static u32 find_slot(const hashtable* table, const hashtable_slots* slots, u64 hash, const char* name)
+{
+    u32 mask = table->element_count - 1;
+    u32 slot = (u32)(hash & mask);
+    for (u32 distance = 0;; ++distance)
+    {
+        u64 slot_hash = slots->hashes[slot];
+        if (!slot_hash || probe_distance(slot_hash, slot, mask) < distance)
+        {
+            return INVALID_ID;
+        }
+        if (slot_hash == hash && strings_equal(slots->names[slot], name))
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/**
+ * Inserts an entry for a name not yet in the table, which must have a free slot.
+ * The entry takes the first slot holding an entry closer to its own slot than the new
+ * one would be, and the run of entries from there up to the next empty slot moves
+ * along by one.
+ */
+static u32 insert_slot(hashtable* table, hashtable_slots* slots, u64 hash, char* name)
+{
+    u32 mask = table->element_count - 1;
+    u32 slot = (u32)(hash & mask);
+    for (u32 distance = 0;; ++distance)
+    {
+        u64 slot_hash = slots->hashes[slot];
+        if (!slot_hash || probe_distance(slot_hash, slot, mask) < distance)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    u32 empty = slot;
+    while (slots->hashes[empty])
+    {
+        empty = (empty + 1) & mask;
+    }
+    while (empty != slot)
+    {
+        u32 previous = (empty - 1) & mask;
+        copy_slot(slots, table->element_size, empty, previous);
+        empty = previous;
+    }
+
+    slots->hashes[slot] = hash;
+    slots->names[slot] = name;
+    table->entry_count++;
+    return slot;
+}
+
+static void allocate_slots(hashtable* table, u32 slot_count)
+{
+    table->element_count = slot_count;
+    table->memory = kallocate(slots_size(table->element_size, slot_count), MEMORY_TAG_DICT);
+}
+
+static void grow(hashtable* table)
+{
+    u32 old_count = table->element_count;
+    void* old_memory = table->memory;
+    hashtable_slots old_slots = get_slots(old_memory, table->element_size, old_count);
+
+    allocate_slots(table, old_count * 2);
+    hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+    kcopy_memory(slots.fill_value, old_slots.fill_value, table->element_size);
+    table->entry_count = 0;
+    for (u32 i = 0; i < old_count; ++i)
+    {
+        if (old_slots.hashes[i])
+        {
+            u32 slot = insert_slot(table, &slots, old_slots.hashes[i], old_slots.names[i]);
+            kcopy_memory(slots.values + table->element_size * slot, old_slots.values + table->element_size * i, table->element_size);
+        }
+    }
+
+    kfree(old_memory, slots_size(table->element_size, old_count), MEMORY_TAG_DICT);
+}
 
-    unsigned const char* us;
-    u64 hash = 0;
-    for(us = (unsigned const char*)name; *us; us++)
+// Obtains the value of the entry with the given name, adding the entry if it doesn't exist.
+static u8* get_or_add_value(hashtable* table, const char* name)
+{
+    u64 hash = hash_name(name);
+    hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+    u32 slot = find_slot(table, &slots, hash, name);
+    if (slot == INVALID_ID)
     {
-        hash = hash * multipler + *us;
+        if ((table->entry_count + 1) * 4 > table->element_count * HASHTABLE_MAX_LOAD_QUARTERS)
+        {
+            grow(table);
+            slots = get_slots(table->memory, table->element_size, table->element_count);
+        }
+        u64 name_size = string_length(name) + 1;
+        char* name_copy = kallocate_with_flags(name_size, 1, MEMORY_TAG_DICT, KALLOCATE_FLAG_UNINITIALIZED);
+        kcopy_memory(name_copy, name, name_size);
+        slot = insert_slot(table, &slots, hash, name_copy);
     }
+    return slots.values + table->element_size * slot;
+}
 
-    // Mod it against the size of the table
-    hash %= element_count;
-    return hash;
+// Obtains the value of the entry with the given name, or 0 if it doesn't exist.
+static u8* get_value(const hashtable* table, const char* name)
+{
+    hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+    u32 slot = find_slot(table, &slots, hash_name(name), name);
+    return slot == INVALID_ID ? 0 : slots.values + table->element_size * slot;
 }
 
-void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_pointer_type, hashtable* out_hashtable)
+void hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, hashtable* out_hashtable)
 {
-    if(!memory || !out_hashtable)
+    if(!out_hashtable)
     {
-        KERROR("hashtable_create failed! Pointer to memory and out_hashtable are required.");
+        KERROR("hashtable_create failed! Pointer to out_hashtable is required.");
         return;
     }
     if(!element_count || !element_size)
@@ -33,19 +188,36 @@ void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_p
         return;
     }
 
-    // TODO: Might want to require an allocator and allocate this memory instead
-    out_hashtable->memory = memory;
-    out_hashtable->element_count = element_count;
+    // Make room for the requested number of entries without growing.
+    u32 slot_count = HASHTABLE_MIN_SLOT_COUNT;
+    while (slot_count * HASHTABLE_MAX_LOAD_QUARTERS < (u64)element_count * 4)
+    {
+        slot_count *= 2;
+    }
+
     out_hashtable->element_size = element_size;
+    out_hashtable->entry_count = 0;
     out_hashtable->is_pointer_type = is_pointer_type;
-    kzero_memory(out_hashtable->memory, element_size * element_count);
+    out_hashtable->has_fill_value = false;
+    allocate_slots(out_hashtable, slot_count);
 }
 
 void hashtable_destroy(hashtable* table)
 {
     if(table)
     {
-        // TODO: If using allocator above, free memory here
+        if (table->memory)
+        {
+            hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+            for (u32 i = 0; i < table->element_count; ++i)
+            {
+                if (slots.hashes[i])
+                {
+                    kfree_with_flags(slots.names[i], string_length(slots.names[i]) + 1, 1, MEMORY_TAG_DICT, KALLOCATE_FLAG_UNINITIALIZED);
+                }
+            }
+            kfree(table->memory, slots_size(table->element_size, table->element_count), MEMORY_TAG_DICT);
+        }
         kzero_memory(table, sizeof(hashtable));
     }
 }
@@ -63,8 +235,7 @@ b8 hashtable_set(hashtable* table, const char* name, void* value)
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    kcopy_memory(table->memory + (table->element_size * hash), value, table->element_size);
+    kcopy_memory(get_or_add_value(table, name), value, table->element_size);
     return true;
 }
 
@@ -81,8 +252,13 @@ b8 hashtable_set_ptr(hashtable* table, const char* name, void** value)
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    ((void**)table->memory)[hash] = value ? *value : 0;
+    if (!value || !*value)
+    {
+        // Unset the entry.
+        hashtable_remove(table, name);
+        return true;
+    }
+    *(void**)get_or_add_value(table, name) = *value;
     return true;
 }
 
@@ -99,8 +275,14 @@ b8 hashtable_get(hashtable* table, const char* name, void* out_value)
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    kcopy_memory(out_value, table->memory + (table->element_size * hash), table->element_size);
+    u8* value = get_value(table, name);
+    if (!value)
+    {
+        hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+        kcopy_memory(out_value, slots.fill_value, table->element_size);
+        return table->has_fill_value;
+    }
+    kcopy_memory(out_value, value, table->element_size);
     return true;
 }
 
@@ -117,11 +299,63 @@ b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value)
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    *out_value = ((void**)table->memory)[hash];
+    u8* value = get_value(table, name);
+    *out_value = value ? *(void**)value : 0;
     return *out_value != 0;
 }
 
+void* hashtable_entry_get(const hashtable* table, const char* name)
+{
+    if(!table || !name)
+    {
+        KWARN("hashtable_entry_get requires table and name to exist.");
+        return 0;
+    }
+    return get_value(table, name);
+}
+
+void* hashtable_entry_get_or_add(hashtable* table, const char* name)
+{
+    if(!table || !name)
+    {
+        KERROR("hashtable_entry_get_or_add requires table and name to exist.");
+        return 0;
+    }
+    return get_or_add_value(table, name);
+}
+
+b8 hashtable_remove(hashtable* table, const char* name)
+{
+    if(!table || !name)
+    {
+        KWARN("hashtable_remove requires table and name to exist.");
+        return false;
+    }
+
+    hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+    u32 slot = find_slot(table, &slots, hash_name(name), name);
+    if (slot == INVALID_ID)
+    {
+        return false;
+    }
+    kfree_with_flags(slots.names[slot], string_length(slots.names[slot]) + 1, 1, MEMORY_TAG_DICT, KALLOCATE_FLAG_UNINITIALIZED);
+
+    // Move the following entries back by one until one is found that is already in its
+    // own slot (or the slot is empty), so that no tombstones are needed.
+    u32 mask = table->element_count - 1;
+    u32 next = (slot + 1) & mask;
+    while (slots.hashes[next] && probe_distance(slots.hashes[next], next, mask) > 0)
+    {
+        copy_slot(&slots, table->element_size, slot, next);
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    slots.hashes[slot] = 0;
+    slots.names[slot] = 0;
+    table->entry_count--;
+    return true;
+}
+
 b8 hashtable_fill(hashtable* table, void* value)
 {
     if(!table || !value)
@@ -134,10 +368,9 @@ b8 hashtable_fill(hashtable* table, void* value)
         KERROR("hashtable_fill should not be used with tables that have pointer types.");
         return false;
     }
-    
-    for(u32 i = 0; i < table->element_count; ++i)
-    {
-        kcopy_memory(table->memory + (table->element_size * i), value, table->element_size);
-    }
+
+    hashtable_slots slots = get_slots(table->memory, table->element_size, table->element_count);
+    kcopy_memory(slots.fill_value, value, table->element_size);
+    table->has_fill_value = true;
     return true;
 }
\ No newline at end of file
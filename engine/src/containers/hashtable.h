@@ -3,37 +3,46 @@
 #include "defines.h"
 
 /**
- * @brief REpresents a simple hashtable. Members of this structure
+ * @brief Represents a simple hashtable. Members of this structure
  * should not be modified outside the function associated with it
- * 
+ *
  * For non-pointer types, table retains a copy of the value. For
  * pointer types, make sure to use the _ptr setter and getter. Table
  * does not take ownership of pointers or associated memory allocations,
  * and should be managed externally
- * 
+ *
+ * Entries are kept using open addressing with Robin Hood probing. The table
+ * stores a copy of each name along with its 64-bit hash, so names which hash
+ * to the same slot never share an entry. The table grows as entries are added,
+ * so element_count need only be a starting estimate.
  */
 typedef struct hashtable
 {
     u64 element_size;
+    /** @brief The number of slots in the table. Grows as entries are added. */
     u32 element_count;
+    /** @brief The number of entries currently held in the table. */
+    u32 entry_count;
     b8 is_pointer_type;
+    /** @brief Indicates if a fill value has been set, which is returned for names not in the table. */
+    b8 has_fill_value;
+    /** @brief The slots of the table. Internally allocated. */
     void* memory;
 } hashtable;
 
 /**
  * @brief Create  a hashtable and stores it in out_hashtable
- * 
+ *
  * @param element_size The size of each element in bytes
- * @param element_count The maximum number of elements. Cannot be resized
- * @param memory A pointer to hold a block of memory to be used. Internally allocated. Will be equal in size to element_size * element_count.
+ * @param element_count The number of entries to make room for up front. The table grows beyond this as needed
  * @param is_pointer_type Indicates if this hashtable will hold pointer types
  * @param out_hashtable A pointer to a hashtable in which to hold relevant data
  */
-KAPI void hashtable_create(u64 element_size, u32 element_count, void* memory, b8 is_pointer_type, hashtable* out_hashtable);
+KAPI void hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, hashtable* out_hashtable);
 
 /**
- * @brief Destroy the provided hashtable. Does not release memory for pointer types
- * 
+ * @brief Destroy the provided hashtable, freeing its internal memory. Does not release memory for pointer types
+ *
  * @param table A pointer to the table to be destroyed
  */
 KAPI void hashtable_destroy(hashtable* table);
@@ -41,7 +50,7 @@ KAPI void hashtable_destroy(hashtable* table);
 /**
  * @brief Stroes a copy of the data in value in the provided hashtable.
  * Only use for tables which were "NOT" created with is_pointer_type = true
- * 
+ *
  * @param table A pointer to the table to get from. Required
  * @param name The name of the entry to set. Required
  * @param value The value to be set. Required
@@ -52,7 +61,7 @@ KAPI b8 hashtable_set(hashtable* table, const char* name, void* value);
 /**
  * @brief Stores a pointer as provided in value in the hashtable.
  * Only use for tables which were created with is_pointer_type = true
- * 
+ *
  * @param table A pointer to the table to get from . Required
  * @param name The name of the entry to set. Required
  * @param value A pointer value to be set. Can pass 0 to 'unset' an entry
@@ -61,20 +70,20 @@ KAPI b8 hashtable_set(hashtable* table, const char* name, void* value);
 KAPI b8 hashtable_set_ptr(hashtable* table, const char* name, void** value);
 
 /**
- * @brief Obtains a pointer to data present in the hashtable
- * Only use for tables which were created with is_pointer_type = true
- * 
+ * @brief Obtains a copy of data present in the hashtable
+ * Only use for tables which were "NOT" created with is_pointer_type = true
+ *
  * @param table A pointer to the table to retrieved from. Required
  * @param name The name of the entry to retrieved. Required
- * @param out_value A pointer to store the retrieved value. Required
- * @return True, or false if a null pointer is passed
+ * @param out_value A pointer to store the retrieved value. Required. Set to the fill value if the entry does not exist, or zeroed if there is none
+ * @return True if the entry exists or the table has a fill value; otherwise false
  */
 KAPI b8 hashtable_get(hashtable* table, const char* name, void* out_value);
 
 /**
  * @brief Obtains a pointer to data present in the hashtable
  * Only use for tables which were created with is_pointer_type = true
- * 
+ *
  * @param table A pointer to the table to retrieved from. Required
  * @param name The name of the entry to retrieved. Required
  * @param out_value A pointer to store the retriened value. required
@@ -83,12 +92,71 @@ KAPI b8 hashtable_get(hashtable* table, const char* name, void* out_value);
 KAPI b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value);
 
 /**
- * @brief Fills all entruies in the hashtable with the given value
+ * @brief Obtains a pointer to the value stored for the given name, which may be read or
+ * written in place. The pointer is only valid until the next entry is added or removed.
+ *
+ * @param table A pointer to the table. Required
+ * @param name The name of the entry. Required
+ * @return A pointer to the value if the entry exists; otherwise 0
+ */
+KAPI void* hashtable_entry_get(const hashtable* table, const char* name);
+
+/**
+ * @brief Obtains a pointer to the value stored for the given name, adding a zeroed entry
+ * if it does not exist. The pointer is only valid until the next entry is added or removed.
+ *
+ * @param table A pointer to the table. Required
+ * @param name The name of the entry. Required
+ * @return A pointer to the value, or 0 if a null pointer is passed
+ */
+KAPI void* hashtable_entry_get_or_add(hashtable* table, const char* name);
+
+/**
+ * @brief Removes the entry with the given name from the hashtable, if it exists
+ *
+ * @param table A pointer to the table to remove from. Required
+ * @param name The name of the entry to be removed. Required
+ * @return True if the entry existed and was removed; otherwise false
+ */
+KAPI b8 hashtable_remove(hashtable* table, const char* name);
+
+/**
+ * @brief Sets the value obtained by hashtable_get for names which are not in the table.
  * Useful when non-existent names should return same default value
  * Should not be used with pointer table types
- * 
+ *
  * @param table A pointer to the table filled. Required
  * @param value The value to the filled with. Required
  * @return True if successfully; otherwise false
  */
-KAPI b8 hashtable_fill(hashtable* table, void* value);
\ No newline at end of file
+KAPI b8 hashtable_fill(hashtable* table, void* value);
+
+/**
+ * @brief Generates functions specialized for hashtables of the given value type, which must
+ * be a single identifier. Values are moved with typed loads and stores of a known size rather
+ * than copies of a runtime element_size. The tables are ordinary hashtables, created with
+ * hashtable_create(sizeof(type), count, false, ...), so may be used with any other function.
+ *
+ * For example, HASHTABLE_DEFINE(u16) provides:
+ *  b8 hashtable_u16_set(hashtable* table, const char* name, u16 value);
+ *  b8 hashtable_u16_get(hashtable* table, const char* name, u16* out_value);
+ * which behave as hashtable_set and hashtable_get, including the fill value.
+ */
+#define HASHTABLE_DEFINE(type)                                                                  \
+    KINLINE b8 hashtable_##type##_set(hashtable* table, const char* name, type value) {         \
+        type* entry = (type*)hashtable_entry_get_or_add(table, name);                           \
+        if (!entry) {                                                                           \
+            return false;                                                                       \
+        }                                                                                       \
+        *entry = value;                                                                         \
+        return true;                                                                            \
+    }                                                                                           \
+    KINLINE b8 hashtable_##type##_get(hashtable* table, const char* name, type* out_value) {    \
+        type* entry = (type*)hashtable_entry_get(table, name);                                  \
+        if (entry) {                                                                            \
+            *out_value = *entry;                                                                \
+            return true;                                                                        \
+        }                                                                                       \
+        /* Not in the table, so fall back to handle the fill value. */                          \
+        return hashtable_get(table, name, out_value);                                           \
+    }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "mpmc_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+/**
+ * A slot at index i starts with sequence i. A producer which claims position p may write
+ * the slot once its sequence is p, then sets it to p + 1. A consumer which claims position p
+ * may read the slot once its sequence is p + 1, then sets it to p + capacity, which is the
+ * next position the slot will be written at.
+ */
+KINLINE volatile u64* slot_sequence(const mpmc_queue* queue, u64 position) {
+    return (volatile u64*)((u8*)queue->block + (position & (queue->capacity - 1)) * queue->slot_size);
+}
+
+b8 mpmc_queue_create(u32 stride, u32 capacity, mpmc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("mpmc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (!stride || !capacity) {
+        KERROR("mpmc_queue_create requires a non-zero stride and capacity.");
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(mpmc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = 1;
+    while (out_queue->capacity < capacity) {
+        out_queue->capacity *= 2;
+    }
+    out_queue->slot_size = get_aligned(sizeof(u64) + stride, sizeof(u64));
+    out_queue->block = kallocate_with_flags((u64)out_queue->slot_size * out_queue->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+
+    for (u32 i = 0; i < out_queue->capacity; ++i) {
+        *slot_sequence(out_queue, i) = i;
+    }
+    // Publish the sequences before any other thread is handed the queue.
+    katomic_store_u64(&out_queue->tail, 0);
+    katomic_store_u64(&out_queue->head, 0);
+    return true;
+}
+
+void mpmc_queue_destroy(mpmc_queue* queue) {
+    if (queue) {
+        if (queue->block) {
+            kfree_with_flags(queue->block, (u64)queue->slot_size * queue->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+        }
+        kzero_memory(queue, sizeof(mpmc_queue));
+    }
+}
+
+b8 mpmc_queue_enqueue(mpmc_queue* queue, const void* value) {
+    if (!queue || !value) {
+        KERROR("mpmc_queue_enqueue requires valid pointers to queue and value.");
+        return false;
+    }
+
+    u64 position = katomic_load_relaxed_u64(&queue->tail);
+    volatile u64* sequence;
+    while (true) {
+        sequence = slot_sequence(queue, position);
+        i64 diff = (i64)(katomic_load_acquire_u64(sequence) - position);
+        if (diff == 0) {
+            // The slot is free for this position. Claim it, unless another producer got there first.
+            if (katomic_compare_exchange_weak_relaxed_u64(&queue->tail, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The slot still holds the element from one lap ago, so the queue is full.
+            return false;
+        } else {
+            // Another producer has already claimed this position.
+            position = katomic_load_relaxed_u64(&queue->tail);
+        }
+    }
+
+    kcopy_memory((u8*)(sequence + 1), value, queue->stride);
+    katomic_store_release_u64(sequence, position + 1);
+    return true;
+}
+
+b8 mpmc_queue_dequeue(mpmc_queue* queue, void* out_value) {
+    if (!queue || !out_value) {
+        KERROR("mpmc_queue_dequeue requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    u64 position = katomic_load_relaxed_u64(&queue->head);
+    volatile u64* sequence;
+    while (true) {
+        sequence = slot_sequence(queue, position);
+        i64 diff = (i64)(katomic_load_acquire_u64(sequence) - (position + 1));
+        if (diff == 0) {
+            // The slot has been written for this position. Claim it, unless another consumer got there first.
+            if (katomic_compare_exchange_weak_relaxed_u64(&queue->head, &position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Nothing has been written at this position yet, so the queue is empty.
+            return false;
+        } else {
+            // Another consumer has already claimed this position.
+            position = katomic_load_relaxed_u64(&queue->head);
+        }
+    }
+
+    kcopy_memory(out_value, (u8*)(sequence + 1), queue->stride);
+    katomic_store_release_u64(sequence, position + queue->capacity);
+    return true;
+}
+
+u32 mpmc_queue_length(mpmc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    // Read the head first so that, in a racing moment, the estimate errs on the high side.
+    u64 head = katomic_load_acquire_u64(&queue->head);
+    u64 tail = katomic_load_acquire_u64(&queue->tail);
+    return tail > head ? (u32)(tail - head) : 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A bounded, lock-free first in, first out queue which any number of threads may
+ * enqueue to and dequeue from at once. Does not resize dynamically.
+ *
+ * Each slot carries a sequence number which tells a thread whether the slot is ready to be
+ * written (for a producer) or read (for a consumer) at a given position. Threads claim a
+ * position with a single compare-exchange on the head or tail, and hand the slot over by
+ * advancing its sequence, so no thread ever waits on another holding a lock.
+ * Members should not be modified outside the functions below.
+ */
+typedef struct mpmc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of two. */
+    u32 capacity;
+    /** @brief The size of each slot in bytes; its sequence number followed by its element. */
+    u32 slot_size;
+    /** @brief The block of memory holding the slots. */
+    void* block;
+
+    // The positions are written by different threads, so each is kept on its own cache line.
+    u8 pad0[KCACHE_LINE_SIZE];
+    /** @brief The position the next element is enqueued at. */
+    volatile u64 tail;
+    u8 pad1[KCACHE_LINE_SIZE - sizeof(u64)];
+    /** @brief The position the next element is dequeued from. */
+    volatile u64 head;
+    u8 pad2[KCACHE_LINE_SIZE - sizeof(u64)];
+} mpmc_queue;
+
+/**
+ * @brief Creates a new queue of the given stride, with room for at least the given number
+ * of elements. Should not be used by other threads until this returns.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The minimum number of elements to be available. Rounded up to a power of two.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 mpmc_queue_create(u32 stride, u32 capacity, mpmc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue, freeing its memory. No other thread may be using it.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void mpmc_queue_destroy(mpmc_queue* queue);
+
+/**
+ * @brief Adds a copy of value to the queue, if space is available. Safe to call from any thread.
+ *
+ * @param queue A pointer to the queue to add data to.
+ * @param value A pointer to the value to be copied.
+ * @return True on success; false if the queue is full.
+ */
+KAPI b8 mpmc_queue_enqueue(mpmc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to remove the next value from the queue. Safe to call from any thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True on success; false if the queue is empty.
+ */
+KAPI b8 mpmc_queue_dequeue(mpmc_queue* queue, void* out_value);
+
+/**
+ * @brief Obtains the number of elements in the queue. While other threads are using the
+ * queue, this is only an estimate, which may be out of date as soon as it is returned.
+ *
+ * @param queue A pointer to the queue.
+ * @return The number of elements in the queue.
+ */
+KAPI u32 mpmc_queue_length(mpmc_queue* queue);
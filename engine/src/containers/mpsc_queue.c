@@ -0,0 +1,70 @@
+#include "mpsc_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+b8 mpsc_queue_create(mpsc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("mpsc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(mpsc_queue));
+    // Publish the empty head before any other thread is handed the queue.
+    katomic_store_u64(&out_queue->head, 0);
+    return true;
+}
+
+void mpsc_queue_destroy(mpsc_queue* queue) {
+    if (queue) {
+        if (queue->head) {
+            KWARN("mpsc_queue_destroy called on a queue which still holds nodes. They will not be released.");
+        }
+        kzero_memory(queue, sizeof(mpsc_queue));
+    }
+}
+
+void mpsc_queue_push(mpsc_queue* queue, mpsc_queue_node* node) {
+    if (!queue || !node) {
+        KERROR("mpsc_queue_push requires a valid queue and node.");
+        return;
+    }
+
+    // The exchange is sequentially consistent, so it also publishes the node's contents to
+    // the consumer. On failure, head is refreshed and the node relinked to it.
+    u64 head = katomic_load_relaxed_u64(&queue->head);
+    do {
+        node->next = (mpsc_queue_node*)head;
+    } while (!katomic_compare_exchange_u64(&queue->head, &head, (u64)node));
+}
+
+mpsc_queue_node* mpsc_queue_take_all(mpsc_queue* queue) {
+    if (!queue) {
+        KERROR("mpsc_queue_take_all requires a valid queue.");
+        return 0;
+    }
+
+    // Check first, so that polling an empty queue never writes to the shared cache line.
+    if (!katomic_load_acquire_u64(&queue->head)) {
+        return 0;
+    }
+    mpsc_queue_node* node = (mpsc_queue_node*)katomic_exchange_u64(&queue->head, 0);
+
+    // The list runs from the newest node to the oldest, so reverse it.
+    mpsc_queue_node* first = 0;
+    while (node) {
+        mpsc_queue_node* next = node->next;
+        node->next = first;
+        first = node;
+        node = next;
+    }
+    return first;
+}
+
+b8 mpsc_queue_is_empty(mpsc_queue* queue) {
+    if (!queue) {
+        return true;
+    }
+    return katomic_load_acquire_u64(&queue->head) == 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A link in an mpsc_queue. Embedded as the first member of whatever is being queued,
+ * so pushing an element never allocates.
+ */
+typedef struct mpsc_queue_node {
+    /** @brief The next node, in the order the nodes were pushed. */
+    struct mpsc_queue_node* next;
+} mpsc_queue_node;
+
+/**
+ * @brief An unbounded, lock-free first in, first out queue which any number of threads may
+ * push to, but only a single thread takes from.
+ *
+ * Producers link their node onto the head of a list with a compare-exchange. The consumer
+ * takes the whole list at once with a single exchange, then reverses it so the nodes come
+ * out in the order they were pushed. As nodes are never removed one at a time, a producer
+ * can never see a node reused underneath it. Checking an empty queue is a single load.
+ * Members should not be modified outside the functions below.
+ */
+typedef struct mpsc_queue {
+    // Pushed to by many threads, so kept on its own cache line.
+    u8 pad0[KCACHE_LINE_SIZE];
+    /** @brief The most recently pushed node, or 0 if the queue is empty. */
+    volatile u64 head;
+    u8 pad1[KCACHE_LINE_SIZE - sizeof(u64)];
+} mpsc_queue;
+
+/**
+ * @brief Creates a new, empty queue. Should not be used by other threads until this returns.
+ *
+ * @param out_queue A pointer to hold the newly created queue.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 mpsc_queue_create(mpsc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. No other thread may be using it. The queue does not own
+ * its nodes, so any still queued should be taken and released by the caller first.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void mpsc_queue_destroy(mpsc_queue* queue);
+
+/**
+ * @brief Adds the given node to the queue. Safe to call from any thread. The node must stay
+ * valid, and must not be pushed again, until it has been taken back out.
+ *
+ * @param queue A pointer to the queue to add the node to.
+ * @param node A pointer to the node to be added.
+ */
+KAPI void mpsc_queue_push(mpsc_queue* queue, mpsc_queue_node* node);
+
+/**
+ * @brief Removes every node from the queue at once. Only one thread may take from a queue.
+ *
+ * @param queue A pointer to the queue to take the nodes from.
+ * @return The first node pushed, linked through next to the rest in the order they were
+ * pushed; or 0 if the queue is empty.
+ */
+KAPI mpsc_queue_node* mpsc_queue_take_all(mpsc_queue* queue);
+
+/**
+ * @brief Indicates if the queue is empty. While other threads are pushing to the queue, this
+ * may be out of date as soon as it is returned.
+ *
+ * @param queue A pointer to the queue.
+ * @return True if the queue is empty; otherwise false.
+ */
+KAPI b8 mpsc_queue_is_empty(mpsc_queue* queue);
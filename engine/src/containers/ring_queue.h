@@ -69,4 +69,43 @@ b8 ring_queue_dequeue(ring_queue* queue, void* out_value);
  * @param out_value A pointer to hold the retrieved value.
  * @return True if success; otherwise false.
  */
-b8 ring_queue_peek(const ring_queue* queue, void* out_value);
\ No newline at end of file
+b8 ring_queue_peek(const ring_queue* queue, void* out_value);
+
+/**
+ * @brief Generates functions specialized for ring queues of the given type, which must be
+ * a single identifier (use a typedef for pointers). Elements are moved with typed loads and
+ * stores of a known size rather than copies of a runtime stride, so the compiler can inline
+ * them. The queues are ordinary ring queues, created with ring_queue_create(sizeof(type), ...).
+ * Unlike the generic functions, these do not log when the queue is full or empty.
+ *
+ * For example, RING_QUEUE_DEFINE(job_info) provides:
+ *  b8 ring_queue_job_info_enqueue(ring_queue* queue, job_info value);
+ *  b8 ring_queue_job_info_dequeue(ring_queue* queue, job_info* out_value);
+ *  b8 ring_queue_job_info_peek(const ring_queue* queue, job_info* out_value);
+ */
+#define RING_QUEUE_DEFINE(type)                                                              \
+    KINLINE b8 ring_queue_##type##_enqueue(ring_queue* queue, type value) {                  \
+        if (queue->length == queue->capacity) {                                              \
+            return false;                                                                    \
+        }                                                                                    \
+        queue->tail = queue->tail + 1 == (i32)queue->capacity ? 0 : queue->tail + 1;         \
+        ((type*)queue->block)[queue->tail] = value;                                          \
+        queue->length++;                                                                     \
+        return true;                                                                         \
+    }                                                                                        \
+    KINLINE b8 ring_queue_##type##_dequeue(ring_queue* queue, type* out_value) {             \
+        if (queue->length == 0) {                                                            \
+            return false;                                                                    \
+        }                                                                                    \
+        *out_value = ((type*)queue->block)[queue->head];                                     \
+        queue->head = queue->head + 1 == (i32)queue->capacity ? 0 : queue->head + 1;         \
+        queue->length--;                                                                     \
+        return true;                                                                         \
+    }                                                                                        \
+    KINLINE b8 ring_queue_##type##_peek(const ring_queue* queue, type* out_value) {          \
+        if (queue->length == 0) {                                                            \
+            return false;                                                                    \
+        }                                                                                    \
+        *out_value = ((type*)queue->block)[queue->head];                                     \
+        return true;                                                                         \
+    }
@@ -0,0 +1,189 @@
+#include "slot_map.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Values are aligned for any type the engine stores, including SIMD-friendly math types.
+#define SLOT_MAP_ALIGNMENT 16
+
+// The block contains the values, then the slot index of each value, then the slots.
+static u64 value_slots_offset(u64 stride, u32 capacity) {
+    return get_aligned(stride * capacity, sizeof(u64));
+}
+
+static u64 block_size(u64 stride, u32 capacity) {
+    return value_slots_offset(stride, capacity) + get_aligned(sizeof(u32) * capacity, sizeof(u64)) + sizeof(slot_map_slot) * capacity;
+}
+
+static void allocate_block(slot_map* map, u32 capacity) {
+    u8* block = kallocate_aligned(block_size(map->stride, capacity), SLOT_MAP_ALIGNMENT, MEMORY_TAG_ARRAY);
+    map->capacity = capacity;
+    map->values = block;
+    map->value_slots = (u32*)(block + value_slots_offset(map->stride, capacity));
+    map->slots = (slot_map_slot*)((u8*)map->value_slots + get_aligned(sizeof(u32) * capacity, sizeof(u64)));
+}
+
+// Moves everything into a larger block. Handles stay valid, since slot indices do not change.
+static void grow(slot_map* map) {
+    u8* old_block = map->values;
+    u32* old_value_slots = map->value_slots;
+    slot_map_slot* old_slots = map->slots;
+    u32 old_capacity = map->capacity;
+
+    u32 capacity = old_capacity * 2 < SLOT_MAP_MAX_CAPACITY ? old_capacity * 2 : SLOT_MAP_MAX_CAPACITY;
+    allocate_block(map, capacity);
+    kcopy_memory(map->values, old_block, map->stride * map->length);
+    kcopy_memory(map->value_slots, old_value_slots, sizeof(u32) * map->length);
+    kcopy_memory(map->slots, old_slots, sizeof(slot_map_slot) * map->slot_count);
+
+    kfree_aligned(old_block, block_size(map->stride, old_capacity), SLOT_MAP_ALIGNMENT, MEMORY_TAG_ARRAY);
+}
+
+// Returns the slot the handle refers to, or 0 if the handle is stale or invalid.
+static slot_map_slot* handle_slot(const slot_map* map, u32 handle) {
+    u32 index = slot_map_handle_index(handle);
+    if (handle == INVALID_ID || index >= map->slot_count) {
+        return 0;
+    }
+    // Free slots have even generations and handles are only made from odd ones. A caller
+    // could still build a u32 with a free slot's generation, so the slot must also be live.
+    slot_map_slot* slot = &map->slots[index];
+    if ((slot->generation & 1) == 0 || (slot->generation & SLOT_MAP_HANDLE_GENERATION_MASK) != slot_map_handle_generation(handle)) {
+        return 0;
+    }
+    return slot;
+}
+
+b8 slot_map_create(u64 stride, u32 capacity, slot_map* out_map) {
+    if (!out_map) {
+        KERROR("slot_map_create requires a valid pointer to hold the map.");
+        return false;
+    }
+    if (!stride) {
+        KERROR("slot_map_create requires a non-zero stride.");
+        return false;
+    }
+
+    kzero_memory(out_map, sizeof(slot_map));
+    out_map->stride = stride;
+    out_map->free_head = INVALID_ID;
+    if (capacity < 1) {
+        capacity = 1;
+    } else if (capacity > SLOT_MAP_MAX_CAPACITY) {
+        capacity = SLOT_MAP_MAX_CAPACITY;
+    }
+    allocate_block(out_map, capacity);
+    return true;
+}
+
+void slot_map_destroy(slot_map* map) {
+    if (map) {
+        if (map->values) {
+            kfree_aligned(map->values, block_size(map->stride, map->capacity), SLOT_MAP_ALIGNMENT, MEMORY_TAG_ARRAY);
+        }
+        kzero_memory(map, sizeof(slot_map));
+    }
+}
+
+void* slot_map_insert(slot_map* map, const void* value, u32* out_handle) {
+    *out_handle = INVALID_ID;
+    if (!map || !map->values) {
+        KERROR("slot_map_insert requires a valid map.");
+        return 0;
+    }
+
+    // Reuse a free slot if there is one, otherwise hand out a new one.
+    u32 index = map->free_head;
+    if (index != INVALID_ID) {
+        map->free_head = map->slots[index].index;
+    } else {
+        if (map->slot_count == map->capacity) {
+            if (map->capacity == SLOT_MAP_MAX_CAPACITY) {
+                KERROR("slot_map_insert - Map is full (%u values). Nothing was inserted.", SLOT_MAP_MAX_CAPACITY);
+                return 0;
+            }
+            grow(map);
+        }
+        index = map->slot_count++;
+        map->slots[index].generation = 0;
+    }
+
+    u32 value_index = map->length++;
+    slot_map_slot* slot = &map->slots[index];
+    slot->generation++;
+    slot->index = value_index;
+    map->value_slots[value_index] = index;
+
+    u8* dest = map->values + map->stride * value_index;
+    if (value) {
+        kcopy_memory(dest, value, map->stride);
+    } else {
+        kzero_memory(dest, map->stride);
+    }
+
+    *out_handle = ((slot->generation & SLOT_MAP_HANDLE_GENERATION_MASK) << SLOT_MAP_HANDLE_INDEX_BITS) | index;
+    return dest;
+}
+
+b8 slot_map_erase(slot_map* map, u32 handle) {
+    if (!map || !map->values) {
+        KERROR("slot_map_erase requires a valid map.");
+        return false;
+    }
+
+    slot_map_slot* slot = handle_slot(map, handle);
+    if (!slot) {
+        KERROR("slot_map_erase called with a stale or invalid handle (%u). Nothing was done.", handle);
+        return false;
+    }
+
+    // Fill the hole with the last value, so that values stay packed.
+    u32 value_index = slot->index;
+    u32 last = --map->length;
+    if (value_index != last) {
+        kcopy_memory(map->values + map->stride * value_index, map->values + map->stride * last, map->stride);
+        u32 moved_slot = map->value_slots[last];
+        map->value_slots[value_index] = moved_slot;
+        map->slots[moved_slot].index = value_index;
+    }
+
+    slot->generation++;
+    slot->index = map->free_head;
+    map->free_head = slot_map_handle_index(handle);
+    return true;
+}
+
+void slot_map_clear(slot_map* map) {
+    if (map && map->values) {
+        // Bump live generations to even so that existing handles become stale, and link
+        // all slots in ascending order so that low indices are handed out first.
+        for (u32 i = 0; i < map->slot_count; ++i) {
+            if (map->slots[i].generation & 1) {
+                map->slots[i].generation++;
+            }
+            map->slots[i].index = i + 1 < map->slot_count ? i + 1 : INVALID_ID;
+        }
+        map->free_head = map->slot_count ? 0 : INVALID_ID;
+        map->length = 0;
+    }
+}
+
+void* slot_map_get(const slot_map* map, u32 handle) {
+    if (!map) {
+        return 0;
+    }
+    slot_map_slot* slot = handle_slot(map, handle);
+    return slot ? map->values + map->stride * slot->index : 0;
+}
+
+b8 slot_map_contains(const slot_map* map, u32 handle) {
+    return map && handle_slot(map, handle) != 0;
+}
+
+u32 slot_map_handle_at(const slot_map* map, u32 value_index) {
+    if (!map || value_index >= map->length) {
+        return INVALID_ID;
+    }
+    u32 index = map->value_slots[value_index];
+    return ((map->slots[index].generation & SLOT_MAP_HANDLE_GENERATION_MASK) << SLOT_MAP_HANDLE_INDEX_BITS) | index;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A container of fixed-size values referred to by generational handles. Values
+ * are packed densely at the front of a single array, so iterating over all live values
+ * touches only those values, however many have been inserted and erased over time.
+ *
+ * Each handle names a slot, which holds the index of its value within the dense array
+ * along with a generation. Erasing a value moves the last value into its place and
+ * advances the slot's generation, so any handle to an erased value is rejected, even
+ * once its slot has been reused. Insert, erase and lookup are all constant-time, and the
+ * map grows as values are inserted.
+ *
+ * Because values move when others are erased (and when the map grows), pointers to
+ * values are only valid until the next insert or erase; hold handles instead.
+ * Members may be read, i.e. to iterate values[0..length), but should not be modified
+ * outside the functions below.
+ */
+
+/** @brief A slot of a slot map. */
+typedef struct slot_map_slot {
+    /** @brief Odd while the slot refers to a value, even while it is free. */
+    u32 generation;
+    /** @brief The index of the slot's value if in use; otherwise the next free slot. */
+    u32 index;
+} slot_map_slot;
+
+typedef struct slot_map {
+    /** @brief The size of each value in bytes. */
+    u64 stride;
+    /** @brief The number of values the map has room for before it must grow. */
+    u32 capacity;
+    /** @brief The number of live values, which are held in values[0..length). */
+    u32 length;
+    /** @brief The number of slots which have been handed out at least once. */
+    u32 slot_count;
+    /** @brief The first free slot below slot_count, or INVALID_ID if there is none. */
+    u32 free_head;
+    /** @brief The live values, in no particular order. Also the start of the internally allocated block. */
+    u8* values;
+    /** @brief For each live value, the index of the slot which refers to it. */
+    u32* value_slots;
+    /** @brief The slots, of which there are capacity. */
+    slot_map_slot* slots;
+} slot_map;
+
+/** @brief The number of low bits of a handle holding the slot index. */
+#define SLOT_MAP_HANDLE_INDEX_BITS 20
+/** @brief The mask applied to a handle to obtain the slot index. */
+#define SLOT_MAP_HANDLE_INDEX_MASK ((1U << SLOT_MAP_HANDLE_INDEX_BITS) - 1)
+/** @brief The mask applied to a generation before it is stored in a handle. */
+#define SLOT_MAP_HANDLE_GENERATION_MASK ((1U << (32 - SLOT_MAP_HANDLE_INDEX_BITS)) - 1)
+/**
+ * @brief The maximum number of values a map may hold. One less than the index range
+ * allows, so that INVALID_ID is never a valid handle.
+ */
+#define SLOT_MAP_MAX_CAPACITY SLOT_MAP_HANDLE_INDEX_MASK
+
+/** @brief Obtains the slot index encoded in the given handle. */
+KINLINE u32 slot_map_handle_index(u32 handle) {
+    return handle & SLOT_MAP_HANDLE_INDEX_MASK;
+}
+
+/** @brief Obtains the generation encoded in the given handle. */
+KINLINE u32 slot_map_handle_generation(u32 handle) {
+    return handle >> SLOT_MAP_HANDLE_INDEX_BITS;
+}
+
+/**
+ * @brief Creates a new slot map.
+ *
+ * @param stride The size of each value in bytes.
+ * @param capacity The number of values to make room for up front. The map grows beyond this as needed.
+ * @param out_map A pointer to hold the newly created map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 slot_map_create(u64 stride, u32 capacity, slot_map* out_map);
+
+/**
+ * @brief Destroys the given map, freeing its internal memory.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void slot_map_destroy(slot_map* map);
+
+/**
+ * @brief Inserts a new value into the map.
+ *
+ * @param map A pointer to the map. Required.
+ * @param value A pointer to the value to be copied in, or 0 to insert a zeroed value.
+ * @param out_handle A pointer to hold the handle of the new value. Set to INVALID_ID on failure.
+ * @return A pointer to the new value, valid until the next insert or erase; or 0 on failure (i.e. the map is at SLOT_MAP_MAX_CAPACITY).
+ */
+KAPI void* slot_map_insert(slot_map* map, const void* value, u32* out_handle);
+
+/**
+ * @brief Erases the value referred to by the given handle, invalidating all handles to it.
+ * The last value in the map is moved into its place.
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle of the value to be erased.
+ * @return True on success; otherwise false (i.e. the handle is stale or invalid).
+ */
+KAPI b8 slot_map_erase(slot_map* map, u32 handle);
+
+/**
+ * @brief Erases all values at once, invalidating all outstanding handles.
+ *
+ * @param map A pointer to the map to be cleared.
+ */
+KAPI void slot_map_clear(slot_map* map);
+
+/**
+ * @brief Obtains the value referred to by the given handle.
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle of the value.
+ * @return A pointer to the value, valid until the next insert or erase, if the handle is valid; otherwise 0.
+ */
+KAPI void* slot_map_get(const slot_map* map, u32 handle);
+
+/**
+ * @brief Indicates whether the given handle refers to a live value.
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle to be checked.
+ * @return True if the handle is valid; otherwise false.
+ */
+KAPI b8 slot_map_contains(const slot_map* map, u32 handle);
+
+/**
+ * @brief Obtains the handle of the value at the given position in values, such as
+ * while iterating over them.
+ *
+ * @param map A pointer to the map. Required.
+ * @param value_index The index of the value, which must be less than length.
+ * @return The handle of the value; or INVALID_ID if value_index is out of range.
+ */
+KAPI u32 slot_map_handle_at(const slot_map* map, u32 value_index);
@@ -0,0 +1,203 @@
+#include "sort.h"
+
+#include "core/kmemory.h"
+#include "memory/scratch_allocator.h"
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/**
+ * Turns a digit histogram into the position each digit's first key is placed at. Returns
+ * false if every key has the same digit, in which case the pass would not move anything.
+ */
+static b8 histogram_to_offsets(u32* histogram, u32 count, u32 first_digit) {
+    if (histogram[first_digit] == count) {
+        return false;
+    }
+    u32 offset = 0;
+    for (u32 d = 0; d < RADIX_SIZE; ++d) {
+        u32 digit_count = histogram[d];
+        histogram[d] = offset;
+        offset += digit_count;
+    }
+    return true;
+}
+
+static void sort_u32(u32* keys, u32* indices, u32 count, u32* scratch_keys, u32* scratch_indices) {
+    // Count all digits of all keys in one read of the keys.
+    u32 histograms[sizeof(u32)][RADIX_SIZE];
+    kzero_memory(histograms, sizeof(histograms));
+    for (u32 i = 0; i < count; ++i) {
+        u32 key = keys[i];
+        for (u32 pass = 0; pass < sizeof(u32); ++pass) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    // Each pass moves the keys from src to dst, then the two are swapped.
+    u32* src = keys;
+    u32* dst = scratch_keys;
+    u32* src_indices = indices;
+    u32* dst_indices = scratch_indices;
+    for (u32 pass = 0; pass < sizeof(u32); ++pass) {
+        u32 shift = pass * RADIX_BITS;
+        u32* offsets = histograms[pass];
+        if (!histogram_to_offsets(offsets, count, (src[0] >> shift) & RADIX_MASK)) {
+            continue;
+        }
+
+        if (indices) {
+            for (u32 i = 0; i < count; ++i) {
+                u32 position = offsets[(src[i] >> shift) & RADIX_MASK]++;
+                dst[position] = src[i];
+                dst_indices[position] = src_indices[i];
+            }
+            u32* temp_indices = src_indices;
+            src_indices = dst_indices;
+            dst_indices = temp_indices;
+        } else {
+            for (u32 i = 0; i < count; ++i) {
+                dst[offsets[(src[i] >> shift) & RADIX_MASK]++] = src[i];
+            }
+        }
+        u32* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    // After an odd number of passes, the result is in the scratch buffers.
+    if (src != keys) {
+        kcopy_memory(keys, src, sizeof(u32) * count);
+        if (indices) {
+            kcopy_memory(indices, src_indices, sizeof(u32) * count);
+        }
+    }
+}
+
+static void sort_u64(u64* keys, u32* indices, u32 count, u64* scratch_keys, u32* scratch_indices) {
+    u32 histograms[sizeof(u64)][RADIX_SIZE];
+    kzero_memory(histograms, sizeof(histograms));
+    for (u32 i = 0; i < count; ++i) {
+        u64 key = keys[i];
+        for (u32 pass = 0; pass < sizeof(u64); ++pass) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    u64* src = keys;
+    u64* dst = scratch_keys;
+    u32* src_indices = indices;
+    u32* dst_indices = scratch_indices;
+    for (u32 pass = 0; pass < sizeof(u64); ++pass) {
+        u32 shift = pass * RADIX_BITS;
+        u32* offsets = histograms[pass];
+        if (!histogram_to_offsets(offsets, count, (u32)(src[0] >> shift) & RADIX_MASK)) {
+            continue;
+        }
+
+        if (indices) {
+            for (u32 i = 0; i < count; ++i) {
+                u32 position = offsets[(src[i] >> shift) & RADIX_MASK]++;
+                dst[position] = src[i];
+                dst_indices[position] = src_indices[i];
+            }
+            u32* temp_indices = src_indices;
+            src_indices = dst_indices;
+            dst_indices = temp_indices;
+        } else {
+            for (u32 i = 0; i < count; ++i) {
+                dst[offsets[(src[i] >> shift) & RADIX_MASK]++] = src[i];
+            }
+        }
+        u64* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != keys) {
+        kcopy_memory(keys, src, sizeof(u64) * count);
+        if (indices) {
+            kcopy_memory(indices, src_indices, sizeof(u32) * count);
+        }
+    }
+}
+
+// Flips the bits of floats in place so that they sort as u32s; see sort_key_from_f32.
+static void f32_to_keys(u32* bits, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        bits[i] ^= (u32)(-(i32)(bits[i] >> 31)) | 0x80000000;
+    }
+}
+
+static void keys_to_f32(u32* bits, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        bits[i] ^= ((bits[i] >> 31) - 1) | 0x80000000;
+    }
+}
+
+/**
+ * Runs a sort, taking any scratch buffers not passed in from the thread's scratch stack.
+ * Keys of either size are handled here so that the public functions stay one-liners.
+ */
+static void run_sort(void* keys, u32 key_size, u32* indices, u32 count, void* scratch_keys, u32* scratch_indices) {
+    if (!keys || count < 2) {
+        return;
+    }
+
+    b8 use_scratch = !scratch_keys || (indices && !scratch_indices);
+    scratch_marker marker;
+    if (use_scratch) {
+        marker = scratch_allocator_begin();
+        if (!scratch_keys) {
+            scratch_keys = scratch_allocator_allocate((u64)key_size * count, key_size);
+        }
+        if (indices && !scratch_indices) {
+            scratch_indices = scratch_allocator_allocate(sizeof(u32) * count, sizeof(u32));
+        }
+    }
+
+    if (key_size == sizeof(u64)) {
+        sort_u64(keys, indices, count, scratch_keys, scratch_indices);
+    } else {
+        sort_u32(keys, indices, count, scratch_keys, scratch_indices);
+    }
+
+    if (use_scratch) {
+        scratch_allocator_end(marker);
+    }
+}
+
+void radix_sort_u32(u32* keys, u32 count, u32* scratch) {
+    run_sort(keys, sizeof(u32), 0, count, scratch, 0);
+}
+
+void radix_sort_u64(u64* keys, u32 count, u64* scratch) {
+    run_sort(keys, sizeof(u64), 0, count, scratch, 0);
+}
+
+void radix_sort_f32(f32* keys, u32 count, f32* scratch) {
+    if (!keys || count < 2) {
+        return;
+    }
+    f32_to_keys((u32*)keys, count);
+    run_sort(keys, sizeof(u32), 0, count, scratch, 0);
+    keys_to_f32((u32*)keys, count);
+}
+
+void radix_sort_u32_indexed(u32* keys, u32* indices, u32 count, u32* scratch_keys, u32* scratch_indices) {
+    run_sort(keys, sizeof(u32), indices, count, scratch_keys, scratch_indices);
+}
+
+void radix_sort_u64_indexed(u64* keys, u32* indices, u32 count, u64* scratch_keys, u32* scratch_indices) {
+    run_sort(keys, sizeof(u64), indices, count, scratch_keys, scratch_indices);
+}
+
+void radix_sort_f32_indexed(f32* keys, u32* indices, u32 count, f32* scratch_keys, u32* scratch_indices) {
+    if (!keys || count < 2) {
+        return;
+    }
+    f32_to_keys((u32*)keys, count);
+    run_sort(keys, sizeof(u32), indices, count, scratch_keys, scratch_indices);
+    keys_to_f32((u32*)keys, count);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Stable least-significant-digit radix sorts for integer and float keys, in
+ * ascending order. Each pass places all keys by one byte, so a sort takes the same linear
+ * time whether the input is random, already sorted or reversed. Passes over bytes which
+ * are the same for every key (i.e. the high bytes of small values) are skipped.
+ *
+ * The indexed variants carry a u32 alongside each key, such as the index of the item the
+ * key was made from, so that large items can be sorted without moving them. To sort in
+ * descending order, sort inverted keys (~key).
+ *
+ * Every sort needs scratch buffers of the same length as its arrays. These may be passed
+ * in, i.e. from a frame allocator, or left as 0 to take them from the calling thread's
+ * scratch stack for the duration of the sort.
+ */
+
+/**
+ * @brief Converts a float into a u32 key which sorts in the same order as the float does.
+ * Positive floats have the sign bit set, and negative floats have all bits flipped.
+ *
+ * @param value The float to convert.
+ * @return The sort key.
+ */
+KINLINE u32 sort_key_from_f32(f32 value) {
+    union {
+        f32 f;
+        u32 u;
+    } bits = {value};
+    u32 mask = (u32)(-(i32)(bits.u >> 31)) | 0x80000000;
+    return bits.u ^ mask;
+}
+
+/**
+ * @brief Converts a key obtained from sort_key_from_f32 back into its float.
+ *
+ * @param key The sort key.
+ * @return The float the key was made from.
+ */
+KINLINE f32 sort_key_to_f32(u32 key) {
+    u32 mask = ((key >> 31) - 1) | 0x80000000;
+    union {
+        u32 u;
+        f32 f;
+    } bits = {key ^ mask};
+    return bits.f;
+}
+
+/**
+ * @brief Sorts the given keys in ascending order.
+ *
+ * @param keys The keys to be sorted in place.
+ * @param count The number of keys.
+ * @param scratch A buffer of count keys to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_u32(u32* keys, u32 count, u32* scratch);
+
+/**
+ * @brief Sorts the given keys in ascending order.
+ *
+ * @param keys The keys to be sorted in place.
+ * @param count The number of keys.
+ * @param scratch A buffer of count keys to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_u64(u64* keys, u32 count, u64* scratch);
+
+/**
+ * @brief Sorts the given floats in ascending order, with -0.0 before 0.0. NaNs are placed
+ * at either end, depending on their sign.
+ *
+ * @param keys The floats to be sorted in place.
+ * @param count The number of floats.
+ * @param scratch A buffer of count floats to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_f32(f32* keys, u32 count, f32* scratch);
+
+/**
+ * @brief Sorts the given keys in ascending order, moving each index along with its key.
+ * Indices of equal keys keep their relative order.
+ *
+ * @param keys The keys to be sorted in place.
+ * @param indices The values to be moved along with the keys.
+ * @param count The number of keys and indices.
+ * @param scratch_keys A buffer of count keys to be used while sorting, or 0 to use the thread's scratch stack.
+ * @param scratch_indices A buffer of count indices to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_u32_indexed(u32* keys, u32* indices, u32 count, u32* scratch_keys, u32* scratch_indices);
+
+/**
+ * @brief Sorts the given keys in ascending order, moving each index along with its key.
+ * Indices of equal keys keep their relative order.
+ *
+ * @param keys The keys to be sorted in place.
+ * @param indices The values to be moved along with the keys.
+ * @param count The number of keys and indices.
+ * @param scratch_keys A buffer of count keys to be used while sorting, or 0 to use the thread's scratch stack.
+ * @param scratch_indices A buffer of count indices to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_u64_indexed(u64* keys, u32* indices, u32 count, u64* scratch_keys, u32* scratch_indices);
+
+/**
+ * @brief Sorts the given floats in ascending order, moving each index along with its float.
+ * Indices of equal floats keep their relative order.
+ *
+ * @param keys The floats to be sorted in place.
+ * @param indices The values to be moved along with the floats.
+ * @param count The number of floats and indices.
+ * @param scratch_keys A buffer of count floats to be used while sorting, or 0 to use the thread's scratch stack.
+ * @param scratch_indices A buffer of count indices to be used while sorting, or 0 to use the thread's scratch stack.
+ */
+KAPI void radix_sort_f32_indexed(f32* keys, u32* indices, u32 count, f32* scratch_keys, u32* scratch_indices);
@@ -0,0 +1,111 @@
+#include "spsc_queue.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+KINLINE void* element_at(const spsc_queue* queue, u64 position) {
+    return (u8*)queue->block + (position & (queue->capacity - 1)) * queue->stride;
+}
+
+b8 spsc_queue_create(u32 stride, u32 capacity, spsc_queue* out_queue) {
+    if (!out_queue) {
+        KERROR("spsc_queue_create requires a valid pointer to hold the queue.");
+        return false;
+    }
+    if (!stride || !capacity) {
+        KERROR("spsc_queue_create requires a non-zero stride and capacity.");
+        return false;
+    }
+
+    kzero_memory(out_queue, sizeof(spsc_queue));
+    out_queue->stride = stride;
+    out_queue->capacity = 1;
+    while (out_queue->capacity < capacity) {
+        out_queue->capacity *= 2;
+    }
+    out_queue->block = kallocate_with_flags((u64)stride * out_queue->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+    katomic_store_u64(&out_queue->tail, 0);
+    katomic_store_u64(&out_queue->head, 0);
+    return true;
+}
+
+void spsc_queue_destroy(spsc_queue* queue) {
+    if (queue) {
+        if (queue->block) {
+            kfree_with_flags(queue->block, (u64)queue->stride * queue->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+        }
+        kzero_memory(queue, sizeof(spsc_queue));
+    }
+}
+
+b8 spsc_queue_enqueue(spsc_queue* queue, const void* value) {
+    if (!queue || !value) {
+        KERROR("spsc_queue_enqueue requires valid pointers to queue and value.");
+        return false;
+    }
+
+    // Only this thread writes the tail, so it can be read without ordering.
+    u64 tail = katomic_load_relaxed_u64(&queue->tail);
+    if (tail - queue->cached_head == queue->capacity) {
+        queue->cached_head = katomic_load_acquire_u64(&queue->head);
+        if (tail - queue->cached_head == queue->capacity) {
+            return false;
+        }
+    }
+
+    kcopy_memory(element_at(queue, tail), value, queue->stride);
+    // Publish the element along with the new tail.
+    katomic_store_release_u64(&queue->tail, tail + 1);
+    return true;
+}
+
+// Returns true if an element is available at the head, refreshing the cached tail if needed.
+KINLINE b8 has_element(spsc_queue* queue, u64 head) {
+    if (head == queue->cached_tail) {
+        queue->cached_tail = katomic_load_acquire_u64(&queue->tail);
+        return head != queue->cached_tail;
+    }
+    return true;
+}
+
+b8 spsc_queue_dequeue(spsc_queue* queue, void* out_value) {
+    if (!queue || !out_value) {
+        KERROR("spsc_queue_dequeue requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    u64 head = katomic_load_relaxed_u64(&queue->head);
+    if (!has_element(queue, head)) {
+        return false;
+    }
+
+    kcopy_memory(out_value, element_at(queue, head), queue->stride);
+    // Hand the slot back to the producer only once it has been read.
+    katomic_store_release_u64(&queue->head, head + 1);
+    return true;
+}
+
+b8 spsc_queue_peek(spsc_queue* queue, void* out_value) {
+    if (!queue || !out_value) {
+        KERROR("spsc_queue_peek requires valid pointers to queue and out_value.");
+        return false;
+    }
+
+    u64 head = katomic_load_relaxed_u64(&queue->head);
+    if (!has_element(queue, head)) {
+        return false;
+    }
+
+    kcopy_memory(out_value, element_at(queue, head), queue->stride);
+    return true;
+}
+
+u32 spsc_queue_length(spsc_queue* queue) {
+    if (!queue) {
+        return 0;
+    }
+    u64 head = katomic_load_acquire_u64(&queue->head);
+    u64 tail = katomic_load_acquire_u64(&queue->tail);
+    return tail > head ? (u32)(tail - head) : 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A bounded, lock-free first in, first out queue for exactly one producing thread
+ * and one consuming thread, such as a worker handing results to the main thread. Does not
+ * resize dynamically.
+ *
+ * Each side only writes its own position and keeps a cached copy of the other side's, so
+ * the shared positions are only read when the queue appears full or empty. This makes it
+ * cheaper than mpmc_queue where there is a single thread on each side.
+ * Members should not be modified outside the functions below.
+ */
+typedef struct spsc_queue {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of two. */
+    u32 capacity;
+    /** @brief The block of memory holding the elements. */
+    void* block;
+
+    // Each side's values are kept on their own cache line.
+    u8 pad0[KCACHE_LINE_SIZE];
+    /** @brief The position the next element is enqueued at. Written by the producer. */
+    volatile u64 tail;
+    /** @brief The producer's last seen value of head. */
+    u64 cached_head;
+    u8 pad1[KCACHE_LINE_SIZE - sizeof(u64) * 2];
+    /** @brief The position the next element is dequeued from. Written by the consumer. */
+    volatile u64 head;
+    /** @brief The consumer's last seen value of tail. */
+    u64 cached_tail;
+    u8 pad2[KCACHE_LINE_SIZE - sizeof(u64) * 2];
+} spsc_queue;
+
+/**
+ * @brief Creates a new queue of the given stride, with room for at least the given number
+ * of elements. Should not be used by other threads until this returns.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The minimum number of elements to be available. Rounded up to a power of two.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 spsc_queue_create(u32 stride, u32 capacity, spsc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue, freeing its memory. No other thread may be using it.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void spsc_queue_destroy(spsc_queue* queue);
+
+/**
+ * @brief Adds a copy of value to the queue, if space is available. Must only be called
+ * from the producing thread.
+ *
+ * @param queue A pointer to the queue to add data to.
+ * @param value A pointer to the value to be copied.
+ * @return True on success; false if the queue is full.
+ */
+KAPI b8 spsc_queue_enqueue(spsc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to remove the next value from the queue. Must only be called from the
+ * consuming thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True on success; false if the queue is empty.
+ */
+KAPI b8 spsc_queue_dequeue(spsc_queue* queue, void* out_value);
+
+/**
+ * @brief Attempts to retrieve, but not remove, the next value in the queue. Must only be
+ * called from the consuming thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True on success; false if the queue is empty.
+ */
+KAPI b8 spsc_queue_peek(spsc_queue* queue, void* out_value);
+
+/**
+ * @brief Obtains the number of elements in the queue. While the other side is using the
+ * queue, this is only an estimate.
+ *
+ * @param queue A pointer to the queue.
+ * @return The number of elements in the queue.
+ */
+KAPI u32 spsc_queue_length(spsc_queue* queue);
@@ -0,0 +1,245 @@
+#include "u64_map.h"
+
+#include "core/kmemory.h"
+#include "core/khash.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+
+// MSVC does not define __SSE2__, but SSE2 is always available on x64.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define U64_MAP_USE_SSE2 1
+#endif
+
+// Control byte values. Full slots hold the low 7 bits of their key's hash, so only
+// the empty and deleted markers have the high bit set.
+#define CTRL_EMPTY 0x80
+#define CTRL_DELETED 0xFE
+
+// Groups may be filled to 7/8 of their slots before the map grows.
+#define U64_MAP_MAX_LOAD_EIGHTHS 7
+
+// Returns a bitmask of the slots in the group whose control byte equals the given value.
+KINLINE u32 group_match(const u8* ctrl, u8 value) {
+#if U64_MAP_USE_SSE2
+    __m128i group = _mm_load_si128((const __m128i*)ctrl);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < U64_MAP_GROUP_SIZE; ++i) {
+        mask |= (u32)(ctrl[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+// Returns a bitmask of the slots in the group which are empty or deleted.
+KINLINE u32 group_match_free(const u8* ctrl) {
+#if U64_MAP_USE_SSE2
+    return (u32)_mm_movemask_epi8(_mm_load_si128((const __m128i*)ctrl));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < U64_MAP_GROUP_SIZE; ++i) {
+        mask |= (u32)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static u64 block_size(u64 element_size, u32 slot_count) {
+    return (1 + sizeof(u64) + element_size) * slot_count;
+}
+
+static u32 max_entries(u32 slot_count) {
+    return slot_count / 8 * U64_MAP_MAX_LOAD_EIGHTHS;
+}
+
+static void allocate_slots(u64_map* map, u32 slot_count) {
+    // Control bytes come first, so that groups are aligned for vector loads.
+    void* block = kallocate_aligned(block_size(map->element_size, slot_count), U64_MAP_GROUP_SIZE, MEMORY_TAG_DICT);
+    map->slot_count = slot_count;
+    map->entry_count = 0;
+    map->growth_left = max_entries(slot_count);
+    map->ctrl = block;
+    map->keys = (u64*)(map->ctrl + slot_count);
+    map->values = (u8*)(map->keys + slot_count);
+    kset_memory(map->ctrl, CTRL_EMPTY, slot_count);
+}
+
+/**
+ * Probes groups in triangular order (1, 2, 3... groups apart), which visits every group
+ * once when the group count is a power of two. A key can only have been placed beyond a
+ * group with no empty slot, so the search for it ends at the first group that has one.
+ */
+static u32 find_slot(const u64_map* map, u64 key, u64 hash) {
+    u8 h2 = (u8)(hash & 0x7F);
+    u32 group_mask = map->slot_count / U64_MAP_GROUP_SIZE - 1;
+    u32 group = (u32)(hash >> 7) & group_mask;
+    for (u32 probe = 0; probe <= group_mask; ++probe) {
+        const u8* ctrl = map->ctrl + group * U64_MAP_GROUP_SIZE;
+        u32 match = group_match(ctrl, h2);
+        while (match) {
+            u32 slot = group * U64_MAP_GROUP_SIZE + count_trailing_zeros_u32(match);
+            if (map->keys[slot] == key) {
+                return slot;
+            }
+            match &= match - 1;
+        }
+        if (group_match(ctrl, CTRL_EMPTY)) {
+            return INVALID_ID;
+        }
+        group = (group + probe + 1) & group_mask;
+    }
+    return INVALID_ID;
+}
+
+// Finds the first empty or deleted slot along the probe sequence of the given hash.
+static u32 find_free_slot(const u64_map* map, u64 hash) {
+    u32 group_mask = map->slot_count / U64_MAP_GROUP_SIZE - 1;
+    u32 group = (u32)(hash >> 7) & group_mask;
+    for (u32 probe = 0;; ++probe) {
+        u32 match = group_match_free(map->ctrl + group * U64_MAP_GROUP_SIZE);
+        if (match) {
+            return group * U64_MAP_GROUP_SIZE + count_trailing_zeros_u32(match);
+        }
+        group = (group + probe + 1) & group_mask;
+    }
+}
+
+// Places an entry for a key not in the map. There must be a free slot.
+static u32 insert_slot(u64_map* map, u64 key, u64 hash) {
+    u32 slot = find_free_slot(map, hash);
+    if (map->ctrl[slot] == CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    map->ctrl[slot] = (u8)(hash & 0x7F);
+    map->keys[slot] = key;
+    map->entry_count++;
+    return slot;
+}
+
+/**
+ * Moves all entries into a new set of slots. Deleted slots still count against the load,
+ * so if many entries have been removed the map is rehashed at the same size instead.
+ */
+static void resize(u64_map* map, u32 slot_count) {
+    u8* old_ctrl = map->ctrl;
+    u64* old_keys = map->keys;
+    u8* old_values = map->values;
+    u32 old_count = map->slot_count;
+
+    allocate_slots(map, slot_count);
+    for (u32 i = 0; i < old_count; ++i) {
+        if (!(old_ctrl[i] & CTRL_EMPTY)) {
+            u32 slot = insert_slot(map, old_keys[i], khash_u64(old_keys[i]));
+            kcopy_memory(map->values + map->element_size * slot, old_values + map->element_size * i, map->element_size);
+        }
+    }
+
+    kfree_aligned(old_ctrl, block_size(map->element_size, old_count), U64_MAP_GROUP_SIZE, MEMORY_TAG_DICT);
+}
+
+b8 u64_map_create(u64 element_size, u32 element_count, u64_map* out_map) {
+    if (!out_map) {
+        KERROR("u64_map_create requires a valid pointer to hold the map.");
+        return false;
+    }
+    if (!element_size) {
+        KERROR("u64_map_create requires a non-zero element_size.");
+        return false;
+    }
+
+    u32 slot_count = U64_MAP_GROUP_SIZE;
+    while (max_entries(slot_count) < element_count) {
+        slot_count *= 2;
+    }
+
+    out_map->element_size = element_size;
+    allocate_slots(out_map, slot_count);
+    return true;
+}
+
+void u64_map_destroy(u64_map* map) {
+    if (map) {
+        if (map->ctrl) {
+            kfree_aligned(map->ctrl, block_size(map->element_size, map->slot_count), U64_MAP_GROUP_SIZE, MEMORY_TAG_DICT);
+        }
+        kzero_memory(map, sizeof(u64_map));
+    }
+}
+
+b8 u64_map_set(u64_map* map, u64 key, const void* value) {
+    if (!map || !value) {
+        KERROR("u64_map_set requires a valid map and value.");
+        return false;
+    }
+
+    u64 hash = khash_u64(key);
+    u32 slot = find_slot(map, key, hash);
+    if (slot == INVALID_ID) {
+        if (!map->growth_left) {
+            // Grow if mostly full of entries, otherwise just clear out deleted slots.
+            u32 slot_count = map->entry_count * 2 >= max_entries(map->slot_count) ? map->slot_count * 2 : map->slot_count;
+            resize(map, slot_count);
+        }
+        slot = insert_slot(map, key, hash);
+    }
+    kcopy_memory(map->values + map->element_size * slot, value, map->element_size);
+    return true;
+}
+
+b8 u64_map_get(const u64_map* map, u64 key, void* out_value) {
+    if (!map || !out_value) {
+        KERROR("u64_map_get requires a valid map and out_value.");
+        return false;
+    }
+
+    u32 slot = find_slot(map, key, khash_u64(key));
+    if (slot == INVALID_ID) {
+        return false;
+    }
+    kcopy_memory(out_value, map->values + map->element_size * slot, map->element_size);
+    return true;
+}
+
+void* u64_map_get_ptr(const u64_map* map, u64 key) {
+    if (!map) {
+        KERROR("u64_map_get_ptr requires a valid map.");
+        return 0;
+    }
+
+    u32 slot = find_slot(map, key, khash_u64(key));
+    return slot == INVALID_ID ? 0 : map->values + map->element_size * slot;
+}
+
+b8 u64_map_remove(u64_map* map, u64 key) {
+    if (!map) {
+        KERROR("u64_map_remove requires a valid map.");
+        return false;
+    }
+
+    u32 slot = find_slot(map, key, khash_u64(key));
+    if (slot == INVALID_ID) {
+        return false;
+    }
+
+    // If the group still has an empty slot, no probe has ever passed over it, so the slot
+    // can be made empty again. Otherwise it must be marked deleted to keep probes going.
+    u8* group_ctrl = map->ctrl + (slot & ~(U64_MAP_GROUP_SIZE - 1));
+    if (group_match(group_ctrl, CTRL_EMPTY)) {
+        map->ctrl[slot] = CTRL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->ctrl[slot] = CTRL_DELETED;
+    }
+    map->entry_count--;
+    return true;
+}
+
+void u64_map_clear(u64_map* map) {
+    if (map && map->ctrl) {
+        kset_memory(map->ctrl, CTRL_EMPTY, map->slot_count);
+        map->entry_count = 0;
+        map->growth_left = max_entries(map->slot_count);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A hash map keyed by 64-bit integers, such as ids, handles or precomputed
+ * name hashes. Values of a fixed size are stored inline, alongside their keys.
+ *
+ * Slots are arranged in groups of U64_MAP_GROUP_SIZE, each with a control byte
+ * holding 7 bits of the key's hash (or marking the slot empty or deleted). A lookup
+ * checks a whole group's control bytes at once (with SSE2 where available), and
+ * only compares keys for slots whose control byte matches. The map grows as entries
+ * are added. Members should not be modified outside the functions below.
+ */
+typedef struct u64_map {
+    /** @brief The size of each value in bytes. */
+    u64 element_size;
+    /** @brief The number of slots in the map. Always a power of two, and at least one group. */
+    u32 slot_count;
+    /** @brief The number of entries currently held in the map. */
+    u32 entry_count;
+    /** @brief The number of empty slots which may be filled before the map must grow or be rehashed. */
+    u32 growth_left;
+    /** @brief The control byte of each slot. Also the start of the internally allocated block. */
+    u8* ctrl;
+    /** @brief The key of each slot. */
+    u64* keys;
+    /** @brief The value of each slot. */
+    u8* values;
+} u64_map;
+
+/** @brief The number of slots whose control bytes are checked together. */
+#define U64_MAP_GROUP_SIZE 16
+
+/**
+ * @brief Creates a new map.
+ *
+ * @param element_size The size of each value in bytes.
+ * @param element_count The number of entries to make room for up front. The map grows beyond this as needed.
+ * @param out_map A pointer to hold the newly created map.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 u64_map_create(u64 element_size, u32 element_count, u64_map* out_map);
+
+/**
+ * @brief Destroys the given map, freeing its internal memory.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void u64_map_destroy(u64_map* map);
+
+/**
+ * @brief Stores a copy of the given value for the given key, replacing any existing value.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key of the entry.
+ * @param value A pointer to the value to be copied. Required.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 u64_map_set(u64_map* map, u64 key, const void* value);
+
+/**
+ * @brief Obtains a copy of the value stored for the given key.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key of the entry.
+ * @param out_value A pointer to hold a copy of the value. Left unchanged if the entry does not exist.
+ * @return True if the entry exists; otherwise false.
+ */
+KAPI b8 u64_map_get(const u64_map* map, u64 key, void* out_value);
+
+/**
+ * @brief Obtains a pointer to the value stored for the given key, which may be modified in
+ * place. The pointer is only valid until the next entry is added to or removed from the map.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key of the entry.
+ * @return A pointer to the value if the entry exists; otherwise 0.
+ */
+KAPI void* u64_map_get_ptr(const u64_map* map, u64 key);
+
+/**
+ * @brief Removes the entry for the given key, if it exists.
+ *
+ * @param map A pointer to the map. Required.
+ * @param key The key of the entry.
+ * @return True if the entry existed and was removed; otherwise false.
+ */
+KAPI b8 u64_map_remove(u64_map* map, u64 key);
+
+/**
+ * @brief Removes all entries from the map, keeping its memory.
+ *
+ * @param map A pointer to the map. Required.
+ */
+KAPI void u64_map_clear(u64_map* map);
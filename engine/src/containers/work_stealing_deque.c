@@ -0,0 +1,128 @@
+#include "work_stealing_deque.h"
+
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+/**
+ * Positions only ever increase, and are wrapped into the block by the capacity. An element
+ * is only overwritten once top has moved past it, so a thief which reads an element and
+ * then wins the compare-exchange on top knows the copy it read was whole.
+ */
+KINLINE void* element_at(const work_stealing_deque* deque, u64 position) {
+    return (u8*)deque->block + (position & (deque->capacity - 1)) * deque->stride;
+}
+
+b8 work_stealing_deque_create(u32 stride, u32 capacity, work_stealing_deque* out_deque) {
+    if (!out_deque) {
+        KERROR("work_stealing_deque_create requires a valid pointer to hold the deque.");
+        return false;
+    }
+    if (!stride || !capacity) {
+        KERROR("work_stealing_deque_create requires a non-zero stride and capacity.");
+        return false;
+    }
+
+    kzero_memory(out_deque, sizeof(work_stealing_deque));
+    out_deque->stride = stride;
+    out_deque->capacity = 1;
+    while (out_deque->capacity < capacity) {
+        out_deque->capacity *= 2;
+    }
+    out_deque->block = kallocate_with_flags((u64)stride * out_deque->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+
+    // Publish the positions before any other thread is handed the deque.
+    katomic_store_u64(&out_deque->top, 0);
+    katomic_store_u64(&out_deque->bottom, 0);
+    return true;
+}
+
+void work_stealing_deque_destroy(work_stealing_deque* deque) {
+    if (deque) {
+        if (deque->block) {
+            kfree_with_flags(deque->block, (u64)deque->stride * deque->capacity, KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE, KALLOCATE_FLAG_UNINITIALIZED);
+        }
+        kzero_memory(deque, sizeof(work_stealing_deque));
+    }
+}
+
+b8 work_stealing_deque_push(work_stealing_deque* deque, const void* value) {
+    if (!deque || !value) {
+        KERROR("work_stealing_deque_push requires valid pointers to deque and value.");
+        return false;
+    }
+
+    u64 bottom = katomic_load_relaxed_u64(&deque->bottom);
+    u64 top = katomic_load_acquire_u64(&deque->top);
+    // A stale top only makes the deque seem fuller than it is.
+    if (bottom - top >= deque->capacity) {
+        return false;
+    }
+
+    kcopy_memory(element_at(deque, bottom), value, deque->stride);
+    katomic_store_release_u64(&deque->bottom, bottom + 1);
+    return true;
+}
+
+b8 work_stealing_deque_pop(work_stealing_deque* deque, void* out_value) {
+    if (!deque || !out_value) {
+        KERROR("work_stealing_deque_pop requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    // Reserve the bottom element before looking at top, so that a thief either sees the
+    // reservation or is seen by the owner. The fence keeps the store before the load.
+    u64 bottom = katomic_load_relaxed_u64(&deque->bottom) - 1;
+    katomic_store_u64(&deque->bottom, bottom);
+    katomic_thread_fence();
+    u64 top = katomic_load_u64(&deque->top);
+
+    i64 remaining = (i64)(bottom - top);
+    if (remaining < 0) {
+        // Empty, so undo the reservation.
+        katomic_store_u64(&deque->bottom, bottom + 1);
+        return false;
+    }
+
+    kcopy_memory(out_value, element_at(deque, bottom), deque->stride);
+    if (remaining > 0) {
+        // More than one element was left, so no thief can reach this one.
+        return true;
+    }
+
+    // The last element, which a thief may be taking at the same time. Whoever moves top wins it.
+    b8 won = katomic_compare_exchange_u64(&deque->top, &top, top + 1);
+    katomic_store_u64(&deque->bottom, bottom + 1);
+    return won;
+}
+
+b8 work_stealing_deque_steal(work_stealing_deque* deque, void* out_value, pfn_deque_steal_filter filter, void* user_data) {
+    if (!deque || !out_value) {
+        KERROR("work_stealing_deque_steal requires valid pointers to deque and out_value.");
+        return false;
+    }
+
+    u64 top = katomic_load_acquire_u64(&deque->top);
+    katomic_thread_fence();
+    u64 bottom = katomic_load_acquire_u64(&deque->bottom);
+    if ((i64)(bottom - top) <= 0) {
+        return false;
+    }
+
+    // Copy first; the copy is only kept if top can be claimed afterward.
+    kcopy_memory(out_value, element_at(deque, top), deque->stride);
+    if (filter && !filter(out_value, user_data)) {
+        return false;
+    }
+    return katomic_compare_exchange_u64(&deque->top, &top, top + 1);
+}
+
+u32 work_stealing_deque_length(work_stealing_deque* deque) {
+    if (!deque) {
+        return 0;
+    }
+    // Read top first so that, in a racing moment, the estimate errs on the high side.
+    u64 top = katomic_load_acquire_u64(&deque->top);
+    u64 bottom = katomic_load_acquire_u64(&deque->bottom);
+    return (i64)(bottom - top) > 0 ? (u32)(bottom - top) : 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Decides whether a value may be stolen, i.e. whether the stealing thread is able
+ * to handle it. Values which are refused are left in the deque.
+ *
+ * @param value A pointer to a copy of the value.
+ * @param user_data The user data passed to work_stealing_deque_steal.
+ */
+typedef b8 (*pfn_deque_steal_filter)(const void* value, void* user_data);
+
+/**
+ * @brief A bounded, lock-free double-ended queue owned by a single thread, which pushes
+ * and pops at the bottom, while any number of other threads steal from the top
+ * (a Chase-Lev deque). Does not resize dynamically.
+ *
+ * The owner works last in, first out, on what it most recently pushed and so is most likely
+ * to be in its cache, and only contends with thieves when a single value remains. Thieves
+ * take the oldest values, which for work split recursively tend to be the largest.
+ * Members should not be modified outside the functions below.
+ */
+typedef struct work_stealing_deque {
+    /** @brief The size of each element in bytes. */
+    u32 stride;
+    /** @brief The total number of elements available. Always a power of two. */
+    u32 capacity;
+    /** @brief The block of memory holding the elements. */
+    void* block;
+
+    // The positions are written by different threads, so each is kept on its own cache line.
+    u8 pad0[KCACHE_LINE_SIZE];
+    /** @brief The position of the oldest element, which is the next to be stolen. */
+    volatile u64 top;
+    u8 pad1[KCACHE_LINE_SIZE - sizeof(u64)];
+    /** @brief The position the next element is pushed at. Written only by the owner. */
+    volatile u64 bottom;
+    u8 pad2[KCACHE_LINE_SIZE - sizeof(u64)];
+} work_stealing_deque;
+
+/**
+ * @brief Creates a new deque of the given stride, with room for at least the given number
+ * of elements. Should not be used by other threads until this returns.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The minimum number of elements to be available. Rounded up to a power of two.
+ * @param out_deque A pointer to hold the newly created deque.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 work_stealing_deque_create(u32 stride, u32 capacity, work_stealing_deque* out_deque);
+
+/**
+ * @brief Destroys the given deque, freeing its memory. No other thread may be using it.
+ *
+ * @param deque A pointer to the deque to destroy.
+ */
+KAPI void work_stealing_deque_destroy(work_stealing_deque* deque);
+
+/**
+ * @brief Adds a copy of value to the bottom of the deque, if space is available.
+ * Only to be called by the owning thread.
+ *
+ * @param deque A pointer to the deque to add data to.
+ * @param value A pointer to the value to be copied.
+ * @return True on success; false if the deque is full.
+ */
+KAPI b8 work_stealing_deque_push(work_stealing_deque* deque, const void* value);
+
+/**
+ * @brief Attempts to remove the most recently pushed value from the bottom of the deque.
+ * Only to be called by the owning thread.
+ *
+ * @param deque A pointer to the deque to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True on success; false if the deque is empty.
+ */
+KAPI b8 work_stealing_deque_pop(work_stealing_deque* deque, void* out_value);
+
+/**
+ * @brief Attempts to remove the oldest value from the top of the deque. Safe to call from
+ * any thread. May fail spuriously if another thread takes the value first.
+ *
+ * @param deque A pointer to the deque to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value. Its contents are undefined if this fails.
+ * @param filter A function which may refuse the value, leaving it in the deque. Optional.
+ * @param user_data Passed to filter.
+ * @return True on success; false if the deque is empty, the value was refused, or another thread took it.
+ */
+KAPI b8 work_stealing_deque_steal(work_stealing_deque* deque, void* out_value, pfn_deque_steal_filter filter, void* user_data);
+
+/**
+ * @brief Obtains the number of elements in the deque. While other threads are using the
+ * deque, this is only an estimate, which may be out of date as soon as it is returned.
+ *
+ * @param deque A pointer to the deque.
+ * @return The number of elements in the deque.
+ */
+KAPI u32 work_stealing_deque_length(work_stealing_deque* deque);
@@ -8,8 +8,10 @@
 #include "core/event.h"
 #include "core/input.h"
 #include "core/clock.h"
+#include "core/kname.h"
 
 #include "memory/linear_allocator.h"
+#include "memory/scratch_allocator.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -41,6 +43,16 @@ typedef struct application_state {
     f64 last_time;
     linear_allocator systems_allocator;
 
+    // Double-buffered allocators for transient per-frame data, such as render packets.
+    // The one in use is reset at the start of each frame, leaving the previous frame's
+    // data intact until the frame after.
+    linear_allocator frame_allocators[2];
+    u8 frame_allocator_index;
+    // The number of kallocate calls made during the last frame. Zero once steady.
+    u64 frame_allocation_count;
+    // The most a frame has needed beyond the frame allocator, so it is only warned about when it grows.
+    u64 frame_overflow_high_water;
+
     u64 event_system_memory_requirement;
     void* event_system_state;
 
@@ -53,6 +65,9 @@ typedef struct application_state {
     u64 input_system_memory_requirement;
     void* input_system_state;
 
+    u64 kname_system_memory_requirement;
+    void* kname_system_state;
+
     u64 platform_system_memory_requirement;
     void* platform_system_state;
 
@@ -80,6 +95,11 @@ typedef struct application_state {
     u64 camera_system_memory_requirement;
     void* camera_system_state;
 
+    // Names of the views built each frame, so they need not be hashed every time.
+    kname skybox_view_name;
+    kname world_view_name;
+    kname ui_view_name;
+
     // TODO: temp
     skybox sb;
     // darray
@@ -153,7 +173,9 @@ b8 application_create(game* game_inst) {
 
     // Memory system must be the first thing to be stood up.
     memory_system_configuration memory_system_config = {};
-    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    // The heap grows in chunks of this size as needed, so this need not cover the largest scene.
+    memory_system_config.total_alloc_size = MEBIBYTES(256);
+    memory_system_config.chunk_size = MEBIBYTES(256);
     if (!memory_system_initialize(memory_system_config)) {
         KERROR("Failed to initialize memory system; shutting down.");
         return false;
@@ -176,6 +198,21 @@ b8 application_create(game* game_inst) {
     u64 systems_allocator_total_size = 64 * 1024 * 1024;  // 64 mb
     linear_allocator_create(systems_allocator_total_size, 0, &app_state->systems_allocator);
 
+    // Frame allocators, carved from the systems allocator. Anything which does not fit
+    // overflows to the memory system, and so shows up in the frame allocation count.
+    u64 frame_allocator_total_size = game_inst->app_config.frame_allocator_size;
+    if (frame_allocator_total_size == 0) {
+        frame_allocator_total_size = 1 * 1024 * 1024;  // 1 mb each
+    }
+    for (u32 i = 0; i < 2; ++i) {
+        void* frame_allocator_block = linear_allocator_allocate(&app_state->systems_allocator, frame_allocator_total_size);
+        linear_allocator_create(frame_allocator_total_size, frame_allocator_block, &app_state->frame_allocators[i]);
+        app_state->frame_allocators[i].allow_overflow = true;
+    }
+    app_state->frame_allocator_index = 0;
+    app_state->frame_allocation_count = 0;
+    app_state->frame_overflow_high_water = 0;
+
     // Initialize Other subsystems.
 
     // Events
@@ -196,6 +233,14 @@ b8 application_create(game* game_inst) {
     app_state->input_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->input_system_memory_requirement);
     input_system_initialize(&app_state->input_system_memory_requirement, app_state->input_system_state);
 
+    // Names
+    kname_system_initialize(&app_state->kname_system_memory_requirement, 0);
+    app_state->kname_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->kname_system_memory_requirement);
+    if (!kname_system_initialize(&app_state->kname_system_memory_requirement, app_state->kname_system_state)) {
+        KERROR("Failed to initialize name system; shutting down.");
+        return false;
+    }
+
     // Register for engine-level events.
     event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
@@ -394,6 +439,10 @@ b8 application_create(game* game_inst) {
         return false;
     }
 
+    app_state->skybox_view_name = kname_create(skybox_config.name);
+    app_state->world_view_name = kname_create(opaque_world_config.name);
+    app_state->ui_view_name = kname_create(ui_view_config.name);
+
     // TODO: temp 
     // Skybox
     texture_map* cube_map = &app_state->sb.cubemap;
@@ -557,6 +606,18 @@ b8 application_run() {
             f64 current_time = app_state->clock.elapsed;
             f64 delta = (current_time - app_state->last_time);
             f64 frame_start_time = platform_get_absolute_time();
+            u64 frame_start_alloc_count = get_memory_total_alloc_count();
+            kmemory_trace_frame_mark();
+
+            // Switch to the other frame allocator, discarding what it held two frames ago.
+            app_state->frame_allocator_index ^= 1;
+            linear_allocator* frame_allocator = &app_state->frame_allocators[app_state->frame_allocator_index];
+            if (frame_allocator->overflow_allocated > app_state->frame_overflow_high_water) {
+                app_state->frame_overflow_high_water = frame_allocator->overflow_allocated;
+                KWARN("Frame allocator overflowed by %lluB. Consider raising application_config.frame_allocator_size above %lluB.",
+                      frame_allocator->overflow_allocated, frame_allocator->total_size);
+            }
+            linear_allocator_free_all(frame_allocator);
 
             // Update the job system.
             job_system_update();
@@ -590,14 +651,17 @@ b8 application_run() {
 
             // TODO: Read from frame config.
             packet.view_count = 3;
-            render_view_packet views[3];
-            kzero_memory(views, sizeof(render_view_packet) * packet.view_count);
-            packet.views = views;
+            // NOTE: Frame allocator memory is already zeroed.
+            packet.views = linear_allocator_allocate(frame_allocator, sizeof(render_view_packet) * packet.view_count);
+            if (!packet.views) {
+                KERROR("Failed to allocate render view packets.");
+                return false;
+            }
 
             // Skybox
             skybox_packet_data skybox_data = {};
             skybox_data.sb = &app_state->sb;
-            if (!render_view_system_build_packet(render_view_system_get("skybox"), &skybox_data, &packet.views[0])) {
+            if (!render_view_system_build_packet(render_view_system_get_kname(app_state->skybox_view_name), frame_allocator, &skybox_data, &packet.views[0])) {
                 KERROR("Failed to build packet for view 'skybox'.");
                 return false;
             }
@@ -617,8 +681,7 @@ b8 application_run() {
             world_mesh_data.mesh_count = mesh_count;
             world_mesh_data.meshes = meshes;
 
-            // TODO: performs a lookup on every frame.
-            if (!render_view_system_build_packet(render_view_system_get("world_opaque"), &world_mesh_data, &packet.views[1])) {
+            if (!render_view_system_build_packet(render_view_system_get_kname(app_state->world_view_name), frame_allocator, &world_mesh_data, &packet.views[1])) {
                 KERROR("Failed to build packet for view 'world_opaque'.");
                 return false;
             }
@@ -640,7 +703,7 @@ b8 application_run() {
             ui_mesh_data.mesh_count = ui_mesh_count;
             ui_mesh_data.meshes = ui_meshes;
             
-            if (!render_view_system_build_packet(render_view_system_get("ui"), &ui_mesh_data, &packet.views[2])) {
+            if (!render_view_system_build_packet(render_view_system_get_kname(app_state->ui_view_name), frame_allocator, &ui_mesh_data, &packet.views[2])) {
                 KERROR("Failed to build packet for view 'ui'.");
                 return false;
             }
@@ -655,6 +718,8 @@ b8 application_run() {
             }
             // TODO: end temp
 
+            app_state->frame_allocation_count = get_memory_total_alloc_count() - frame_start_alloc_count;
+
             // Figure out how long the frame took and, if below
             f64 frame_end_time = platform_get_absolute_time();
             f64 frame_elapsed_time = frame_end_time - frame_start_time;
@@ -686,6 +751,12 @@ b8 application_run() {
 
     app_state->is_running = false;
 
+    // Keep any trace still being recorded.
+    if (kmemory_trace_is_active()) {
+        kmemory_trace_stop();
+        kmemory_trace_write("memory_trace.csv");
+    }
+
     // Shutdown event system.
     event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
@@ -715,10 +786,15 @@ b8 application_run() {
 
     job_system_shutdown(app_state->job_system_state);
 
+    kname_system_shutdown(app_state->kname_system_state);
+
     platform_system_shutdown(app_state->platform_system_state);
 
     event_system_shutdown(app_state->event_system_state);
 
+    // Release any scratch memory used by loaders on this thread.
+    scratch_allocator_thread_shutdown();
+
     memory_system_shutdown();
 
     return true;
@@ -799,4 +875,8 @@ b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_con
 
     // Event purposely not handled to allow other listeners to get this.
     return false;
-}
\ No newline at end of file
+}
+
+u64 application_get_frame_allocation_count() {
+    return app_state ? app_state->frame_allocation_count : 0;
+}
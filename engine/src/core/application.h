@@ -20,6 +20,10 @@ typedef struct application_config {
 
     // The application name used in windowing, if applicable.
     char* name;
+
+    // The size in bytes of each of the two per-frame allocators. 0 uses the default of 1 MiB.
+    // Frames which need more still work, but fall back to the memory system for the rest.
+    u64 frame_allocator_size;
 } application_config;
 
 
@@ -27,4 +31,11 @@ KAPI b8 application_create(struct game* game_inst);
 
 KAPI b8 application_run();
 
-void application_get_framebuffer_size(u32* width, u32* height);
\ No newline at end of file
+void application_get_framebuffer_size(u32* width, u32* height);
+
+/**
+ * @brief Returns the number of allocations made through the memory system during the
+ * last completed frame. Steady-state frames should make none, since transient per-frame
+ * data comes from the frame allocator instead.
+ */
+KAPI u64 application_get_frame_allocation_count();
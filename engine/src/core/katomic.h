@@ -0,0 +1,173 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Thin wrappers around the compiler's atomic intrinsics. All of these are
+ * sequentially consistent unless noted otherwise, which is the safest (if
+ * not always the fastest) ordering. Both clang and GCC provide these
+ * builtins on every platform the engine targets.
+ */
+
+/**
+ * @brief Atomically adds value to the target.
+ * @param target A pointer to the value to be modified.
+ * @param value The amount to add.
+ * @returns The value held by target before the addition.
+ */
+KINLINE u64 katomic_fetch_add_u64(volatile u64* target, u64 value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically subtracts value from the target.
+ * @param target A pointer to the value to be modified.
+ * @param value The amount to subtract.
+ * @returns The value held by target before the subtraction.
+ */
+KINLINE u64 katomic_fetch_sub_u64(volatile u64* target, u64 value) {
+    return __atomic_fetch_sub(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically loads the value held by target.
+ * @param target A pointer to the value to be loaded.
+ * @returns The loaded value.
+ */
+KINLINE u64 katomic_load_u64(volatile u64* target) {
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically stores value in the target.
+ * @param target A pointer to the value to be overwritten.
+ * @param value The value to be stored.
+ */
+KINLINE void katomic_store_u64(volatile u64* target, u64 value) {
+    __atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replaces the target with desired if it currently holds expected.
+ * @param target A pointer to the value to be modified.
+ * @param expected A pointer to the expected value. Overwritten with the current value on failure.
+ * @param desired The value to store on success.
+ * @returns True if the exchange happened; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u64(volatile u64* target, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replaces the value held by target.
+ * @param target A pointer to the value to be overwritten.
+ * @param value The value to be stored.
+ * @returns The value held by target before the exchange.
+ */
+KINLINE u64 katomic_exchange_u64(volatile u64* target, u64 value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically adds value to the target.
+ * @param target A pointer to the value to be modified.
+ * @param value The amount to add.
+ * @returns The value held by target before the addition.
+ */
+KINLINE u32 katomic_fetch_add_u32(volatile u32* target, u32 value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically subtracts value from the target.
+ * @param target A pointer to the value to be modified.
+ * @param value The amount to subtract.
+ * @returns The value held by target before the subtraction.
+ */
+KINLINE u32 katomic_fetch_sub_u32(volatile u32* target, u32 value) {
+    return __atomic_fetch_sub(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically loads the value held by target.
+ * @param target A pointer to the value to be loaded.
+ * @returns The loaded value.
+ */
+KINLINE u32 katomic_load_u32(volatile u32* target) {
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically stores value in the target.
+ * @param target A pointer to the value to be overwritten.
+ * @param value The value to be stored.
+ */
+KINLINE void katomic_store_u32(volatile u32* target, u32 value) {
+    __atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replaces the target with desired if it currently holds expected.
+ * @param target A pointer to the value to be modified.
+ * @param expected A pointer to the expected value. Overwritten with the current value on failure.
+ * @param desired The value to store on success.
+ * @returns True if the exchange happened; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u32(volatile u32* target, u32* expected, u32 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * The following variants take weaker orderings, for lock-free structures which
+ * only need to order a handful of accesses against each other. An acquire load
+ * sees everything written before the release store it reads from.
+ */
+
+/**
+ * @brief Atomically loads the value held by target, without ordering other accesses.
+ * @param target A pointer to the value to be loaded.
+ * @returns The loaded value.
+ */
+KINLINE u64 katomic_load_relaxed_u64(volatile u64* target) {
+    return __atomic_load_n(target, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Atomically loads the value held by target with acquire ordering.
+ * @param target A pointer to the value to be loaded.
+ * @returns The loaded value.
+ */
+KINLINE u64 katomic_load_acquire_u64(volatile u64* target) {
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically stores value in the target with release ordering.
+ * @param target A pointer to the value to be overwritten.
+ * @param value The value to be stored.
+ */
+KINLINE void katomic_store_release_u64(volatile u64* target, u64 value) {
+    __atomic_store_n(target, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Atomically replaces the target with desired if it currently holds expected, without
+ * ordering other accesses. May fail spuriously, so should be called in a loop.
+ * @param target A pointer to the value to be modified.
+ * @param expected A pointer to the expected value. Overwritten with the current value on failure.
+ * @param desired The value to store on success.
+ * @returns True if the exchange happened; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_weak_relaxed_u64(volatile u64* target, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Orders all memory accesses before the fence against all of those after it, for
+ * every thread which also uses a fence. Needed where a thread stores to one value and then
+ * loads another which a second thread stores to before loading the first, i.e. to make
+ * sure that at least one of the two threads sees the other's store.
+ */
+KINLINE void katomic_thread_fence() {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
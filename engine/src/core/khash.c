@@ -0,0 +1,101 @@
+#include "khash.h"
+
+#include "core/kstring.h"
+
+// TODO: Custom string lib
+#include <string.h>
+
+// Based on xxHash64, which is fast for both short keys such as names and long blocks.
+#define PRIME_1 0x9E3779B185EBCA87ULL
+#define PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME_3 0x165667B19E3779F9ULL
+#define PRIME_4 0x85EBCA77C2B2AE63ULL
+#define PRIME_5 0x27D4EB2F165667C5ULL
+
+KINLINE u64 rotate_left(u64 value, u32 bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Reads without alignment requirements. Compiles to a single load.
+KINLINE u64 read_u64(const u8* p) {
+    u64 value;
+    memcpy(&value, p, sizeof(u64));
+    return value;
+}
+
+KINLINE u32 read_u32(const u8* p) {
+    u32 value;
+    memcpy(&value, p, sizeof(u32));
+    return value;
+}
+
+KINLINE u64 round_value(u64 accumulator, u64 input) {
+    accumulator += input * PRIME_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * PRIME_1;
+}
+
+KINLINE u64 merge_round(u64 accumulator, u64 value) {
+    accumulator ^= round_value(0, value);
+    return accumulator * PRIME_1 + PRIME_4;
+}
+
+u64 khash_bytes(const void* data, u64 size, u64 seed) {
+    const u8* p = (const u8*)data;
+    const u8* end = p + size;
+    u64 hash;
+
+    if (size >= 32) {
+        // Four independent lanes, for longer inputs.
+        u64 v1 = seed + PRIME_1 + PRIME_2;
+        u64 v2 = seed + PRIME_2;
+        u64 v3 = seed;
+        u64 v4 = seed - PRIME_1;
+        const u8* limit = end - 32;
+        do {
+            v1 = round_value(v1, read_u64(p));
+            v2 = round_value(v2, read_u64(p + 8));
+            v3 = round_value(v3, read_u64(p + 16));
+            v4 = round_value(v4, read_u64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    } else {
+        hash = seed + PRIME_5;
+    }
+    hash += size;
+
+    // The remaining 0-31 bytes.
+    while (p + 8 <= end) {
+        hash ^= round_value(0, read_u64(p));
+        hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= (u64)read_u32(p) * PRIME_1;
+        hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * PRIME_5;
+        hash = rotate_left(hash, 11) * PRIME_1;
+        p++;
+    }
+
+    // Final avalanche.
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 khash_string(const char* str) {
+    return khash_bytes(str, string_length(str), 0);
+}
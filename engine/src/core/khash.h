@@ -0,0 +1,41 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * 64-bit, non-cryptographic hash functions, for use by hash-based containers.
+ * All bits of the results are well mixed, so tables may take the low bits of
+ * a hash as a slot index directly, and compare full hashes to rule out most
+ * key mismatches before comparing keys.
+ */
+
+/**
+ * @brief Hashes the given block of bytes.
+ * @param data A pointer to the data to be hashed.
+ * @param size The size of the data in bytes.
+ * @param seed A value to vary the hash by. Use 0 if unsure.
+ * @returns The 64-bit hash.
+ */
+KAPI u64 khash_bytes(const void* data, u64 size, u64 seed);
+
+/**
+ * @brief Hashes the given null-terminated string, excluding the terminator.
+ * @param str The string to be hashed.
+ * @returns The 64-bit hash.
+ */
+KAPI u64 khash_string(const char* str);
+
+/**
+ * @brief Mixes the bits of a single 64-bit value, such as an id or a pointer, so that
+ * all bits of the result depend on all bits of the input.
+ * @param value The value to be hashed.
+ * @returns The 64-bit hash.
+ */
+KINLINE u64 khash_u64(u64 value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
@@ -3,18 +3,72 @@
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmutex.h"
+#include "core/katomic.h"
+#include "core/kthread.h"
 #include "platform/platform.h"
+#include "platform/filesystem.h"
 #include "memory/dynamic_allocator.h"
 
 // TODO: Custom string lib
 #include <string.h>
 #include <stdio.h>
 
+// The callsite macros are for callers of this system, not its implementation.
+#if KMEMORY_TRACE_ENABLED == 1
+#undef kallocate
+#undef kallocate_aligned
+#undef kallocate_with_flags
+#undef kfree
+#undef kfree_aligned
+#undef kfree_with_flags
+#endif
+
 struct memory_stats {
-    u64 total_allocated;
-    u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    volatile u64 total_allocated;
+    volatile u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
 };
 
+// The number of blocks moved between a thread cache and the global allocator at once.
+#define KMEMORY_CACHE_BATCH_COUNT 32
+// The number of blocks a bin may hold before a batch is flushed back to the global allocator.
+#define KMEMORY_CACHE_MAX_COUNT 128
+// Freed blocks of at least this size have their pages handed back to the OS.
+#define KMEMORY_DECOMMIT_THRESHOLD MEBIBYTES(1)
+// The maximum number of chunks the heap may be made up of.
+#define KMEMORY_MAX_CHUNKS 64
+// Chunks are reserved in multiples of this size.
+#define KMEMORY_CHUNK_GRANULARITY MEBIBYTES(2)
+// A packed chunk range holds the start address in 4 KiB pages in its low bits, and
+// the size in KMEMORY_CHUNK_GRANULARITY units in the rest.
+#define KMEMORY_CHUNK_START_SHIFT 12
+#define KMEMORY_CHUNK_START_BITS 36
+// The maximum number of threads which may record trace events.
+#define KMEMORY_TRACE_MAX_THREADS 64
+
+/** @brief A singly-linked list of free blocks of a single size class. The link is stored in the block itself. */
+typedef struct thread_cache_bin {
+    void* head;
+    u32 count;
+} thread_cache_bin;
+
+/** @brief A range of memory reserved from the OS, managed by its own allocator. */
+typedef struct memory_chunk {
+    // The reserved range, packed into a single value so that the chunk owning a block
+    // can be found without holding the allocation lock. 0 if the slot is unused.
+    volatile u64 packed_range;
+    void* block;
+    u64 reserved_size;
+    // The size of the pages backing the range.
+    u64 page_size;
+    dynamic_allocator allocator;
+} memory_chunk;
+
+/** @brief A per-thread cache of small blocks, one bin per size class. */
+typedef struct thread_cache {
+    b8 enabled;
+    thread_cache_bin bins[DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT];
+} thread_cache;
+
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "UNKNOWN    ",
     "ARRAY      ",
@@ -45,16 +99,351 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
 typedef struct memory_system_state {
     memory_system_configuration config;
     struct memory_stats stats;
-    u64 alloc_count;
-    u64 allocator_memory_requirement;
-    dynamic_allocator allocator;
-    void* allocator_block;
+    volatile u64 alloc_count;
+    // The number of allocations ever made, which is never decremented.
+    volatile u64 total_alloc_count;
+    // The number of bytes held in thread caches, allocated from the allocator but not in use.
+    volatile u64 cached_bytes;
+    // The chunks making up the heap. The first also holds this state, and is never released.
+    memory_chunk chunks[KMEMORY_MAX_CHUNKS];
+    u32 chunk_count;
+    // One past the highest chunk slot in use, which bounds chunk lookups.
+    volatile u32 chunk_slot_count;
     kmutex allocation_mutex;
 } memory_system_state;
 
 // Pointer to system state.
 static memory_system_state* state_ptr;
 
+// The small block cache of the current thread. Only used once enabled.
+static KTHREAD_LOCAL thread_cache local_cache;
+
+#if KMEMORY_TRACE_ENABLED == 1
+typedef enum kmemory_trace_event_type {
+    KMEMORY_TRACE_EVENT_ALLOCATE,
+    KMEMORY_TRACE_EVENT_FREE
+} kmemory_trace_event_type;
+
+/** @brief A single allocation or free recorded while tracing. */
+typedef struct kmemory_trace_event {
+    f64 time;
+    u64 frame;
+    void* block;
+    u64 size;
+    // The callsite of the event, or 0 if unknown.
+    const char* file;
+    u32 line;
+    u8 tag;
+    u8 type;
+} kmemory_trace_event;
+
+/** @brief The events recorded by a single thread. Only ever written by that thread. */
+typedef struct kmemory_trace_ring {
+    kmemory_trace_event* events;
+    // The number of events recorded since tracing was started. May exceed the capacity,
+    // in which case the oldest events have been overwritten.
+    u64 event_count;
+    u64 thread_id;
+    // The trace the events belong to. Events from an older trace are discarded.
+    u32 epoch;
+} kmemory_trace_ring;
+
+typedef struct kmemory_trace_state {
+    volatile u32 active;
+    // Incremented each time tracing is started.
+    volatile u32 epoch;
+    // Incremented each time the rings are freed, which invalidates the threads' pointers to them.
+    volatile u32 generation;
+    volatile u64 frame;
+    volatile u32 ring_count;
+    kmemory_trace_ring* rings[KMEMORY_TRACE_MAX_THREADS];
+} kmemory_trace_state;
+
+// Trace rings outlive the memory system state, as they are allocated from the platform.
+static kmemory_trace_state trace_state;
+static KTHREAD_LOCAL kmemory_trace_ring* local_trace_ring;
+static KTHREAD_LOCAL u32 local_trace_generation;
+// The callsite of the next allocation or free made by this thread.
+static KTHREAD_LOCAL const char* local_callsite_file;
+static KTHREAD_LOCAL u32 local_callsite_line;
+#endif
+
+static void track_allocation(u64 size, memory_tag tag) {
+    katomic_fetch_add_u64(&state_ptr->stats.total_allocated, size);
+    katomic_fetch_add_u64(&state_ptr->stats.tagged_allocations[tag], size);
+    katomic_fetch_add_u64(&state_ptr->alloc_count, 1);
+    katomic_fetch_add_u64(&state_ptr->total_alloc_count, 1);
+}
+
+static void track_free(u64 size, memory_tag tag) {
+    katomic_fetch_sub_u64(&state_ptr->stats.total_allocated, size);
+    katomic_fetch_sub_u64(&state_ptr->stats.tagged_allocations[tag], size);
+    katomic_fetch_sub_u64(&state_ptr->alloc_count, 1);
+}
+
+#if KMEMORY_TRACE_ENABLED == 1
+static kmemory_trace_ring* trace_ring_get() {
+    if (local_trace_ring && local_trace_generation == katomic_load_u32(&trace_state.generation)) {
+        return local_trace_ring;
+    }
+
+    // First event recorded by this thread since the rings were last freed.
+    local_trace_ring = 0;
+    u32 index = katomic_fetch_add_u32(&trace_state.ring_count, 1);
+    if (index >= KMEMORY_TRACE_MAX_THREADS) {
+        katomic_fetch_sub_u32(&trace_state.ring_count, 1);
+        return 0;
+    }
+    kmemory_trace_ring* ring = platform_allocate(sizeof(kmemory_trace_ring), false);
+    ring->events = platform_allocate(sizeof(kmemory_trace_event) * KMEMORY_TRACE_EVENTS_PER_THREAD, false);
+    ring->event_count = 0;
+    ring->thread_id = get_thread_id();
+    ring->epoch = katomic_load_u32(&trace_state.epoch);
+    trace_state.rings[index] = ring;
+    local_trace_ring = ring;
+    local_trace_generation = katomic_load_u32(&trace_state.generation);
+    return ring;
+}
+
+static void trace_record(kmemory_trace_event_type type, void* block, u64 size, memory_tag tag) {
+    const char* file = local_callsite_file;
+    u32 line = local_callsite_line;
+    local_callsite_file = 0;
+    if (!katomic_load_u32(&trace_state.active)) {
+        return;
+    }
+
+    kmemory_trace_ring* ring = trace_ring_get();
+    if (!ring) {
+        return;
+    }
+    u32 epoch = katomic_load_u32(&trace_state.epoch);
+    if (ring->epoch != epoch) {
+        // Left over from a previous trace.
+        ring->epoch = epoch;
+        ring->event_count = 0;
+    }
+
+    kmemory_trace_event* event = &ring->events[ring->event_count % KMEMORY_TRACE_EVENTS_PER_THREAD];
+    event->time = platform_get_absolute_time();
+    event->frame = katomic_load_u64(&trace_state.frame);
+    event->block = block;
+    event->size = size;
+    event->file = file;
+    event->line = file ? line : 0;
+    event->tag = (u8)tag;
+    event->type = (u8)type;
+    ring->event_count++;
+}
+
+// Frees all rings. No other thread may be recording events.
+static void trace_rings_free() {
+    katomic_store_u32(&trace_state.active, 0);
+    u32 ring_count = katomic_load_u32(&trace_state.ring_count);
+    for (u32 i = 0; i < ring_count && i < KMEMORY_TRACE_MAX_THREADS; ++i) {
+        if (trace_state.rings[i]) {
+            platform_free(trace_state.rings[i]->events, false);
+            platform_free(trace_state.rings[i], false);
+            trace_state.rings[i] = 0;
+        }
+    }
+    katomic_store_u32(&trace_state.ring_count, 0);
+    katomic_fetch_add_u32(&trace_state.generation, 1);
+}
+#endif
+
+static void chunk_publish(memory_chunk* chunk, u32 slot, void* block, u64 reserved_size, u64 page_size) {
+    chunk->block = block;
+    chunk->reserved_size = reserved_size;
+    chunk->page_size = page_size;
+    u64 packed = ((u64)block >> KMEMORY_CHUNK_START_SHIFT) | ((reserved_size / KMEMORY_CHUNK_GRANULARITY) << KMEMORY_CHUNK_START_BITS);
+    katomic_store_u64(&chunk->packed_range, packed);
+    if (slot + 1 > katomic_load_u32(&state_ptr->chunk_slot_count)) {
+        katomic_store_u32(&state_ptr->chunk_slot_count, slot + 1);
+    }
+    state_ptr->chunk_count++;
+}
+
+/**
+ * Obtains the chunk whose range holds the given block, or 0 if there is none. Safe
+ * to call without the allocation lock, provided the block is live, since the chunk
+ * owning a live block can never be released.
+ */
+static memory_chunk* chunk_for_block(void* block) {
+    u64 address = (u64)block;
+    u32 slot_count = katomic_load_u32(&state_ptr->chunk_slot_count);
+    for (u32 i = 0; i < slot_count; ++i) {
+        u64 packed = katomic_load_u64(&state_ptr->chunks[i].packed_range);
+        u64 start = (packed & ((1ULL << KMEMORY_CHUNK_START_BITS) - 1)) << KMEMORY_CHUNK_START_SHIFT;
+        u64 size = (packed >> KMEMORY_CHUNK_START_BITS) * KMEMORY_CHUNK_GRANULARITY;
+        if (address >= start && address < start + size) {
+            return &state_ptr->chunks[i];
+        }
+    }
+    return 0;
+}
+
+// Reserves a new chunk for an allocator of the given size. Must be called with the allocation lock held.
+static memory_chunk* chunk_create(u64 total_size) {
+    u32 slot = 1;
+    while (slot < KMEMORY_MAX_CHUNKS && state_ptr->chunks[slot].packed_range) {
+        slot++;
+    }
+    if (slot == KMEMORY_MAX_CHUNKS) {
+        KERROR("Memory system cannot grow beyond %u chunks.", KMEMORY_MAX_CHUNKS);
+        return 0;
+    }
+
+    u64 requirement = 0;
+    dynamic_allocator_create(total_size, &requirement, 0, 0);
+    u64 reserved_size = get_aligned(requirement, KMEMORY_CHUNK_GRANULARITY);
+    u64 page_size = 0;
+    void* block = platform_memory_reserve(reserved_size, state_ptr->config.use_large_pages, &page_size);
+    if (!block) {
+        return 0;
+    }
+
+    memory_chunk* chunk = &state_ptr->chunks[slot];
+    // The allocator must be ready before the chunk is published.
+    dynamic_allocator_create_zeroed(total_size, &requirement, block, &chunk->allocator);
+    chunk_publish(chunk, slot, block, reserved_size, page_size);
+    KDEBUG("Memory system grew by a chunk of %llu bytes (%u chunks).", total_size, state_ptr->chunk_count);
+    return chunk;
+}
+
+// Gives the memory of a chunk back to the OS. Must be called with the allocation lock held.
+static void chunk_release(memory_chunk* chunk) {
+    katomic_store_u64(&chunk->packed_range, 0);
+    dynamic_allocator_destroy(&chunk->allocator);
+    platform_memory_release(chunk->block, chunk->reserved_size);
+    chunk->block = 0;
+    chunk->reserved_size = 0;
+    chunk->allocator.memory = 0;
+    state_ptr->chunk_count--;
+    KDEBUG("Memory system released an empty chunk (%u chunks).", state_ptr->chunk_count);
+}
+
+/**
+ * Allocates from the first chunk with room for the request, adding a chunk if none has.
+ * Earlier chunks are preferred, so that later ones may drain and be released. Must be
+ * called with the allocation lock held.
+ */
+static void* heap_allocate(u64 size, u16 alignment) {
+    u32 slot_count = state_ptr->chunk_slot_count;
+    for (u32 i = 0; i < slot_count; ++i) {
+        memory_chunk* chunk = &state_ptr->chunks[i];
+        if (chunk->packed_range) {
+            void* block = dynamic_allocator_try_allocate_aligned(&chunk->allocator, size, alignment);
+            if (block) {
+                return block;
+            }
+        }
+    }
+
+    // Requests too big for a regular chunk get one sized to fit just them, rounded up to the
+    // granularity chunks are reserved at anyway, which is a multiple of the page size.
+    u64 chunk_size = state_ptr->config.chunk_size ? state_ptr->config.chunk_size : state_ptr->config.total_alloc_size;
+    u64 required_size = get_aligned(dynamic_allocator_size_for_block(size, alignment), KMEMORY_CHUNK_GRANULARITY);
+    memory_chunk* chunk = chunk_create(chunk_size > required_size ? chunk_size : required_size);
+    if (!chunk) {
+        return 0;
+    }
+    return dynamic_allocator_try_allocate_aligned(&chunk->allocator, size, alignment);
+}
+
+/**
+ * Frees a block to the chunk it belongs to. The pages of large blocks are handed back to
+ * the OS, as are whole chunks once they are empty. Must be called with the allocation lock held.
+ */
+static b8 heap_free(void* block) {
+    memory_chunk* chunk = chunk_for_block(block);
+    if (!chunk) {
+        return false;
+    }
+
+    u64 block_size = 0;
+    u16 block_alignment = 0;
+    if (!dynamic_allocator_get_size_alignment(&chunk->allocator, block, &block_size, &block_alignment)) {
+        return false;
+    }
+    if (!dynamic_allocator_free_aligned(&chunk->allocator, block)) {
+        return false;
+    }
+
+    if (chunk != &state_ptr->chunks[0] && dynamic_allocator_free_space(&chunk->allocator) == dynamic_allocator_total_space(&chunk->allocator)) {
+        chunk_release(chunk);
+    } else if (block_size >= KMEMORY_DECOMMIT_THRESHOLD) {
+        // Hand back the pages lying wholly within the block. This must happen under the lock,
+        // before the range can be handed out again.
+        u64 start = get_aligned((u64)block, chunk->page_size);
+        u64 end = ((u64)block + block_size) & ~(chunk->page_size - 1);
+        if (end > start) {
+            platform_memory_decommit((void*)start, end - start);
+        }
+    }
+    return true;
+}
+
+/**
+ * Indicates if the given block is a small block of one of the slab size classes,
+ * regardless of which thread (if any) cached it. Small blocks are tracked by their
+ * class size rather than the size passed by the caller, since that is what
+ * kmemory_get_size_alignment reports back for them.
+ */
+static b8 is_small_block(void* block, u64* out_class_size) {
+    u64 size = 0;
+    u16 alignment = 0;
+    memory_chunk* chunk = chunk_for_block(block);
+    if (!chunk || !dynamic_allocator_get_size_alignment(&chunk->allocator, block, &size, &alignment)) {
+        return false;
+    }
+    if (alignment != DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT || size < DYNAMIC_ALLOCATOR_SMALL_MIN_SIZE || size > DYNAMIC_ALLOCATOR_SMALL_MAX_SIZE || (size & (size - 1)) != 0) {
+        return false;
+    }
+    *out_class_size = size;
+    return true;
+}
+
+static b8 thread_cache_refill(thread_cache_bin* bin, u32 class_index) {
+    u64 class_size = dynamic_allocator_size_class_size(class_index);
+    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+        KFATAL("Error obtaining mutex lock during thread cache refill.");
+        return false;
+    }
+    u32 added = 0;
+    for (; added < KMEMORY_CACHE_BATCH_COUNT; ++added) {
+        void* block = heap_allocate(class_size, DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT);
+        if (!block) {
+            break;
+        }
+        *(void**)block = bin->head;
+        bin->head = block;
+    }
+    kmutex_unlock(&state_ptr->allocation_mutex);
+
+    bin->count += added;
+    katomic_fetch_add_u64(&state_ptr->cached_bytes, class_size * added);
+    return added > 0;
+}
+
+static void thread_cache_flush(thread_cache_bin* bin, u32 class_index, u32 count) {
+    u64 class_size = dynamic_allocator_size_class_size(class_index);
+    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+        KFATAL("Unable to obtain mutex lock for thread cache flush. Heap corruption is likely.");
+        return;
+    }
+    u32 removed = 0;
+    for (; removed < count && bin->head; ++removed) {
+        void* block = bin->head;
+        bin->head = *(void**)block;
+        heap_free(block);
+    }
+    kmutex_unlock(&state_ptr->allocation_mutex);
+
+    bin->count -= removed;
+    katomic_fetch_sub_u64(&state_ptr->cached_bytes, class_size * removed);
+}
+
 b8 memory_system_initialize(memory_system_configuration config) {
     // The amount needed by the system state.
     u64 state_memory_requirement = sizeof(memory_system_state);
@@ -63,9 +452,11 @@ b8 memory_system_initialize(memory_system_configuration config) {
     u64 alloc_requirement = 0;
     dynamic_allocator_create(config.total_alloc_size, &alloc_requirement, 0, 0);
 
-    // Call the platform allocator to get the memory for the whole system, including the state.
-    // TODO: memory alignment
-    void* block = platform_allocate(state_memory_requirement + alloc_requirement, false);
+    // Reserve the memory for the first chunk, including the state, from the OS. Pages
+    // are only committed as they are touched, and start out zeroed.
+    u64 page_size = 0;
+    u64 reserved_size = get_aligned(state_memory_requirement + alloc_requirement, KMEMORY_CHUNK_GRANULARITY);
+    void* block = platform_memory_reserve(reserved_size, config.use_large_pages, &page_size);
     if (!block) {
         KFATAL("Memory system allocation failed and the system cannot continue.");
         return false;
@@ -75,19 +466,24 @@ b8 memory_system_initialize(memory_system_configuration config) {
     state_ptr = (memory_system_state*)block;
     state_ptr->config = config;
     state_ptr->alloc_count = 0;
-    state_ptr->allocator_memory_requirement = alloc_requirement;
+    state_ptr->total_alloc_count = 0;
+    state_ptr->cached_bytes = 0;
+    state_ptr->chunk_count = 0;
+    state_ptr->chunk_slot_count = 0;
     platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
-    // The allocator block is in the same block of memory, but after the state.
-    state_ptr->allocator_block = ((void*)block + state_memory_requirement);
 
-    if (!dynamic_allocator_create(
+    // The first chunk's allocator is in the same block of memory, but after the state. The
+    // reserved block starts out zeroed, so the allocator need not clear it.
+    memory_chunk* chunk = &state_ptr->chunks[0];
+    if (!dynamic_allocator_create_zeroed(
             config.total_alloc_size,
-            &state_ptr->allocator_memory_requirement,
-            state_ptr->allocator_block,
-            &state_ptr->allocator)) {
+            &alloc_requirement,
+            (void*)block + state_memory_requirement,
+            &chunk->allocator)) {
         KFATAL("Memory system is unable to setup internal allocator. Application cannot continue.");
         return false;
     }
+    chunk_publish(chunk, 0, block, reserved_size, page_size);
 
     // Create allocation mutex
     if (!kmutex_create(&state_ptr->allocation_mutex)) {
@@ -104,9 +500,18 @@ void memory_system_shutdown() {
         // Destroy allocation mutex
         kmutex_destroy(&state_ptr->allocation_mutex);
 
-        dynamic_allocator_destroy(&state_ptr->allocator);
-        // Free the entire block.
-        platform_free(state_ptr, state_ptr->allocator_memory_requirement + sizeof(memory_system_state));
+#if KMEMORY_TRACE_ENABLED == 1
+        trace_rings_free();
+#endif
+        // Release any chunks the heap grew by, then the first, which holds the state.
+        for (u32 i = 1; i < state_ptr->chunk_slot_count; ++i) {
+            if (state_ptr->chunks[i].packed_range) {
+                chunk_release(&state_ptr->chunks[i]);
+            }
+        }
+        memory_chunk first = state_ptr->chunks[0];
+        dynamic_allocator_destroy(&first.allocator);
+        platform_memory_release(first.block, first.reserved_size);
     }
     state_ptr = 0;
 }
@@ -115,27 +520,72 @@ void* kallocate(u64 size, memory_tag tag) {
     return kallocate_aligned(size, 1, tag);
 }
 
+void kmemory_thread_cache_initialize() {
+    if (!state_ptr) {
+        KWARN("kmemory_thread_cache_initialize called before the memory system is initialized.");
+        return;
+    }
+    kzero_memory(&local_cache, sizeof(thread_cache));
+    local_cache.enabled = true;
+}
+
+void kmemory_thread_cache_shutdown() {
+    if (state_ptr && local_cache.enabled) {
+        for (u32 i = 0; i < DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT; ++i) {
+            thread_cache_flush(&local_cache.bins[i], i, local_cache.bins[i].count);
+        }
+    }
+    kzero_memory(&local_cache, sizeof(thread_cache));
+}
+
 void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
+    return kallocate_with_flags(size, alignment, tag, KALLOCATE_FLAG_ZEROED);
+}
+
+void* kallocate_with_flags(u64 size, u16 alignment, memory_tag tag, kallocate_flag_bits flags) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         KWARN("kallocate_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
+    if ((flags & KALLOCATE_FLAG_CACHE_ALIGNED) && alignment < KALLOCATE_CACHE_LINE_SIZE) {
+        alignment = KALLOCATE_CACHE_LINE_SIZE;
+    }
+    b8 tracked = !(flags & KALLOCATE_FLAG_UNTRACKED);
 
     // Either allocate from the system's allocator or the OS. The latter shouldn't ever
     // really happen.
     void* block = 0;
     if (state_ptr) {
-        // Make sure multithreaded requests don't trample each other.
-        if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-            KFATAL("Error obtaining mutex lock during allocation.");
-            return 0;
+        if (local_cache.enabled && dynamic_allocator_is_small(size, alignment)) {
+            // Small allocations are taken from the thread's cache, which is only locked
+            // against other threads when it needs refilling.
+            u32 class_index = dynamic_allocator_size_class_index(size);
+            thread_cache_bin* bin = &local_cache.bins[class_index];
+            if (bin->head || thread_cache_refill(bin, class_index)) {
+                block = bin->head;
+                bin->head = *(void**)block;
+                bin->count--;
+
+                u64 class_size = dynamic_allocator_size_class_size(class_index);
+                katomic_fetch_sub_u64(&state_ptr->cached_bytes, class_size);
+                if (tracked) {
+                    track_allocation(class_size, tag);
+                }
+            }
+        } else {
+            // Make sure multithreaded requests don't trample each other.
+            if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+                KFATAL("Error obtaining mutex lock during allocation.");
+                return 0;
+            }
+            block = heap_allocate(size, alignment);
+            kmutex_unlock(&state_ptr->allocation_mutex);
+
+            if (block && tracked) {
+                // Small requests are served from slabs, so are tracked by their class size.
+                u64 tracked_size = dynamic_allocator_is_small(size, alignment) ? dynamic_allocator_size_class_size(dynamic_allocator_size_class_index(size)) : size;
+                track_allocation(tracked_size, tag);
+            }
         }
-
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
-
-        block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
-        kmutex_unlock(&state_ptr->allocation_mutex);
     } else {
         // If the system is not up yet, warn about it but give memory for now.
         KWARN("kallocate_aligned called before the memory system is initialized.");
@@ -144,7 +594,12 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
     }
 
     if (block) {
-        platform_zero_memory(block, size);
+        if (!(flags & KALLOCATE_FLAG_UNINITIALIZED)) {
+            platform_zero_memory(block, size);
+        }
+#if KMEMORY_TRACE_ENABLED == 1
+        trace_record(KMEMORY_TRACE_EVENT_ALLOCATE, block, size, tag);
+#endif
         return block;
     }
 
@@ -153,15 +608,7 @@ void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kallocate_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
-    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
-        return;
-    }
-    state_ptr->stats.total_allocated += size;
-    state_ptr->stats.tagged_allocations[tag] += size;
-    state_ptr->alloc_count++;
-    kmutex_unlock(&state_ptr->allocation_mutex);
+    track_allocation(size, tag);
 }
 
 void kfree(void* block, u64 size, memory_tag tag) {
@@ -169,21 +616,47 @@ void kfree(void* block, u64 size, memory_tag tag) {
 }
 
 void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
+    kfree_with_flags(block, size, alignment, tag, KALLOCATE_FLAG_ZEROED);
+}
+
+void kfree_with_flags(void* block, u64 size, u16 alignment, memory_tag tag, kallocate_flag_bits flags) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         KWARN("kfree_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
+    b8 tracked = !(flags & KALLOCATE_FLAG_UNTRACKED);
+#if KMEMORY_TRACE_ENABLED == 1
+    trace_record(KMEMORY_TRACE_EVENT_FREE, block, size, tag);
+#endif
     if (state_ptr) {
+        u64 class_size = 0;
+        if (is_small_block(block, &class_size)) {
+            if (tracked) {
+                track_free(class_size, tag);
+            }
+            if (local_cache.enabled) {
+                // Keep the block for reuse by this thread, handing a batch back if the bin gets too full.
+                u32 class_index = dynamic_allocator_size_class_index(class_size);
+                thread_cache_bin* bin = &local_cache.bins[class_index];
+                *(void**)block = bin->head;
+                bin->head = block;
+                bin->count++;
+                katomic_fetch_add_u64(&state_ptr->cached_bytes, class_size);
+                if (bin->count > KMEMORY_CACHE_MAX_COUNT) {
+                    thread_cache_flush(bin, class_index, KMEMORY_CACHE_BATCH_COUNT);
+                }
+                return;
+            }
+            size = class_size;
+        } else if (tracked) {
+            track_free(size, tag);
+        }
+
         // Make sure multithreaded requests don't trample each other.
         if (!kmutex_lock(&state_ptr->allocation_mutex)) {
             KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
             return;
         }
-
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
-        state_ptr->alloc_count--;
-        b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
-
+        b8 result = heap_free(block);
         kmutex_unlock(&state_ptr->allocation_mutex);
 
         // If the free failed, it's possible this is because the allocation was made
@@ -201,19 +674,18 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kfree_report(u64 size, memory_tag tag) {
-    // Make sure multithreaded requests don't trample each other.
-    if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-        KFATAL("Error obtaining mutex lock during allocation reporting.");
-        return;
-    }
-    state_ptr->stats.total_allocated -= size;
-    state_ptr->stats.tagged_allocations[tag] -= size;
-    state_ptr->alloc_count--;
-    kmutex_unlock(&state_ptr->allocation_mutex);
+    track_free(size, tag);
 }
 
 b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment) {
-    return dynamic_allocator_get_size_alignment(block, out_size, out_alignment);
+    if (!state_ptr) {
+        return false;
+    }
+    memory_chunk* chunk = chunk_for_block(block);
+    if (!chunk) {
+        return false;
+    }
+    return dynamic_allocator_get_size_alignment(&chunk->allocator, block, out_size, out_alignment);
 }
 
 void* kzero_memory(void* block, u64 size) {
@@ -259,9 +731,18 @@ char* get_memory_usage_str() {
         offset += length;
     }
     {
-        // Compute total usage.
-        u64 total_space = dynamic_allocator_total_space(&state_ptr->allocator);
-        u64 free_space = dynamic_allocator_free_space(&state_ptr->allocator);
+        // Compute total usage across all chunks.
+        u64 total_space = 0;
+        u64 free_space = 0;
+        kmutex_lock(&state_ptr->allocation_mutex);
+        for (u32 i = 0; i < state_ptr->chunk_slot_count; ++i) {
+            if (state_ptr->chunks[i].packed_range) {
+                total_space += dynamic_allocator_total_space(&state_ptr->chunks[i].allocator);
+                free_space += dynamic_allocator_free_space(&state_ptr->chunks[i].allocator);
+            }
+        }
+        u32 chunk_count = state_ptr->chunk_count;
+        kmutex_unlock(&state_ptr->allocation_mutex);
         u64 used_space = total_space - free_space;
 
         f32 used_amount = 1.0f;
@@ -272,9 +753,36 @@ char* get_memory_usage_str() {
 
         f64 percent_used = (f64)(used_space) / total_space;
 
-        i32 length = snprintf(buffer + offset, 8000, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        i32 length = snprintf(buffer + offset, 8000, "Total memory usage: %.2f%s of %.2f%s in %u chunk(s) (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, chunk_count, percent_used);
+        offset += length;
+
+        f32 cached_amount = 1.0f;
+        const char* cached_unit = get_unit_for_size(state_ptr->cached_bytes, &cached_amount);
+        length = snprintf(buffer + offset, 8000, "  Held in thread caches: %.2f%s\n", cached_amount, cached_unit);
         offset += length;
     }
+    {
+        // Slab occupancy for each small size class.
+        i32 length = snprintf(buffer + offset, 8000, "Small block slabs:\n");
+        offset += length;
+        for (u32 i = 0; i < DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT; ++i) {
+            dynamic_allocator_slab_usage usage = {};
+            kmutex_lock(&state_ptr->allocation_mutex);
+            for (u32 c = 0; c < state_ptr->chunk_slot_count; ++c) {
+                dynamic_allocator_slab_usage chunk_usage;
+                if (state_ptr->chunks[c].packed_range && dynamic_allocator_get_slab_usage(&state_ptr->chunks[c].allocator, i, &chunk_usage)) {
+                    usage.block_size = chunk_usage.block_size;
+                    usage.used_blocks += chunk_usage.used_blocks;
+                    usage.total_blocks += chunk_usage.total_blocks;
+                    usage.slab_count += chunk_usage.slab_count;
+                }
+            }
+            kmutex_unlock(&state_ptr->allocation_mutex);
+            f64 percent_used = usage.total_blocks ? ((f64)usage.used_blocks / usage.total_blocks) * 100.0 : 0.0;
+            length = snprintf(buffer + offset, 8000, "  %4lluB: %llu/%llu blocks in %llu slab(s) (%.2f%%)\n", usage.block_size, usage.used_blocks, usage.total_blocks, usage.slab_count, percent_used);
+            offset += length;
+        }
+    }
     char* out_string = string_duplicate(buffer);
     return out_string;
 }
@@ -284,4 +792,119 @@ u64 get_memory_alloc_count() {
         return state_ptr->alloc_count;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+u32 get_memory_chunk_count() {
+    if (state_ptr) {
+        return state_ptr->chunk_count;
+    }
+    return 0;
+}
+
+u64 get_memory_total_alloc_count() {
+    if (state_ptr) {
+        return katomic_load_u64(&state_ptr->total_alloc_count);
+    }
+    return 0;
+}
+
+#if KMEMORY_TRACE_ENABLED == 1
+void kmemory_trace_set_callsite(const char* file, u32 line) {
+    local_callsite_file = file;
+    local_callsite_line = line;
+}
+
+b8 kmemory_trace_start() {
+    katomic_fetch_add_u32(&trace_state.epoch, 1);
+    katomic_store_u64(&trace_state.frame, 0);
+    katomic_store_u32(&trace_state.active, 1);
+    return true;
+}
+
+void kmemory_trace_stop() {
+    katomic_store_u32(&trace_state.active, 0);
+}
+
+b8 kmemory_trace_is_active() {
+    return katomic_load_u32(&trace_state.active) != 0;
+}
+
+void kmemory_trace_frame_mark() {
+    katomic_fetch_add_u64(&trace_state.frame, 1);
+}
+
+b8 kmemory_trace_write(const char* path) {
+    if (kmemory_trace_is_active()) {
+        KERROR("kmemory_trace_write - Tracing must be stopped before the trace is written.");
+        return false;
+    }
+
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &f)) {
+        KERROR("kmemory_trace_write - Unable to open '%s' for writing.", path);
+        return false;
+    }
+
+    // Lines are gathered into a buffer and written in batches.
+    const u64 buffer_size = KIBIBYTES(64);
+    const u64 max_line_length = 1024;
+    char* buffer = platform_allocate(buffer_size, false);
+    u64 offset = snprintf(buffer, buffer_size, "frame,time,thread,event,block,size,tag,line,file\n");
+    u64 written = 0;
+    u64 event_total = 0;
+    u64 dropped_total = 0;
+
+    u32 epoch = katomic_load_u32(&trace_state.epoch);
+    u32 ring_count = katomic_load_u32(&trace_state.ring_count);
+    for (u32 r = 0; r < ring_count && r < KMEMORY_TRACE_MAX_THREADS; ++r) {
+        kmemory_trace_ring* ring = trace_state.rings[r];
+        if (!ring || ring->epoch != epoch) {
+            continue;
+        }
+        u64 first = ring->event_count > KMEMORY_TRACE_EVENTS_PER_THREAD ? ring->event_count - KMEMORY_TRACE_EVENTS_PER_THREAD : 0;
+        dropped_total += first;
+        for (u64 i = first; i < ring->event_count; ++i) {
+            kmemory_trace_event* e = &ring->events[i % KMEMORY_TRACE_EVENTS_PER_THREAD];
+            // Tag names are padded for display, so only take up to the first space.
+            const char* tag_name = memory_tag_strings[e->tag];
+            i32 tag_length = (i32)(strchr(tag_name, ' ') ? strchr(tag_name, ' ') - tag_name : strlen(tag_name));
+            offset += snprintf(buffer + offset, max_line_length, "%llu,%.9f,%llu,%s,%p,%llu,%.*s,%u,%s\n",
+                               e->frame, e->time, ring->thread_id, e->type == KMEMORY_TRACE_EVENT_ALLOCATE ? "alloc" : "free",
+                               e->block, e->size, tag_length, tag_name, e->line, e->file ? e->file : "unknown");
+            event_total++;
+            if (offset + max_line_length > buffer_size) {
+                filesystem_write(&f, offset, buffer, &written);
+                offset = 0;
+            }
+        }
+    }
+    filesystem_write(&f, offset, buffer, &written);
+    filesystem_close(&f);
+    platform_free(buffer, false);
+
+    if (dropped_total) {
+        KWARN("kmemory_trace_write - %llu of the oldest events were overwritten. Trace fewer frames to keep them all.", dropped_total);
+    }
+    KINFO("Wrote %llu memory trace events to '%s'.", event_total, path);
+    return true;
+}
+#else
+b8 kmemory_trace_start() {
+    KWARN("kmemory_trace_start - Tracing is not enabled in this build. Build with KMEMORY_TRACE=1 to enable it.");
+    return false;
+}
+
+void kmemory_trace_stop() {
+}
+
+b8 kmemory_trace_is_active() {
+    return false;
+}
+
+void kmemory_trace_frame_mark() {
+}
+
+b8 kmemory_trace_write(const char* path) {
+    return false;
+}
+#endif
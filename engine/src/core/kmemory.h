@@ -34,15 +34,80 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
+typedef enum kallocate_flag {
+    /** @brief The block is zeroed before it is returned. This is the default, as with kallocate. */
+    KALLOCATE_FLAG_ZEROED = 0x0,
+    /**
+     * @brief The contents of the block are left undefined. For blocks the caller is
+     * about to overwrite entirely, such as the destination of a copy or file read,
+     * which would otherwise be written twice.
+     */
+    KALLOCATE_FLAG_UNINITIALIZED = 0x1,
+    /**
+     * @brief The block is not counted in the memory stats. For allocations whose size
+     * is not known when they are freed, such as those made by 3rd party libraries.
+     * The block must be freed with this flag as well.
+     */
+    KALLOCATE_FLAG_UNTRACKED = 0x2,
+    /**
+     * @brief A hint that the block will be processed in bulk (i.e. copied or streamed),
+     * which raises its alignment to at least KALLOCATE_CACHE_LINE_SIZE.
+     */
+    KALLOCATE_FLAG_CACHE_ALIGNED = 0x4,
+} kallocate_flag;
+
+/** @brief Holds bit flags for allocations. */
+typedef u8 kallocate_flag_bits;
+
+/** @brief The alignment in bytes of blocks allocated with KALLOCATE_FLAG_CACHE_ALIGNED. */
+#define KALLOCATE_CACHE_LINE_SIZE KCACHE_LINE_SIZE
+
+/**
+ * @brief Indicates if allocation tracing is compiled in. When it is, allocations and
+ * frees can be recorded along with their callsites once kmemory_trace_start is called.
+ * Off by default, as every allocation and free then also records its callsite. Build
+ * with KMEMORY_TRACE=1 to turn it on for the engine and everything built against it.
+ */
+#ifndef KMEMORY_TRACE_ENABLED
+#define KMEMORY_TRACE_ENABLED 0
+#endif
+
+/** @brief The number of events kept per thread while tracing. Older events are overwritten. */
+#define KMEMORY_TRACE_EVENTS_PER_THREAD 65536
+
 /** @brief The configuration for the memory system. */
 typedef struct memory_system_configuration {
-    /** @brief The total memory size in byes used by the internal allocator for this system. */
+    /**
+     * @brief The size in bytes of the heap as initially reserved. The heap grows beyond
+     * this by adding chunks as needed, and gives them back to the OS once empty.
+     */
     u64 total_alloc_size;
+    /** @brief The size in bytes of each chunk added when the heap grows. If 0, total_alloc_size is used. */
+    u64 chunk_size;
+    /** @brief Indicates if the system's memory should be backed by large pages where the platform allows. */
+    b8 use_large_pages;
 } memory_system_configuration;
 
 KAPI b8 memory_system_initialize(memory_system_configuration config);
 KAPI void memory_system_shutdown();
 
+/**
+ * @brief Enables a small-block allocation cache for the calling thread. Small
+ * allocations made from this thread are then served from thread-local free lists,
+ * which are refilled from (and flushed back to) the global allocator in batches,
+ * avoiding the global allocation lock for most requests. Intended to be called
+ * once at the start of each long-lived worker thread (i.e. job threads).
+ * Blocks allocated from a cache may be freed from any thread.
+ */
+KAPI void kmemory_thread_cache_initialize();
+
+/**
+ * @brief Returns all blocks held by the calling thread's cache to the global
+ * allocator and disables the cache for the thread. Should be called before a
+ * thread that called kmemory_thread_cache_initialize exits.
+ */
+KAPI void kmemory_thread_cache_shutdown();
+
 KAPI void* kallocate(u64 size, memory_tag tag);
 
 /**
@@ -56,6 +121,18 @@ KAPI void* kallocate(u64 size, memory_tag tag);
  */
 KAPI void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag);
 
+/**
+ * @brief Performs a memory allocation from the host of the given size and alignment,
+ * with behaviour controlled by the given flags. NOTE: Memory allocated this way must be
+ * freed using kfree_with_flags, passing the same flags.
+ * @param size The size of the allocation.
+ * @param alignment The alignment in bytes.
+ * @param tag Indicates the use of the allocated block.
+ * @param flags The kallocate_flag bits for the allocation.
+ * @returns If successful, a pointer to a block of allocated memory; otherwise 0.
+ */
+KAPI void* kallocate_with_flags(u64 size, u16 alignment, memory_tag tag, kallocate_flag_bits flags);
+
 /**
  * @brief Reports an allocation associated with the application, but made externally.
  * This can be done for items allocated within 3rd party libraries, for example, to
@@ -76,6 +153,16 @@ KAPI void kfree(void* block, u64 size, memory_tag tag);
  */
 KAPI void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag);
 
+/**
+ * @brief Frees a block allocated with kallocate_with_flags.
+ * @param block A pointer to the block of memory to be freed.
+ * @param size The size of the block to be freed. Ignored for untracked blocks.
+ * @param alignment The alignment of the block.
+ * @param tag The tag indicating the block's use.
+ * @param flags The kallocate_flag bits the block was allocated with.
+ */
+KAPI void kfree_with_flags(void* block, u64 size, u16 alignment, memory_tag tag, kallocate_flag_bits flags);
+
 /**
  * @brief Reports a free associated with the application, but made externally.
  * This can be done for items allocated within 3rd party libraries, for example, to
@@ -105,4 +192,59 @@ KAPI void* kset_memory(void* dest, i32 value, u64 size);
 
 KAPI char* get_memory_usage_str();
 
-KAPI u64 get_memory_alloc_count();
\ No newline at end of file
+KAPI u64 get_memory_alloc_count();
+
+/** @brief Returns the number of chunks currently making up the heap, including the initial one. */
+KAPI u32 get_memory_chunk_count();
+
+/**
+ * @brief Returns the total number of allocations made since the memory system was
+ * initialized, including those which have since been freed. Sampling this at two
+ * points gives the number of allocations made in between (i.e. during a frame).
+ */
+KAPI u64 get_memory_total_alloc_count();
+
+/**
+ * @brief Starts recording allocations and frees, along with their callsite, size, tag,
+ * thread and time, into a ring buffer per thread. Any previous trace is discarded.
+ * Has no effect unless KMEMORY_TRACE_ENABLED is set.
+ * @return True if tracing was started; otherwise false.
+ */
+KAPI b8 kmemory_trace_start();
+
+/** @brief Stops recording allocations and frees. The recorded events are kept until the next start. */
+KAPI void kmemory_trace_stop();
+
+/** @brief Indicates if allocations and frees are currently being recorded. */
+KAPI b8 kmemory_trace_is_active();
+
+/**
+ * @brief Marks the start of a new frame in the trace, so that events may be grouped
+ * by the frame they occurred in. Should be called once per frame.
+ */
+KAPI void kmemory_trace_frame_mark();
+
+/**
+ * @brief Writes the recorded events to a CSV file, one event per line. Tracing must be
+ * stopped first. The file may be summarized with the memtrace mode of the tools.
+ * @param path The path of the file to be written.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 kmemory_trace_write(const char* path);
+
+#if KMEMORY_TRACE_ENABLED == 1
+/**
+ * @brief Sets the callsite recorded for the next allocation or free made by the calling
+ * thread. Not intended to be called directly; use the macros below.
+ */
+KAPI void kmemory_trace_set_callsite(const char* file, u32 line);
+
+// Record the callsite of each allocation and free. A function-like macro is not expanded
+// within its own replacement, so these still call the functions of the same name.
+#define kallocate(size, tag) (kmemory_trace_set_callsite(__FILE__, __LINE__), kallocate(size, tag))
+#define kallocate_aligned(size, alignment, tag) (kmemory_trace_set_callsite(__FILE__, __LINE__), kallocate_aligned(size, alignment, tag))
+#define kallocate_with_flags(size, alignment, tag, flags) (kmemory_trace_set_callsite(__FILE__, __LINE__), kallocate_with_flags(size, alignment, tag, flags))
+#define kfree(block, size, tag) (kmemory_trace_set_callsite(__FILE__, __LINE__), kfree(block, size, tag))
+#define kfree_aligned(block, size, alignment, tag) (kmemory_trace_set_callsite(__FILE__, __LINE__), kfree_aligned(block, size, alignment, tag))
+#define kfree_with_flags(block, size, alignment, tag, flags) (kmemory_trace_set_callsite(__FILE__, __LINE__), kfree_with_flags(block, size, alignment, tag, flags))
+#endif
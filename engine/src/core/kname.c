@@ -0,0 +1,191 @@
+#include "kname.h"
+
+#include "containers/u64_map.h"
+#include "core/katomic.h"
+#include "core/khash.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+// Entries are held in fixed pages which never move once allocated, so that names can
+// be read without taking the lock while others are being added.
+#define KNAME_PAGE_SIZE 4096
+#define KNAME_MAX_PAGES 256
+
+// The text of names is packed into chunks of at least this size.
+#define KNAME_ARENA_CHUNK_SIZE KIBIBYTES(64)
+
+typedef struct kname_entry {
+    u64 hash;
+    const char* str;
+} kname_entry;
+
+typedef struct kname_arena_chunk {
+    struct kname_arena_chunk* next;
+    u64 size;
+    u64 used;
+} kname_arena_chunk;
+
+typedef struct kname_system_state {
+    kmutex lock;
+    /** @brief Maps the hash of a name's text to its kname. */
+    u64_map lookup;
+    /** @brief The number of entries in use, including the one reserved for INVALID_KNAME. */
+    volatile u32 count;
+    kname_entry* pages[KNAME_MAX_PAGES];
+    /** @brief The chunk currently being filled, which links to the previous ones. */
+    kname_arena_chunk* chunks;
+} kname_system_state;
+
+static kname_system_state* state_ptr = 0;
+
+static kname_entry* get_entry(kname name) {
+    return &state_ptr->pages[name / KNAME_PAGE_SIZE][name % KNAME_PAGE_SIZE];
+}
+
+// Copies the given text into the arena, adding a chunk if the current one is full.
+static const char* arena_copy(const char* str, u64 length) {
+    kname_arena_chunk* chunk = state_ptr->chunks;
+    if (!chunk || chunk->used + length + 1 > chunk->size) {
+        u64 size = length + 1 > KNAME_ARENA_CHUNK_SIZE ? length + 1 : KNAME_ARENA_CHUNK_SIZE;
+        chunk = kallocate_with_flags(sizeof(kname_arena_chunk) + size, 8, MEMORY_TAG_STRING, KALLOCATE_FLAG_UNINITIALIZED);
+        chunk->next = state_ptr->chunks;
+        chunk->size = size;
+        chunk->used = 0;
+        state_ptr->chunks = chunk;
+    }
+
+    char* copy = (char*)(chunk + 1) + chunk->used;
+    kcopy_memory(copy, str, length + 1);
+    chunk->used += length + 1;
+    return copy;
+}
+
+/**
+ * Names are keyed by their hash. Should two names ever share one, the later name is
+ * keyed by a hash of the hash instead, and so on until a free key is found. Returns the
+ * name of the given text if it has one, otherwise INVALID_KNAME and the free key it would
+ * take. The lock must be held.
+ */
+static kname find_locked(const char* str, u64 hash, u64* out_free_key) {
+    u64 key = hash;
+    kname* existing = 0;
+    while ((existing = u64_map_get_ptr(&state_ptr->lookup, key))) {
+        if (strings_equal(get_entry(*existing)->str, str)) {
+            return *existing;
+        }
+        key = khash_u64(key);
+    }
+    *out_free_key = key;
+    return INVALID_KNAME;
+}
+
+b8 kname_system_initialize(u64* memory_requirement, void* state) {
+    *memory_requirement = sizeof(kname_system_state);
+    if (!state) {
+        return true;
+    }
+
+    kzero_memory(state, sizeof(kname_system_state));
+    state_ptr = state;
+
+    if (!kmutex_create(&state_ptr->lock)) {
+        KFATAL("Failed to create mutex for the name system.");
+        return false;
+    }
+    u64_map_create(sizeof(kname), KNAME_PAGE_SIZE, &state_ptr->lookup);
+
+    // The first entry is reserved so that INVALID_KNAME is never handed out.
+    state_ptr->pages[0] = kallocate(sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+    state_ptr->count = 1;
+    return true;
+}
+
+void kname_system_shutdown(void* state) {
+    kname_system_state* s = (kname_system_state*)state;
+    if (s) {
+        for (u32 i = 0; i < KNAME_MAX_PAGES && s->pages[i]; ++i) {
+            kfree(s->pages[i], sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+        }
+        while (s->chunks) {
+            kname_arena_chunk* next = s->chunks->next;
+            kfree_with_flags(s->chunks, sizeof(kname_arena_chunk) + s->chunks->size, 8, MEMORY_TAG_STRING, KALLOCATE_FLAG_UNINITIALIZED);
+            s->chunks = next;
+        }
+        u64_map_destroy(&s->lookup);
+        kmutex_destroy(&s->lock);
+        kzero_memory(s, sizeof(kname_system_state));
+    }
+    state_ptr = 0;
+}
+
+kname kname_create(const char* str) {
+    if (!state_ptr || !str || !str[0]) {
+        return INVALID_KNAME;
+    }
+
+    u64 length = string_length(str);
+    u64 hash = khash_bytes(str, length, 0);
+
+    kmutex_lock(&state_ptr->lock);
+
+    u64 key = 0;
+    kname name = find_locked(str, hash, &key);
+    if (name != INVALID_KNAME) {
+        kmutex_unlock(&state_ptr->lock);
+        return name;
+    }
+
+    name = state_ptr->count;
+    if (name >= KNAME_PAGE_SIZE * KNAME_MAX_PAGES) {
+        kmutex_unlock(&state_ptr->lock);
+        KERROR("kname_create - Maximum number of names (%u) reached.", KNAME_PAGE_SIZE * KNAME_MAX_PAGES);
+        return INVALID_KNAME;
+    }
+    u32 page = name / KNAME_PAGE_SIZE;
+    if (!state_ptr->pages[page]) {
+        state_ptr->pages[page] = kallocate(sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+    }
+
+    kname_entry* entry = get_entry(name);
+    entry->hash = hash;
+    entry->str = arena_copy(str, length);
+    u64_map_set(&state_ptr->lookup, key, &name);
+    // Publish the entry only once it is complete.
+    katomic_store_u32(&state_ptr->count, name + 1);
+
+    kmutex_unlock(&state_ptr->lock);
+    return name;
+}
+
+kname kname_find(const char* str) {
+    if (!state_ptr || !str || !str[0]) {
+        return INVALID_KNAME;
+    }
+
+    u64 hash = khash_bytes(str, string_length(str), 0);
+    u64 key = 0;
+    kmutex_lock(&state_ptr->lock);
+    kname name = find_locked(str, hash, &key);
+    kmutex_unlock(&state_ptr->lock);
+    return name;
+}
+
+const char* kname_string_get(kname name) {
+    if (!state_ptr || name == INVALID_KNAME || name >= katomic_load_u32(&state_ptr->count)) {
+        return 0;
+    }
+    return get_entry(name)->str;
+}
+
+u64 kname_hash_get(kname name) {
+    if (!state_ptr || name == INVALID_KNAME || name >= katomic_load_u32(&state_ptr->count)) {
+        return 0;
+    }
+    return get_entry(name)->hash;
+}
+
+u32 kname_count() {
+    return state_ptr ? katomic_load_u32(&state_ptr->count) - 1 : 0;
+}
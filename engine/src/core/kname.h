@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief An interned name. Each distinct string is given a stable id the first time it
+ * is seen, so names may be compared with == and used as integer keys (i.e. in a u64_map)
+ * instead of being copied, compared and re-hashed as strings. Names are case-sensitive.
+ * The text and hash of a name are kept for as long as the name system is running.
+ */
+typedef u32 kname;
+
+/** @brief The kname for no name at all. Never returned for a valid string. */
+#define INVALID_KNAME 0
+
+/**
+ * @brief Initializes the name system. Should be called twice; once to get the memory
+ * requirement (passing state=0), and a second time passing an allocated block of
+ * memory to actually initialize the system.
+ *
+ * @param memory_requirement A pointer to hold the memory requirement as it is calculated.
+ * @param state A block of memory to hold the state or, if gathering the memory requirement, 0.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 kname_system_initialize(u64* memory_requirement, void* state);
+
+/**
+ * @brief Shuts down the name system, freeing the text of all names. Any knames obtained
+ * before are no longer valid.
+ *
+ * @param state The state block of memory.
+ */
+KAPI void kname_system_shutdown(void* state);
+
+/**
+ * @brief Obtains the kname for the given string, interning a copy of it if it has not
+ * been seen before. Safe to call from any thread.
+ *
+ * @param str The string to obtain a name for.
+ * @return The kname of the string, or INVALID_KNAME if str is 0 or empty, or the system is not running.
+ */
+KAPI kname kname_create(const char* str);
+
+/**
+ * @brief Obtains the kname for the given string only if it has already been interned, so
+ * that looking up something which may not exist never adds a name. Safe to call from any thread.
+ *
+ * @param str The string to find the name of.
+ * @return The kname of the string, or INVALID_KNAME if it has not been interned, str is 0 or empty, or the system is not running.
+ */
+KAPI kname kname_find(const char* str);
+
+/**
+ * @brief Obtains the text of the given name. The returned string must not be modified,
+ * and remains valid until the name system is shut down.
+ *
+ * @param name The name to obtain the text of.
+ * @return The text of the name, or 0 if the name is invalid.
+ */
+KAPI const char* kname_string_get(kname name);
+
+/**
+ * @brief Obtains the hash of the given name's text, as computed by khash_string when
+ * the name was interned.
+ *
+ * @param name The name to obtain the hash of.
+ * @return The hash of the name, or 0 if the name is invalid.
+ */
+KAPI u64 kname_hash_get(kname name);
+
+/** @brief Returns the number of distinct names interned so far. */
+KAPI u32 kname_count();
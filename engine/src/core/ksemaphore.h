@@ -0,0 +1,43 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * A semaphore to be used for synchronization purposes. A semaphore holds
+ * a count which signalling increments and waiting decrements, blocking
+ * the waiting thread while the count is zero. Unlike polling with a sleep,
+ * a waiting thread uses no CPU time and wakes as soon as it is signalled.
+ */
+typedef struct ksemaphore {
+    void *internal_data;
+} ksemaphore;
+
+/**
+ * Creates a semaphore.
+ * @param out_semaphore A pointer to hold the created semaphore.
+ * @param max_count The maximum count the semaphore can hold. Signals beyond this fail.
+ * @param start_count The count to start at. Must not be greater than max_count.
+ * @returns True if created successfully; otherwise false.
+ */
+KAPI b8 ksemaphore_create(ksemaphore *out_semaphore, u32 max_count, u32 start_count);
+
+/**
+ * @brief Destroys the provided semaphore. No thread may be waiting on it.
+ *
+ * @param semaphore A pointer to the semaphore to be destroyed.
+ */
+KAPI void ksemaphore_destroy(ksemaphore *semaphore);
+
+/**
+ * Increments the count of the semaphore, waking a thread waiting on it if there is one.
+ * @param semaphore A pointer to the semaphore.
+ * @returns True if signalled successfully; otherwise false.
+ */
+KAPI b8 ksemaphore_signal(ksemaphore *semaphore);
+
+/**
+ * Waits until the count of the semaphore is above zero, then decrements it.
+ * @param semaphore A pointer to the semaphore.
+ * @returns True once the count was decremented; false if an error occurred.
+ */
+KAPI b8 ksemaphore_wait(ksemaphore *semaphore);
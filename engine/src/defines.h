@@ -130,6 +130,17 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #define KNOINLINE
 #endif
 
+// Thread-local storage
+#if defined(_MSC_VER) && !defined(__clang__)
+#define KTHREAD_LOCAL __declspec(thread)
+#else
+#define KTHREAD_LOCAL _Thread_local
+#endif
+
+// The assumed size of a cache line. Values written by different threads are kept at
+// least this far apart, so that writing one does not invalidate the other's line.
+#define KCACHE_LINE_SIZE 64
+
 /** @brief Gets the number of bytes from amount of gibibytes (GiB) (1024 * 1024 * 1024) */
 #define GIBIBYTES(amount) (amount * 1024 * 1024 * 1024)
 /** @brief Gets the number of bytes from amount of mebibytes (MiB) (1024 * 1024) */
@@ -12,7 +12,8 @@ extern b8 create_game(game* out_game);
  */
 int main(void) {
     // Request the game instance from the application.
-    game game_inst;
+    // Zeroed, so any config the game leaves unset takes its default.
+    game game_inst = {};
     if (!create_game(&game_inst)) {
         KFATAL("Could not create game!");
         return -1;
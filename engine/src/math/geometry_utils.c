@@ -2,6 +2,8 @@
 
 #include "kmath.h"
 #include "core/logger.h"
+#include "core/kmemory.h"
+#include "memory/scratch_allocator.h"
 
 void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
     for (u32 i = 0; i < index_count; i += 3) {
@@ -76,8 +78,9 @@ void reassign_index(u32 index_count, u32* indices, u32 from, u32 to) {
 }
 
 void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices) {
-    // Create new arrays for the collection to sit in.
-    vertex_3d* unique_verts = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    // Collect unique vertices in scratch memory, since the final count is not yet known.
+    scratch_marker scratch = scratch_allocator_begin();
+    vertex_3d* unique_verts = scratch_allocator_allocate(sizeof(vertex_3d) * vertex_count, 16);
     *out_vertex_count = 0;
 
     u32 found_count = 0;
@@ -104,8 +107,8 @@ void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 in
     *out_vertices = kallocate(sizeof(vertex_3d) * (*out_vertex_count), MEMORY_TAG_ARRAY);
     // Copy over unique
     kcopy_memory(*out_vertices, unique_verts, sizeof(vertex_3d) * (*out_vertex_count));
-    // Destroy temp array
-    kfree(unique_verts, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    // Release the temp array.
+    scratch_allocator_end(scratch);
 
     u32 removed_count = vertex_count - *out_vertex_count;
     KDEBUG("geometry_deduplicate_vertices: removed %d vertices, orig/now %d/%d.", removed_count, vertex_count, *out_vertex_count);
@@ -5,6 +5,10 @@
 
 #include "core/kmemory.h"
 
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
 #define K_PI 3.14159265358979323846f
 #define K_PI_2 2.0f * K_PI
 #define K_HALF_PI 0.5f * K_PI
@@ -49,6 +53,51 @@ KINLINE b8 is_power_of_2(u64 value) {
     return (value != 0) && ((value & (value - 1)) == 0);
 }
 
+/**
+ * Obtains the index of the lowest set bit in the value.
+ * @param value The value to be interpreted. Must not be 0.
+ * @returns The number of trailing zero bits.
+ */
+KINLINE u32 count_trailing_zeros_u32(u32 value) {
+#if _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctz(value);
+#endif
+}
+
+/**
+ * Obtains the index of the lowest set bit in the value.
+ * @param value The value to be interpreted. Must not be 0.
+ * @returns The number of trailing zero bits.
+ */
+KINLINE u32 count_trailing_zeros_u64(u64 value) {
+#if _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctzll(value);
+#endif
+}
+
+/**
+ * Obtains the index of the highest set bit in the value, i.e. floor(log2(value)).
+ * @param value The value to be interpreted. Must not be 0.
+ * @returns The index of the highest set bit.
+ */
+KINLINE u32 highest_bit_index_u64(u64 value) {
+#if _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (u32)index;
+#else
+    return 63 - (u32)__builtin_clzll(value);
+#endif
+}
+
 KAPI i32 krandom();
 KAPI i32 krandom_in_range(i32 min, i32 max);
 
@@ -5,11 +5,54 @@
 #include "core/logger.h"
 #include "containers/freelist.h"
 
+// The size of a single slab. Slabs are aligned to their size, so the slab owning
+// a block can be found by masking the block's address.
+#define SLAB_SIZE KIBIBYTES(64)
+// Space reserved at the start of each slab for its header.
+#define SLAB_HEADER_SIZE 64
+// The fraction of the allocator's total size reserved for slabs.
+#define SLAB_REGION_DIVISOR 8
+
+/**
+ * @brief A slab holds blocks of a single size class. Blocks never handed out are
+ * tracked by a bump index, so a new slab is not touched until used; freed blocks
+ * are linked through their first bytes.
+ */
+typedef struct slab {
+    struct slab* next;
+    struct slab* prev;
+    void* free_head;
+    u32 class_index;
+    u32 capacity;
+    u32 used_count;
+    u32 bump_index;
+} slab;
+
+STATIC_ASSERT(sizeof(slab) <= SLAB_HEADER_SIZE, "Slab header must fit within SLAB_HEADER_SIZE.");
+
+typedef struct slab_class {
+    // Slabs with at least one free block.
+    slab* partial;
+    u64 slab_count;
+    u64 used_blocks;
+    u64 total_blocks;
+} slab_class;
+
 typedef struct dynamic_allocator_state {
     u64 total_size;
     freelist list;
     void* freelist_block;
     void* memory_block;
+    // The size of the range managed by the freelist, starting at memory_block.
+    u64 general_size;
+
+    // The slab region, aligned to SLAB_SIZE. Pages are handed out by bump
+    // index, and returned to free_slabs once empty.
+    void* slab_region;
+    u64 slab_count;
+    u64 slab_bump_index;
+    slab* free_slabs;
+    slab_class classes[DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT];
 } dynamic_allocator_state;
 
 typedef struct alloc_header {
@@ -20,7 +63,7 @@ typedef struct alloc_header {
 // The storage size in bytes of a node's user memory block size
 #define KSIZE_STORAGE sizeof(u32)
 
-b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+static b8 create(u64 total_size, u64* memory_requirement, void* memory, b8 memory_zeroed, dynamic_allocator* out_allocator) {
     if (total_size < 1) {
         KERROR("dynamic_allocator_create cannot have a total_size of 0. Create failed.");
         return false;
@@ -29,11 +72,18 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
         KERROR("dynamic_allocator_create requires memory_requirement to exist. Create failed.");
         return false;
     }
+    // Reserve part of the space for slabs, provided there is enough to be worth it.
+    u64 slab_count = (total_size / SLAB_REGION_DIVISOR) / SLAB_SIZE;
+    u64 slab_region_size = slab_count * SLAB_SIZE;
+    u64 general_size = total_size - slab_region_size;
+
     u64 freelist_requirement = 0;
     // Grab the memory requirement for the free list first.
-    freelist_create(total_size, &freelist_requirement, 0, 0);
+    freelist_create(general_size, &freelist_requirement, 0, 0);
 
-    *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size;
+    // Extra space is required to align the slab region.
+    u64 slab_padding = slab_count ? SLAB_SIZE : 0;
+    *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size + slab_padding;
 
     // If only obtaining requirement, boot out.
     if (!memory) {
@@ -43,25 +93,45 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
     // Memory layout:
     // state
     // freelist block
-    // memory block
+    // memory block (general)
+    // padding
+    // slab region (aligned to SLAB_SIZE)
     out_allocator->memory = memory;
     dynamic_allocator_state* state = out_allocator->memory;
+    kzero_memory(state, sizeof(dynamic_allocator_state));
     state->total_size = total_size;
+    state->general_size = general_size;
     state->freelist_block = (void*)(out_allocator->memory + sizeof(dynamic_allocator_state));
     state->memory_block = (void*)(state->freelist_block + freelist_requirement);
+    state->slab_count = slab_count;
+    if (slab_count) {
+        state->slab_region = (void*)get_aligned((u64)state->memory_block + general_size, SLAB_SIZE);
+    }
 
     // Actually create the freelist
-    freelist_create(total_size, &freelist_requirement, state->freelist_block, &state->list);
+    if (memory_zeroed) {
+        freelist_create_zeroed(general_size, &freelist_requirement, state->freelist_block, &state->list);
+    } else {
+        freelist_create(general_size, &freelist_requirement, state->freelist_block, &state->list);
+    }
 
-    kzero_memory(state->memory_block, total_size);
+    // NOTE: The managed range is deliberately not zeroed here. Touching it would commit every
+    // page of what may be a very large block up front.
     return true;
 }
 
+b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+    return create(total_size, memory_requirement, memory, false, out_allocator);
+}
+
+b8 dynamic_allocator_create_zeroed(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+    return create(total_size, memory_requirement, memory, true, out_allocator);
+}
+
 b8 dynamic_allocator_destroy(dynamic_allocator* allocator) {
     if (allocator) {
         dynamic_allocator_state* state = allocator->memory;
         freelist_destroy(&state->list);
-        kzero_memory(state->memory_block, state->total_size);
         state->total_size = 0;
         return true;
     }
@@ -70,21 +140,147 @@ b8 dynamic_allocator_destroy(dynamic_allocator* allocator) {
     return false;
 }
 
+static b8 is_slab_block(dynamic_allocator_state* state, void* block) {
+    return state->slab_count && (u64)block >= (u64)state->slab_region && (u64)block < (u64)state->slab_region + state->slab_count * SLAB_SIZE;
+}
+
+static void slab_list_remove(slab** head, slab* s) {
+    if (s->prev) {
+        s->prev->next = s->next;
+    } else {
+        *head = s->next;
+    }
+    if (s->next) {
+        s->next->prev = s->prev;
+    }
+    s->next = s->prev = 0;
+}
+
+static void slab_list_push(slab** head, slab* s) {
+    s->prev = 0;
+    s->next = *head;
+    if (*head) {
+        (*head)->prev = s;
+    }
+    *head = s;
+}
+
+static slab* slab_acquire(dynamic_allocator_state* state, u32 class_index) {
+    slab* s = 0;
+    if (state->free_slabs) {
+        s = state->free_slabs;
+        slab_list_remove(&state->free_slabs, s);
+    } else if (state->slab_bump_index < state->slab_count) {
+        s = (slab*)((u64)state->slab_region + state->slab_bump_index * SLAB_SIZE);
+        state->slab_bump_index++;
+    } else {
+        return 0;
+    }
+
+    s->next = s->prev = 0;
+    s->free_head = 0;
+    s->class_index = class_index;
+    s->capacity = (SLAB_SIZE - SLAB_HEADER_SIZE) / dynamic_allocator_size_class_size(class_index);
+    s->used_count = 0;
+    s->bump_index = 0;
+
+    slab_class* c = &state->classes[class_index];
+    c->slab_count++;
+    c->total_blocks += s->capacity;
+    slab_list_push(&c->partial, s);
+    return s;
+}
+
+static void* slab_allocate(dynamic_allocator_state* state, u32 class_index) {
+    slab_class* c = &state->classes[class_index];
+    slab* s = c->partial;
+    if (!s) {
+        s = slab_acquire(state, class_index);
+        if (!s) {
+            return 0;
+        }
+    }
+
+    void* block = 0;
+    if (s->free_head) {
+        block = s->free_head;
+        s->free_head = *(void**)block;
+    } else {
+        block = (void*)((u64)s + SLAB_HEADER_SIZE + s->bump_index * dynamic_allocator_size_class_size(class_index));
+        s->bump_index++;
+    }
+    s->used_count++;
+    c->used_blocks++;
+
+    // Full slabs leave the partial list until a block is freed back to them.
+    if (s->used_count == s->capacity) {
+        slab_list_remove(&c->partial, s);
+    }
+    return block;
+}
+
+static void slab_free(dynamic_allocator_state* state, void* block) {
+    slab* s = (slab*)((u64)block & ~((u64)SLAB_SIZE - 1));
+    slab_class* c = &state->classes[s->class_index];
+    b8 was_full = s->used_count == s->capacity;
+
+    *(void**)block = s->free_head;
+    s->free_head = block;
+    s->used_count--;
+    c->used_blocks--;
+
+    if (s->used_count == 0) {
+        // Empty slabs can be reused by any size class.
+        if (!was_full) {
+            slab_list_remove(&c->partial, s);
+        }
+        c->slab_count--;
+        c->total_blocks -= s->capacity;
+        slab_list_push(&state->free_slabs, s);
+    } else if (was_full) {
+        slab_list_push(&c->partial, s);
+    }
+}
+
 void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size) {
     return dynamic_allocator_allocate_aligned(allocator, size, 1);
 }
 
-void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment) {
+// The space a block takes up in the general pool.
+KINLINE u64 block_requirement(u64 size, u16 alignment) {
+    // The size required is based on the requested size, plus the alignment, header and a u32 to hold
+    // the size for quick/easy lookups.
+    return alignment + sizeof(alloc_header) + KSIZE_STORAGE + size;
+}
+
+u64 dynamic_allocator_size_for_block(u64 size, u16 alignment) {
+    // At most 1/SLAB_REGION_DIVISOR of the total goes to slabs, so the general pool gets the rest.
+    u64 required_size = block_requirement(size, alignment);
+    return required_size + (required_size + SLAB_REGION_DIVISOR - 2) / (SLAB_REGION_DIVISOR - 1);
+}
+
+static void* allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment, b8 report_failure) {
     if (allocator && size && alignment) {
         dynamic_allocator_state* state = allocator->memory;
-        // The size required is based on the requested size, plus the alignment, header and a u32 to hold
-        // the size for quick/easy lookups.
-        u64 required_size = alignment + sizeof(alloc_header) + KSIZE_STORAGE + size;
+
+        if (dynamic_allocator_is_small(size, alignment)) {
+            u32 class_index = dynamic_allocator_size_class_index(size);
+            void* block = slab_allocate(state, class_index);
+            if (block) {
+                return block;
+            }
+            // Out of slabs. Take the block from the general pool instead, but with the
+            // full class size and alignment so it reports the same as a slab block would.
+            size = dynamic_allocator_size_class_size(class_index);
+            alignment = DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT;
+        }
+
+        u64 required_size = block_requirement(size, alignment);
         // NOTE: This cast will really only be an issue on allocations over ~4GiB, so... don't do that.
         KASSERT_MSG(required_size < 4294967295U, "dynamic_allocator_allocate_aligned called with required size > 4 GiB. Don't do that.");
 
         u64 base_offset = 0;
-        if (freelist_allocate_block(&state->list, required_size, &base_offset)) {
+        if (freelist_try_allocate_block(&state->list, required_size, &base_offset)) {
             /*
             Memory layout:
             x bytes/void padding
@@ -96,7 +292,7 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
             void* ptr = (void*)((u64)state->memory_block + base_offset);
             // Start the alignment after enough space to hold a u32. This allows for the u32 to be stored
             // immediately before the user block, while maintaining alignment on said user block.
-            u64 aligned_block_offset = get_aligned((u64)ptr + base_offset + KSIZE_STORAGE, alignment);
+            u64 aligned_block_offset = get_aligned((u64)ptr + KSIZE_STORAGE, alignment);
             // Store the size just before the user data block
             u32* block_size = (u32*)(aligned_block_offset - KSIZE_STORAGE);
             *block_size = (u32)size;
@@ -106,10 +302,12 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
             header->alignment = alignment;
             return (void*)aligned_block_offset;
         } else {
-            KERROR("dynamic_allocator_allocate_aligned no blocks of memory large enough to allocate from.");
-            u64 available = freelist_free_space(&state->list);
-            KERROR("Requested size: %llu, total space available: %llu", size, available);
-            // TODO: Report fragmentation?
+            if (report_failure) {
+                KERROR("dynamic_allocator_allocate_aligned no blocks of memory large enough to allocate from.");
+                u64 available = freelist_free_space(&state->list);
+                KERROR("Requested size: %llu, total space available: %llu", size, available);
+                // TODO: Report fragmentation?
+            }
             return 0;
         }
     }
@@ -118,6 +316,14 @@ void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size,
     return 0;
 }
 
+void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment) {
+    return allocate_aligned(allocator, size, alignment, true);
+}
+
+void* dynamic_allocator_try_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment) {
+    return allocate_aligned(allocator, size, alignment, false);
+}
+
 b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block, u64 size) {
     return dynamic_allocator_free_aligned(allocator, block);
 }
@@ -129,8 +335,13 @@ b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block) {
     }
 
     dynamic_allocator_state* state = allocator->memory;
-    if (block < state->memory_block || block > state->memory_block + state->total_size) {
-        void* end_of_block = (void*)(state->memory_block + state->total_size);
+    if (is_slab_block(state, block)) {
+        slab_free(state, block);
+        return true;
+    }
+
+    if (block < state->memory_block || block > state->memory_block + state->general_size) {
+        void* end_of_block = (void*)(state->memory_block + state->general_size);
         KERROR("dynamic_allocator_free_aligned trying to release block (0x%p) outside of allocator range (0x%p)-(0x%p)", block, state->memory_block, end_of_block);
         return false;
     }
@@ -147,7 +358,21 @@ b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block) {
     return true;
 }
 
-b8 dynamic_allocator_get_size_alignment(void* block, u64* out_size, u16* out_alignment) {
+b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* block, u64* out_size, u16* out_alignment) {
+    if (!allocator || !block) {
+        return false;
+    }
+    dynamic_allocator_state* state = allocator->memory;
+    if (is_slab_block(state, block)) {
+        slab* s = (slab*)((u64)block & ~((u64)SLAB_SIZE - 1));
+        *out_size = dynamic_allocator_size_class_size(s->class_index);
+        *out_alignment = DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT;
+        return true;
+    }
+    if (block < state->memory_block || block >= state->memory_block + state->general_size) {
+        return false;
+    }
+
     // Get the header.
     *out_size = *(u32*)((u64)block - KSIZE_STORAGE);
     alloc_header* header = (alloc_header*)((u64)block + *out_size);
@@ -157,10 +382,27 @@ b8 dynamic_allocator_get_size_alignment(void* block, u64* out_size, u16* out_ali
 
 u64 dynamic_allocator_free_space(dynamic_allocator* allocator) {
     dynamic_allocator_state* state = allocator->memory;
-    return freelist_free_space(&state->list);
+    u64 slab_used = 0;
+    for (u32 i = 0; i < DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT; ++i) {
+        slab_used += state->classes[i].used_blocks * dynamic_allocator_size_class_size(i);
+    }
+    return freelist_free_space(&state->list) + (state->slab_count * SLAB_SIZE - slab_used);
 }
 
 u64 dynamic_allocator_total_space(dynamic_allocator* allocator) {
     dynamic_allocator_state* state = allocator->memory;
     return state->total_size;
-}
\ No newline at end of file
+}
+
+b8 dynamic_allocator_get_slab_usage(dynamic_allocator* allocator, u32 class_index, dynamic_allocator_slab_usage* out_usage) {
+    if (!allocator || !out_usage || class_index >= DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT) {
+        return false;
+    }
+    dynamic_allocator_state* state = allocator->memory;
+    slab_class* c = &state->classes[class_index];
+    out_usage->block_size = dynamic_allocator_size_class_size(class_index);
+    out_usage->used_blocks = c->used_blocks;
+    out_usage->total_blocks = c->total_blocks;
+    out_usage->slab_count = c->slab_count;
+    return true;
+}
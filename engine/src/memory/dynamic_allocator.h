@@ -2,12 +2,71 @@
 
 #include "defines.h"
 
+/** @brief Requests of up to this many bytes are served from size-class slabs, without a per-block header. */
+#define DYNAMIC_ALLOCATOR_SMALL_MAX_SIZE 256
+/** @brief The smallest slab size class in bytes. Classes are powers of two from here up to the max. */
+#define DYNAMIC_ALLOCATOR_SMALL_MIN_SIZE 16
+/** @brief The largest alignment a slab block is guaranteed to satisfy. */
+#define DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT 16
+/** @brief The number of slab size classes (16, 32, 64, 128 and 256 bytes). */
+#define DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT 5
+
 typedef struct dynamic_allocator {
     void* memory;
 } dynamic_allocator;
 
+/** @brief Occupancy information for a single slab size class. */
+typedef struct dynamic_allocator_slab_usage {
+    /** @brief The size in bytes of each block in this class. */
+    u64 block_size;
+    /** @brief The number of blocks currently handed out. */
+    u64 used_blocks;
+    /** @brief The total number of blocks held by the slabs of this class. */
+    u64 total_blocks;
+    /** @brief The number of slabs currently assigned to this class. */
+    u64 slab_count;
+} dynamic_allocator_slab_usage;
+
+/**
+ * @brief Indicates if a request of the given size and alignment is served from a slab.
+ * Such requests always result in a block of the full class size.
+ */
+KINLINE b8 dynamic_allocator_is_small(u64 size, u16 alignment) {
+    return size <= DYNAMIC_ALLOCATOR_SMALL_MAX_SIZE && alignment <= DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT;
+}
+
+/** @brief Obtains the index of the size class a small request of the given size falls into. */
+KINLINE u32 dynamic_allocator_size_class_index(u64 size) {
+    u32 index = 0;
+    u64 class_size = DYNAMIC_ALLOCATOR_SMALL_MIN_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/** @brief Obtains the block size in bytes of the size class at the given index. */
+KINLINE u64 dynamic_allocator_size_class_size(u32 index) {
+    return (u64)DYNAMIC_ALLOCATOR_SMALL_MIN_SIZE << index;
+}
+
 KAPI b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
 
+/**
+ * @brief Same as dynamic_allocator_create, but for a block of memory which is known
+ * to be zeroed already, such as fresh pages from the OS. The allocator then only
+ * writes to its bookkeeping as needed, so pages are committed as they are used
+ * rather than all up front.
+ *
+ * @param total_size The total size in bytes the allocator should manage.
+ * @param memory_requirement A pointer to hold the memory requirement for the allocator.
+ * @param memory 0, or a pre-allocated, zeroed block of memory for the allocator to use.
+ * @param out_allocator A pointer to hold the created allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 dynamic_allocator_create_zeroed(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
+
 KAPI b8 dynamic_allocator_destroy(dynamic_allocator* allocator);
 
 KAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
@@ -22,8 +81,30 @@ KAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
  */
 KAPI void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment);
 
+/**
+ * @brief Same as dynamic_allocator_allocate_aligned, but does not report an error if
+ * the allocator is out of space. For callers with another allocator to fall back on.
+ *
+ * @param allocator A pointer to the allocator to allocate from.
+ * @param size The amount in bytes to be allocated.
+ * @param alignment The alignment in bytes.
+ * @return The aligned, allocated block of memory unless this operation fails, then 0.
+ */
+KAPI void* dynamic_allocator_try_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment);
+
 KAPI b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block, u64 size);
 
+/**
+ * @brief Obtains the smallest total_size an allocator can be created with and still hold
+ * a single block of the given size and alignment. Accounts for the block's alignment
+ * padding and header, and for the share of the allocator set aside for slabs.
+ *
+ * @param size The size of the block in bytes.
+ * @param alignment The alignment of the block in bytes.
+ * @return The total size in bytes.
+ */
+KAPI u64 dynamic_allocator_size_for_block(u64 size, u16 alignment);
+
 /**
  * @brief Frees the given block of aligned memory. Technically the same as calling
  * dynamic_allocator_free, but here for API consistency. No size is required.
@@ -36,14 +117,16 @@ KAPI b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block
 
 /**
  * @brief Obtains the size and alignment of the given block of memory. Can fail if
- * invalid data is passed.
+ * invalid data is passed, or if the block does not belong to the allocator. Blocks
+ * served from a slab report the size and alignment of their size class.
  *
+ * @param allocator A pointer to the allocator the block was allocated from.
  * @param block The block of memory.
  * @param out_size A pointer to hold the size.
  * @param out_alignment A pointer to hold the alignment.
  * @return True on success; otherwise false.
  */
-KAPI b8 dynamic_allocator_get_size_alignment(void* block, u64* out_size, u16* out_alignment);
+KAPI b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* block, u64* out_size, u16* out_alignment);
 
 KAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
 
@@ -53,4 +136,14 @@ KAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
  * @param allocator A pointer to the allocator to be examined.
  * @return The total amount of space originally available in bytes.
  */
-KAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
\ No newline at end of file
+KAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
+
+/**
+ * @brief Obtains occupancy information for the slabs of the given size class.
+ *
+ * @param allocator A pointer to the allocator to be examined.
+ * @param class_index The index of the size class. Must be less than DYNAMIC_ALLOCATOR_SIZE_CLASS_COUNT.
+ * @param out_usage A pointer to hold the usage information.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 dynamic_allocator_get_slab_usage(dynamic_allocator* allocator, u32 class_index, dynamic_allocator_slab_usage* out_usage);
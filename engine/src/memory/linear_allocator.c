@@ -3,11 +3,50 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 
+// Precedes each overflow block, so they can be found and freed again.
+typedef struct overflow_header {
+    struct overflow_header* next;
+    u64 size;
+    u16 alignment;
+} overflow_header;
+
+static void* overflow_allocate(linear_allocator* allocator, u64 size, u16 alignment) {
+    // Keep the header aligned, and the block after it at the requested alignment.
+    if (alignment < 16) {
+        alignment = 16;
+    }
+    u64 header_size = get_aligned(sizeof(overflow_header), alignment);
+    overflow_header* header = kallocate_aligned(header_size + size, alignment, MEMORY_TAG_LINEAR_ALLOCATOR);
+    if (!header) {
+        return 0;
+    }
+    header->next = allocator->overflow_blocks;
+    header->size = header_size + size;
+    header->alignment = alignment;
+    allocator->overflow_blocks = header;
+    allocator->overflow_allocated += size;
+    return ((u8*)header) + header_size;
+}
+
+static void overflow_free_all(linear_allocator* allocator) {
+    overflow_header* header = allocator->overflow_blocks;
+    while (header) {
+        overflow_header* next = header->next;
+        kfree_aligned(header, header->size, header->alignment, MEMORY_TAG_LINEAR_ALLOCATOR);
+        header = next;
+    }
+    allocator->overflow_blocks = 0;
+    allocator->overflow_allocated = 0;
+}
+
 void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator) {
     if (out_allocator) {
         out_allocator->total_size = total_size;
         out_allocator->allocated = 0;
         out_allocator->owns_memory = memory == 0;
+        out_allocator->allow_overflow = false;
+        out_allocator->overflow_allocated = 0;
+        out_allocator->overflow_blocks = 0;
         if (memory) {
             out_allocator->memory = memory;
         } else {
@@ -18,6 +57,7 @@ void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out
 void linear_allocator_destroy(linear_allocator* allocator) {
     if (allocator) {
         allocator->allocated = 0;
+        overflow_free_all(allocator);
         if (allocator->owns_memory && allocator->memory) {
             kfree(allocator->memory, allocator->total_size, MEMORY_TAG_LINEAR_ALLOCATOR);
         } 
@@ -30,6 +70,9 @@ void linear_allocator_destroy(linear_allocator* allocator) {
 void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
     if (allocator && allocator->memory) {
         if (allocator->allocated + size > allocator->total_size) {
+            if (allocator->allow_overflow) {
+                return overflow_allocate(allocator, size, 1);
+            }
             u64 remaining = allocator->total_size - allocator->allocated;
             KERROR("linear_allocator_allocate - Tried to allocate %lluB, only %lluB remaining.", size, remaining);
             return 0;
@@ -44,9 +87,49 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
     return 0;
 }
 
+void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment) {
+    if (allocator && allocator->memory) {
+        // Align the address rather than the offset, as the block itself may not be aligned.
+        u64 base = (u64)allocator->memory;
+        u64 aligned_offset = get_aligned(base + allocator->allocated, alignment) - base;
+        if (aligned_offset + size > allocator->total_size) {
+            if (allocator->allow_overflow) {
+                return overflow_allocate(allocator, size, alignment);
+            }
+            u64 remaining = allocator->total_size - allocator->allocated;
+            KERROR("linear_allocator_allocate_aligned - Tried to allocate %lluB (alignment %u), only %lluB remaining.", size, alignment, remaining);
+            return 0;
+        }
+
+        void* block = ((u8*)allocator->memory) + aligned_offset;
+        allocator->allocated = aligned_offset + size;
+        return block;
+    }
+
+    KERROR("linear_allocator_allocate_aligned - provided allocator not initialized.");
+    return 0;
+}
+
 void linear_allocator_free_all(linear_allocator* allocator) {
     if (allocator && allocator->memory) {
+        // Only the used portion can be dirty, which matters for allocators reset every frame.
+        kzero_memory(allocator->memory, allocator->allocated);
         allocator->allocated = 0;
-        kzero_memory(allocator->memory, allocator->total_size);
+        overflow_free_all(allocator);
     }
-}
\ No newline at end of file
+}
+
+linear_allocator_marker linear_allocator_get_marker(linear_allocator* allocator) {
+    return allocator ? allocator->allocated : 0;
+}
+
+void linear_allocator_free_to_marker(linear_allocator* allocator, linear_allocator_marker marker) {
+    if (allocator && allocator->memory) {
+        if (marker > allocator->allocated) {
+            KERROR("linear_allocator_free_to_marker - Marker %llu is beyond the allocated size %llu. Were markers freed out of order?", marker, allocator->allocated);
+            return;
+        }
+        kzero_memory(((u8*)allocator->memory) + marker, allocator->allocated - marker);
+        allocator->allocated = marker;
+    }
+}
@@ -7,10 +7,62 @@ typedef struct linear_allocator {
     u64 allocated;
     void* memory;
     b8 owns_memory;
+    /**
+     * @brief If true, allocations which do not fit are made from the memory system instead
+     * of failing, and held until the next free_all. Off by default; may be set after creation.
+     */
+    b8 allow_overflow;
+    /** @brief The bytes handed out from overflow blocks since the last free_all. */
+    u64 overflow_allocated;
+    /** @brief The overflow blocks held, linked through their headers. */
+    void* overflow_blocks;
 } linear_allocator;
 
+/**
+ * @brief A position within a linear allocator. Obtained before a group of allocations
+ * so that they can later be freed together, leaving earlier allocations intact. Markers
+ * may be nested, and must be freed to in the reverse order they were obtained.
+ */
+typedef u64 linear_allocator_marker;
+
 KAPI void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator);
 KAPI void linear_allocator_destroy(linear_allocator* allocator);
 
 KAPI void* linear_allocator_allocate(linear_allocator* allocator, u64 size);
+
+/**
+ * @brief Allocates a block of the given size whose address is a multiple of the given alignment.
+ * Any padding required to reach the alignment is consumed from the allocator.
+ *
+ * @param allocator A pointer to the allocator to allocate from.
+ * @param size The size of the block in bytes.
+ * @param alignment The alignment in bytes. Must be a power of 2.
+ * @return A pointer to the block on success; otherwise 0.
+ */
+KAPI void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment);
+
+/**
+ * @brief Frees everything allocated from the allocator, zeroing its block and releasing any
+ * overflow blocks.
+ *
+ * @param allocator A pointer to the allocator.
+ */
 KAPI void linear_allocator_free_all(linear_allocator* allocator);
+
+/**
+ * @brief Obtains a marker for the current position of the allocator.
+ *
+ * @param allocator A pointer to the allocator.
+ * @return A marker which may be passed to linear_allocator_free_to_marker.
+ */
+KAPI linear_allocator_marker linear_allocator_get_marker(linear_allocator* allocator);
+
+/**
+ * @brief Frees every allocation made since the given marker was obtained. As with
+ * linear_allocator_free_all, the freed memory is zeroed. Overflow blocks are only
+ * released by linear_allocator_free_all.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param marker A marker previously obtained from the same allocator.
+ */
+KAPI void linear_allocator_free_to_marker(linear_allocator* allocator, linear_allocator_marker marker);
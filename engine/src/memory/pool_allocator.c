@@ -0,0 +1,189 @@
+#include "pool_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Terminates the free list.
+#define FREE_LIST_END INVALID_ID
+
+/**
+ * Each slot has a generation, which is even while the slot is free and odd
+ * while it is in use. Both acquiring and releasing a slot advance it, so a
+ * handle is valid exactly when its generation matches that of its slot.
+ */
+typedef struct pool_allocator_state {
+    u64 element_stride;
+    u32 element_count;
+    u32 live_count;
+    // The index of the first free element, or FREE_LIST_END if full.
+    u32 free_head;
+    u16* generations;
+    u8* elements;
+} pool_allocator_state;
+
+static u64 state_size() {
+    return get_aligned(sizeof(pool_allocator_state), POOL_ALLOCATOR_ALIGNMENT);
+}
+
+static void build_free_list(pool_allocator_state* state) {
+    // Link elements in ascending order, so that low indices are handed out first.
+    for (u32 i = 0; i < state->element_count; ++i) {
+        *(u32*)(state->elements + (i * state->element_stride)) = (i + 1 < state->element_count) ? i + 1 : FREE_LIST_END;
+    }
+    state->free_head = 0;
+    state->live_count = 0;
+}
+
+b8 pool_allocator_create(u64 element_size, u32 element_count, u64* memory_requirement, void* memory, pool_allocator* out_allocator) {
+    if (element_size < sizeof(u32)) {
+        KERROR("pool_allocator_create requires an element_size of at least %u bytes. Create failed.", (u32)sizeof(u32));
+        return false;
+    }
+    if (element_count < 1 || element_count > POOL_ALLOCATOR_MAX_ELEMENT_COUNT) {
+        KERROR("pool_allocator_create requires an element_count between 1 and %u. Create failed.", POOL_ALLOCATOR_MAX_ELEMENT_COUNT);
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("pool_allocator_create requires memory_requirement to exist. Create failed.");
+        return false;
+    }
+
+    u64 element_stride = get_aligned(element_size, POOL_ALLOCATOR_ALIGNMENT);
+    u64 elements_requirement = element_stride * element_count;
+    u64 generations_requirement = sizeof(u16) * element_count;
+    *memory_requirement = state_size() + elements_requirement + generations_requirement;
+
+    if (!memory) {
+        return true;
+    }
+
+    // The block contains the state, then the elements, then the generations.
+    out_allocator->memory = memory;
+    pool_allocator_state* state = out_allocator->memory;
+    state->element_stride = element_stride;
+    state->element_count = element_count;
+    state->elements = (u8*)memory + state_size();
+    state->generations = (u16*)(state->elements + elements_requirement);
+    kzero_memory(state->generations, generations_requirement);
+    build_free_list(state);
+
+    return true;
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        pool_allocator_state* state = allocator->memory;
+        kzero_memory(state, sizeof(pool_allocator_state));
+        allocator->memory = 0;
+    }
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator, u32* out_handle) {
+    *out_handle = INVALID_ID;
+    if (!allocator || !allocator->memory) {
+        KERROR("pool_allocator_allocate requires a valid allocator.");
+        return 0;
+    }
+
+    pool_allocator_state* state = allocator->memory;
+    u32 index = state->free_head;
+    if (index == FREE_LIST_END) {
+        return 0;
+    }
+
+    u8* element = state->elements + (index * state->element_stride);
+    state->free_head = *(u32*)element;
+    kzero_memory(element, state->element_stride);
+
+    u16 generation = (state->generations[index] + 1) & POOL_HANDLE_GENERATION_MASK;
+    state->generations[index] = generation;
+    state->live_count++;
+
+    *out_handle = ((u32)generation << POOL_HANDLE_INDEX_BITS) | index;
+    return element;
+}
+
+b8 pool_allocator_free(pool_allocator* allocator, u32 handle) {
+    if (!allocator || !allocator->memory) {
+        KERROR("pool_allocator_free requires a valid allocator.");
+        return false;
+    }
+
+    pool_allocator_state* state = allocator->memory;
+    u32 index = pool_handle_index(handle);
+    // Live slots have odd generations, so a bare index into a free slot is never a handle.
+    if (handle == INVALID_ID || index >= state->element_count || (state->generations[index] & 1) == 0 || state->generations[index] != pool_handle_generation(handle)) {
+        KERROR("pool_allocator_free called with a stale or invalid handle (%u). Nothing was done.", handle);
+        return false;
+    }
+
+    state->generations[index] = (state->generations[index] + 1) & POOL_HANDLE_GENERATION_MASK;
+    *(u32*)(state->elements + (index * state->element_stride)) = state->free_head;
+    state->free_head = index;
+    state->live_count--;
+    return true;
+}
+
+void pool_allocator_free_all(pool_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        pool_allocator_state* state = allocator->memory;
+        // Bump live generations to even, so that existing handles become stale.
+        for (u32 i = 0; i < state->element_count; ++i) {
+            if (state->generations[i] & 1) {
+                state->generations[i] = (state->generations[i] + 1) & POOL_HANDLE_GENERATION_MASK;
+            }
+        }
+        build_free_list(state);
+    }
+}
+
+void* pool_allocator_get(pool_allocator* allocator, u32 handle) {
+    if (!allocator || !allocator->memory || handle == INVALID_ID) {
+        return 0;
+    }
+
+    pool_allocator_state* state = allocator->memory;
+    u32 index = pool_handle_index(handle);
+    if (index >= state->element_count || (state->generations[index] & 1) == 0 || state->generations[index] != pool_handle_generation(handle)) {
+        return 0;
+    }
+    return state->elements + (index * state->element_stride);
+}
+
+void* pool_allocator_get_by_index(pool_allocator* allocator, u32 index) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+
+    pool_allocator_state* state = allocator->memory;
+    if (index >= state->element_count || (state->generations[index] & 1) == 0) {
+        return 0;
+    }
+    return state->elements + (index * state->element_stride);
+}
+
+u32 pool_allocator_handle_at(pool_allocator* allocator, u32 index) {
+    if (!allocator || !allocator->memory) {
+        return INVALID_ID;
+    }
+
+    pool_allocator_state* state = allocator->memory;
+    if (index >= state->element_count || (state->generations[index] & 1) == 0) {
+        return INVALID_ID;
+    }
+    return ((u32)state->generations[index] << POOL_HANDLE_INDEX_BITS) | index;
+}
+
+u32 pool_allocator_capacity(pool_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    return ((pool_allocator_state*)allocator->memory)->element_count;
+}
+
+u32 pool_allocator_live_count(pool_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    return ((pool_allocator_state*)allocator->memory)->live_count;
+}
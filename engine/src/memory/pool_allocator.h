@@ -0,0 +1,136 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A pool of fixed-size elements, such as the registered resources of a
+ * system. Acquiring and releasing an element are both constant-time operations,
+ * regardless of how many elements are in use. Free elements are linked through
+ * their own first bytes, so no memory is needed for bookkeeping beyond a small
+ * generation counter per element.
+ *
+ * Elements are referred to by 32-bit handles which encode both the index of the
+ * element and its generation at the time it was acquired. Once an element is
+ * released, any handles to it become stale and are rejected, even if the slot is
+ * later reused for another element.
+ */
+typedef struct pool_allocator {
+    /** @brief The internal state of the pool. */
+    void* memory;
+} pool_allocator;
+
+/** @brief The number of low bits of a handle holding the element index. */
+#define POOL_HANDLE_INDEX_BITS 20
+/** @brief The mask applied to a handle to obtain the element index. */
+#define POOL_HANDLE_INDEX_MASK ((1U << POOL_HANDLE_INDEX_BITS) - 1)
+/** @brief The mask applied to a generation before it is stored in a handle. */
+#define POOL_HANDLE_GENERATION_MASK ((1U << (32 - POOL_HANDLE_INDEX_BITS)) - 1)
+/**
+ * @brief The maximum number of elements a pool may hold. One less than the index
+ * range allows, so that INVALID_ID is never a valid handle.
+ */
+#define POOL_ALLOCATOR_MAX_ELEMENT_COUNT POOL_HANDLE_INDEX_MASK
+/** @brief Elements are aligned to (and padded to a multiple of) this many bytes. */
+#define POOL_ALLOCATOR_ALIGNMENT 8
+
+/** @brief Obtains the element index encoded in the given handle. */
+KINLINE u32 pool_handle_index(u32 handle) {
+    return handle & POOL_HANDLE_INDEX_MASK;
+}
+
+/** @brief Obtains the generation encoded in the given handle. */
+KINLINE u32 pool_handle_generation(u32 handle) {
+    return handle >> POOL_HANDLE_INDEX_BITS;
+}
+
+/**
+ * @brief Creates a new pool allocator or obtains the memory requirement for one.
+ * Call twice; once passing 0 to memory to obtain the memory requirement, and a
+ * second time passing an allocated block to memory.
+ *
+ * @param element_size The size of a single element in bytes. Must be at least 4.
+ * @param element_count The number of elements the pool can hold. Must be between 1 and POOL_ALLOCATOR_MAX_ELEMENT_COUNT.
+ * @param memory_requirement A pointer to hold the memory requirement for the pool, including its elements.
+ * @param memory 0, or a pre-allocated block of memory for the pool to use.
+ * @param out_allocator A pointer to hold the created pool.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 pool_allocator_create(u64 element_size, u32 element_count, u64* memory_requirement, void* memory, pool_allocator* out_allocator);
+
+/**
+ * @brief Destroys the given pool. The memory block passed at creation is not
+ * freed, and should be freed by the caller afterward.
+ *
+ * @param allocator A pointer to the pool to be destroyed.
+ */
+KAPI void pool_allocator_destroy(pool_allocator* allocator);
+
+/**
+ * @brief Acquires a zeroed element from the pool.
+ *
+ * @param allocator A pointer to the pool to allocate from.
+ * @param out_handle A pointer to hold the handle of the element. Set to INVALID_ID on failure.
+ * @return A pointer to the element on success; otherwise 0 (i.e. the pool is full).
+ */
+KAPI void* pool_allocator_allocate(pool_allocator* allocator, u32* out_handle);
+
+/**
+ * @brief Releases the element referred to by the given handle back to the pool.
+ * Invalidates all handles to the element.
+ *
+ * @param allocator A pointer to the pool to free from.
+ * @param handle The handle of the element to be released.
+ * @return True on success; otherwise false (i.e. the handle is stale or invalid).
+ */
+KAPI b8 pool_allocator_free(pool_allocator* allocator, u32 handle);
+
+/**
+ * @brief Releases all elements at once, invalidating all outstanding handles.
+ *
+ * @param allocator A pointer to the pool to be cleared.
+ */
+KAPI void pool_allocator_free_all(pool_allocator* allocator);
+
+/**
+ * @brief Obtains the element referred to by the given handle.
+ *
+ * @param allocator A pointer to the pool to search.
+ * @param handle The handle of the element.
+ * @return A pointer to the element if the handle is valid; otherwise 0.
+ */
+KAPI void* pool_allocator_get(pool_allocator* allocator, u32 handle);
+
+/**
+ * @brief Obtains the element at the given index, if it is currently in use. Useful
+ * for iterating all live elements of a pool.
+ *
+ * @param allocator A pointer to the pool to search.
+ * @param index The index of the element.
+ * @return A pointer to the element if it is in use; otherwise 0.
+ */
+KAPI void* pool_allocator_get_by_index(pool_allocator* allocator, u32 index);
+
+/**
+ * @brief Obtains the current handle of the element at the given index.
+ *
+ * @param allocator A pointer to the pool to search.
+ * @param index The index of the element.
+ * @return The handle if the element is in use; otherwise INVALID_ID.
+ */
+KAPI u32 pool_allocator_handle_at(pool_allocator* allocator, u32 index);
+
+/**
+ * @brief Obtains the number of elements the pool can hold.
+ *
+ * @param allocator A pointer to the pool to be examined.
+ * @return The capacity in elements.
+ */
+KAPI u32 pool_allocator_capacity(pool_allocator* allocator);
+
+/**
+ * @brief Obtains the number of elements currently in use.
+ *
+ * @param allocator A pointer to the pool to be examined.
+ * @return The number of live elements.
+ */
+KAPI u32 pool_allocator_live_count(pool_allocator* allocator);
@@ -0,0 +1,87 @@
+#include "scratch_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// The size of the first chunk. Each further chunk is twice the size of the one before.
+#define SCRATCH_FIRST_CHUNK_SIZE MEBIBYTES(1)
+#define SCRATCH_MAX_CHUNKS 16
+
+typedef struct scratch_stack {
+    linear_allocator chunks[SCRATCH_MAX_CHUNKS];
+    u32 chunk_count;
+    // The chunk currently being allocated from. Chunks beyond it are empty.
+    u32 current_chunk;
+} scratch_stack;
+
+// The scratch stack of the current thread. Chunks are created on first use.
+static KTHREAD_LOCAL scratch_stack local_stack;
+
+static b8 chunk_fits(linear_allocator* chunk, u64 size, u16 alignment) {
+    u64 base = (u64)chunk->memory;
+    return get_aligned(base + chunk->allocated, alignment) + size <= base + chunk->total_size;
+}
+
+scratch_marker scratch_allocator_begin() {
+    scratch_marker marker;
+    marker.chunk_index = local_stack.current_chunk;
+    marker.chunk_marker = local_stack.chunk_count ? linear_allocator_get_marker(&local_stack.chunks[local_stack.current_chunk]) : 0;
+    return marker;
+}
+
+void* scratch_allocator_allocate(u64 size, u16 alignment) {
+    scratch_stack* stack = &local_stack;
+    if (stack->chunk_count && chunk_fits(&stack->chunks[stack->current_chunk], size, alignment)) {
+        return linear_allocator_allocate_aligned(&stack->chunks[stack->current_chunk], size, alignment);
+    }
+
+    // Move on to the next chunk, which is empty.
+    u32 next = stack->chunk_count ? stack->current_chunk + 1 : 0;
+    if (next < stack->chunk_count && !chunk_fits(&stack->chunks[next], size, alignment)) {
+        // Too small for this request. Drop it and any after it to make room for one large enough.
+        for (u32 i = next; i < stack->chunk_count; ++i) {
+            linear_allocator_destroy(&stack->chunks[i]);
+        }
+        stack->chunk_count = next;
+    }
+    if (next == stack->chunk_count) {
+        if (next == SCRATCH_MAX_CHUNKS) {
+            KERROR("scratch_allocator_allocate - Out of chunks, unable to allocate %lluB.", size);
+            return 0;
+        }
+        u64 chunk_size = (u64)SCRATCH_FIRST_CHUNK_SIZE << next;
+        while (chunk_size < size + alignment) {
+            chunk_size <<= 1;
+        }
+        linear_allocator_create(chunk_size, 0, &stack->chunks[next]);
+        stack->chunk_count++;
+    }
+    stack->current_chunk = next;
+    return linear_allocator_allocate_aligned(&stack->chunks[next], size, alignment);
+}
+
+void scratch_allocator_end(scratch_marker marker) {
+    scratch_stack* stack = &local_stack;
+    if (!stack->chunk_count) {
+        return;
+    }
+    if (marker.chunk_index > stack->current_chunk) {
+        KERROR("scratch_allocator_end - Marker is ahead of the current position. Were scopes ended out of order?");
+        return;
+    }
+
+    // Empty every chunk moved on to since the marker, then rewind the one it was in.
+    for (u32 i = marker.chunk_index + 1; i <= stack->current_chunk; ++i) {
+        linear_allocator_free_all(&stack->chunks[i]);
+    }
+    stack->current_chunk = marker.chunk_index;
+    linear_allocator_free_to_marker(&stack->chunks[marker.chunk_index], marker.chunk_marker);
+}
+
+void scratch_allocator_thread_shutdown() {
+    for (u32 i = 0; i < local_stack.chunk_count; ++i) {
+        linear_allocator_destroy(&local_stack.chunks[i]);
+    }
+    local_stack.chunk_count = 0;
+    local_stack.current_chunk = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+#include "memory/linear_allocator.h"
+
+/**
+ * @brief A per-thread stack of scratch memory for temporary buffers, such as
+ * those used by resource loaders while parsing. Scopes are opened with
+ * scratch_allocator_begin and closed with scratch_allocator_end, which frees
+ * everything allocated within the scope at once. Scopes may be nested.
+ *
+ * The stack grows by adding larger chunks as needed, which are kept for reuse
+ * once freed. This means that after warming up, scratch allocations never touch
+ * the global allocator. Memory obtained from a thread's scratch stack must not
+ * outlive the scope it was allocated in, nor be freed by any other means.
+ */
+
+/** @brief A position in the calling thread's scratch stack. */
+typedef struct scratch_marker {
+    /** @brief The index of the chunk in use when the marker was obtained. */
+    u32 chunk_index;
+    /** @brief The position within that chunk. */
+    linear_allocator_marker chunk_marker;
+} scratch_marker;
+
+/**
+ * @brief Opens a scratch scope on the calling thread.
+ *
+ * @return A marker to be passed to scratch_allocator_end to close the scope.
+ */
+KAPI scratch_marker scratch_allocator_begin();
+
+/**
+ * @brief Allocates zeroed memory from the calling thread's scratch stack. The
+ * memory remains valid until the enclosing scope is ended.
+ *
+ * @param size The size of the allocation in bytes.
+ * @param alignment The alignment in bytes. Must be a power of 2.
+ * @return A pointer to the allocated block on success; otherwise 0.
+ */
+KAPI void* scratch_allocator_allocate(u64 size, u16 alignment);
+
+/**
+ * @brief Closes a scratch scope, freeing everything allocated since the given
+ * marker was obtained on the calling thread.
+ *
+ * @param marker The marker returned by the matching scratch_allocator_begin.
+ */
+KAPI void scratch_allocator_end(scratch_marker marker);
+
+/**
+ * @brief Releases all scratch memory held by the calling thread. Should be called
+ * before a thread that used scratch memory exits.
+ */
+KAPI void scratch_allocator_thread_shutdown();
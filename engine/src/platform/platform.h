@@ -21,6 +21,38 @@ void* platform_zero_memory(void* block, u64 size);
 void* platform_copy_memory(void* dest, const void* source, u64 size);
 void* platform_set_memory(void* dest, i32 value, u64 size);
 
+/**
+ * @brief Reserves a range of virtual memory directly from the OS. Physical pages
+ * are only committed once first touched, and read as zero until written, so
+ * large ranges may be reserved up front without cost.
+ *
+ * @param size The size of the range in bytes.
+ * @param large_pages Indicates if the range should be backed by large pages where
+ * possible, to reduce TLB misses. Falls back to regular pages if unavailable.
+ * @param out_page_size A pointer to hold the size of the pages backing the range.
+ * Decommits should be made at this granularity.
+ * @return A pointer to the start of the range on success; otherwise 0.
+ */
+void* platform_memory_reserve(u64 size, b8 large_pages, u64* out_page_size);
+
+/**
+ * @brief Releases a range of memory obtained from platform_memory_reserve.
+ *
+ * @param block The start of the range.
+ * @param size The size of the range in bytes, as passed when reserved.
+ */
+void platform_memory_release(void* block, u64 size);
+
+/**
+ * @brief Returns the physical pages backing part of a reserved range to the OS,
+ * keeping the range itself reserved. The range is recommitted on the next touch
+ * and reads as zero afterward.
+ *
+ * @param block The start of the range. Must be aligned to the page size.
+ * @param size The size of the range in bytes. Must be a multiple of the page size.
+ */
+void platform_memory_decommit(void* block, u64 size);
+
 void platform_console_write(const char* message, u8 colour);
 void platform_console_write_error(const char* message, u8 colour);
 
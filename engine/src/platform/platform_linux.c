@@ -8,6 +8,8 @@
 #include "core/input.h"
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/katomic.h"
 
 #include "containers/darray.h"
 
@@ -25,8 +27,12 @@
 #endif
 
 #include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>        // sched_yield
 #include <errno.h>        // For error reporting
 #include <sys/sysinfo.h>  // Processor info
+#include <sys/mman.h>     // Virtual memory
+#include <unistd.h>       // Page size
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -306,6 +312,45 @@ void* platform_set_memory(void* dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
 
+// The size of a huge page. Reservations are rounded up to this so they can be backed by huge pages.
+#define LINUX_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+void* platform_memory_reserve(u64 size, b8 large_pages, u64* out_page_size) {
+    size = get_aligned(size, LINUX_HUGE_PAGE_SIZE);
+    *out_page_size = sysconf(_SC_PAGESIZE);
+    void* block = MAP_FAILED;
+    if (large_pages) {
+        // Explicit huge pages only succeed if the system has a pool of them set aside.
+        block = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED) {
+            *out_page_size = LINUX_HUGE_PAGE_SIZE;
+            return block;
+        }
+    }
+
+    block = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        KERROR("platform_memory_reserve failed to reserve %llu bytes: %s", size, strerror(errno));
+        return 0;
+    }
+    if (large_pages) {
+        // Otherwise ask for transparent huge pages, which the kernel uses where it can.
+        madvise(block, size, MADV_HUGEPAGE);
+    }
+    return block;
+}
+
+void platform_memory_release(void* block, u64 size) {
+    if (block) {
+        munmap(block, get_aligned(size, LINUX_HUGE_PAGE_SIZE));
+    }
+}
+
+void platform_memory_decommit(void* block, u64 size) {
+    // Private anonymous pages read as zero after this, and are faulted back in on the next touch.
+    madvise(block, size, MADV_DONTNEED);
+}
+
 void platform_console_write(const char* message, u8 colour) {
     // FATAL,ERROR,WARN,INFO,DEBUG,TRACE
     const char* colour_strings[] = {"0;41", "1;31", "1;33", "1;32", "1;34", "1;30"};
@@ -447,6 +492,10 @@ void kthread_sleep(kthread* thread, u64 ms) {
     platform_sleep(ms);
 }
 
+void kthread_yield() {
+    sched_yield();
+}
+
 u64 get_thread_id() {
     return (u64)pthread_self();
 }
@@ -552,6 +601,100 @@ b8 kmutex_unlock(kmutex* mutex) {
 }
 // NOTE: End mutexes
 
+// NOTE: Begin semaphores
+typedef struct linux_semaphore {
+    sem_t handle;
+    u32 max_count;
+    // POSIX semaphores have no maximum of their own. This counts signals not yet consumed
+    // by a wait, and is reserved before posting so that concurrent signals cannot pass the cap.
+    volatile u32 count;
+} linux_semaphore;
+
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 max_count, u32 start_count) {
+    if (!out_semaphore) {
+        return false;
+    }
+    if (start_count > max_count) {
+        KERROR("ksemaphore_create - start_count (%u) cannot be greater than max_count (%u).", start_count, max_count);
+        return false;
+    }
+
+    // A sem_t may not be copied once initialized, so it is initialized in place.
+    linux_semaphore* semaphore = platform_allocate(sizeof(linux_semaphore), false);
+    if (sem_init(&semaphore->handle, 0, start_count) != 0) {
+        KERROR("Semaphore creation failure! errno=%i", errno);
+        platform_free(semaphore, false);
+        return false;
+    }
+    semaphore->max_count = max_count;
+    katomic_store_u32(&semaphore->count, start_count);
+    out_semaphore->internal_data = semaphore;
+
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        linux_semaphore* s = semaphore->internal_data;
+        if (sem_destroy(&s->handle) != 0) {
+            KERROR("Unable to destroy semaphore: errno=%i", errno);
+        }
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    linux_semaphore* s = semaphore->internal_data;
+    // Reserve a place in the count first. As with ReleaseSemaphore on Windows, a signal
+    // at the maximum count simply fails.
+    u32 count = katomic_load_u32(&s->count);
+    do {
+        if (count >= s->max_count) {
+            return false;
+        }
+    } while (!katomic_compare_exchange_u32(&s->count, &count, count + 1));
+    if (sem_post(&s->handle) != 0) {
+        katomic_fetch_sub_u32(&s->count, 1);
+        switch (errno) {
+            case EOVERFLOW:
+                KERROR("Unable to signal semaphore: the maximum count would be exceeded.");
+                return false;
+            default:
+                KERROR("An handled error has occurred while signalling a semaphore: errno=%i", errno);
+                return false;
+        }
+    }
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    linux_semaphore* s = semaphore->internal_data;
+    while (sem_wait(&s->handle) != 0) {
+        switch (errno) {
+            case EINTR:
+                // Interrupted by a signal handler before the count was decremented, so wait again.
+                continue;
+            case EINVAL:
+                KERROR("Unable to wait on semaphore: the semaphore is invalid.");
+                return false;
+            default:
+                KERROR("An handled error has occurred while waiting on a semaphore: errno=%i", errno);
+                return false;
+        }
+    }
+    // Released only after the decrement, so the count never undercounts the semaphore's value.
+    katomic_fetch_sub_u32(&s->count, 1);
+    return true;
+}
+// NOTE: End semaphores
+
 void platform_get_required_extension_names(const char*** names_darray) {
     darray_push(*names_darray, &"VK_KHR_xcb_surface");  // VK_KHR_xlib_surface?
 }
@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 typedef struct platform_state {
     GLFWwindow* glfw_window;
@@ -125,6 +127,28 @@ void* platform_set_memory(void* dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
 
+void* platform_memory_reserve(u64 size, b8 large_pages, u64* out_page_size) {
+    // NOTE: Large pages are not requested here, as superpages must be committed up front on macOS.
+    *out_page_size = getpagesize();
+    void* block = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (block == MAP_FAILED) {
+        KERROR("platform_memory_reserve failed to reserve %llu bytes.", size);
+        return 0;
+    }
+    return block;
+}
+
+void platform_memory_release(void* block, u64 size) {
+    if (block) {
+        munmap(block, size);
+    }
+}
+
+void platform_memory_decommit(void* block, u64 size) {
+    // Mapping fresh pages over the range releases the old ones, and reads as zero.
+    mmap(block, size, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0);
+}
+
 void platform_console_write(const char* message, u8 colour) {
     platform_console_write_file(stdout, message, colour);
 }
@@ -8,6 +8,7 @@
 #include "core/event.h"
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
 
 #include "containers/darray.h"
 
@@ -171,6 +172,45 @@ void *platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
 
+void *platform_memory_reserve(u64 size, b8 large_pages, u64 *out_page_size) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    *out_page_size = info.dwPageSize;
+
+    if (large_pages) {
+        // Large pages require SeLockMemoryPrivilege, and are committed up front.
+        SIZE_T large_page_size = GetLargePageMinimum();
+        if (large_page_size) {
+            void *block = VirtualAlloc(0, get_aligned(size, large_page_size), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (block) {
+                // Large pages cannot be decommitted individually, so report the whole range as one page.
+                *out_page_size = get_aligned(size, large_page_size);
+                return block;
+            }
+        }
+    }
+
+    // Committed pages only take up physical memory once touched.
+    void *block = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!block) {
+        KERROR("platform_memory_reserve failed to reserve %llu bytes. Error: %u", size, GetLastError());
+        return 0;
+    }
+    return block;
+}
+
+void platform_memory_release(void *block, u64 size) {
+    if (block) {
+        VirtualFree(block, 0, MEM_RELEASE);
+    }
+}
+
+void platform_memory_decommit(void *block, u64 size) {
+    // Decommit, then recommit so the range is usable again. It reads as zero afterward.
+    VirtualFree(block, size, MEM_DECOMMIT);
+    VirtualAlloc(block, size, MEM_COMMIT, PAGE_READWRITE);
+}
+
 void platform_console_write(const char *message, u8 colour) {
     HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
     // FATAL,ERROR,WARN,INFO,DEBUG,TRACE
@@ -278,6 +318,10 @@ void kthread_sleep(kthread *thread, u64 ms) {
     platform_sleep(ms);
 }
 
+void kthread_yield() {
+    SwitchToThread();
+}
+
 u64 get_thread_id() {
     return (u64)GetCurrentThreadId();
 }
@@ -339,6 +383,50 @@ b8 kmutex_unlock(kmutex *mutex) {
 
 // NOTE: End mutexes.
 
+// NOTE: Begin semaphores
+b8 ksemaphore_create(ksemaphore *out_semaphore, u32 max_count, u32 start_count) {
+    if (!out_semaphore) {
+        return false;
+    }
+
+    out_semaphore->internal_data = CreateSemaphore(0, start_count, max_count, 0);
+    if (!out_semaphore->internal_data) {
+        KERROR("Unable to create semaphore.");
+        return false;
+    }
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    // Fails if the maximum count would be exceeded.
+    i32 result = ReleaseSemaphore(semaphore->internal_data, 1, 0);
+    return result != 0;  // 0 is a failure
+}
+
+b8 ksemaphore_wait(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+
+    DWORD result = WaitForSingleObject(semaphore->internal_data, INFINITE);
+    if (result != WAIT_OBJECT_0) {
+        KERROR("Semaphore wait failed.");
+        return false;
+    }
+    return true;
+}
+// NOTE: End semaphores.
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
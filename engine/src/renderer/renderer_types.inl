@@ -11,6 +11,7 @@
 
 struct shader;
 struct shader_uniform;
+struct linear_allocator;
 
 typedef enum renderer_backend_type {
     RENDERER_BACKEND_TYPE_VULKAN,
@@ -602,14 +603,16 @@ typedef struct render_view {
      * @brief Builds a render view packet using the provided view and meshes.
      *
      * @param self A pointer to the view to use.
+     * @param frame_allocator An allocator for any data the packet needs, which is valid until the end of the frame.
      * @param data Freeform data used to build the packet.
      * @param out_packet A pointer to hold the generated packet.
      * @return True on success; otherwise false.
      */
-    b8 (*on_build_packet)(const struct render_view* self, void* data, struct render_view_packet* out_packet);
+    b8 (*on_build_packet)(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet);
 
     /**
-     * @brief Destroys the provided render view packet.
+     * @brief Destroys the provided render view packet. Any memory obtained from the
+     * frame allocator is reclaimed when it is reset, and so should not be freed here.
      * @param self A pointer to the view to use.
      * @param packet A pointer to the packet to be destroyed.
      */
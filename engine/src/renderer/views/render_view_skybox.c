@@ -74,7 +74,7 @@ void render_view_skybox_on_resize(struct render_view* self, u32 width, u32 heigh
     }
 }
 
-b8 render_view_skybox_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+b8 render_view_skybox_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
     if (!self || !data || !out_packet) {
         KWARN("render_view_skybox_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -5,7 +5,7 @@
 #include "core/event.h"
 #include "math/kmath.h"
 #include "math/transform.h"
-#include "containers/darray.h"
+#include "memory/linear_allocator.h"
 #include "systems/material_system.h"
 #include "systems/shader_system.h"
 #include "renderer/renderer_frontend.h"
@@ -65,7 +65,7 @@ void render_view_ui_on_resize(struct render_view* self, u32 width, u32 height) {
     }
 }
 
-b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+b8 render_view_ui_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
     if (!self || !data || !out_packet) {
         KWARN("render_view_ui_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -74,22 +74,31 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, st
     mesh_packet_data* mesh_data = (mesh_packet_data*)data;
     render_view_ui_internal_data* internal_data = (render_view_ui_internal_data*)self->internal_data;
 
-    out_packet->geometries = darray_create(geometry_render_data);
     out_packet->view = self;
 
     // Set matrices, etc.
     out_packet->projection_matrix = internal_data->projection_matrix;
     out_packet->view_matrix = internal_data->view_matrix;
 
+    // Size the geometry array up front, since it lives in the frame allocator and cannot grow.
+    u32 total_geometry_count = 0;
+    for (u32 i = 0; i < mesh_data->mesh_count; ++i) {
+        total_geometry_count += mesh_data->meshes[i]->geometry_count;
+    }
+    out_packet->geometries = linear_allocator_allocate(frame_allocator, sizeof(geometry_render_data) * total_geometry_count);
+    if (total_geometry_count && !out_packet->geometries) {
+        KERROR("render_view_ui_on_build_packet - Failed to allocate geometries from the frame allocator.");
+        return false;
+    }
+
     // Obtain all geometries from the current scene.
     // Iterate all meshes and add them to the packet's geometries collection
     for (u32 i = 0; i < mesh_data->mesh_count; ++i) {
         mesh* m = mesh_data->meshes[i];
         for (u32 j = 0; j < m->geometry_count; ++j) {
-            geometry_render_data render_data;
-            render_data.geometry = m->geometries[j];
-            render_data.model = transform_get_world(&m->transform);
-            darray_push(out_packet->geometries, render_data);
+            geometry_render_data* render_data = &out_packet->geometries[out_packet->geometry_count];
+            render_data->geometry = m->geometries[j];
+            render_data->model = transform_get_world(&m->transform);
             out_packet->geometry_count++;
         }
     }
@@ -98,7 +107,7 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, st
 }
 
 void render_view_ui_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
-    darray_destroy(packet->geometries);
+    // Geometries are owned by the frame allocator, so just zero out.
     kzero_memory(packet, sizeof(render_view_packet));
 }
 
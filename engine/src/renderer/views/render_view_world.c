@@ -5,7 +5,8 @@
 #include "core/event.h"
 #include "math/kmath.h"
 #include "math/transform.h"
-#include "containers/darray.h"
+#include "memory/linear_allocator.h"
+#include "containers/sort.h"
 #include "systems/material_system.h"
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
@@ -22,24 +23,6 @@ typedef struct render_view_world_internal_data {
     u32 render_mode;
 } render_view_world_internal_data;
 
-/** @brief A private structure used to sort geometry by distance from the camera. */
-typedef struct geometry_distance {
-    /** @brief The geometry render data. */
-    geometry_render_data g;
-    /** @brief The distance from the camera. */
-    f32 distance;
-} geometry_distance;
-
-/**
- * @brief A private, recursive, in-place sort function for geometry_distance structures.
- *
- * @param arr The array of geometry_distance structures to be sorted.
- * @param low_index The low index to start the sort from (typically 0)
- * @param high_index The high index to end with (typically the array length - 1)
- * @param ascending True to sort in ascending order; otherwise descending.
- */
-static void quick_sort(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending);
-
 static b8 render_view_on_event(u16 code, void* sender, void* listener_inst, event_context context) {
     render_view* self = (render_view*)listener_inst;
     if (!self) {
@@ -134,7 +117,7 @@ void render_view_world_on_resize(struct render_view* self, u32 width, u32 height
     }
 }
 
-b8 render_view_world_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+b8 render_view_world_on_build_packet(const struct render_view* self, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet) {
     if (!self || !data || !out_packet) {
         KWARN("render_view_world_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -143,7 +126,6 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
     mesh_packet_data* mesh_data = (mesh_packet_data*)data;
     render_view_world_internal_data* internal_data = (render_view_world_internal_data*)self->internal_data;
 
-    out_packet->geometries = darray_create(geometry_render_data);
     out_packet->view = self;
 
     // Set matrices, etc.
@@ -152,9 +134,27 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
     out_packet->view_position = camera_position_get(internal_data->world_camera);
     out_packet->ambient_color = internal_data->ambient_color;
 
+    // Size the arrays up front, since they live in the frame allocator and cannot grow.
+    // Transparent geometries are gathered separately to be sorted, so either array
+    // could hold all of them. They are sorted by key along with their index, so that
+    // the geometries themselves are only moved once, into the packet.
+    u32 total_geometry_count = 0;
+    for (u32 i = 0; i < mesh_data->mesh_count; ++i) {
+        total_geometry_count += mesh_data->meshes[i]->geometry_count;
+    }
+    out_packet->geometries = linear_allocator_allocate(frame_allocator, sizeof(geometry_render_data) * total_geometry_count);
+    geometry_render_data* transparent_geometries = linear_allocator_allocate(frame_allocator, sizeof(geometry_render_data) * total_geometry_count);
+    // Keys and indices, followed by the scratch space needed to sort them.
+    u32* sort_buffer = linear_allocator_allocate(frame_allocator, sizeof(u32) * 4 * total_geometry_count);
+    if (total_geometry_count && (!out_packet->geometries || !transparent_geometries || !sort_buffer)) {
+        KERROR("render_view_world_on_build_packet - Failed to allocate geometries from the frame allocator.");
+        return false;
+    }
+    u32* distance_keys = sort_buffer;
+    u32* distance_indices = sort_buffer + total_geometry_count;
+
     // Obtain all geometries from the current scene.
-    
-    geometry_distance* geometry_distances = darray_create(geometry_distance);
+    u32 geometry_count = 0;
 
     for (u32 i = 0; i < mesh_data->mesh_count; ++i) {
         mesh* m = mesh_data->meshes[i];
@@ -166,7 +166,7 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
             // TODO: Add something to material to check for transparency.
             if ((m->geometries[j]->material->diffuse_map.texture->flags & TEXTURE_FLAG_HAS_TRANSPARENCY) == 0) {
                 // Only add meshes with _no_ transparency.
-                darray_push(out_packet->geometries, render_data);
+                out_packet->geometries[out_packet->geometry_count] = render_data;
                 out_packet->geometry_count++;
             } else {
                 // For meshes _with_ transparency, add them to a separate list to be sorted by distance later.
@@ -176,33 +176,30 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
                 vec3 center = vec3_transform(render_data.geometry->center, model);
                 f32 distance = vec3_distance(center, internal_data->world_camera->position);
 
-                geometry_distance gdist;
-                gdist.distance = kabs(distance);
-                gdist.g = render_data;
-
-                darray_push(geometry_distances, gdist);
+                // Inverted, so that the farthest geometry sorts first.
+                distance_keys[geometry_count] = ~sort_key_from_f32(kabs(distance));
+                distance_indices[geometry_count] = geometry_count;
+                transparent_geometries[geometry_count] = render_data;
+                geometry_count++;
             }
         }
     }
 
-    // Sort the distances
-    u32 geometry_count = darray_length(geometry_distances);
-    quick_sort(geometry_distances, 0, geometry_count - 1, false);
+    // Sort the distances, back to front.
+    radix_sort_u32_indexed(distance_keys, distance_indices, geometry_count, sort_buffer + total_geometry_count * 2, sort_buffer + total_geometry_count * 3);
 
     // Add them to the packet geometry.
     for (u32 i = 0; i < geometry_count; ++i) {
-        darray_push(out_packet->geometries, geometry_distances[i].g);
+        out_packet->geometries[out_packet->geometry_count] = transparent_geometries[distance_indices[i]];
         out_packet->geometry_count++;
     }
 
-    // Clean up.
-    darray_destroy(geometry_distances);
-
+    // NOTE: No cleanup needed, the sort buffer is reclaimed with the rest of the frame.
     return true;
 }
 
 void render_view_world_on_destroy_packet(const struct render_view* self, struct render_view_packet* packet) {
-    darray_destroy(packet->geometries);
+    // Geometries are owned by the frame allocator, so just zero out.
     kzero_memory(packet, sizeof(render_view_packet));
 }
 
@@ -268,42 +265,3 @@ b8 render_view_world_on_render(const struct render_view* self, const struct rend
 
     return true;
 }
-
-// Quicksort for geometry_distance
-
-static void swap(geometry_distance* a, geometry_distance* b) {
-    geometry_distance temp = *a;
-    *a = *b;
-    *b = temp;
-}
-
-static i32 partition(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending) {
-    geometry_distance pivot = arr[high_index];
-    i32 i = (low_index - 1);
-
-    for (i32 j = low_index; j <= high_index - 1; ++j) {
-        if (ascending) {
-            if (arr[j].distance < pivot.distance) {
-                ++i;
-                swap(&arr[i], &arr[j]);
-            }
-        } else {
-            if (arr[j].distance > pivot.distance) {
-                ++i;
-                swap(&arr[i], &arr[j]);
-            }
-        }
-    }
-    swap(&arr[i + 1], &arr[high_index]);
-    return i + 1;
-}
-
-static void quick_sort(geometry_distance arr[], i32 low_index, i32 high_index, b8 ascending) {
-    if (low_index < high_index) {
-        i32 partition_index = partition(arr, low_index, high_index, ascending);
-
-        // Independently sort elements before and after the partition index.
-        quick_sort(arr, low_index, partition_index - 1, ascending);
-        quick_sort(arr, partition_index + 1, high_index, ascending);
-    }
-}
\ No newline at end of file
@@ -137,7 +137,8 @@ void* vulkan_alloc_reallocation(void* user_data, void* original, size_t size, si
         return 0;
     }
 
-    if (alloc_alignment != alignment) {
+    // NOTE: Small blocks may come back with a stricter alignment than was requested, which is fine.
+    if (alloc_alignment < alignment) {
         KERROR("Attempted realloc using a different alignment of %llu than the original of %hu.", alignment, alloc_alignment);
         return 0;
     }
@@ -410,8 +411,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_
     }
 
     // The renderpass table will be a lookup of array indices. Start off every index with an invalid id.
-    context.renderpass_table_block = kallocate(sizeof(u32) * VULKAN_MAX_REGISTERED_RENDERPASSES, MEMORY_TAG_RENDERER);
-    hashtable_create(sizeof(u32), VULKAN_MAX_REGISTERED_RENDERPASSES, context.renderpass_table_block, false, &context.renderpass_table);
+    hashtable_create(sizeof(u32), VULKAN_MAX_REGISTERED_RENDERPASSES, false, &context.renderpass_table);
     u32 value = INVALID_ID;
     hashtable_fill(&context.renderpass_table, &value);
 
@@ -497,10 +497,8 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const renderer_
     }
     renderer_renderbuffer_bind(&context.object_index_buffer, 0);
 
-    // Mark all geometries as invalid
-    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
-        context.geometries[i].id = INVALID_ID;
-    }
+    // Create the slot map for geometry data.
+    slot_map_create(sizeof(vulkan_geometry_data), VULKAN_MAX_GEOMETRY_COUNT, &context.geometries);
 
     KINFO("Vulkan renderer initialized successfully.");
     return true;
@@ -515,6 +513,12 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     renderer_renderbuffer_destroy(&context.object_vertex_buffer);
     renderer_renderbuffer_destroy(&context.object_index_buffer);
 
+    // Geometry data
+    slot_map_destroy(&context.geometries);
+
+    // Renderpass lookup
+    hashtable_destroy(&context.renderpass_table);
+
     // Sync objects
     for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
         if (context.image_available_semaphores[i]) {
@@ -1117,7 +1121,11 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
 
     vulkan_geometry_data* internal_data = 0;
     if (is_reupload) {
-        internal_data = &context.geometries[geometry->internal_id];
+        internal_data = slot_map_get(&context.geometries, geometry->internal_id);
+        if (!internal_data) {
+            KERROR("vulkan_renderer_create_geometry called to reupload a geometry with a stale internal_id.");
+            return false;
+        }
 
         // Take a copy of the old range.
         old_range.index_buffer_offset = internal_data->index_buffer_offset;
@@ -1127,14 +1135,12 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
         old_range.vertex_count = internal_data->vertex_count;
         old_range.vertex_element_size = internal_data->vertex_element_size;
     } else {
-        for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
-            if (context.geometries[i].id == INVALID_ID) {
-                // Found a free index.
-                geometry->internal_id = i;
-                context.geometries[i].id = i;
-                internal_data = &context.geometries[i];
-                break;
-            }
+        u32 handle = INVALID_ID;
+        internal_data = slot_map_insert(&context.geometries, 0, &handle);
+        if (internal_data) {
+            geometry->internal_id = handle;
+            internal_data->id = handle;
+            internal_data->generation = INVALID_ID;
         }
     }
     if (!internal_data) {
@@ -1202,7 +1208,11 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
 void vulkan_renderer_destroy_geometry(geometry* geometry) {
     if (geometry && geometry->internal_id != INVALID_ID) {
         vkDeviceWaitIdle(context.device.logical_device);
-        vulkan_geometry_data* internal_data = &context.geometries[geometry->internal_id];
+        vulkan_geometry_data* internal_data = slot_map_get(&context.geometries, geometry->internal_id);
+        if (!internal_data) {
+            KERROR("vulkan_renderer_destroy_geometry called for a geometry with no uploaded data. Nothing was done.");
+            return;
+        }
 
         // Free vertex data
         if (!renderer_renderbuffer_free(&context.object_vertex_buffer, internal_data->vertex_element_size * internal_data->vertex_count, internal_data->vertex_buffer_offset)) {
@@ -1216,10 +1226,9 @@ void vulkan_renderer_destroy_geometry(geometry* geometry) {
             }
         }
 
-        // Clean up data.
-        kzero_memory(internal_data, sizeof(vulkan_geometry_data));
-        internal_data->id = INVALID_ID;
-        internal_data->generation = INVALID_ID;
+        // Clean up data, and erase the entry.
+        slot_map_erase(&context.geometries, internal_data->id);
+        geometry->internal_id = INVALID_ID;
     }
 }
 
@@ -1229,7 +1238,11 @@ void vulkan_renderer_draw_geometry(geometry_render_data* data) {
         return;
     }
 
-    vulkan_geometry_data* buffer_data = &context.geometries[data->geometry->internal_id];
+    vulkan_geometry_data* buffer_data = slot_map_get(&context.geometries, data->geometry->internal_id);
+    if (!buffer_data) {
+        KERROR("vulkan_renderer_draw_geometry called for a geometry with a stale internal_id.");
+        return;
+    }
     b8 includes_index_data = buffer_data->index_count > 0;
     if (!vulkan_buffer_draw(&context.object_vertex_buffer, buffer_data->vertex_buffer_offset, buffer_data->vertex_count, includes_index_data)) {
         KERROR("vulkan_renderer_draw_geometry failed to draw vertex buffer;");
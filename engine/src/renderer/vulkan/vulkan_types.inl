@@ -5,6 +5,7 @@
 #include "renderer/renderer_types.inl"
 #include "containers/freelist.h"
 #include "containers/hashtable.h"
+#include "containers/slot_map.h"
 
 #include <vulkan/vulkan.h>
 
@@ -138,7 +139,7 @@ typedef struct vulkan_pipeline
 // TODO: make configurable
 #define VULKAN_MAX_MATERIAL_COUNT 1024
 
-// Max number of simultaneously uploaded geometries
+// The number of simultaneously uploaded geometries to make room for up front.
 // TODO: make configurable
 #define VULKAN_MAX_GEOMETRY_COUNT 4096
 
@@ -146,6 +147,7 @@ typedef struct vulkan_pipeline
  * @brief Internal buffer data for geometry.
  */
 typedef struct vulkan_geometry_data {
+    /** @brief The handle of this entry within the geometry slot map. */
     u32 id;
     u32 generation;
     u32 vertex_count;
@@ -338,7 +340,6 @@ typedef struct vulkan_context {
 
     vulkan_swapchain swapchain;
 
-    void* renderpass_table_block;
     hashtable renderpass_table;
 
     renderpass registered_passes[VULKAN_MAX_REGISTERED_RENDERPASSES];
@@ -366,8 +367,8 @@ typedef struct vulkan_context {
 
     b8 recreating_swapchain;
 
-    // TODO: make dynamic
-    vulkan_geometry_data geometries[VULKAN_MAX_GEOMETRY_COUNT];
+    /** @brief Slot map of vulkan_geometry_data. Each geometry's internal_id is the handle of its entry. */
+    slot_map geometries;
 
     /** @brief Render targets used for world rendering. @note One per frame. */
     render_target world_render_targets[3];
@@ -36,7 +36,8 @@ b8 binary_loader_load(struct resource_loader* self, const char* name, void* para
     }
 
     // TODO: Should be using an allocator here.
-    u8* resource_data = kallocate(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
+    // The whole block is read into, so it need not be zeroed first.
+    u8* resource_data = kallocate_with_flags(sizeof(u8) * file_size, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNINITIALIZED);
     u64 read_size = 0;
     if (!filesystem_read_all_bytes(&f, resource_data, &read_size)) {
         KERROR("Unable to binary read file: %s.", full_file_path);
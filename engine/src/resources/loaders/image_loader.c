@@ -3,15 +3,43 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
+#include "memory/scratch_allocator.h"
 #include "resources/resource_types.h"
 #include "platform/filesystem.h"
 #include "systems/resource_system.h"
 #include "loader_utils.h"
 
+// Decoded images are written over entirely, so are not zeroed. They are not tracked,
+// since stb_image does not give the size of a block when freeing it.
+#define STBI_ALLOCATION_FLAGS (KALLOCATE_FLAG_UNINITIALIZED | KALLOCATE_FLAG_UNTRACKED | KALLOCATE_FLAG_CACHE_ALIGNED)
+
+static void* stbi_allocate(u64 size) {
+    return kallocate_with_flags(size, 1, MEMORY_TAG_TEXTURE, STBI_ALLOCATION_FLAGS);
+}
+
+static void stbi_free(void* block) {
+    if (block) {
+        kfree_with_flags(block, 0, 1, MEMORY_TAG_TEXTURE, STBI_ALLOCATION_FLAGS);
+    }
+}
+
+static void* stbi_reallocate(void* block, u64 old_size, u64 new_size) {
+    void* new_block = stbi_allocate(new_size);
+    if (block && new_block) {
+        kcopy_memory(new_block, block, old_size < new_size ? old_size : new_size);
+        stbi_free(block);
+    }
+    return new_block;
+}
+
 // TODO: resource loader.
 #define STB_IMAGE_IMPLEMENTATION
 // Use our own filesystem.
 #define STBI_NO_STDIO
+// Use our own allocator.
+#define STBI_MALLOC(size) stbi_allocate(size)
+#define STBI_REALLOC_SIZED(block, old_size, new_size) stbi_reallocate(block, old_size, new_size)
+#define STBI_FREE(block) stbi_free(block)
 #include "vendor/stb_image.h"
 
 b8 image_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
@@ -65,10 +93,13 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
     i32 height;
     i32 channel_count;
 
-    u8* raw_data = kallocate(file_size, MEMORY_TAG_TEXTURE);
+    // The file contents are only needed while decoding, so read them into scratch memory.
+    scratch_marker scratch = scratch_allocator_begin();
+    u8* raw_data = scratch_allocator_allocate(file_size, 16);
     if (!raw_data) {
         KERROR("Unable to read file '%s'.", full_file_path);
         filesystem_close(&f);
+        scratch_allocator_end(scratch);
         return false;
     }
 
@@ -78,23 +109,24 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
 
     if (!read_result) {
         KERROR("Unable to read file: '%s'", full_file_path);
+        scratch_allocator_end(scratch);
         return false;
     }
 
     if (bytes_read != file_size) {
         KERROR("File size if %llu does not match expected: %llu", bytes_read, file_size);
+        scratch_allocator_end(scratch);
         return false;
     }
 
     u8* data = stbi_load_from_memory(raw_data, file_size, &width, &height, &channel_count, required_channel_count);
+    scratch_allocator_end(scratch);
 
     if (!data) {
         KERROR("Image resource loader failed to load file '%s'.", full_file_path);
         return false;
     }
 
-    kfree(raw_data, file_size, MEMORY_TAG_TEXTURE);
-
     image_resource_data* resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
     resource_data->pixels = data;
     resource_data->width = width;
@@ -4,9 +4,11 @@
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "containers/darray.h"
+#include "memory/scratch_allocator.h"
 #include "resources/resource_types.h"
 #include "systems/resource_system.h"
 #include "systems/geometry_system.h"
+#include "systems/job_system.h"
 #include "math/kmath.h"
 #include "math/geometry_utils.h"
 #include "loader_utils.h"
@@ -38,12 +40,16 @@ typedef struct mesh_face_data {
 } mesh_face_data;
 
 typedef struct mesh_group_data {
-    // darray
+    // The group's range of the faces array.
     mesh_face_data* faces;
+    u32 face_count;
 } mesh_group_data;
 
+// Geometry configs are large, so are pushed with typed copies rather than by stride.
+DARRAY_DEFINE(geometry_config)
+
 b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray);
-void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data);
+void process_subobject(vec3* positions, vec3* normals, u32 normal_count, vec2* tex_coords, u32 tex_coord_count, mesh_face_data* faces, u32 face_count, geometry_config* out_data);
 b8 import_obj_material_library_file(const char* mtl_file_path);
 
 b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray);
@@ -157,19 +163,20 @@ b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray)
     filesystem_read(ksm_file, sizeof(u32), &geometry_count, &bytes_read);
 
     // Each geometry
+    darray_reserve_more(*out_geometries_darray, geometry_count);
     for (u32 i = 0; i < geometry_count; ++i) {
         geometry_config g = {};
 
         // Vertices (size/count/array)
         filesystem_read(ksm_file, sizeof(u32), &g.vertex_size, &bytes_read);
         filesystem_read(ksm_file, sizeof(u32), &g.vertex_count, &bytes_read);
-        g.vertices = kallocate(g.vertex_size * g.vertex_count, MEMORY_TAG_ARRAY);
+        g.vertices = kallocate_with_flags(g.vertex_size * g.vertex_count, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNINITIALIZED);
         filesystem_read(ksm_file, g.vertex_size * g.vertex_count, g.vertices, &bytes_read);
 
         // Indices (size/count/array)
         filesystem_read(ksm_file, sizeof(u32), &g.index_size, &bytes_read);
         filesystem_read(ksm_file, sizeof(u32), &g.index_count, &bytes_read);
-        g.indices = kallocate(g.index_size * g.index_count, MEMORY_TAG_ARRAY);
+        g.indices = kallocate_with_flags(g.index_size * g.index_count, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNINITIALIZED);
         filesystem_read(ksm_file, g.index_size * g.index_count, g.indices, &bytes_read);
 
         // Name
@@ -190,7 +197,7 @@ b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray)
         filesystem_read(ksm_file, sizeof(vertex_3d), &g.max_extents, &bytes_read);
 
         // Add to the output array.
-        darray_push(*out_geometries_darray, g);
+        *out_geometries_darray = darray_geometry_config_push(*out_geometries_darray, g);
     }
 
     filesystem_close(ksm_file);
@@ -260,6 +267,93 @@ b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geomet
     return true;
 }
 
+/**
+ * @brief Copies the next line of the given text into line_buf, without its line ending.
+ *
+ * @param cursor A pointer to the read position within the text. Advanced past the line.
+ * @param end A pointer to the end of the text.
+ * @param max_length The size of line_buf in bytes. Longer lines are truncated.
+ * @param line_buf The buffer to hold the line.
+ * @param out_line_length A pointer to hold the length of the copied line.
+ * @return True if a line was read; false if the end of the text was reached.
+ */
+static b8 read_text_line(const char** cursor, const char* end, u64 max_length, char* line_buf, u64* out_line_length) {
+    if (*cursor >= end) {
+        return false;
+    }
+
+    const char* start = *cursor;
+    const char* line_end = start;
+    while (line_end < end && *line_end != '\n') {
+        line_end++;
+    }
+    *cursor = line_end < end ? line_end + 1 : end;
+
+    // Drop the carriage return of CRLF line endings.
+    if (line_end > start && line_end[-1] == '\r') {
+        line_end--;
+    }
+
+    u64 length = line_end - start;
+    if (length > max_length - 1) {
+        length = max_length - 1;
+    }
+    kcopy_memory(line_buf, start, length);
+    line_buf[length] = 0;
+    *out_line_length = length;
+    return true;
+}
+
+typedef struct subobject_job_params {
+    vec3* positions;
+    vec3* normals;
+    u32 normal_count;
+    vec2* tex_coords;
+    u32 tex_coord_count;
+    mesh_face_data* faces;
+    u32 face_count;
+    geometry_config* out_data;
+} subobject_job_params;
+
+static b8 subobject_job_start(void* params, void* result_data) {
+    subobject_job_params* p = params;
+    process_subobject(p->positions, p->normals, p->normal_count, p->tex_coords, p->tex_coord_count, p->faces, p->face_count, p->out_data);
+    return true;
+}
+
+/**
+ * @brief Builds a geometry config from each of the given groups, adding them to the output array.
+ * De-duplication and tangent generation dominate an import, so each group is built in a job of
+ * its own, and the calling thread helps with them until all are done.
+ */
+static void process_groups(const char* name, char material_names[][64], mesh_group_data* groups, u32 group_count, vec3* positions, vec3* normals, u32 normal_count, vec2* tex_coords, u32 tex_coord_count, geometry_config** out_geometries_darray) {
+    scratch_marker scratch = scratch_allocator_begin();
+    geometry_config* configs = scratch_allocator_allocate(sizeof(geometry_config) * group_count, 16);
+    kzero_memory(configs, sizeof(geometry_config) * group_count);
+
+    job_counter built = {0};
+    for (u32 i = 0; i < group_count; ++i) {
+        string_ncopy(configs[i].name, name, 255);
+        if (i > 0) {
+            string_append_int(configs[i].name, configs[i].name, i);
+        }
+        string_ncopy(configs[i].material_name, material_names[i], 255);
+
+        subobject_job_params params = {positions, normals, normal_count, tex_coords, tex_coord_count, groups[i].faces, groups[i].face_count, &configs[i]};
+        job_info job = job_create(subobject_job_start, 0, 0, &params, sizeof(subobject_job_params), 0);
+        job.counter = &built;
+        job_system_submit(job);
+    }
+    job_wait(&built);
+
+    darray_reserve_more(*out_geometries_darray, group_count);
+    for (u32 i = 0; i < group_count; ++i) {
+        *out_geometries_darray = darray_geometry_config_push(*out_geometries_darray, configs[i]);
+        kzero_memory(material_names[i], 64);
+    }
+    scratch_allocator_end(scratch);
+}
+
 /**
  * @brief Imports an obj file. This reads the obj, creates geometry configs, then calls logic to write
  * those geometries out to a binary ksm file. That file can be used on the next load.
@@ -270,17 +364,78 @@ b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geomet
  * @return True on success; otherwise false.
  */
 b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray) {
-    // Positions
-    vec3* positions = darray_reserve(vec3, 16384);
+    // Everything parsed from the file is only needed until the geometries are built, so it
+    // all lives in scratch memory.
+    scratch_marker scratch = scratch_allocator_begin();
+
+    // Read the whole file up front, since it is scanned twice: once to size the arrays
+    // below, and once to fill them.
+    u64 file_size = 0;
+    if (!filesystem_size(obj_file, &file_size)) {
+        KERROR("Unable to get size of obj file.");
+        scratch_allocator_end(scratch);
+        return false;
+    }
+    char* text = scratch_allocator_allocate(file_size + 1, 16);
+    if (!text) {
+        KERROR("Unable to allocate memory to read obj file.");
+        scratch_allocator_end(scratch);
+        return false;
+    }
+    // NOTE: Line endings may be translated in text mode, which can read fewer bytes than
+    // the file size. So the result is not compared against it.
+    u64 text_length = 0;
+    filesystem_read_all_text(obj_file, text, &text_length);
+    const char* text_end = text + text_length;
 
-    // Normals
-    vec3* normals = darray_reserve(vec3, 16384);
+    char line_buf[512] = "";
+    u64 line_length = 0;
 
-    // Normals
-    vec2* tex_coords = darray_reserve(vec2, 16384);
+    // Count everything first.
+    u32 position_count = 0;
+    u32 normal_count = 0;
+    u32 tex_coord_count = 0;
+    u32 face_count = 0;
+    u32 group_count = 0;
+    const char* cursor = text;
+    while (read_text_line(&cursor, text_end, 512, line_buf, &line_length)) {
+        switch (line_buf[0]) {
+            case 'v':
+                if (line_buf[1] == ' ') {
+                    position_count++;
+                } else if (line_buf[1] == 'n') {
+                    normal_count++;
+                } else if (line_buf[1] == 't') {
+                    tex_coord_count++;
+                }
+                break;
+            case 'f':
+                face_count++;
+                break;
+            case 'u':
+                group_count++;
+                break;
+        }
+    }
 
-    // Faces
-    mesh_group_data* groups = darray_reserve(mesh_group_data, 4);
+    vec3* positions = scratch_allocator_allocate(sizeof(vec3) * position_count, 16);
+    vec3* normals = scratch_allocator_allocate(sizeof(vec3) * normal_count, 16);
+    vec2* tex_coords = scratch_allocator_allocate(sizeof(vec2) * tex_coord_count, 16);
+    // Faces of all groups, each group referencing its own range.
+    mesh_face_data* faces = scratch_allocator_allocate(sizeof(mesh_face_data) * face_count, 16);
+    mesh_group_data* groups = scratch_allocator_allocate(sizeof(mesh_group_data) * group_count, 16);
+    if (!positions || !normals || !tex_coords || !faces || !groups) {
+        KERROR("Unable to allocate memory to import obj file.");
+        scratch_allocator_end(scratch);
+        return false;
+    }
+
+    // Now fill them in, counting up again.
+    position_count = 0;
+    normal_count = 0;
+    tex_coord_count = 0;
+    face_count = 0;
+    group_count = 0;
 
     char material_file_name[512] = "";
     // b8 hit_name = false;
@@ -290,17 +445,10 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
     u8 current_mat_name_count = 0;
     char material_names[32][64];
 
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
-
     // index 0 is previous, 1 is previous before that.
     char prev_first_chars[2] = {0, 0};
-    while (true) {
-        if (!filesystem_read_line(obj_file, 511, &p, &line_length)) {
-            break;
-        }
-
+    cursor = text;
+    while (read_text_line(&cursor, text_end, 512, line_buf, &line_length)) {
         // Skip blank lines.
         if (line_length < 1) {
             continue;
@@ -318,7 +466,7 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                     case ' ': {
                         // Vertex position
                         vec3 pos;
-                        char t[2];
+                        char t[3];
                         sscanf(
                             line_buf,
                             "%s %f %f %f",
@@ -327,12 +475,13 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                             &pos.y,
                             &pos.z);
 
-                        darray_push(positions, pos);
+                        positions[position_count] = pos;
+                        position_count++;
                     } break;
                     case 'n': {
                         // Vertex normal
                         vec3 norm;
-                        char t[2];
+                        char t[3];
                         sscanf(
                             line_buf,
                             "%s %f %f %f",
@@ -341,12 +490,13 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                             &norm.y,
                             &norm.z);
 
-                        darray_push(normals, norm);
+                        normals[normal_count] = norm;
+                        normal_count++;
                     } break;
                     case 't': {
                         // Vertex texture coords.
                         vec2 tex_coord;
-                        char t[2];
+                        char t[3];
 
                         // NOTE: Ignoring Z if present.
                         sscanf(
@@ -356,7 +506,8 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                             &tex_coord.x,
                             &tex_coord.y);
 
-                        darray_push(tex_coords, tex_coord);
+                        tex_coords[tex_coord_count] = tex_coord;
+                        tex_coord_count++;
                     } break;
                 }
             } break;
@@ -369,9 +520,6 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                 mesh_face_data face;
                 char t[2];
 
-                u64 normal_count = darray_length(normals);
-                u64 tex_coord_count = darray_length(tex_coords);
-
                 if (normal_count == 0 || tex_coord_count == 0) {
                     sscanf(
                         line_buf,
@@ -397,8 +545,14 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                         &face.vertices[2].texcoord_index,
                         &face.vertices[2].normal_index);
                 }
-                u64 group_index = darray_length(groups) - 1;
-                darray_push(groups[group_index].faces, face);
+
+                // NOTE: Faces before any usemtl have no group (or material) to go in, and are skipped.
+                if (group_count > 0) {
+                    mesh_group_data* group = &groups[group_count - 1];
+                    group->faces[group->face_count] = face;
+                    group->face_count++;
+                    face_count++;
+                }
             } break;
             case 'm': {
                 // Material library file.
@@ -419,31 +573,10 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
                 // case 'o': {
                 //  New object. process the previous object first if we previously read anything in. This will only be true after the first object..
                 // if (hit_name) {
-                u64 group_count = darray_length(groups);
-
                 // Process each group as a subobject.
-                for (u64 i = 0; i < group_count; ++i) {
-                    geometry_config new_data = {};
-                    string_ncopy(new_data.name, name, 255);
-                    if (i > 0) {
-                        string_append_int(new_data.name, new_data.name, i);
-                    }
-                    string_ncopy(new_data.material_name, material_names[i], 255);
-
-                    process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-                    new_data.vertex_count = darray_length(new_data.vertices);
-                    new_data.vertex_size = sizeof(vertex_3d);
-                    new_data.index_count = darray_length(new_data.indices);
-                    new_data.index_size = sizeof(u32);
-
-                    darray_push(*out_geometries_darray, new_data);
-
-                    // Increment the number of objects.
-                    darray_destroy(groups[i].faces);
-                    kzero_memory(material_names[i], 64);
-                }
+                process_groups(name, material_names, groups, group_count, positions, normals, normal_count, tex_coords, tex_coord_count, out_geometries_darray);
                 current_mat_name_count = 0;
-                darray_clear(groups);
+                group_count = 0;
                 kzero_memory(name, 512);
                 //}
 
@@ -457,9 +590,11 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
             case 'u': {
                 // Any time there is a usemtl, assume a new group.
                 // New named group or smoothing group, all faces coming after should be added to it.
-                mesh_group_data new_group;
-                new_group.faces = darray_reserve(mesh_face_data, 16384);
-                darray_push(groups, new_group);
+                // Its faces follow on from those of every group before it.
+                mesh_group_data* new_group = &groups[group_count];
+                new_group->faces = &faces[face_count];
+                new_group->face_count = 0;
+                group_count++;
 
                 // usemtl
                 // Read the material name.
@@ -477,31 +612,10 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
     // Process the remaining group since the last one will not have been trigged
     // by the finding of a new name.
     // Process each group as a subobject.
-    u64 group_count = darray_length(groups);
-    for (u64 i = 0; i < group_count; ++i) {
-        geometry_config new_data = {};
-        string_ncopy(new_data.name, name, 255);
-        if (i > 0) {
-            string_append_int(new_data.name, new_data.name, i);
-        }
-        string_ncopy(new_data.material_name, material_names[i], 255);
-
-        process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-        new_data.vertex_count = darray_length(new_data.vertices);
-        new_data.vertex_size = sizeof(vertex_3d);
-        new_data.index_count = darray_length(new_data.indices);
-        new_data.index_size = sizeof(u32);
-
-        darray_push(*out_geometries_darray, new_data);
-
-        // Increment the number of objects.
-        darray_destroy(groups[i].faces);
-    }
+    process_groups(name, material_names, groups, group_count, positions, normals, normal_count, tex_coords, tex_coord_count, out_geometries_darray);
 
-    darray_destroy(groups);
-    darray_destroy(positions);
-    darray_destroy(normals);
-    darray_destroy(tex_coords);
+    // All parsed data has been turned into geometry now.
+    scratch_allocator_end(scratch);
 
     if (string_length(material_file_name) > 0) {
         // Load up the material file
@@ -516,119 +630,165 @@ b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry
         }
     }
 
-    // De-duplicate geometry
-    u32 count = darray_length(*out_geometries_darray);
-    for (u64 i = 0; i < count; ++i) {
-        geometry_config* g = &((*out_geometries_darray)[i]);
-        KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", g->name);
-
-        u32 new_vert_count = 0;
-        vertex_3d* unique_verts = 0;
-        geometry_deduplicate_vertices(g->vertex_count, g->vertices, g->index_count, g->indices, &new_vert_count, &unique_verts);
-
-        // Destroy the old, large array...
-        darray_destroy(g->vertices);
-
-        // And replace with the de-duplicated one.
-        g->vertices = unique_verts;
-        g->vertex_count = new_vert_count;
-
-        // Take a copy of the indices as a normal, non-darray
-        u32* indices = kallocate(sizeof(u32) * g->index_count, MEMORY_TAG_ARRAY);
-        kcopy_memory(indices, g->indices, sizeof(u32) * g->index_count);
-        // Destroy the darray
-        darray_destroy(g->indices);
-        // Replace with the non-darray version.
-        g->indices = indices;
-        // Also generate tangents here, this way tangents are also stored in the output file.
-        geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
-    }
-
     // Output a ksm file, which will be loaded in the future.
+    u32 count = darray_length(*out_geometries_darray);
     return write_ksm_file(out_ksm_filename, name, count, *out_geometries_darray);
 }
 
-void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data) {
-    out_data->indices = darray_create(u32);
-    out_data->vertices = darray_create(vertex_3d);
-    b8 extent_set = false;
-    kzero_memory(&out_data->min_extents, sizeof(vec3));
-    kzero_memory(&out_data->max_extents, sizeof(vec3));
-
-    u64 face_count = darray_length(faces);
-    u64 normal_count = darray_length(normals);
-    u64 tex_coord_count = darray_length(tex_coords);
+// The number of faces each chunk of process_subobject handles.
+#define SUBOBJECT_FACE_GRAIN 4096
 
-    b8 skip_normals = false;
-    b8 skip_tex_coords = false;
-    if (normal_count == 0) {
-        KWARN("No normals are present in this model.");
-        skip_normals = true;
-    }
-    if (tex_coord_count == 0) {
-        KWARN("No texture coordinates are present in this model.");
-        skip_tex_coords = true;
-    }
-    for (u64 f = 0; f < face_count; ++f) {
-        mesh_face_data face = faces[f];
+typedef struct subobject_face_context {
+    vec3* positions;
+    // Null if the object has none.
+    vec3* normals;
+    // Null if the object has none.
+    vec2* tex_coords;
+    mesh_face_data* faces;
+    vertex_3d* vertices;
+    u32* indices;
+} subobject_face_context;
+
+typedef struct subobject_extents {
+    vec3 min;
+    vec3 max;
+    b8 set;
+} subobject_extents;
+
+static void process_subobject_faces(u32 begin, u32 end, void* context, void* partial) {
+    subobject_face_context* c = context;
+    subobject_extents* extents = partial;
+    for (u64 f = begin; f < end; ++f) {
+        mesh_face_data face = c->faces[f];
 
         // Each vertex
         for (u64 i = 0; i < 3; ++i) {
             mesh_vertex_index_data index_data = face.vertices[i];
-            darray_push(out_data->indices, (u32)(i + (f * 3)));
+            c->indices[i + (f * 3)] = (u32)(i + (f * 3));
 
             vertex_3d vert;
-
-            vec3 pos = positions[index_data.position_index - 1];
+            vec3 pos = c->positions[index_data.position_index - 1];
             vert.position = pos;
 
             // Check extents - min
-            if (pos.x < out_data->min_extents.x || !extent_set) {
-                out_data->min_extents.x = pos.x;
+            if (pos.x < extents->min.x || !extents->set) {
+                extents->min.x = pos.x;
             }
-            if (pos.y < out_data->min_extents.y || !extent_set) {
-                out_data->min_extents.y = pos.y;
+            if (pos.y < extents->min.y || !extents->set) {
+                extents->min.y = pos.y;
             }
-            if (pos.z < out_data->min_extents.z || !extent_set) {
-                out_data->min_extents.z = pos.z;
+            if (pos.z < extents->min.z || !extents->set) {
+                extents->min.z = pos.z;
             }
 
             // Check extents - max
-            if (pos.x > out_data->max_extents.x || !extent_set) {
-                out_data->max_extents.x = pos.x;
+            if (pos.x > extents->max.x || !extents->set) {
+                extents->max.x = pos.x;
             }
-            if (pos.y > out_data->max_extents.y || !extent_set) {
-                out_data->max_extents.y = pos.y;
+            if (pos.y > extents->max.y || !extents->set) {
+                extents->max.y = pos.y;
             }
-            if (pos.z > out_data->max_extents.z || !extent_set) {
-                out_data->max_extents.z = pos.z;
+            if (pos.z > extents->max.z || !extents->set) {
+                extents->max.z = pos.z;
             }
 
-            extent_set = true;
+            extents->set = true;
 
-            if (skip_normals) {
+            if (!c->normals) {
                 vert.normal = vec3_create(0, 0, 1);
             } else {
-                vert.normal = normals[index_data.normal_index - 1];
+                vert.normal = c->normals[index_data.normal_index - 1];
             }
 
-            if (skip_tex_coords) {
+            if (!c->tex_coords) {
                 vert.texcoord = vec2_zero();
             } else {
-                vert.texcoord = tex_coords[index_data.texcoord_index - 1];
+                vert.texcoord = c->tex_coords[index_data.texcoord_index - 1];
             }
 
             // TODO: Color. Hardcode to white for now.
             vert.color = vec4_one();
 
-            darray_push(out_data->vertices, vert);
+            c->vertices[i + (f * 3)] = vert;
+        }
+    }
+}
+
+static void combine_subobject_extents(void* a, const void* b, void* context) {
+    subobject_extents* out = a;
+    const subobject_extents* in = b;
+    if (!in->set) {
+        return;
+    }
+    if (!out->set) {
+        *out = *in;
+        return;
+    }
+    for (u8 i = 0; i < 3; ++i) {
+        if (in->min.elements[i] < out->min.elements[i]) {
+            out->min.elements[i] = in->min.elements[i];
+        }
+        if (in->max.elements[i] > out->max.elements[i]) {
+            out->max.elements[i] = in->max.elements[i];
         }
     }
+}
+
+void process_subobject(vec3* positions, vec3* normals, u32 normal_count, vec2* tex_coords, u32 tex_coord_count, mesh_face_data* faces, u32 face_count, geometry_config* out_data) {
+    // Each face gets three vertices of its own. These are de-duplicated below, so only
+    // the indices are allocated to be kept.
+    scratch_marker scratch = scratch_allocator_begin();
+    u32 vertex_count = face_count * 3;
+    vertex_3d* vertices = scratch_allocator_allocate(sizeof(vertex_3d) * vertex_count, 16);
+    out_data->index_size = sizeof(u32);
+    out_data->index_count = vertex_count;
+    u32* indices = kallocate(sizeof(u32) * out_data->index_count, MEMORY_TAG_ARRAY);
+    out_data->indices = indices;
+
+    subobject_face_context context;
+    context.positions = positions;
+    context.normals = normal_count ? normals : 0;
+    context.tex_coords = tex_coord_count ? tex_coords : 0;
+    context.faces = faces;
+    context.vertices = vertices;
+    context.indices = indices;
+    if (normal_count == 0) {
+        KWARN("No normals are present in this model.");
+    }
+    if (tex_coord_count == 0) {
+        KWARN("No texture coordinates are present in this model.");
+    }
+
+    // Faces are independent, so large objects are split across the job threads. Each chunk
+    // tracks the extents of its own faces, which are then combined.
+    subobject_extents identity = {0};
+    subobject_extents extents;
+    job_parallel_reduce(face_count, SUBOBJECT_FACE_GRAIN, sizeof(subobject_extents), &identity, process_subobject_faces, combine_subobject_extents, &context, &extents);
+    if (extents.set) {
+        out_data->min_extents = extents.min;
+        out_data->max_extents = extents.max;
+    } else {
+        kzero_memory(&out_data->min_extents, sizeof(vec3));
+        kzero_memory(&out_data->max_extents, sizeof(vec3));
+    }
 
     // Calculate the center based on the extents.
     for (u8 i = 0; i < 3; ++i) {
         out_data->center.elements[i] = (out_data->min_extents.elements[i] + out_data->max_extents.elements[i]) / 2.0f;
     }
+
+    // De-duplicate geometry
+    KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", out_data->name);
+    vertex_3d* unique_verts = 0;
+    geometry_deduplicate_vertices(vertex_count, vertices, out_data->index_count, indices, &out_data->vertex_count, &unique_verts);
+    out_data->vertices = unique_verts;
+    out_data->vertex_size = sizeof(vertex_3d);
+
+    // The original, large array is no longer needed.
+    scratch_allocator_end(scratch);
+
+    // Also generate tangents here, this way tangents are also stored in the output file.
+    geometry_generate_tangents(out_data->vertex_count, out_data->vertices, out_data->index_count, indices);
 }
 
 // TODO: Load the material library file, and create material definitions from it.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "math/math_types.h"
+#include "core/kname.h"
 
 // Pre-defined resource types.
 typedef enum resource_type {
@@ -81,7 +82,8 @@ typedef struct texture
     u8 channel_count;
     texture_flag_bits flags;
     u32 generation;
-    char name[TEXTURE_NAME_MAX_LENGTH];
+    /** @brief The texture name. The text is held by the name system, keeping this structure small. */
+    kname name;
     void* internal_data;
 } texture;
 
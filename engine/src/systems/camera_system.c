@@ -14,7 +14,6 @@ typedef struct camera_lookup {
 typedef struct camera_system_state {
     camera_system_config config;
     hashtable lookup;
-    void* hashtable_block;
     camera_lookup* cameras;
 
     // A default, non-registered camera that always exists as a fallback.
@@ -29,11 +28,10 @@ b8 camera_system_initialize(u64* memory_requirement, void* state, camera_system_
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for array.
     u64 struct_requirement = sizeof(camera_system_state);
     u64 array_requirement = sizeof(camera_lookup) * config.max_camera_count;
-    u64 hashtable_requirement = sizeof(camera_lookup) * config.max_camera_count;
-    *memory_requirement = struct_requirement + array_requirement + hashtable_requirement;
+    *memory_requirement = struct_requirement + array_requirement;
 
     if (!state) {
         return true;
@@ -46,11 +44,8 @@ b8 camera_system_initialize(u64* memory_requirement, void* state, camera_system_
     void* array_block = state + struct_requirement;
     state_ptr->cameras = array_block;
 
-    // Hashtable block is after array.
-    void* hashtable_block = array_block + array_requirement;
-
     // Create a hashtable for camera lookups.
-    hashtable_create(sizeof(u16), config.max_camera_count, hashtable_block, false, &state_ptr->lookup);
+    hashtable_create(sizeof(u16), config.max_camera_count, false, &state_ptr->lookup);
 
     // Fill the hashtable with invalid references to use as a default.
     u16 invalid_id = INVALID_ID_U16;
@@ -80,6 +75,7 @@ void camera_system_shutdown(void* state) {
 
         //     }
         // }
+        hashtable_destroy(&s->lookup);
     }
 
     state_ptr = 0;
@@ -142,7 +138,7 @@ void camera_system_release(const char* name) {
             if (state_ptr->cameras[id].reference_count < 1) {
                 camera_reset(&state_ptr->cameras[id].c);
                 state_ptr->cameras[id].id = INVALID_ID_U16;
-                hashtable_set(&state_ptr->lookup, name, &state_ptr->cameras[id].id);
+                hashtable_remove(&state_ptr->lookup, name);
             }
         }
     }
@@ -4,6 +4,7 @@
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "math/geometry_utils.h"
+#include "memory/pool_allocator.h"
 #include "systems/material_system.h"
 #include "renderer/renderer_frontend.h"
 #include "math/geometry_utils.h"
@@ -20,8 +21,8 @@ typedef struct geometry_system_state {
     geometry default_geometry;
     geometry default_2d_geometry;
 
-    // Array of registered meshes.
-    geometry_reference* registered_geometries;
+    // Pool of registered geometries. A geometry's id is the index of its slot.
+    pool_allocator registered_geometries;
 } geometry_system_state;
 
 static geometry_system_state* state_ptr = 0;
@@ -36,9 +37,13 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for pool.
     u64 struct_requirement = sizeof(geometry_system_state);
-    u64 array_requirement = sizeof(geometry_reference) * config.max_geometry_count;
+    u64 array_requirement = 0;
+    if (!pool_allocator_create(sizeof(geometry_reference), config.max_geometry_count, &array_requirement, 0, 0)) {
+        KFATAL("geometry_system_initialize - Unable to create pool for %u geometries.", config.max_geometry_count);
+        return false;
+    }
     *memory_requirement = struct_requirement + array_requirement;
 
     if (!state) {
@@ -48,17 +53,9 @@ b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_sys
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the pointer.
+    // The pool block is after the state. Already allocated, so just create the pool in it.
     void* array_block = state + struct_requirement;
-    state_ptr->registered_geometries = array_block;
-
-    // Invalidate all geometries in the array.
-    u32 count = state_ptr->config.max_geometry_count;
-    for (u32 i = 0; i < count; ++i) {
-        state_ptr->registered_geometries[i].geometry.id = INVALID_ID;
-        state_ptr->registered_geometries[i].geometry.internal_id = INVALID_ID;
-        state_ptr->registered_geometries[i].geometry.generation = INVALID_ID_U16;
-    }
+    pool_allocator_create(sizeof(geometry_reference), config.max_geometry_count, &array_requirement, array_block, &state_ptr->registered_geometries);
 
     if (!create_default_geometries(state_ptr)) {
         KFATAL("Failed to create default geometries. Application cannot continue.");
@@ -73,9 +70,10 @@ void geometry_system_shutdown(void* state) {
 }
 
 geometry* geometry_system_acquire_by_id(u32 id) {
-    if (id != INVALID_ID && state_ptr->registered_geometries[id].geometry.id != INVALID_ID) {
-        state_ptr->registered_geometries[id].reference_count++;
-        return &state_ptr->registered_geometries[id].geometry;
+    geometry_reference* ref = id != INVALID_ID ? pool_allocator_get_by_index(&state_ptr->registered_geometries, id) : 0;
+    if (ref && ref->geometry.id != INVALID_ID) {
+        ref->reference_count++;
+        return &ref->geometry;
     }
 
     // NOTE: Should return default geometry instead?
@@ -84,25 +82,23 @@ geometry* geometry_system_acquire_by_id(u32 id) {
 }
 
 geometry* geometry_system_acquire_from_config(geometry_config config, b8 auto_release) {
-    geometry* g = 0;
-    for (u32 i = 0; i < state_ptr->config.max_geometry_count; ++i) {
-        if (state_ptr->registered_geometries[i].geometry.id == INVALID_ID) {
-            // Found empty slot.
-            state_ptr->registered_geometries[i].auto_release = auto_release;
-            state_ptr->registered_geometries[i].reference_count = 1;
-            g = &state_ptr->registered_geometries[i].geometry;
-            g->id = i;
-            break;
-        }
-    }
-
-    if (!g) {
+    u32 handle = INVALID_ID;
+    geometry_reference* ref = pool_allocator_allocate(&state_ptr->registered_geometries, &handle);
+    if (!ref) {
         KERROR("Unable to obtain free slot for geometry. Adjust configuration to allow more space. Returning nullptr.");
         return 0;
     }
 
+    ref->auto_release = auto_release;
+    ref->reference_count = 1;
+    geometry* g = &ref->geometry;
+    g->id = pool_handle_index(handle);
+    g->internal_id = INVALID_ID;
+    g->generation = INVALID_ID_U16;
+
     if (!create_geometry(state_ptr, config, g)) {
         KERROR("Failed to create geometry. Returning nullptr.");
+        pool_allocator_free(&state_ptr->registered_geometries, handle);
         return 0;
     }
 
@@ -123,11 +119,11 @@ void geometry_system_config_dispose(geometry_config* config) {
 
 void geometry_system_release(geometry* geometry) {
     if (geometry && geometry->id != INVALID_ID) {
-        geometry_reference* ref = &state_ptr->registered_geometries[geometry->id];
+        geometry_reference* ref = pool_allocator_get_by_index(&state_ptr->registered_geometries, geometry->id);
 
         // Take a copy of the id;
         u32 id = geometry->id;
-        if (ref->geometry.id == geometry->id) {
+        if (ref && ref->geometry.id == id) {
             if (ref->reference_count > 0) {
                 ref->reference_count--;
             }
@@ -137,6 +133,9 @@ void geometry_system_release(geometry* geometry) {
                 destroy_geometry(state_ptr, &ref->geometry);
                 ref->reference_count = 0;
                 ref->auto_release = false;
+
+                // Return the slot to the pool.
+                pool_allocator_free(&state_ptr->registered_geometries, pool_allocator_handle_at(&state_ptr->registered_geometries, id));
             }
         } else {
             KFATAL("Geometry id mismatch. Check registration logic, as this should never occur.");
@@ -168,9 +167,7 @@ geometry* geometry_system_get_default_2d() {
 b8 create_geometry(geometry_system_state* state, geometry_config config, geometry* g) {
     // Send the geometry off to the renderer to be uploaded to the GPU.
     if (!renderer_create_geometry(g, config.vertex_size, config.vertex_count, config.vertices, config.index_size, config.index_count, config.indices)) {
-        // Invalidate the entry.
-        state->registered_geometries[g->id].reference_count = 0;
-        state->registered_geometries[g->id].auto_release = false;
+        // Invalidate the entry. The caller returns its slot to the pool.
         g->id = INVALID_ID;
         g->generation = INVALID_ID_U16;
         g->internal_id = INVALID_ID;
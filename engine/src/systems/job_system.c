@@ -2,80 +2,232 @@
 
 #include "core/kthread.h"
 #include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/katomic.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
-#include "containers/ring_queue.h"
+#include "platform/platform.h"
+#include "memory/scratch_allocator.h"
+#include "containers/mpmc_queue.h"
+#include "containers/mpsc_queue.h"
+#include "containers/work_stealing_deque.h"
+
+// The number of priorities.
+#define JOB_PRIORITY_COUNT 3
+
+// The max number of jobs each thread can hold in each of its own deques at once.
+#define MAX_LOCAL_JOBS 256
 
 typedef struct job_thread {
-    u8 index;
+    u32 index;
     kthread thread;
-    job_info info;
-    // A mutex to guard access to this thread's info.
-    kmutex info_mutex;
 
     // The types of jobs this thread can handle.
     u32 type_mask;
+
+    // Signalled to wake the thread once it has gone to sleep waiting for jobs.
+    ksemaphore wake;
+    // Set by the thread just before it waits on wake. Whoever swaps it back to 0 owes the
+    // thread exactly one signal, so wake never holds more than one.
+    volatile u32 sleeping;
+
+    // Jobs submitted by this thread's own jobs, one deque per priority. Only this thread
+    // pushes and pops them; idle threads steal from them.
+    work_stealing_deque deques[JOB_PRIORITY_COUNT];
 } job_thread;
 
+/**
+ * A finished job's callback, waiting to be run on the main thread. Allocated in one block
+ * along with a copy of the job's result data, which immediately follows it.
+ */
 typedef struct job_result_entry {
-    u16 id;
+    // Must be first, so a node taken from the queue is its entry.
+    mpsc_queue_node node;
     pfn_job_on_complete callback;
     u32 param_size;
-    void* params;
 } job_result_entry;
 
-// The max number of job results that can be stored at once.
-#define MAX_JOB_RESULTS 512
+// The max number of jobs that can be waiting in each queue at once.
+#define MAX_QUEUED_JOBS 1024
+
+// The max number of jobs that can be held back waiting on their dependencies at once.
+#define MAX_WAITING_JOBS 256
+
+// The number of job types, and so of queues per priority.
+#define JOB_TYPE_COUNT 3
+
+// How many times job_wait yields with nothing to run before it sleeps between checks instead.
+#define JOB_WAIT_SPIN_COUNT 64
 
 typedef struct job_system_state {
-    b8 running;
+    volatile u32 running;
     u8 thread_count;
     job_thread job_threads[32];
+    // The number of job threads which have not yet exited.
+    volatile u32 live_thread_count;
 
-    ring_queue low_priority_queue;
-    ring_queue normal_priority_queue;
-    ring_queue high_priority_queue;
+    // A queue per priority and type, so a thread only ever takes jobs it can handle.
+    // Lock-free, since a job could be kicked off from another job (thread).
+    mpmc_queue queues[JOB_PRIORITY_COUNT][JOB_TYPE_COUNT];
 
-    // Mutexes for each queue, since a job could be kicked off from another job (thread).
-    kmutex low_pri_queue_mutex;
-    kmutex normal_pri_queue_mutex;
-    kmutex high_pri_queue_mutex;
+    // Jobs submitted before their dependency reached zero. Guarded by waiting_mutex.
+    job_info waiting_jobs[MAX_WAITING_JOBS];
+    u32 waiting_count;
+    kmutex waiting_mutex;
 
-    job_result_entry pending_results[MAX_JOB_RESULTS];
-    kmutex result_mutex;
-    // A mutex for the result array
+    // Results of finished jobs, pushed by any thread and drained by the main thread.
+    mpsc_queue results;
 } job_system_state;
 
 static job_system_state* state_ptr;
 
+// The job thread running on the calling thread, if any.
+static KTHREAD_LOCAL job_thread* local_thread;
+
+// The size of an entry's allocation, including its copy of the result data.
+KINLINE u64 job_result_entry_size(u32 param_size) {
+    return get_aligned(sizeof(job_result_entry), sizeof(u64)) + param_size;
+}
+
+KINLINE void* job_result_entry_params(job_result_entry* entry) {
+    return entry->param_size ? (u8*)entry + get_aligned(sizeof(job_result_entry), sizeof(u64)) : 0;
+}
+
 void store_result(pfn_job_on_complete callback, u32 param_size, void* params) {
-    // Create the new entry.
-    job_result_entry entry;
-    entry.id = INVALID_ID_U16;
-    entry.param_size = param_size;
-    entry.callback = callback;
-    if (entry.param_size > 0) {
-        // Take a copy, as the job is destroyed after this.
-        entry.params = kallocate(param_size, MEMORY_TAG_JOB);
-        kcopy_memory(entry.params, params, param_size);
-    } else {
-        entry.params = 0;
+    // Take a copy of the result data, as the job is destroyed after this.
+    job_result_entry* entry = kallocate_with_flags(job_result_entry_size(param_size), sizeof(u64), MEMORY_TAG_JOB, KALLOCATE_FLAG_UNINITIALIZED);
+    entry->callback = callback;
+    entry->param_size = param_size;
+    if (param_size) {
+        kcopy_memory(job_result_entry_params(entry), params, param_size);
     }
 
-    // Lock, find a free space, store, unlock.
-    if (!kmutex_lock(&state_ptr->result_mutex)) {
-        KERROR("Failed to obtain mutex lock for storing a result! Result storage may be corrupted.");
+    mpsc_queue_push(&state_ptr->results, &entry->node);
+}
+
+static void free_result(job_result_entry* entry) {
+    kfree_with_flags(entry, job_result_entry_size(entry->param_size), sizeof(u64), MEMORY_TAG_JOB, KALLOCATE_FLAG_UNINITIALIZED);
+}
+
+static u32 job_type_index(job_type type) {
+    switch (type) {
+        case JOB_TYPE_RESOURCE_LOAD:
+            return 1;
+        case JOB_TYPE_GPU_RESOURCE:
+            return 2;
+        case JOB_TYPE_GENERAL:
+        default:
+            return 0;
     }
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        if (state_ptr->pending_results[i].id == INVALID_ID_U16) {
-            state_ptr->pending_results[i] = entry;
-            state_ptr->pending_results[i].id = i;
+}
+
+static const job_type job_types[JOB_TYPE_COUNT] = {JOB_TYPE_GENERAL, JOB_TYPE_RESOURCE_LOAD, JOB_TYPE_GPU_RESOURCE};
+
+// Only lets a thread steal jobs of the types it can handle. user_data is the type mask.
+static b8 can_steal(const void* value, void* user_data) {
+    return (*(u32*)user_data & ((const job_info*)value)->type) != 0;
+}
+
+/**
+ * Takes the next job the given thread can handle, highest priority first. Within a
+ * priority, the thread's own deque comes first, as its jobs were pushed by this thread
+ * and are likely still in its cache. Then the shared queues, with the thread's dedicated
+ * types before general jobs, since general jobs may be picked up by any other thread.
+ * Last, jobs are stolen from other threads' deques, starting with the next thread along
+ * so that thieves spread out over their victims.
+ *
+ * thread may be 0 for a thread which is not a job thread (i.e. the main thread in job_wait),
+ * which has no deque of its own and only takes general jobs.
+ */
+static b8 take_job(job_thread* thread, job_info* out_info) {
+    u32 thread_count = state_ptr->thread_count;
+    u32 type_mask = thread ? thread->type_mask : JOB_TYPE_GENERAL;
+    u32 first_victim = thread ? thread->index + 1 : 0;
+    for (i32 p = JOB_PRIORITY_COUNT - 1; p >= 0; --p) {
+        if (thread && work_stealing_deque_pop(&thread->deques[p], out_info)) {
+            return true;
+        }
+
+        // General jobs are at index 0, so are checked last.
+        for (u32 t = 1; t <= JOB_TYPE_COUNT; ++t) {
+            u32 type_index = t % JOB_TYPE_COUNT;
+            if ((type_mask & job_types[type_index]) && mpmc_queue_dequeue(&state_ptr->queues[p][type_index], out_info)) {
+                return true;
+            }
+        }
+
+        for (u32 i = 0; i < thread_count; ++i) {
+            job_thread* victim = &state_ptr->job_threads[(first_victim + i) % thread_count];
+            if (victim != thread && work_stealing_deque_steal(&victim->deques[p], out_info, can_steal, &type_mask)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Clears the param data and result data.
+static void release_job(job_info* info) {
+    if (info->param_data) {
+        kfree(info->param_data, info->param_data_size, MEMORY_TAG_JOB);
+    }
+    if (info->result_data) {
+        kfree(info->result_data, info->result_data_size, MEMORY_TAG_JOB);
+    }
+}
+
+static void enqueue_job(job_info info);
+
+/**
+ * Queues every waiting job whose dependency has reached zero. Each is removed under the
+ * lock and queued outside it, as queueing may finish a job (if dropped) and so end up here again.
+ */
+static void release_waiting_jobs() {
+    while (true) {
+        b8 found = false;
+        job_info info;
+        if (!kmutex_lock(&state_ptr->waiting_mutex)) {
+            KERROR("Failed to obtain lock on waiting job mutex!");
+        }
+        for (u32 i = 0; i < state_ptr->waiting_count; ++i) {
+            if (katomic_load_u32(&state_ptr->waiting_jobs[i].dependency->remaining) == 0) {
+                info = state_ptr->waiting_jobs[i];
+                state_ptr->waiting_jobs[i] = state_ptr->waiting_jobs[--state_ptr->waiting_count];
+                found = true;
+                break;
+            }
+        }
+        if (!kmutex_unlock(&state_ptr->waiting_mutex)) {
+            KERROR("Failed to release lock on waiting job mutex!");
+        }
+        if (!found) {
             break;
         }
+        enqueue_job(info);
+    }
+}
+
+// Counts the job as finished, releasing any jobs which depend on its counter if it was the last.
+static void finish_job(job_info* info) {
+    if (info->counter && katomic_fetch_sub_u32(&info->counter->remaining, 1) == 1 && state_ptr) {
+        release_waiting_jobs();
     }
-    if (!kmutex_unlock(&state_ptr->result_mutex)) {
-        KERROR("Failed to release mutex lock for result storage, storage may be corrupted.");
+}
+
+static void run_job(job_info* info) {
+    b8 result = info->entry_point(info->param_data, info->result_data);
+
+    // Store the result to be executed on the main thread later.
+    // Note that store_result takes a copy of the result_data
+    // so it does not have to be held onto by this thread any longer.
+    if (result && info->on_success) {
+        store_result(info->on_success, info->result_data_size, info->result_data);
+    } else if (!result && info->on_fail) {
+        store_result(info->on_fail, info->result_data_size, info->result_data);
     }
+
+    release_job(info);
+    finish_job(info);
 }
 
 u32 job_thread_run(void* params) {
@@ -84,68 +236,49 @@ u32 job_thread_run(void* params) {
     u64 thread_id = thread->thread.thread_id;
     KTRACE("Starting job thread #%i (id=%#x, type=%#x).", thread->index, thread_id, thread->type_mask);
 
-    // A mutex to lock info for this thread.
-    if (!kmutex_create(&thread->info_mutex)) {
-        KERROR("Failed to create job thread mutex! Aborting thread.");
-        return 0;
-    }
+    // Serve this thread's small allocations from its own cache to stay off the global allocation lock.
+    kmemory_thread_cache_initialize();
 
-    // Run forever, waiting for jobs.
-    while (true) {
-        if (!state_ptr || !state_ptr->running || !thread) {
-            break;
-        }
+    // Jobs submitted from this thread go to its own deques.
+    local_thread = thread;
 
-        // Lock and grab a copy of the info
-        if (!kmutex_lock(&thread->info_mutex)) {
-            KERROR("Failed to obtain lock on job thread mutex!");
-        }
-        job_info info = thread->info;
-        if (!kmutex_unlock(&thread->info_mutex)) {
-            KERROR("Failed to release lock on job thread mutex!");
+    // Run until shutdown, sleeping whenever there are no jobs for this thread.
+    job_info info;
+    while (katomic_load_u32(&state_ptr->running)) {
+        if (take_job(thread, &info)) {
+            run_job(&info);
+            continue;
         }
 
-        if (info.entry_point) {
-            b8 result = info.entry_point(info.param_data, info.result_data);
-
-            // Store the result to be executed on the main thread later.
-            // Note that store_result takes a copy of the result_data
-            // so it does not have to be held onto by this thread any longer.
-            if (result && info.on_success) {
-                store_result(info.on_success, info.result_data_size, info.result_data);
-            } else if (!result && info.on_fail) {
-                store_result(info.on_fail, info.result_data_size, info.result_data);
-            }
-
-            // Clear the param data and result data.
-            if (info.param_data) {
-                kfree(info.param_data, info.param_data_size, MEMORY_TAG_JOB);
+        // Announce the sleep, then look once more. A job submitted (or a shutdown begun)
+        // before the announcement is seen here, and one after it sees sleeping and wakes
+        // the thread, so none is missed. The fences keep both sides' store-then-load in order.
+        katomic_store_u32(&thread->sleeping, 1);
+        katomic_thread_fence();
+        b8 found = false;
+        if (!katomic_load_u32(&state_ptr->running) || (found = take_job(thread, &info))) {
+            // Cancel the sleep. If someone already took it back, their signal is on its way.
+            u32 expected = 1;
+            if (!katomic_compare_exchange_u32(&thread->sleeping, &expected, 0)) {
+                ksemaphore_wait(&thread->wake);
             }
-            if (info.result_data) {
-                kfree(info.result_data, info.result_data_size, MEMORY_TAG_JOB);
-            }
-
-            // Lock and reset the thread's info object
-            if (!kmutex_lock(&thread->info_mutex)) {
-                KERROR("Failed to obtain lock on job thread mutex!");
-            }
-            kzero_memory(&thread->info, sizeof(job_info));
-            if (!kmutex_unlock(&thread->info_mutex)) {
-                KERROR("Failed to release lock on job thread mutex!");
+            if (found) {
+                run_job(&info);
             }
+            continue;
         }
 
-        if (state_ptr->running) {
-            // TODO: Should probably find a better way to do this, such as sleeping until
-            // a request comes through for a new job.
-            kthread_sleep(&thread->thread, 10);
-        } else {
-            break;
-        }
+        // Nothing to do, so block until a job is submitted for this thread.
+        ksemaphore_wait(&thread->wake);
     }
 
-    // Destroy the mutex for this thread.
-    kmutex_destroy(&thread->info_mutex);
+    // Hand any cached blocks and scratch memory back before the thread exits.
+    scratch_allocator_thread_shutdown();
+    kmemory_thread_cache_shutdown();
+    local_thread = 0;
+
+    // Last, as shutdown frees the state once every thread is out.
+    katomic_fetch_sub_u32(&state_ptr->live_thread_count, 1);
     return 1;
 }
 
@@ -160,14 +293,19 @@ b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 job
     state_ptr = state;
     state_ptr->running = true;
 
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->low_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->normal_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->high_priority_queue);
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+            mpmc_queue_create(sizeof(job_info), MAX_QUEUED_JOBS, &state_ptr->queues[p][t]);
+        }
+    }
     state_ptr->thread_count = job_thread_count;
 
-    // Invalidate all result slots
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        state_ptr->pending_results[i].id = INVALID_ID_U16;
+    mpsc_queue_create(&state_ptr->results);
+
+    // Create needed mutexes
+    if (!kmutex_create(&state_ptr->waiting_mutex)) {
+        KERROR("Failed to create waiting job mutex!.");
+        return false;
     }
 
     KDEBUG("Main thread id is: %#x", get_thread_id());
@@ -175,109 +313,97 @@ b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 job
     KDEBUG("Spawning %i job threads.", state_ptr->thread_count);
 
     for (u8 i = 0; i < state_ptr->thread_count; ++i) {
-        state_ptr->job_threads[i].index = i;
-        state_ptr->job_threads[i].type_mask = type_masks[i];
-        if (!kthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread)) {
-            KFATAL("OS Error in creating job thread. Application cannot continue.");
+        job_thread* thread = &state_ptr->job_threads[i];
+        thread->index = i;
+        thread->type_mask = type_masks[i];
+        // Only ever signalled once per sleep, so a count of 1 is enough.
+        if (!ksemaphore_create(&thread->wake, 1, 0)) {
+            KFATAL("OS Error in creating job thread semaphore. Application cannot continue.");
             return false;
         }
-        kzero_memory(&state_ptr->job_threads[i].info, sizeof(job_info));
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            work_stealing_deque_create(sizeof(job_info), MAX_LOCAL_JOBS, &thread->deques[p]);
+        }
     }
 
-    // Create needed mutexes
-    if (!kmutex_create(&state_ptr->result_mutex)) {
-        KERROR("Failed to create result mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->low_pri_queue_mutex)) {
-        KERROR("Failed to create low priority queue mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->normal_pri_queue_mutex)) {
-        KERROR("Failed to create normal priority queue mutex!.");
-        return false;
-    }
-    if (!kmutex_create(&state_ptr->high_pri_queue_mutex)) {
-        KERROR("Failed to create high priority queue mutex!.");
-        return false;
+    // Only start threads once every thread's deques and semaphore exist, as each one may
+    // steal from or wake any of the others as soon as it runs.
+    for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        katomic_fetch_add_u32(&state_ptr->live_thread_count, 1);
+        if (!kthread_create(job_thread_run, &thread->index, false, &thread->thread)) {
+            KFATAL("OS Error in creating job thread. Application cannot continue.");
+            return false;
+        }
     }
 
     return true;
 }
 
+// Wakes the given thread if it is asleep. Returns true if it was.
+static b8 wake_thread(job_thread* thread) {
+    u32 expected = 1;
+    if (katomic_load_u32(&thread->sleeping) && katomic_compare_exchange_u32(&thread->sleeping, &expected, 0)) {
+        ksemaphore_signal(&thread->wake);
+        return true;
+    }
+    return false;
+}
+
 void job_system_shutdown(void* state) {
     if (state_ptr) {
-        state_ptr->running = false;
+        katomic_store_u32(&state_ptr->running, false);
+        katomic_thread_fence();
 
         u64 thread_count = state_ptr->thread_count;
 
-        // Check for a free thread first.
+        // Wake any sleeping threads so they see the shutdown, then wait for all of them to
+        // exit, as they clean up their allocation caches on the way out.
         for (u8 i = 0; i < thread_count; ++i) {
-            kthread_destroy(&state_ptr->job_threads[i].thread);
+            wake_thread(&state_ptr->job_threads[i]);
         }
-        ring_queue_destroy(&state_ptr->low_priority_queue);
-        ring_queue_destroy(&state_ptr->normal_priority_queue);
-        ring_queue_destroy(&state_ptr->high_priority_queue);
-
-        // Destroy mutexes
-        kmutex_destroy(&state_ptr->result_mutex);
-        kmutex_destroy(&state_ptr->low_pri_queue_mutex);
-        kmutex_destroy(&state_ptr->normal_pri_queue_mutex);
-        kmutex_destroy(&state_ptr->high_pri_queue_mutex);
-
-        state_ptr = 0;
-    }
-}
-
-void process_queue(ring_queue* queue, kmutex* queue_mutex) {
-    u64 thread_count = state_ptr->thread_count;
-
-    // Check for a free thread first.
-    while (queue->length > 0) {
-        job_info info;
-        if (!ring_queue_peek(queue, &info)) {
-            break;
+        while (katomic_load_u32(&state_ptr->live_thread_count)) {
+            kthread_sleep(&state_ptr->job_threads[0].thread, 1);
         }
 
-        b8 thread_found = false;
+        // Release any jobs which never got to run.
+        job_info info;
         for (u8 i = 0; i < thread_count; ++i) {
             job_thread* thread = &state_ptr->job_threads[i];
-            if ((thread->type_mask & info.type) == 0) {
-                continue;
-            }
-
-            // Check that the job thread can handle the job type.
-            if (!kmutex_lock(&thread->info_mutex)) {
-                KERROR("Failed to obtain lock on job thread mutex!");
-            }
-            if (!thread->info.entry_point) {
-                // Make sure to remove the entry from the queue.
-                if (!kmutex_lock(queue_mutex)) {
-                    KERROR("Failed to obtain lock on queue mutex!");
-                }
-                ring_queue_dequeue(queue, &info);
-                if (!kmutex_unlock(queue_mutex)) {
-                    KERROR("Failed to release lock on queue mutex!");
+            kthread_destroy(&thread->thread);
+            ksemaphore_destroy(&thread->wake);
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+                while (work_stealing_deque_pop(&thread->deques[p], &info)) {
+                    release_job(&info);
                 }
-                thread->info = info;
-                KTRACE("Assigning job to thread: %u", thread->index);
-                thread_found = true;
+                work_stealing_deque_destroy(&thread->deques[p]);
             }
-            if (!kmutex_unlock(&thread->info_mutex)) {
-                KERROR("Failed to release lock on job thread mutex!");
-            }
-
-            // Break after unlocking if an available thread was found.
-            if (thread_found) {
-                break;
+        }
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            for (u32 t = 0; t < JOB_TYPE_COUNT; ++t) {
+                while (mpmc_queue_dequeue(&state_ptr->queues[p][t], &info)) {
+                    release_job(&info);
+                }
+                mpmc_queue_destroy(&state_ptr->queues[p][t]);
             }
         }
+        for (u32 i = 0; i < state_ptr->waiting_count; ++i) {
+            release_job(&state_ptr->waiting_jobs[i]);
+        }
 
-        // This means all of the threads are currently handling a job,
-        // So wait until the next update and try again.
-        if (!thread_found) {
-            break;
+        // Results which were never processed are dropped, without running their callbacks.
+        mpsc_queue_node* node = mpsc_queue_take_all(&state_ptr->results);
+        while (node) {
+            mpsc_queue_node* next = node->next;
+            free_result((job_result_entry*)node);
+            node = next;
         }
+        mpsc_queue_destroy(&state_ptr->results);
+
+        // Destroy mutexes
+        kmutex_destroy(&state_ptr->waiting_mutex);
+
+        state_ptr = 0;
     }
 }
 
@@ -286,91 +412,130 @@ void job_system_update() {
         return;
     }
 
-    process_queue(&state_ptr->high_priority_queue, &state_ptr->high_pri_queue_mutex);
-    process_queue(&state_ptr->normal_priority_queue, &state_ptr->normal_pri_queue_mutex);
-    process_queue(&state_ptr->low_priority_queue, &state_ptr->low_pri_queue_mutex);
-
-    // Process pending results.
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-        // Lock and take a copy, unlock.
-        if (!kmutex_lock(&state_ptr->result_mutex)) {
-            KERROR("Failed to obtain lock on result mutex!");
-        }
-        job_result_entry entry = state_ptr->pending_results[i];
-        if (!kmutex_unlock(&state_ptr->result_mutex)) {
-            KERROR("Failed to release lock on result mutex!");
-        }
+    // Process pending results, in the order they finished. Results of jobs which finish
+    // meanwhile (including any kicked off by these callbacks) are left for the next update.
+    mpsc_queue_node* node = mpsc_queue_take_all(&state_ptr->results);
+    while (node) {
+        // Grab the next node first, as the entry is freed once its callback has run.
+        mpsc_queue_node* next = node->next;
+        job_result_entry* entry = (job_result_entry*)node;
+        entry->callback(job_result_entry_params(entry));
+        free_result(entry);
+        node = next;
+    }
+}
 
-        if (entry.id != INVALID_ID_U16) {
-            // Execute the callback.
-            entry.callback(entry.params);
+// Queues a job which is ready to run, waking a thread to run it.
+static void enqueue_job(job_info info) {
+    // A job submitted by a job goes to the submitting thread's own deque if that thread can
+    // run it, where the thread will pick it up next unless an idle thread steals it first.
+    // Otherwise, or if the deque is full, it goes to the shared queue for its type.
+    job_thread* local = local_thread;
+    b8 pushed = local && (local->type_mask & info.type) && work_stealing_deque_push(&local->deques[info.priority], &info);
+
+    // NOTE: No lock is needed even if the job is submitted from another job/thread.
+    if (!pushed && !mpmc_queue_enqueue(&state_ptr->queues[info.priority][job_type_index(info.type)], &info)) {
+        KERROR("job_system_submit - Job queue is full (max %u jobs). The job has been dropped.", MAX_QUEUED_JOBS);
+        release_job(&info);
+        finish_job(&info);
+        return;
+    }
 
-            if (entry.params) {
-                kfree(entry.params, entry.param_size, MEMORY_TAG_JOB);
-            }
+    // Pairs with the fence in job_thread_run, so either a thread about to sleep sees the
+    // job, or it is seen to be sleeping here.
+    katomic_thread_fence();
 
-            // Lock actual entry, invalidate and clear it
-            if (!kmutex_lock(&state_ptr->result_mutex)) {
-                KERROR("Failed to obtain lock on result mutex!");
-            }
-            kzero_memory(&state_ptr->pending_results[i], sizeof(job_result_entry));
-            state_ptr->pending_results[i].id = INVALID_ID_U16;
-            if (!kmutex_unlock(&state_ptr->result_mutex)) {
-                KERROR("Failed to release lock on result mutex!");
-            }
+    // Wake one sleeping thread which can handle the job. If none are asleep, those which
+    // can are busy and will take (or steal) it before they next sleep.
+    u64 thread_count = state_ptr->thread_count;
+    for (u8 i = 0; i < thread_count; ++i) {
+        job_thread* thread = &state_ptr->job_threads[i];
+        if ((thread->type_mask & info.type) && wake_thread(thread)) {
+            return;
         }
     }
 }
 
 void job_system_submit(job_info info) {
-    u64 thread_count = state_ptr->thread_count;
-    ring_queue* queue = &state_ptr->normal_priority_queue;
-    kmutex* queue_mutex = &state_ptr->normal_pri_queue_mutex;
+    if (info.counter) {
+        katomic_fetch_add_u32(&info.counter->remaining, 1);
+    }
+
+    if (!state_ptr) {
+        // No job threads to hand the job to, so run it here and now.
+        if (info.dependency && katomic_load_u32(&info.dependency->remaining)) {
+            KWARN("job_system_submit - Job dependency can never be met without the job system running. Running the job anyway.");
+        }
+        b8 result = info.entry_point(info.param_data, info.result_data);
+        if (result && info.on_success) {
+            info.on_success(info.result_data);
+        } else if (!result && info.on_fail) {
+            info.on_fail(info.result_data);
+        }
+        release_job(&info);
+        finish_job(&info);
+        return;
+    }
 
-    // If the job is high priority, try to kick it off immediately.
-    if (info.priority == JOB_PRIORITY_HIGH) {
-        queue = &state_ptr->high_priority_queue;
-        queue_mutex = &state_ptr->high_pri_queue_mutex;
+    if (info.priority >= JOB_PRIORITY_COUNT) {
+        info.priority = JOB_PRIORITY_NORMAL;
+    }
 
-        // Check for a free thread that supports the job type first.
-        for (u8 i = 0; i < thread_count; ++i) {
-            job_thread* thread = &state_ptr->job_threads[i];
-            if (state_ptr->job_threads[i].type_mask & info.type) {
-                b8 found = false;
-                if (!kmutex_lock(&thread->info_mutex)) {
-                    KERROR("Failed to obtain lock on job thread mutex!");
-                }
-                if (!state_ptr->job_threads[i].info.entry_point) {
-                    KTRACE("Job immediately submitted on thread %i", state_ptr->job_threads[i].index);
-                    state_ptr->job_threads[i].info = info;
-                    found = true;
-                }
-                if (!kmutex_unlock(&thread->info_mutex)) {
-                    KERROR("Failed to release lock on job thread mutex!");
-                }
-                if (found) {
-                    return;
-                }
+    if (info.dependency && katomic_load_u32(&info.dependency->remaining)) {
+        // Check again under the lock. The last job to finish on the dependency only looks for
+        // waiting jobs under the same lock after its decrement, so either it sees this job
+        // or this sees its decrement.
+        if (!kmutex_lock(&state_ptr->waiting_mutex)) {
+            KERROR("Failed to obtain lock on waiting job mutex!");
+        }
+        b8 held = false;
+        b8 full = false;
+        if (katomic_load_u32(&info.dependency->remaining)) {
+            if (state_ptr->waiting_count < MAX_WAITING_JOBS) {
+                state_ptr->waiting_jobs[state_ptr->waiting_count++] = info;
+                held = true;
+            } else {
+                full = true;
             }
         }
+        if (!kmutex_unlock(&state_ptr->waiting_mutex)) {
+            KERROR("Failed to release lock on waiting job mutex!");
+        }
+        if (full) {
+            KERROR("job_system_submit - Too many jobs are waiting on dependencies (max %u). The job has been dropped.", MAX_WAITING_JOBS);
+            release_job(&info);
+            finish_job(&info);
+            return;
+        }
+        if (held) {
+            return;
+        }
     }
 
-    // If this point is reached, all threads are busy (if high) or it can wait a frame.
-    // Add to the queue and try again next cycle.
-    if (info.priority == JOB_PRIORITY_LOW) {
-        queue = &state_ptr->low_priority_queue;
-        queue_mutex = &state_ptr->low_pri_queue_mutex;
-    }
+    enqueue_job(info);
+}
 
-    // NOTE: Locking here in case the job is submitted from another job/thread.
-    if (!kmutex_lock(queue_mutex)) {
-        KERROR("Failed to obtain lock on queue mutex!");
+void job_wait(job_counter* counter) {
+    if (!counter) {
+        return;
     }
-    ring_queue_enqueue(queue, &info);
-    if (!kmutex_unlock(queue_mutex)) {
-        KERROR("Failed to release lock on queue mutex!");
+
+    job_thread* thread = local_thread;
+    job_info info;
+    u32 empty_polls = 0;
+    while (katomic_load_u32(&counter->remaining)) {
+        if (state_ptr && take_job(thread, &info)) {
+            run_job(&info);
+            empty_polls = 0;
+        } else if (empty_polls < JOB_WAIT_SPIN_COUNT) {
+            // The jobs being waited on are often nearly done, so check again shortly.
+            kthread_yield();
+            empty_polls++;
+        } else {
+            // Nothing to help with and still waiting, so stop burning the core.
+            platform_sleep(1);
+        }
     }
-    KTRACE("Job queued.");
 }
 
 job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size) {
@@ -388,6 +553,8 @@ job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_s
     job.on_fail = on_fail;
     job.type = type;
     job.priority = priority;
+    job.counter = 0;
+    job.dependency = 0;
 
     job.param_data_size = param_data_size;
     if (param_data_size) {
@@ -405,4 +572,147 @@ job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_s
     }
 
     return job;
-}
\ No newline at end of file
+}
+
+// The number of chunks per participating thread when no grain is given.
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+/**
+ * A range shared by every thread working on a job_parallel_for or job_parallel_reduce. It
+ * lives on the calling thread's stack, which waits for all helper jobs before returning.
+ */
+typedef struct parallel_range {
+    u32 count;
+    u32 grain;
+    u32 chunk_count;
+    // The next chunk to be claimed. Counts past chunk_count once all have been claimed.
+    volatile u32 next_chunk;
+    pfn_parallel_for for_fn;
+    pfn_parallel_reduce reduce_fn;
+    void* context;
+    u32 result_size;
+    // One partial result per participating thread, for reductions only.
+    u8* partials;
+} parallel_range;
+
+typedef struct parallel_range_job_params {
+    parallel_range* range;
+    u32 participant;
+} parallel_range_job_params;
+
+// Runs chunks of the range until none are left to claim.
+static void parallel_range_run(parallel_range* range, u32 participant) {
+    void* partial = range->partials ? range->partials + (u64)range->result_size * participant : 0;
+    while (true) {
+        u32 chunk = katomic_fetch_add_u32(&range->next_chunk, 1);
+        if (chunk >= range->chunk_count) {
+            break;
+        }
+        u32 begin = chunk * range->grain;
+        u32 end = range->count - begin > range->grain ? begin + range->grain : range->count;
+        if (range->reduce_fn) {
+            range->reduce_fn(begin, end, range->context, partial);
+        } else {
+            range->for_fn(begin, end, range->context);
+        }
+    }
+}
+
+static b8 parallel_range_job_start(void* params, void* result_data) {
+    parallel_range_job_params* p = params;
+    parallel_range_run(p->range, p->participant);
+    return true;
+}
+
+// The number of threads which can help with a range, not counting the calling thread.
+static u32 parallel_helper_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    u32 count = 0;
+    for (u32 i = 0; i < state_ptr->thread_count; ++i) {
+        count += (state_ptr->job_threads[i].type_mask & JOB_TYPE_GENERAL) != 0;
+    }
+    return count;
+}
+
+/**
+ * Splits the range into chunks, hands a job to each helper thread, and works on it alongside
+ * them. Helpers which start after every chunk has been claimed simply return.
+ */
+static void parallel_range_execute(parallel_range* range, u32 helper_count) {
+    job_counter helpers = {0};
+    for (u32 i = 0; i < helper_count; ++i) {
+        parallel_range_job_params params = {range, i + 1};
+        // High priority, as the calling thread is waiting on them.
+        job_info job = job_create_priority(parallel_range_job_start, 0, 0, &params, sizeof(parallel_range_job_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH);
+        job.counter = &helpers;
+        job_system_submit(job);
+    }
+    parallel_range_run(range, 0);
+    job_wait(&helpers);
+}
+
+// Sets up the chunks of a range, returning the number of helpers worth handing jobs to.
+static u32 parallel_range_prepare(parallel_range* range, u32 count, u32 grain) {
+    u32 helper_count = parallel_helper_count();
+    if (!grain) {
+        u32 chunks = (helper_count + 1) * PARALLEL_CHUNKS_PER_THREAD;
+        grain = count / chunks + (count % chunks ? 1 : 0);
+        grain = grain ? grain : 1;
+    }
+    range->count = count;
+    range->grain = grain;
+    range->chunk_count = count / grain + (count % grain ? 1 : 0);
+    range->next_chunk = 0;
+    // The calling thread takes one chunk itself, so more helpers than the rest would idle.
+    return range->chunk_count > helper_count ? helper_count : (range->chunk_count ? range->chunk_count - 1 : 0);
+}
+
+void job_parallel_for(u32 count, u32 grain, pfn_parallel_for fn, void* context) {
+    if (!fn) {
+        KERROR("job_parallel_for requires a function to run.");
+        return;
+    }
+    if (!count) {
+        return;
+    }
+
+    parallel_range range = {0};
+    range.for_fn = fn;
+    range.context = context;
+    u32 helper_count = parallel_range_prepare(&range, count, grain);
+    parallel_range_execute(&range, helper_count);
+}
+
+void job_parallel_reduce(u32 count, u32 grain, u32 result_size, const void* identity, pfn_parallel_reduce fn, pfn_parallel_combine combine, void* context, void* out_result) {
+    if (!fn || !combine || !identity || !out_result || !result_size) {
+        KERROR("job_parallel_reduce requires a result size, identity, functions to reduce and combine, and a pointer to hold the result.");
+        return;
+    }
+    kcopy_memory(out_result, identity, result_size);
+    if (!count) {
+        return;
+    }
+
+    parallel_range range = {0};
+    range.reduce_fn = fn;
+    range.context = context;
+    range.result_size = result_size;
+    u32 helper_count = parallel_range_prepare(&range, count, grain);
+
+    u32 participant_count = helper_count + 1;
+    u64 partials_size = (u64)result_size * participant_count;
+    range.partials = kallocate_with_flags(partials_size, sizeof(u64), MEMORY_TAG_JOB, KALLOCATE_FLAG_UNINITIALIZED);
+    for (u32 i = 0; i < participant_count; ++i) {
+        kcopy_memory(range.partials + (u64)result_size * i, identity, result_size);
+    }
+
+    parallel_range_execute(&range, helper_count);
+
+    // Combine in participant order, so a single-threaded run matches a serial loop.
+    for (u32 i = 0; i < participant_count; ++i) {
+        combine(out_result, range.partials + (u64)result_size * i, context);
+    }
+    kfree_with_flags(range.partials, partials_size, sizeof(u64), MEMORY_TAG_JOB, KALLOCATE_FLAG_UNINITIALIZED);
+}
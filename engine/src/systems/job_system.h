@@ -44,6 +44,21 @@ typedef enum job_priority {
     JOB_PRIORITY_HIGH
 } job_priority;
 
+/**
+ * @brief Counts jobs which have not yet finished running. A job given a counter increments
+ * it when submitted, and decrements it once its entry point has returned. Many jobs may
+ * share a counter, which then reaches zero once all of them have run.
+ *
+ * A counter is owned by whoever submits the jobs, i.e. on the stack of a function which
+ * waits on it with job_wait, and must stay valid until every job which counts on it has
+ * run and every job which depends on it has started. Start it at zero. Since jobs are
+ * only counted once submitted, submit them before any job which depends on their counter.
+ */
+typedef struct job_counter {
+    /** @brief The number of jobs submitted which have not yet finished running. */
+    volatile u32 remaining;
+} job_counter;
+
 /**
  * @brief Describes a job to be run.
  */
@@ -74,6 +89,15 @@ typedef struct job_info {
 
     /** @brief The size of the data passed to the success/fail function. */
     u32 result_data_size;
+
+    /** @brief A counter to be incremented on submission and decremented once the job has run. Optional. */
+    job_counter* counter;
+
+    /**
+     * @brief A counter which must reach zero before the job may start, i.e. that of the jobs
+     * this one depends on. Until then the job is held back rather than queued. Optional.
+     */
+    job_counter* dependency;
 } job_info;
 
 /**
@@ -86,24 +110,100 @@ typedef struct job_info {
  * @param type_masks A collection of type masks for each job thread. Must match max_job_thread_count.
  * @returns True if the job system started up successfully; otherwise false.
  */
-b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 max_job_thread_count, u32 type_masks[]);
+KAPI b8 job_system_initialize(u64* job_system_memory_requirement, void* state, u8 max_job_thread_count, u32 type_masks[]);
 
 /**
  * @brief Shuts the job system down.
  */
-void job_system_shutdown(void* state);
+KAPI void job_system_shutdown(void* state);
 
 /**
  * @brief Updates the job system. Should happen once an update cycle.
  */
-void job_system_update();
+KAPI void job_system_update();
 
 /**
- * @brief Submits the provided job to be queued for execution.
+ * @brief Submits the provided job to be queued for execution. If the job system is not
+ * running (i.e. in tools and tests), the job is run on the calling thread right away,
+ * including its success/fail function.
  * @param info The description of the job to be executed.
  */
 KAPI void job_system_submit(job_info info);
 
+/**
+ * @brief Waits until the given counter reaches zero, i.e. until all jobs counted on it
+ * have run. Rather than block, the calling thread runs other jobs meanwhile: a job
+ * thread runs any it can handle, and any other thread helps with general jobs.
+ * Success/fail functions of the jobs are still only run by job_system_update.
+ *
+ * NOTE: The jobs run while waiting may be entirely unrelated to the counter, so this can
+ * return well after it reaches zero if a long job was picked up. Avoid calling it from
+ * the main thread where that matters. Once there is nothing to run, the caller sleeps
+ * for a millisecond between checks rather than spinning.
+ * @param counter A pointer to the counter to wait on.
+ */
+KAPI void job_wait(job_counter* counter);
+
+/**
+ * @brief A function run by job_parallel_for over one chunk of its range.
+ * @param begin The first index of the chunk.
+ * @param end One past the last index of the chunk.
+ * @param context The context passed to job_parallel_for.
+ */
+typedef void (*pfn_parallel_for)(u32 begin, u32 end, void* context);
+
+/**
+ * @brief A function run by job_parallel_reduce over one chunk of its range, which folds the
+ * results for the chunk into partial. A partial is only ever used by one thread at a time,
+ * and starts as a copy of the identity.
+ * @param begin The first index of the chunk.
+ * @param end One past the last index of the chunk.
+ * @param context The context passed to job_parallel_reduce.
+ * @param partial The partial result to fold the chunk into.
+ */
+typedef void (*pfn_parallel_reduce)(u32 begin, u32 end, void* context, void* partial);
+
+/**
+ * @brief Combines two partial results of job_parallel_reduce, folding b into a.
+ * @param a The partial result to fold into.
+ * @param b The partial result to be folded in.
+ * @param context The context passed to job_parallel_reduce.
+ */
+typedef void (*pfn_parallel_combine)(void* a, const void* b, void* context);
+
+/**
+ * @brief Runs fn over the range [0, count), split into chunks of grain indices which are
+ * spread across the job threads which take general jobs. The calling thread works on chunks
+ * too, and returns once all of them are done. Chunks are claimed with a single atomic
+ * increment, so each costs little more than the call to fn.
+ *
+ * Chunks run in no particular order and, while the job system is running, on any thread,
+ * so fn must be safe to run on different chunks at once.
+ * @param count The number of indices in the range.
+ * @param grain The number of indices per chunk. Pass 0 to split the range into a few chunks per thread.
+ * @param fn The function to run on each chunk.
+ * @param context Passed to fn. Optional.
+ */
+KAPI void job_parallel_for(u32 count, u32 grain, pfn_parallel_for fn, void* context);
+
+/**
+ * @brief Reduces the range [0, count) to a single result, splitting it into chunks as
+ * job_parallel_for does. Each participating thread folds the chunks it runs into a partial
+ * result of its own, and the partials are combined on the calling thread at the end.
+ *
+ * Chunks are folded in no particular order, so combine should be associative and
+ * commutative. Floating-point sums may differ slightly from run to run.
+ * @param count The number of indices in the range.
+ * @param grain The number of indices per chunk. Pass 0 to split the range into a few chunks per thread.
+ * @param result_size The size of a result in bytes.
+ * @param identity A pointer to the result of an empty range, i.e. 0 for a sum. Each partial starts as a copy of it.
+ * @param fn The function which folds a chunk into a partial result.
+ * @param combine The function which combines two partial results.
+ * @param context Passed to fn and combine. Optional.
+ * @param out_result A pointer to hold the result.
+ */
+KAPI void job_parallel_reduce(u32 count, u32 grain, u32 result_size, const void* identity, pfn_parallel_reduce fn, pfn_parallel_combine combine, void* context, void* out_result);
+
 /**
  * @brief Creates a new job with default type (Generic) and priority (Normal).
  * @param entry_point A pointer to a function to be invoked when the job starts. Required.
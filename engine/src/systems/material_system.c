@@ -2,7 +2,8 @@
 
 #include "core/logger.h"
 #include "core/kstring.h"
-#include "containers/hashtable.h"
+#include "containers/u64_map.h"
+#include "memory/pool_allocator.h"
 #include "math/kmath.h"
 #include "renderer/renderer_frontend.h"
 #include "systems/texture_system.h"
@@ -36,11 +37,11 @@ typedef struct material_system_state {
 
     material default_material;
 
-    // Array of registered materials.
-    material* registered_materials;
+    // Pool of registered materials, referred to by handle.
+    pool_allocator registered_materials;
 
     // Hashtable for material lookups.
-    hashtable registered_material_table;
+    u64_map registered_material_table;
 
     // Known locations for the material shader.
     material_shader_uniform_locations material_locations;
@@ -59,6 +60,9 @@ typedef struct material_reference {
 
 static material_system_state* state_ptr = 0;
 
+// The number of materials the lookup table has room for before it first grows.
+#define MATERIAL_SYSTEM_INITIAL_TABLE_COUNT 512
+
 b8 create_default_material(material_system_state* state);
 b8 load_material(material_config config, material* m);
 void destroy_material(material* m);
@@ -69,11 +73,14 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable.
+    // Block of memory will contain state structure, then block for pool.
     u64 struct_requirement = sizeof(material_system_state);
-    u64 array_requirement = sizeof(material) * config.max_material_count;
-    u64 hashtable_requirement = sizeof(material_reference) * config.max_material_count;
-    *memory_requirement = struct_requirement + array_requirement + hashtable_requirement;
+    u64 array_requirement = 0;
+    if (!pool_allocator_create(sizeof(material), config.max_material_count, &array_requirement, 0, 0)) {
+        KFATAL("material_system_initialize - Unable to create pool for %u materials.", config.max_material_count);
+        return false;
+    }
+    *memory_requirement = struct_requirement + array_requirement;
 
     if (!state) {
         return true;
@@ -101,31 +108,14 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
     state_ptr->ui_locations.projection = INVALID_ID_U16;
     state_ptr->ui_locations.model = INVALID_ID_U16;
 
-    // The array block is after the state. Already allocated, so just set the pointer.
+    // The pool block is after the state. Already allocated, so just create the pool in it.
     void* array_block = state + struct_requirement;
-    state_ptr->registered_materials = array_block;
+    pool_allocator_create(sizeof(material), config.max_material_count, &array_requirement, array_block, &state_ptr->registered_materials);
 
-    // Hashtable block is after array.
-    void* hashtable_block = array_block + array_requirement;
-
-    // Create a hashtable for material lookups.
-    hashtable_create(sizeof(material_reference), config.max_material_count, hashtable_block, false, &state_ptr->registered_material_table);
-
-    // Fill the hashtable with invalid references to use as a default.
-    material_reference invalid_ref;
-    invalid_ref.auto_release = false;
-    invalid_ref.handle = INVALID_ID;  // Primary reason for needing default values.
-    invalid_ref.reference_count = 0;
-    hashtable_fill(&state_ptr->registered_material_table, &invalid_ref);
-
-    // Invalidate all materials in the array.
-    u32 count = state_ptr->config.max_material_count;
-    for (u32 i = 0; i < count; ++i) {
-        state_ptr->registered_materials[i].id = INVALID_ID;
-        state_ptr->registered_materials[i].generation = INVALID_ID;
-        state_ptr->registered_materials[i].internal_id = INVALID_ID;
-        state_ptr->registered_materials[i].render_frame_number = INVALID_ID;
-    }
+    // Create a map for material lookups by name. It grows as materials are registered, so
+    // starts out with room for only a fraction of the maximum.
+    u32 table_count = config.max_material_count < MATERIAL_SYSTEM_INITIAL_TABLE_COUNT ? config.max_material_count : MATERIAL_SYSTEM_INITIAL_TABLE_COUNT;
+    u64_map_create(sizeof(material_reference), table_count, &state_ptr->registered_material_table);
 
     if (!create_default_material(state_ptr)) {
         KFATAL("Failed to create default material. Application cannot continue.");
@@ -138,13 +128,16 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
 void material_system_shutdown(void* state) {
     material_system_state* s = (material_system_state*)state;
     if (s) {
-        // Invalidate all materials in the array.
+        // Destroy all live materials in the pool.
         u32 count = s->config.max_material_count;
         for (u32 i = 0; i < count; ++i) {
-            if (s->registered_materials[i].id != INVALID_ID) {
-                destroy_material(&s->registered_materials[i]);
+            material* m = pool_allocator_get_by_index(&s->registered_materials, i);
+            if (m) {
+                destroy_material(m);
             }
         }
+        pool_allocator_destroy(&s->registered_materials);
+        u64_map_destroy(&s->registered_material_table);
 
         // Destroy the default material.
         destroy_material(&s->default_material);
@@ -154,15 +147,28 @@ void material_system_shutdown(void* state) {
 }
 
 material* material_system_acquire(const char* name) {
+    return material_system_acquire_kname(kname_create(name));
+}
+
+material* material_system_acquire_kname(kname name) {
+    // Materials which are already loaded need not have their configuration loaded again.
+    if (state_ptr) {
+        material_reference* ref = u64_map_get_ptr(&state_ptr->registered_material_table, name);
+        if (ref && ref->handle != INVALID_ID) {
+            ref->reference_count++;
+            return pool_allocator_get(&state_ptr->registered_materials, ref->handle);
+        }
+    }
+
     // Load material configuration from resource;
     resource material_resource;
-    if (!resource_system_load(name, RESOURCE_TYPE_MATERIAL, 0, &material_resource)) {
+    if (!resource_system_load_kname(name, RESOURCE_TYPE_MATERIAL, 0, &material_resource)) {
         KERROR("Failed to load material resource, returning nullptr.");
         return 0;
     }
 
     // Now acquire from loaded config.
-    material* m;
+    material* m = 0;
     if (material_resource.data) {
         m = material_system_acquire_from_config(*(material_config*)material_resource.data);
     }
@@ -183,35 +189,38 @@ material* material_system_acquire_from_config(material_config config) {
         return &state_ptr->default_material;
     }
 
-    material_reference ref;
-    if (state_ptr && hashtable_get(&state_ptr->registered_material_table, config.name, &ref)) {
+    kname name = kname_create(config.name);
+    if (state_ptr && name != INVALID_KNAME) {
+        // Materials not yet registered start off with an invalid handle.
+        material_reference ref;
+        ref.auto_release = false;
+        ref.handle = INVALID_ID;
+        ref.reference_count = 0;
+        u64_map_get(&state_ptr->registered_material_table, name, &ref);
+
         // This can only be changed the first time a material is loaded.
         if (ref.reference_count == 0) {
             ref.auto_release = config.auto_release;
         }
         ref.reference_count++;
         if (ref.handle == INVALID_ID) {
-            // This means no material exists here. Find a free index first.
-            u32 count = state_ptr->config.max_material_count;
-            material* m = 0;
-            for (u32 i = 0; i < count; ++i) {
-                if (state_ptr->registered_materials[i].id == INVALID_ID) {
-                    // A free slot has been found. Use its index as the handle.
-                    ref.handle = i;
-                    m = &state_ptr->registered_materials[i];
-                    break;
-                }
-            }
+            // This means no material exists here. Take a free slot from the pool.
+            material* m = pool_allocator_allocate(&state_ptr->registered_materials, &ref.handle);
 
             // Make sure an empty slot was actually found.
-            if (!m || ref.handle == INVALID_ID) {
+            if (!m) {
                 KFATAL("material_system_acquire - Material system cannot hold anymore materials. Adjust configuration to allow more.");
                 return 0;
             }
+            m->id = INVALID_ID;
+            m->generation = INVALID_ID;
+            m->internal_id = INVALID_ID;
+            m->render_frame_number = INVALID_ID;
 
             // Create new material.
             if (!load_material(config, m)) {
                 KERROR("Failed to load material '%s'.", config.name);
+                pool_allocator_free(&state_ptr->registered_materials, ref.handle);
                 return 0;
             }
 
@@ -246,16 +255,16 @@ material* material_system_acquire_from_config(material_config config) {
                 m->generation++;
             }
 
-            // Also use the handle as the material id.
-            m->id = ref.handle;
+            // Also use the slot index as the material id.
+            m->id = pool_handle_index(ref.handle);
             // KTRACE("Material '%s' does not yet exist. Created, and ref_count is now %i.", config.name, ref.reference_count);
         } else {
             // KTRACE("Material '%s' already exists, ref_count increased to %i.", config.name, ref.reference_count);
         }
 
         // Update the entry.
-        hashtable_set(&state_ptr->registered_material_table, config.name, &ref);
-        return &state_ptr->registered_materials[ref.handle];
+        u64_map_set(&state_ptr->registered_material_table, name, &ref);
+        return pool_allocator_get(&state_ptr->registered_materials, ref.handle);
     }
 
     // NOTE: This would only happen in the event something went wrong with the state.
@@ -264,35 +273,34 @@ material* material_system_acquire_from_config(material_config config) {
 }
 
 void material_system_release(const char* name) {
+    material_system_release_kname(kname_find(name));
+}
+
+void material_system_release_kname(kname name) {
     // Ignore release requests for the default material.
-    if (strings_equali(name, DEFAULT_MATERIAL_NAME)) {
+    if (strings_equali(kname_string_get(name), DEFAULT_MATERIAL_NAME)) {
         return;
     }
-    material_reference ref;
-    if (state_ptr && hashtable_get(&state_ptr->registered_material_table, name, &ref)) {
-        if (ref.reference_count == 0) {
-            KWARN("Tried to release non-existent material: '%s'", name);
+    material_reference* ref = state_ptr ? u64_map_get_ptr(&state_ptr->registered_material_table, name) : 0;
+    if (ref) {
+        if (ref->reference_count == 0) {
+            KWARN("Tried to release non-existent material: '%s'", kname_string_get(name));
             return;
         }
-        ref.reference_count--;
-        if (ref.reference_count == 0 && ref.auto_release) {
-            material* m = &state_ptr->registered_materials[ref.handle];
-
-            // Destroy/reset material.
-            destroy_material(m);
-
-            // Reset the reference.
-            ref.handle = INVALID_ID;
-            ref.auto_release = false;
-            // KTRACE("Released material '%s'., Material unloaded because reference count=0 and auto_release=true.", name);
+        ref->reference_count--;
+        if (ref->reference_count == 0 && ref->auto_release) {
+            u32 handle = ref->handle;
+            u64_map_remove(&state_ptr->registered_material_table, name);
+
+            // Destroy/reset material, and return its slot to the pool.
+            destroy_material(pool_allocator_get(&state_ptr->registered_materials, handle));
+            pool_allocator_free(&state_ptr->registered_materials, handle);
+            // KTRACE("Released material '%s'., Material unloaded because reference count=0 and auto_release=true.", kname_string_get(name));
         } else {
-            // KTRACE("Released material '%s', now has a reference count of '%i' (auto_release=%s).", name, ref.reference_count, ref.auto_release ? "true" : "false");
+            // KTRACE("Released material '%s', now has a reference count of '%i' (auto_release=%s).", kname_string_get(name), ref->reference_count, ref->auto_release ? "true" : "false");
         }
-
-        // Update the entry.
-        hashtable_set(&state_ptr->registered_material_table, name, &ref);
     } else {
-        KERROR("material_system_release failed to release material '%s'.", name);
+        KERROR("material_system_release failed to release material '%s'.", kname_string_get(name));
     }
 }
 
@@ -469,13 +477,13 @@ void destroy_material(material* m) {
 
     // Release texture references.
     if (m->diffuse_map.texture) {
-        texture_system_release(m->diffuse_map.texture->name);
+        texture_system_release_kname(m->diffuse_map.texture->name);
     }
     if (m->specular_map.texture) {
-        texture_system_release(m->specular_map.texture->name);
+        texture_system_release_kname(m->specular_map.texture->name);
     }
     if (m->normal_map.texture) {
-        texture_system_release(m->normal_map.texture->name);
+        texture_system_release_kname(m->normal_map.texture->name);
     }
 
     // Release texture map resources.
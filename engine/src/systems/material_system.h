@@ -3,6 +3,7 @@
 #include "defines.h"
 
 #include "resources/resource_types.h"
+#include "core/kname.h"
 
 #define DEFAULT_MATERIAL_NAME "default"
 
@@ -14,9 +15,25 @@ b8 material_system_initialize(u64* memory_requirement, void* state, material_sys
 void material_system_shutdown(void* state);
 
 material* material_system_acquire(const char* name);
+
+/**
+ * @brief Acquires the material with the given name, as with material_system_acquire. Materials
+ * which are already loaded are looked up by the name's id, without loading their configuration.
+ *
+ * @param name The name of the material to acquire.
+ * @return A pointer to the material, or 0 on failure.
+ */
+material* material_system_acquire_kname(kname name);
 material* material_system_acquire_from_config(material_config config);
 void material_system_release(const char* name);
 
+/**
+ * @brief Releases the material with the given name, as with material_system_release.
+ *
+ * @param name The name of the material to release.
+ */
+void material_system_release_kname(kname name);
+
 material* material_system_get_default();
 
 /**
@@ -1,6 +1,6 @@
 #include "render_view_system.h"
 
-#include "containers/hashtable.h"
+#include "containers/u64_map.h"
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
@@ -12,8 +12,8 @@
 #include "renderer/views/render_view_skybox.h"
 
 typedef struct render_view_system_state {
-    hashtable lookup;
-    void* table_block;
+    // View ids, keyed by the kname of the view's name.
+    u64_map lookup;
     u32 max_view_count;
     render_view* registered_views;
 } render_view_system_state;
@@ -26,11 +26,10 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
         return false;
     }
 
-    // Block of memory will contain state structure, then block for hashtable, then block for array.
+    // Block of memory will contain state structure, then block for array.
     u64 struct_requirement = sizeof(render_view_system_state);
-    u64 hashtable_requirement = sizeof(u16) * config.max_view_count;
     u64 array_requirement = sizeof(render_view) * config.max_view_count;
-    *memory_requirement = struct_requirement + hashtable_requirement + array_requirement;
+    *memory_requirement = struct_requirement + array_requirement;
 
      if (!state) {
         return true;
@@ -39,18 +38,12 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
     state_ptr = state;
     state_ptr->max_view_count = config.max_view_count;
 
-    // The hashtable block is after the state. Already allocated, so just set the pointer.
+    // The array block is after the state. Already allocated, so just set the pointer.
     u64 addr = (u64)state_ptr;
-    state_ptr->table_block = (void*)((u64)addr + struct_requirement);
+    state_ptr->registered_views = (void*)((u64)addr + struct_requirement);
 
-    // Array block is after hashtable.
-    state_ptr->registered_views = (void*)((u64)state_ptr->table_block + hashtable_requirement);
-
-    // Create a hashtable for view lookups.
-    hashtable_create(sizeof(u16), state_ptr->max_view_count, state_ptr->table_block, false, &state_ptr->lookup);
-    // Fill the hashtable with invalid ids
-    u16 invalid_id = INVALID_ID_U16;
-    hashtable_fill(&state_ptr->lookup, &invalid_id);
+    // Create a map for view lookups.
+    u64_map_create(sizeof(u16), state_ptr->max_view_count, &state_ptr->lookup);
 
     // Fill the array with invalid entries.
     for (u32 i = 0; i < state_ptr->max_view_count; ++i) {
@@ -61,6 +54,10 @@ b8 render_view_system_initialize(u64* memory_requirement, void* state, render_vi
 }
 
 void render_view_system_shutdown(void* state) {
+    render_view_system_state* s = (render_view_system_state*)state;
+    if (s) {
+        u64_map_destroy(&s->lookup);
+    }
     state_ptr = 0;
 }
 
@@ -81,9 +78,9 @@ b8 render_view_system_create(const render_view_config* config) {
     }
 
     u16 id = INVALID_ID_U16;
+    kname name = kname_create(config->name);
     // Make sure there is not already an entry with this name already registered.
-    hashtable_get(&state_ptr->lookup, config->name, &id);
-    if (id != INVALID_ID_U16) {
+    if (u64_map_get_ptr(&state_ptr->lookup, name)) {
         KERROR("render_view_system_create - A view named '%s' already exists. A new one will not be created.", config->name);
         return false;
     }
@@ -152,8 +149,8 @@ b8 render_view_system_create(const render_view_config* config) {
         return false;
     }
 
-    // Update the hashtable entry.
-    hashtable_set(&state_ptr->lookup, config->name, &id);
+    // Update the lookup entry.
+    u64_map_set(&state_ptr->lookup, name, &id);
 
     return true;
 }
@@ -168,19 +165,22 @@ void render_view_system_on_window_resize(u32 width, u32 height) {
 }
 
 render_view* render_view_system_get(const char* name) {
+    return render_view_system_get_kname(kname_find(name));
+}
+
+render_view* render_view_system_get_kname(kname name) {
     if (state_ptr) {
         u16 id = INVALID_ID_U16;
-        hashtable_get(&state_ptr->lookup, name, &id);
-        if (id != INVALID_ID_U16) {
+        if (u64_map_get(&state_ptr->lookup, name, &id)) {
             return &state_ptr->registered_views[id];
         }
     }
     return 0;
 }
 
-b8 render_view_system_build_packet(const render_view* view, void* data, struct render_view_packet* out_packet){
+b8 render_view_system_build_packet(const render_view* view, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet){
     if (view && out_packet) {
-        return view->on_build_packet(view, data, out_packet);
+        return view->on_build_packet(view, frame_allocator, data, out_packet);
     }
 
     KERROR("render_view_system_build_packet requires valid pointers to a view and a packet.");
@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "math/math_types.h"
 #include "renderer/renderer_types.inl"
+#include "core/kname.h"
 
 /** @brief The configuration for the render view system. */
 typedef struct render_view_system_config {
@@ -53,15 +54,25 @@ void render_view_system_on_window_resize(u32 width, u32 height);
  */
 render_view* render_view_system_get(const char* name);
 
+/**
+ * @brief Obtains a pointer to a view with the given name, as with render_view_system_get.
+ * Cheaper for callers which look views up each frame, as the name is not hashed.
+ *
+ * @param name The name of the view.
+ * @return A pointer to a view if found; otherwise 0.
+ */
+render_view* render_view_system_get_kname(kname name);
+
 /**
  * @brief Builds a render view packet using the provided view and meshes.
  *
  * @param view A pointer to the view to use.
+ * @param frame_allocator An allocator for any data the packet needs, which is valid until the end of the frame.
  * @param data Freeform data used to build the packet.
  * @param out_packet A pointer to hold the generated packet.
  * @return True on success; otherwise false.
  */
-b8 render_view_system_build_packet(const render_view* view, void* data, struct render_view_packet* out_packet);
+b8 render_view_system_build_packet(const render_view* view, struct linear_allocator* frame_allocator, void* data, struct render_view_packet* out_packet);
 
 /**
  * @brief Uses the given view and packet to render the contents therein.
@@ -109,6 +109,16 @@ b8 resource_system_load(const char* name, resource_type type, void* params, reso
     return false;
 }
 
+b8 resource_system_load_kname(kname name, resource_type type, void* params, resource* out_resource) {
+    const char* name_str = kname_string_get(name);
+    if (!name_str) {
+        out_resource->loader_id = INVALID_ID;
+        KERROR("resource_system_load_kname - An invalid name was passed.");
+        return false;
+    }
+    return resource_system_load(name_str, type, params, out_resource);
+}
+
 b8 resource_system_load_custom(const char* name, const char* custom_type, void* params, resource* out_resource) {
     if (state_ptr && custom_type && string_length(custom_type) > 0) {
         // Select loader.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "resources/resource_types.h"
+#include "core/kname.h"
 
 typedef struct resource_system_config {
     u32 max_loader_count;
@@ -17,12 +18,24 @@ typedef struct resource_loader {
     void (*unload)(struct resource_loader* self, resource* resource);
 } resource_loader;
 
-b8 resource_system_initialize(u64* memory_requirement, void* state, resource_system_config config);
-void resource_system_shutdown(void* state);
+KAPI b8 resource_system_initialize(u64* memory_requirement, void* state, resource_system_config config);
+KAPI void resource_system_shutdown(void* state);
 
 KAPI b8 resource_system_register_loader(resource_loader loader);
 
 KAPI b8 resource_system_load(const char* name, resource_type type, void* params, resource* out_resource);
+
+/**
+ * @brief Loads the resource with the given name, as with resource_system_load.
+ *
+ * @param name The name of the resource to load.
+ * @param type The type of resource to load.
+ * @param params Parameters passed on to the loader. Optional.
+ * @param out_resource A pointer to hold the loaded resource.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 resource_system_load_kname(kname name, resource_type type, void* params, resource* out_resource);
+
 KAPI b8 resource_system_load_custom(const char* name, const char* custom_type, void* params, resource* out_resource);
 
 KAPI void resource_system_unload(resource* resource);
@@ -13,10 +13,8 @@
 typedef struct shader_system_state {
     // This system's configuration.
     shader_system_config config;
-    // A lookup table for shader name->id
-    hashtable lookup;
-    // The memory used for the lookup table.
-    void* lookup_memory;
+    // A lookup of shader ids, keyed by the kname of the shader's name.
+    u64_map lookup;
     // The identifier for the currently bound shader.
     u32 current_shader_id;
     // A collection of created shaders.
@@ -29,7 +27,7 @@ static shader_system_state* state_ptr = 0;
 b8 add_attribute(shader* shader, const shader_attribute_config* config);
 b8 add_sampler(shader* shader, shader_uniform_config* config);
 b8 add_uniform(shader* shader, shader_uniform_config* config);
-u32 get_shader_id(const char* shader_name);
+u32 get_shader_id(kname shader_name);
 u32 new_shader_id();
 b8 uniform_add(shader* shader, const char* uniform_name, u32 size, shader_uniform_type type, shader_scope scope, u32 set_location, b8 is_sampler);
 b8 uniform_name_valid(shader* shader, const char* uniform_name);
@@ -39,35 +37,27 @@ void shader_destroy(shader* s);
 
 b8 shader_system_initialize(u64* memory_requirement, void* memory, shader_system_config config) {
     // Verify configuration.
-    if (config.max_shader_count < 512) {
-        if (config.max_shader_count == 0) {
-            KERROR("shader_system_initialize - config.max_shader_count must be greater than 0");
-            return false;
-        } else {
-            // This is to help avoid hashtable collisions.
-            KWARN("shader_system_initialize - config.max_shader_count is recommended to be at least 512.");
-        }
+    if (config.max_shader_count == 0) {
+        KERROR("shader_system_initialize - config.max_shader_count must be greater than 0");
+        return false;
     }
 
-    // Figure out how large of a hashtable is needed.
-    // Block of memory will contain state structure then the block for the hashtable.
+    // Block of memory will contain state structure then the shader array.
     u64 struct_requirement = sizeof(shader_system_state);
-    u64 hashtable_requirement = sizeof(u32) * config.max_shader_count;
     u64 shader_array_requirement = sizeof(shader) * config.max_shader_count;
-    *memory_requirement = struct_requirement + hashtable_requirement + shader_array_requirement;
+    *memory_requirement = struct_requirement + shader_array_requirement;
 
     if (!memory) {
         return true;
     }
 
-    // Setup the state pointer, memory block, shader array, then create the hashtable.
+    // Setup the state pointer, memory block, shader array, then create the lookup.
     state_ptr = memory;
     u64 addr = (u64)memory;
-    state_ptr->lookup_memory = (void*)(addr + struct_requirement);
-    state_ptr->shaders = (void*)((u64)state_ptr->lookup_memory + hashtable_requirement);
+    state_ptr->shaders = (void*)(addr + struct_requirement);
     state_ptr->config = config;
     state_ptr->current_shader_id = INVALID_ID;
-    hashtable_create(sizeof(u32), config.max_shader_count, state_ptr->lookup_memory, false, &state_ptr->lookup);
+    u64_map_create(sizeof(u32), config.max_shader_count, &state_ptr->lookup);
 
     // Invalidate all shader ids.
     for (u32 i = 0; i < config.max_shader_count; ++i) {
@@ -75,13 +65,6 @@ b8 shader_system_initialize(u64* memory_requirement, void* memory, shader_system
         state_ptr->shaders[i].render_frame_number = INVALID_ID_U64;
     }
 
-    // Fill the table with invalid ids.
-    u32 invalid_fill_id = INVALID_ID;
-    if (!hashtable_fill(&state_ptr->lookup, &invalid_fill_id)) {
-        KERROR("hashtable_fill failed.");
-        return false;
-    }
-
     for (u32 i = 0; i < state_ptr->config.max_shader_count; ++i) {
         state_ptr->shaders[i].id = INVALID_ID;
     }
@@ -99,7 +82,7 @@ void shader_system_shutdown(void* state) {
                 shader_destroy(s);
             }
         }
-        hashtable_destroy(&st->lookup);
+        u64_map_destroy(&st->lookup);
         kzero_memory(st, sizeof(shader_system_state));
     }
 
@@ -122,21 +105,15 @@ b8 shader_system_create(const shader_config* config) {
     out_shader->bound_instance_id = INVALID_ID;
     out_shader->attribute_stride = 0;
 
-    // Setup arrays
+    // Setup arrays, sized up front from the config so that adding each entry doesn't reallocate.
     out_shader->global_texture_maps = darray_create(texture_map*);
-    out_shader->uniforms = darray_create(shader_uniform);
-    out_shader->attributes = darray_create(shader_attribute);
+    out_shader->uniforms = darray_reserve(shader_uniform, config->uniform_count);
+    out_shader->attributes = darray_reserve(shader_attribute, config->attribute_count);
 
-    // Create a hashtable to store uniform array indexes. This provides a direct index into the
+    // Create a map to store uniform array indexes. This provides a direct index into the
     // 'uniforms' array stored in the shader for quick lookups by name.
     u64 element_size = sizeof(u16);  // Indexes are stored as u16s.
-    u64 element_count = 1024;        // This is more uniforms than we will ever need, but a bigger table reduces collision chance.
-    out_shader->hashtable_block = kallocate(element_size * element_count, MEMORY_TAG_UNKNOWN);
-    hashtable_create(element_size, element_count, out_shader->hashtable_block, false, &out_shader->uniform_lookup);
-
-    // Invalidate all spots in the hashtable.
-    u32 invalid = INVALID_ID;
-    hashtable_fill(&out_shader->uniform_lookup, &invalid);
+    u64_map_create(element_size, state_ptr->config.max_uniform_count, &out_shader->uniform_lookup);
 
     // A running total of the actual global uniform buffer object size.
     out_shader->global_ubo_size = 0;
@@ -185,9 +162,9 @@ b8 shader_system_create(const shader_config* config) {
         return false;
     }
 
-    // At this point, creation is successful, so store the shader id in the hashtable
+    // At this point, creation is successful, so store the shader id in the lookup
     // so this can be looked up by name later.
-    if (!hashtable_set(&state_ptr->lookup, config->name, &out_shader->id)) {
+    if (!u64_map_set(&state_ptr->lookup, kname_create(config->name), &out_shader->id)) {
         // Dangit, we got so far... welp, nuke the shader and boot.
         renderer_shader_destroy(out_shader);
         return false;
@@ -197,6 +174,10 @@ b8 shader_system_create(const shader_config* config) {
 }
 
 u32 shader_system_get_id(const char* shader_name) {
+    return get_shader_id(kname_find(shader_name));
+}
+
+u32 shader_system_get_id_kname(kname shader_name) {
     return get_shader_id(shader_name);
 }
 
@@ -208,7 +189,7 @@ shader* shader_system_get_by_id(u32 shader_id) {
 }
 
 shader* shader_system_get(const char* shader_name) {
-    u32 shader_id = get_shader_id(shader_name);
+    u32 shader_id = get_shader_id(kname_find(shader_name));
     if (shader_id != INVALID_ID) {
         return shader_system_get_by_id(shader_id);
     }
@@ -226,6 +207,7 @@ void shader_destroy(shader* s) {
         kfree(s->global_texture_maps[i], sizeof(texture_map), MEMORY_TAG_RENDERER);
     }
     darray_destroy(s->global_texture_maps);
+    u64_map_destroy(&s->uniform_lookup);
 
     // Free the name.
     if (s->name) {
@@ -236,18 +218,22 @@ void shader_destroy(shader* s) {
 }
 
 void shader_system_destroy(const char* shader_name) {
-    u32 shader_id = get_shader_id(shader_name);
+    kname name = kname_find(shader_name);
+    u32 shader_id = get_shader_id(name);
     if (shader_id == INVALID_ID) {
         return;
     }
 
     shader* s = &state_ptr->shaders[shader_id];
 
+    // Free the name's entry, so that a shader of the same name may be created again.
+    u64_map_remove(&state_ptr->lookup, name);
     shader_destroy(s);
+    s->id = INVALID_ID;
 }
 
 b8 shader_system_use(const char* shader_name) {
-    u32 next_shader_id = get_shader_id(shader_name);
+    u32 next_shader_id = get_shader_id(kname_find(shader_name));
     if (next_shader_id == INVALID_ID) {
         return false;
     }
@@ -273,26 +259,36 @@ b8 shader_system_use_by_id(u32 shader_id) {
 }
 
 u16 shader_system_uniform_index(shader* s, const char* uniform_name) {
+    return shader_system_uniform_index_kname(s, kname_find(uniform_name));
+}
+
+u16 shader_system_uniform_index_kname(shader* s, kname uniform_name) {
     if (!s || s->id == INVALID_ID) {
         KERROR("shader_system_uniform_location called with invalid shader.");
         return INVALID_ID_U16;
     }
 
     u16 index = INVALID_ID_U16;
-    if (!hashtable_get(&s->uniform_lookup, uniform_name, &index) || index == INVALID_ID_U16) {
-        KERROR("Shader '%s' does not have a registered uniform named '%s'", s->name, uniform_name);
+    if (!u64_map_get(&s->uniform_lookup, uniform_name, &index)) {
+        // Names looked up by text are only found if some shader registered them.
+        const char* name_text = kname_string_get(uniform_name);
+        KERROR("Shader '%s' does not have a registered uniform named '%s'", s->name, name_text ? name_text : "(unknown)");
         return INVALID_ID_U16;
     }
     return s->uniforms[index].index;
 }
 
 b8 shader_system_uniform_set(const char* uniform_name, const void* value) {
+    return shader_system_uniform_set_kname(kname_find(uniform_name), value);
+}
+
+b8 shader_system_uniform_set_kname(kname uniform_name, const void* value) {
     if (state_ptr->current_shader_id == INVALID_ID) {
         KERROR("shader_system_uniform_set called without a shader in use.");
         return false;
     }
     shader* s = &state_ptr->shaders[state_ptr->current_shader_id];
-    u16 index = shader_system_uniform_index(s, uniform_name);
+    u16 index = shader_system_uniform_index_kname(s, uniform_name);
     return shader_system_uniform_set_by_index(index, value);
 }
 
@@ -425,7 +421,7 @@ b8 add_sampler(shader* shader, shader_uniform_config* config) {
     }
 
     // Treat it like a uniform. NOTE: In the case of samplers, out_location is used to determine the
-    // hashtable entry's 'location' field value directly, and is then set to the index of the uniform array.
+    // lookup entry's 'location' field value directly, and is then set to the index of the uniform array.
     // This allows location lookups for samplers as if they were uniforms as well (since technically they are).
     // TODO: might need to store this elsewhere
     if (!uniform_add(shader, config->name, 0, config->type, config->scope, location, true)) {
@@ -443,10 +439,10 @@ b8 add_uniform(shader* shader, shader_uniform_config* config) {
     return uniform_add(shader, config->name, config->size, config->type, config->scope, 0, false);
 }
 
-u32 get_shader_id(const char* shader_name) {
+u32 get_shader_id(kname shader_name) {
     u32 shader_id = INVALID_ID;
-    if (!hashtable_get(&state_ptr->lookup, shader_name, &shader_id)) {
-        KERROR("There is no shader registered named '%s'.", shader_name);
+    if (!u64_map_get(&state_ptr->lookup, shader_name, &shader_id)) {
+        KERROR("There is no shader registered named '%s'.", kname_string_get(shader_name));
         return INVALID_ID;
     }
     return shader_id;
@@ -468,7 +464,7 @@ b8 uniform_add(shader* shader, const char* uniform_name, u32 size, shader_unifor
         return false;
     }
     shader_uniform entry;
-    entry.index = uniform_count;  // Index is saved to the hashtable for lookups.
+    entry.index = uniform_count;  // Index is saved to the lookup.
     entry.scope = scope;
     entry.type = type;
     b8 is_global = (scope == SHADER_SCOPE_GLOBAL);
@@ -500,7 +496,7 @@ b8 uniform_add(shader* shader, const char* uniform_name, u32 size, shader_unifor
         shader->push_constant_size += r.size;
     }
 
-    if (!hashtable_set(&shader->uniform_lookup, uniform_name, &entry.index)) {
+    if (!u64_map_set(&shader->uniform_lookup, kname_create(uniform_name), &entry.index)) {
         KERROR("Failed to add uniform.");
         return false;
     }
@@ -522,8 +518,7 @@ b8 uniform_name_valid(shader* shader, const char* uniform_name) {
         KERROR("Uniform name must exist.");
         return false;
     }
-    u16 location;
-    if (hashtable_get(&shader->uniform_lookup, uniform_name, &location) && location != INVALID_ID_U16) {
+    if (u64_map_get_ptr(&shader->uniform_lookup, kname_find(uniform_name))) {
         KERROR("A uniform by the name '%s' already exists on shader '%s'.", uniform_name, shader->name);
         return false;
     }
@@ -2,7 +2,8 @@
 
 #include "defines.h"
 #include "renderer/renderer_types.inl"
-#include "containers/hashtable.h"
+#include "containers/u64_map.h"
+#include "core/kname.h"
 
 /** @brief Configuration for the shader system. */
 typedef struct shader_system_config {
@@ -116,10 +117,8 @@ typedef struct shader {
     /** @brief The currently bound instance's ubo offset. */
     u32 bound_ubo_offset;
 
-    /** @brief The block of memory used by the uniform hashtable. */
-    void* hashtable_block;
-    /** @brief A hashtable to store uniform index/locations by name. */
-    hashtable uniform_lookup;
+    /** @brief A map of uniform indices, keyed by the kname of the uniform's name. */
+    u64_map uniform_lookup;
 
     /** @brief An array of uniforms in this shader. Darray. */
     shader_uniform* uniforms;
@@ -179,6 +178,14 @@ KAPI b8 shader_system_create(const shader_config* config);
  */
 KAPI u32 shader_system_get_id(const char* shader_name);
 
+/**
+ * @brief Gets the identifier of a shader by name, as with shader_system_get_id.
+ * 
+ * @param shader_name The name of the shader.
+ * @return The shader id, if found; otherwise INVALID_ID.
+ */
+KAPI u32 shader_system_get_id_kname(kname shader_name);
+
 /**
  * @brief Returns a pointer to a shader with the given identifier.
  * 
@@ -220,6 +227,16 @@ KAPI b8 shader_system_use_by_id(u32 shader_id);
  */
 KAPI u16 shader_system_uniform_index(shader* s, const char* uniform_name);
 
+/**
+ * @brief Returns the uniform index for a uniform with the given name, as with
+ * shader_system_uniform_index, without hashing the name's text.
+ * 
+ * @param s A pointer to the shader to obtain the index from.
+ * @param uniform_name The name of the uniform to search for.
+ * @return The uniform index, if found; otherwise INVALID_ID_U16.
+ */
+KAPI u16 shader_system_uniform_index_kname(shader* s, kname uniform_name);
+
 /**
  * @brief Sets the value of a uniform with the given name to the supplied value.
  * NOTE: Operates against the currently-used shader.
@@ -230,6 +247,16 @@ KAPI u16 shader_system_uniform_index(shader* s, const char* uniform_name);
  */
 KAPI b8 shader_system_uniform_set(const char* uniform_name, const void* value);
 
+/**
+ * @brief Sets the value of a uniform with the given name, as with shader_system_uniform_set.
+ * NOTE: Operates against the currently-used shader.
+ * 
+ * @param uniform_name The name of the uniform to be set.
+ * @param value The value to be set.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 shader_system_uniform_set_kname(kname uniform_name, const void* value);
+
 /**
  * @brief Sets the texture of a sampler with the given name to the supplied texture.
  * NOTE: Operates against the currently-used shader.
@@ -3,7 +3,9 @@
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
-#include "containers/hashtable.h"
+#include "core/kname.h"
+#include "containers/u64_map.h"
+#include "memory/pool_allocator.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -18,11 +20,11 @@ typedef struct texture_system_state
     texture default_specular_texture;
     texture default_normal_texture;
 
-    // Array of registered textures
-    texture* registered_textures;
+    // Pool of registered textures, referred to by handle.
+    pool_allocator registered_textures;
 
-    // Hashtable for texture lookups
-    hashtable registered_texture_table;
+    // Texture references, keyed by name.
+    u64_map registered_texture_table;
 } texture_system_state;
 
 typedef struct texture_reference
@@ -34,8 +36,10 @@ typedef struct texture_reference
 
 // Also used as result_data from job.
 typedef struct texture_load_params {
-    char* resource_name;
+    kname name;
     texture* out_texture;
+    // The handle of out_texture, used to detect if it was released while loading.
+    u32 texture_handle;
     texture temp_texture;
     u32 current_generation;
     resource image_resource;
@@ -43,12 +47,15 @@ typedef struct texture_load_params {
 
 static texture_system_state* state_ptr = 0;
 
+// The number of textures the lookup table has room for before it first grows.
+#define TEXTURE_SYSTEM_INITIAL_TABLE_COUNT 512
+
 b8 create_default_textures(texture_system_state* state);
 void destroy_default_textures(texture_system_state* state);
-b8 load_texture(const char* texture_name, texture* t);
-b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t);
+b8 load_texture(kname texture_name, texture* t, u32 handle);
+b8 load_cube_textures(kname name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t);
 void destroy_texture(texture* t);
-b8 process_texture_reference(const char* name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_id);
+b8 process_texture_reference(kname name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_handle);
 
 b8 texture_system_initialize(u64* memory_requirement, void* state, texture_system_config config)
 {
@@ -58,11 +65,14 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, texture_syste
         return false;
     }
 
-    // Block of memory will contain state structure, then block for array, then block for hashtable
+    // Block of memory will contain state structure, then block for pool
     u64 struct_requirement = sizeof(texture_system_state);
-    u64 array_requirement = sizeof(texture) * config.max_texture_count;
-    u64 hashtable_requirement = sizeof(texture_reference) * config.max_texture_count;
-    *memory_requirement = struct_requirement + array_requirement + hashtable_requirement;
+    u64 array_requirement = 0;
+    if (!pool_allocator_create(sizeof(texture), config.max_texture_count, &array_requirement, 0, 0)) {
+        KFATAL("texture_system_initialize - Unable to create pool for %u textures.", config.max_texture_count);
+        return false;
+    }
+    *memory_requirement = struct_requirement + array_requirement;
 
     if(!state)
     {
@@ -72,30 +82,16 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, texture_syste
     state_ptr = state;
     state_ptr->config = config;
 
-    // The array block is after the state. Already allocated, so just set the pointer
+    // The pool block is after the state. Already allocated, so just create the pool in it
     void* array_block = state + struct_requirement;
-    state_ptr->registered_textures = array_block;
+    pool_allocator_create(sizeof(texture), config.max_texture_count, &array_requirement, array_block, &state_ptr->registered_textures);
+    KDEBUG("Texture system: pool of %u textures occupies %.2f MiB (%u bytes per texture).",
+           config.max_texture_count, (f64)array_requirement / MEBIBYTES(1), (u32)sizeof(texture));
 
-    // Hashtable block is after array
-    void* hashtable_block = array_block + array_requirement;
-
-    // Create a hsahtable for texture lookups
-    hashtable_create(sizeof(texture_reference), config.max_texture_count, hashtable_block, false, &state_ptr->registered_texture_table);
-
-    // Fill the hashtable with invalid references to use as a default
-    texture_reference invalid_ref;
-    invalid_ref.auto_release = false;
-    invalid_ref.handle = INVALID_ID; // Primary reason for needing default values
-    invalid_ref.reference_count = 0;
-    hashtable_fill(&state_ptr->registered_texture_table, &invalid_ref);
-
-    // Invalidate all textures in the array
-    u32 count = state_ptr->config.max_texture_count;
-    for(u32 i = 0; i < count; ++i)
-    {
-        state_ptr->registered_textures[i].id = INVALID_ID;
-        state_ptr->registered_textures[i].generation = INVALID_ID;
-    }
+    // Create a map for texture lookups. It grows as textures are registered, so
+    // starts out with room for only a fraction of the maximum.
+    u32 table_count = config.max_texture_count < TEXTURE_SYSTEM_INITIAL_TABLE_COUNT ? config.max_texture_count : TEXTURE_SYSTEM_INITIAL_TABLE_COUNT;
+    u64_map_create(sizeof(texture_reference), table_count, &state_ptr->registered_texture_table);
 
     // Create default textures for use in the system
     create_default_textures(state_ptr);
@@ -110,14 +106,16 @@ void texture_system_shutdown(void* state)
         // Destroy all loaded textures
         for(u32 i = 0; i < state_ptr->config.max_texture_count; ++i)
         {
-            texture* t = &state_ptr->registered_textures[i];
-            if(t->generation != INVALID_ID)
+            texture* t = pool_allocator_get_by_index(&state_ptr->registered_textures, i);
+            if(t && t->generation != INVALID_ID)
             {
                 renderer_texture_destroy(t);
             }
         }
 
         destroy_default_textures(state_ptr);
+        pool_allocator_destroy(&state_ptr->registered_textures);
+        u64_map_destroy(&state_ptr->registered_texture_table);
 
         state_ptr = 0;
     }
@@ -125,22 +123,33 @@ void texture_system_shutdown(void* state)
 
 texture* texture_system_acquire(const char* name, b8 auto_release)
 {
+    return texture_system_acquire_kname(kname_create(name), auto_release);
+}
+
+texture* texture_system_acquire_kname(kname name, b8 auto_release)
+{
+    // An empty name, or one created while the name system was not running, has no text to compare.
+    if (name == INVALID_KNAME) {
+        KERROR("texture_system_acquire requires a valid name.");
+        return 0;
+    }
+
     // Return default texture, but warn about it since this should be returned via get_default_texture()
     // TODO: Check against other default texture names?
-    if(strings_equali(name, DEFAULT_TEXTURE_NAME))
+    if(strings_equali(kname_string_get(name), DEFAULT_TEXTURE_NAME))
     {
         KWARN("texture_system_acquire called for default texture. Use get_default_texture for texture 'default'.");
         return &state_ptr->default_texture;
     }
 
-    u32 id = INVALID_ID;
+    u32 handle = INVALID_ID;
     // NOTE: Increments reference count, or creates new entry.
-    if (!process_texture_reference(name, TEXTURE_TYPE_2D, 1, auto_release, false, &id)) {
+    if (!process_texture_reference(name, TEXTURE_TYPE_2D, 1, auto_release, false, &handle)) {
         KERROR("texture_system_acquire failed to obtain a new texture id.");
         return 0;
     }
 
-    return &state_ptr->registered_textures[id];
+    return pool_allocator_get(&state_ptr->registered_textures, handle);
 }
 
 texture* texture_system_acquire_cube(const char* name, b8 auto_release) {
@@ -151,29 +160,29 @@ texture* texture_system_acquire_cube(const char* name, b8 auto_release) {
         return &state_ptr->default_texture;
     }
 
-    u32 id = INVALID_ID;
+    u32 handle = INVALID_ID;
     // NOTE: Increments reference count, or creates new entry.
-    if (!process_texture_reference(name, TEXTURE_TYPE_CUBE, 1, auto_release, false, &id)) {
+    if (!process_texture_reference(kname_create(name), TEXTURE_TYPE_CUBE, 1, auto_release, false, &handle)) {
         KERROR("texture_system_acquire_cube failed to obtain a new texture id.");
         return 0;
     }
 
-    return &state_ptr->registered_textures[id];
+    return pool_allocator_get(&state_ptr->registered_textures, handle);
 }
 
 texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height, u8 channel_count, b8 has_transparency) {
-    u32 id = INVALID_ID;
+    u32 handle = INVALID_ID;
     // NOTE: Wrapped textures are never auto-released because it means that thier
     // resources are created and managed somewhere within the renderer internals.
-    if (!process_texture_reference(name, TEXTURE_TYPE_2D, 1, false, true, &id)) {
+    if (!process_texture_reference(kname_create(name), TEXTURE_TYPE_2D, 1, false, true, &handle)) {
         KERROR("texture_system_aquire_writeable failed to obtain a new texture id.");
         return 0;
     }
 
-    texture* t = &state_ptr->registered_textures[id];
-    t->id = id;
+    texture* t = pool_allocator_get(&state_ptr->registered_textures, handle);
+    t->id = pool_handle_index(handle);
     t->type = TEXTURE_TYPE_2D;
-    string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+    t->name = kname_create(name);
     t->width = width;
     t->height = height;
     t->channel_count = channel_count;
@@ -187,16 +196,25 @@ texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height
 
 void texture_system_release(const char* name)
 {
+    texture_system_release_kname(kname_find(name));
+}
+
+void texture_system_release_kname(kname name)
+{
+    if (name == INVALID_KNAME) {
+        return;
+    }
+
     // Ignore release requests for the default texture
     // TODO: Check against other default texture names as well?
-    if(strings_equali(name, DEFAULT_TEXTURE_NAME))
+    if(strings_equali(kname_string_get(name), DEFAULT_TEXTURE_NAME))
     {
         return;
     }
-    u32 id = INVALID_ID;
+    u32 handle = INVALID_ID;
     // NOTE: Decrement the reference count.
-    if (!process_texture_reference(name, TEXTURE_TYPE_2D, -1, false, false, &id)) {
-        KERROR("texture_system_release failed to release texture '%s' properly.", name);
+    if (!process_texture_reference(name, TEXTURE_TYPE_2D, -1, false, false, &handle)) {
+        KERROR("texture_system_release failed to release texture '%s' properly.", kname_string_get(name));
     }
 }
 
@@ -206,12 +224,14 @@ texture* texture_system_wrap_internal(const char* name, u32 width, u32 height, u
     if (register_texture) {
         // NOTE: Wrapped textures are never auto-released because it means that thier
         // resources are created and managed somewhere within the renderer internals.
-        if (!process_texture_reference(name, TEXTURE_TYPE_2D, 1, false, true, &id)) {
+        u32 handle = INVALID_ID;
+        if (!process_texture_reference(kname_create(name), TEXTURE_TYPE_2D, 1, false, true, &handle)) {
             KERROR("texture_system_wrap_internal failed to obtain a new texture id.");
             return 0;
         }
 
-        t = &state_ptr->registered_textures[id];
+        id = pool_handle_index(handle);
+        t = pool_allocator_get(&state_ptr->registered_textures, handle);
     } else {
         t = kallocate(sizeof(texture), MEMORY_TAG_TEXTURE);
         // KTRACE("texture_system_wrap_internal created texture '%s', but not registering, resulting in an allocation. It is up to the caller to free this memory.", name);
@@ -219,7 +239,7 @@ texture* texture_system_wrap_internal(const char* name, u32 width, u32 height, u
 
     t->id = id;
     t->type = TEXTURE_TYPE_2D;
-    string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+    t->name = kname_create(name);
     t->width = width;
     t->height = height;
     t->channel_count = channel_count;
@@ -325,7 +345,7 @@ b8 create_default_textures(texture_system_state* state)
         }
     }
 
-    string_ncopy(state->default_texture.name, DEFAULT_TEXTURE_NAME, TEXTURE_NAME_MAX_LENGTH);
+    state->default_texture.name = kname_create(DEFAULT_TEXTURE_NAME);
     state->default_texture.width = tex_dimension;
     state->default_texture.height = tex_dimension;
     state->default_texture.channel_count = 4;
@@ -341,7 +361,7 @@ b8 create_default_textures(texture_system_state* state)
     u8 diff_pixels[16 * 16 * 4];
     // Default diffuse map is all white.
     kset_memory(diff_pixels, 255, sizeof(u8) * 16 * 16 * 4);
-    string_ncopy(state->default_diffuse_texture.name, DEFAULT_DIFFUSE_TEXTURE_NAME, TEXTURE_NAME_MAX_LENGTH);
+    state->default_diffuse_texture.name = kname_create(DEFAULT_DIFFUSE_TEXTURE_NAME);
     state->default_diffuse_texture.width = 16;
     state->default_diffuse_texture.height = 16;
     state->default_diffuse_texture.channel_count = 4;
@@ -357,7 +377,7 @@ b8 create_default_textures(texture_system_state* state)
     u8 spec_pixels[16 * 16 * 4];
     // Default spec map is black (no specular)
     kset_memory(spec_pixels, 0, sizeof(u8) * 16 * 16 * 4);
-    string_ncopy(state->default_specular_texture.name, DEFAULT_SPECULAR_TEXTURE_NAME, TEXTURE_NAME_MAX_LENGTH);
+    state->default_specular_texture.name = kname_create(DEFAULT_SPECULAR_TEXTURE_NAME);
     state->default_specular_texture.width = 16;
     state->default_specular_texture.height = 16;
     state->default_specular_texture.channel_count = 4;
@@ -386,7 +406,7 @@ b8 create_default_textures(texture_system_state* state)
         }
     }
 
-    string_ncopy(state->default_normal_texture.name, DEFAULT_NORMAL_TEXTURE_NAME, TEXTURE_NAME_MAX_LENGTH);
+    state->default_normal_texture.name = kname_create(DEFAULT_NORMAL_TEXTURE_NAME);
     state->default_normal_texture.width = 16;
     state->default_normal_texture.height = 16;
     state->default_normal_texture.channel_count = 4;
@@ -411,28 +431,55 @@ void destroy_default_textures(texture_system_state* state)
     }
 }
 
-b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t) {
+typedef struct cube_face_load_params {
+    const char* name;
+    resource* out_resource;
+    b8* out_loaded;
+} cube_face_load_params;
+
+b8 cube_face_load_job_start(void* params, void* result_data) {
+    cube_face_load_params* face_params = (cube_face_load_params*)params;
+    image_resource_params resource_params;
+    resource_params.flip_y = false;
+
+    *face_params->out_loaded = resource_system_load(face_params->name, RESOURCE_TYPE_IMAGE, &resource_params, face_params->out_resource);
+    return *face_params->out_loaded;
+}
+
+b8 load_cube_textures(kname name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t) {
+    // Load and decode all six faces at once, helping with the jobs while waiting on them.
+    resource face_resources[6] = {0};
+    b8 loaded[6] = {0};
+    job_counter faces = {0};
+    for (u8 i = 0; i < 6; ++i) {
+        cube_face_load_params params;
+        params.name = texture_names[i];
+        params.out_resource = &face_resources[i];
+        params.out_loaded = &loaded[i];
+        job_info job = job_create(cube_face_load_job_start, 0, 0, &params, sizeof(cube_face_load_params), 0);
+        job.counter = &faces;
+        job_system_submit(job);
+    }
+    job_wait(&faces);
+
+    b8 success = true;
     u8* pixels = 0;
     u64 image_size = 0;
     for (u8 i = 0; i < 6; ++i) {
-        image_resource_params params;
-        params.flip_y = false;
-
-        resource img_resource;
-        if (!resource_system_load(texture_names[i], RESOURCE_TYPE_IMAGE, &params, &img_resource)) {
+        if (!loaded[i]) {
             KERROR("load_cube_textures() - Failed to load image resource for texture '%s'", texture_names[i]);
-            return false;
+            success = false;
+            break;
         }
 
-        image_resource_data* resource_data = img_resource.data;
+        image_resource_data* resource_data = face_resources[i].data;
         if (!pixels) {
             t->width = resource_data->width;
             t->height = resource_data->height;
             t->channel_count = resource_data->channel_count;
             t->flags = 0;
             t->generation = 0;
-            // Take a copy of the name.
-            string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+            t->name = name;
 
             image_size = t->width * t->height * t->channel_count;
             // NOTE: no need for transparency in cube maps, so not checking for it.
@@ -442,26 +489,33 @@ b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME
             // Verify all textures are the same size.
             if (t->width != resource_data->width || t->height != resource_data->height || t->channel_count != resource_data->channel_count) {
                 KERROR("load_cube_textures - All textures must be the same resolution and bit depth.");
-                kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-                pixels = 0;
-                return false;
+                success = false;
+                break;
             }
         }
 
         // Copy to the relevant portion of the array.
         kcopy_memory(pixels + image_size * i, resource_data->pixels, image_size);
+    }
 
-        // Clean up data.
-        resource_system_unload(&img_resource);
+    // Clean up data.
+    for (u8 i = 0; i < 6; ++i) {
+        if (loaded[i]) {
+            resource_system_unload(&face_resources[i]);
+        }
     }
 
-    // Acquire internal texture resources and upload to GPU.
-    renderer_texture_create(pixels, t);
+    if (success) {
+        // Acquire internal texture resources and upload to GPU.
+        renderer_texture_create(pixels, t);
+    }
 
-    kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-    pixels = 0;
+    if (pixels) {
+        kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
+        pixels = 0;
+    }
 
-    return true;
+    return success;
 }
 
 void texture_load_job_success(void* params) {
@@ -472,48 +526,74 @@ void texture_load_job_success(void* params) {
     // Acquire internal texture resources and upload to GPU. Can't be jobified until the renderer is multithreaded.
     renderer_texture_create(resource_data->pixels, &texture_params->temp_texture);
 
-    // Take a copy of the old texture.
-    texture old = *texture_params->out_texture;
+    // If the texture was released while loading, its slot may have been freed or reused, so discard the result.
+    if (!state_ptr || pool_allocator_get(&state_ptr->registered_textures, texture_params->texture_handle) != texture_params->out_texture) {
+        KWARN("Texture '%s' was released before loading completed. Result discarded.", kname_string_get(texture_params->name));
+        renderer_texture_destroy(&texture_params->temp_texture);
+    } else {
+        // Take a copy of the old texture.
+        texture old = *texture_params->out_texture;
+
+        // Assign the temp texture to the pointer, keeping the id of the slot.
+        *texture_params->out_texture = texture_params->temp_texture;
+        texture_params->out_texture->id = old.id;
 
-    // Assign the temp texture to the pointer.
-    *texture_params->out_texture = texture_params->temp_texture;
+        // Destroy the old texture.
+        renderer_texture_destroy(&old);
+        kzero_memory(&old, sizeof(texture));
 
-    // Destroy the old texture.
-    renderer_texture_destroy(&old);
-    kzero_memory(&old, sizeof(texture));
+        if (texture_params->current_generation == INVALID_ID) {
+            texture_params->out_texture->generation = 0;
+        } else {
+            texture_params->out_texture->generation = texture_params->current_generation + 1;
+        }
 
-    if (texture_params->current_generation == INVALID_ID) {
-        texture_params->out_texture->generation = 0;
-    } else {
-        texture_params->out_texture->generation = texture_params->current_generation + 1;
+        KTRACE("Successfully loaded texture '%s'.", kname_string_get(texture_params->name));
     }
 
-    KTRACE("Successfully loaded texture '%s'.", texture_params->resource_name);
-
     // Clean up data.
     resource_system_unload(&texture_params->image_resource);
-    if (texture_params->resource_name) {
-        u32 length = string_length(texture_params->resource_name);
-        kfree(texture_params->resource_name, sizeof(char) * length + 1, MEMORY_TAG_STRING);
-        texture_params->resource_name = 0;
-    }
 }
 
 void texture_load_job_fail(void* params) {
     texture_load_params* texture_params = (texture_load_params*)params;
 
-    KERROR("Failed to load texture '%s'.", texture_params->resource_name);
+    KERROR("Failed to load texture '%s'.", kname_string_get(texture_params->name));
 
     resource_system_unload(&texture_params->image_resource);
 }
 
+// The number of pixels each chunk of a transparency scan checks.
+#define TRANSPARENCY_SCAN_GRAIN 65536
+
+typedef struct transparency_scan {
+    const u8* pixels;
+    u8 channel_count;
+    // Set by the first chunk to find a transparent pixel, so the others can stop early.
+    volatile u32 found;
+} transparency_scan;
+
+static void transparency_scan_range(u32 begin, u32 end, void* context) {
+    transparency_scan* scan = context;
+    if (scan->found) {
+        return;
+    }
+    for (u64 i = begin; i < end; ++i) {
+        u8 a = scan->pixels[i * scan->channel_count + 3];
+        if (a < 255) {
+            scan->found = true;
+            return;
+        }
+    }
+}
+
 b8 texture_load_job_start(void* params, void* result_data) {
     texture_load_params* load_params = (texture_load_params*)params;
 
     image_resource_params resource_params;
     resource_params.flip_y = true;
 
-    b8 result = resource_system_load(load_params->resource_name, RESOURCE_TYPE_IMAGE, &resource_params, &load_params->image_resource);
+    b8 result = resource_system_load_kname(load_params->name, RESOURCE_TYPE_IMAGE, &resource_params, &load_params->image_resource);
 
     image_resource_data* resource_data = load_params->image_resource.data;
 
@@ -527,17 +607,14 @@ b8 texture_load_job_start(void* params, void* result_data) {
 
     u64 total_size = load_params->temp_texture.width * load_params->temp_texture.height * load_params->temp_texture.channel_count;
 
-    // Check for transparency
-    b32 has_transparency = false;
-    for (u64 i = 0; i < total_size; i += load_params->temp_texture.channel_count) {
-        u8 a = resource_data->pixels[i + 3];
-        if (a < 255) {
-            has_transparency = true;
-            break;
-        }
-    }
+    // Check for transparency, splitting large images across the job threads.
+    transparency_scan scan = {0};
+    scan.pixels = resource_data->pixels;
+    scan.channel_count = load_params->temp_texture.channel_count;
+    job_parallel_for(total_size / scan.channel_count, TRANSPARENCY_SCAN_GRAIN, transparency_scan_range, &scan);
+    b32 has_transparency = scan.found;
 
-    string_ncopy(load_params->temp_texture.name, load_params->resource_name, TEXTURE_NAME_MAX_LENGTH);
+    load_params->temp_texture.name = load_params->name;
     load_params->temp_texture.generation = INVALID_ID;
     load_params->temp_texture.flags |= has_transparency ? TEXTURE_FLAG_HAS_TRANSPARENCY : 0;
 
@@ -547,12 +624,14 @@ b8 texture_load_job_start(void* params, void* result_data) {
     return result;
 }
 
-b8 load_texture(const char* texture_name, texture* t) {
+b8 load_texture(kname texture_name, texture* t, u32 handle) {
     // Kick off a texture loading job. Only handles loading from disk
     // to CPU. GPU upload is handled after completion of this job.
     texture_load_params params;
-    params.resource_name = string_duplicate(texture_name);
+    // The text of the name lives as long as the name system, so need not be copied for the job.
+    params.name = texture_name;
     params.out_texture = t;
+    params.texture_handle = handle;
     params.image_resource = (resource){};
     params.current_generation = t->generation;
     params.temp_texture = (texture){};
@@ -566,128 +645,128 @@ void destroy_texture(texture* t) {
     // Clean up backend resources.
     renderer_texture_destroy(t);
 
-    kzero_memory(t->name, sizeof(char) * TEXTURE_NAME_MAX_LENGTH);
     kzero_memory(t, sizeof(texture));
     t->id = INVALID_ID;
     t->generation = INVALID_ID;
 }
 
-b8 process_texture_reference(const char* name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_id) {
-    *out_texture_id = INVALID_ID;
+b8 process_texture_reference(kname name_id, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_handle) {
+    *out_texture_handle = INVALID_ID;
     if (state_ptr) {
+        // The text is kept for as long as the name, so remains valid if the texture is destroyed.
+        const char* name = kname_string_get(name_id);
+        if (!name) {
+            KERROR("process_texture_reference called with an invalid name.");
+            return false;
+        }
+
+        // Textures not yet registered start off with an invalid handle.
         texture_reference ref;
-        if (hashtable_get(&state_ptr->registered_texture_table, name, &ref)) {
-            // If the reference count starts off at zero, one of two things can be
-            // true. If incrementing references, this means the entry is new. If
-            // decrementing, then the texture doesn't exist _if_ not auto-releasing.
-            if (ref.reference_count == 0 && reference_diff > 0) {
-                if (reference_diff > 0) {
-                    // This can only be changed the first time a texture is loaded.
-                    ref.auto_release = auto_release;
+        ref.auto_release = false;
+        ref.handle = INVALID_ID;
+        ref.reference_count = 0;
+        u64_map_get(&state_ptr->registered_texture_table, name_id, &ref);
+        // If the reference count starts off at zero, one of two things can be
+        // true. If incrementing references, this means the entry is new. If
+        // decrementing, then the texture doesn't exist _if_ not auto-releasing.
+        if (ref.reference_count == 0 && reference_diff > 0) {
+            if (reference_diff > 0) {
+                // This can only be changed the first time a texture is loaded.
+                ref.auto_release = auto_release;
+            } else {
+                if (ref.auto_release) {
+                    KWARN("Tried to release non-existent texture: '%s'", name);
+                    return false;
                 } else {
-                    if (ref.auto_release) {
-                        KWARN("Tried to release non-existent texture: '%s'", name);
-                        return false;
-                    } else {
-                        KWARN("Tried to release a texture where autorelease=false, but references was already 0.");
-                        // Still count this as a success, but warn about it.
-                        return true;
-                    }
+                    KWARN("Tried to release a texture where autorelease=false, but references was already 0.");
+                    // Still count this as a success, but warn about it.
+                    return true;
                 }
             }
+        }
 
-            ref.reference_count += reference_diff;
-
-            // Take a copy of the name since it would be wiped out if destroyed,
-            // (as passed in name is generally a pointer to the actual texture's name).
-            char name_copy[TEXTURE_NAME_MAX_LENGTH];
-            string_ncopy(name_copy, name, TEXTURE_NAME_MAX_LENGTH);
+        ref.reference_count += reference_diff;
 
-            // If decrementing, this means a release.
-            if (reference_diff < 0) {
-                // Check if the reference count has reached 0. If it has, and the reference
-                // is set to auto-release, destroy the texture.
-                if (ref.reference_count == 0 && ref.auto_release) {
-                    texture* t = &state_ptr->registered_textures[ref.handle];
+        // If decrementing, this means a release.
+        if (reference_diff < 0) {
+            // Check if the reference count has reached 0. If it has, and the reference
+            // is set to auto-release, destroy the texture.
+            if (ref.reference_count == 0 && ref.auto_release) {
+                texture* t = pool_allocator_get(&state_ptr->registered_textures, ref.handle);
 
-                    // Destroy/reset texture.
-                    destroy_texture(t);
-
-                    // Reset the reference.
-                    ref.handle = INVALID_ID;
-                    ref.auto_release = false;
-                    // KTRACE("Released texture '%s'., Texture unloaded because reference count=0 and auto_release=true.", name_copy);
-                } else {
-                    // KTRACE("Released texture '%s', now has a reference count of '%i' (auto_release=%s).", name_copy, ref.reference_count, ref.auto_release ? "true" : "false");
-                }
+                // Destroy/reset texture, and return its slot to the pool.
+                destroy_texture(t);
+                pool_allocator_free(&state_ptr->registered_textures, ref.handle);
 
+                // Reset the reference.
+                ref.handle = INVALID_ID;
+                ref.auto_release = false;
+                // KTRACE("Released texture '%s'., Texture unloaded because reference count=0 and auto_release=true.", name);
             } else {
-                // Incrementing. Check if the handle is new or not.
-                if (ref.handle == INVALID_ID) {
-                    // This means no texture exists here. Find a free index first.
-                    u32 count = state_ptr->config.max_texture_count;
-
-                    for (u32 i = 0; i < count; ++i) {
-                        if (state_ptr->registered_textures[i].id == INVALID_ID) {
-                            // A free slot has been found. Use its index as the handle.
-                            ref.handle = i;
-                            *out_texture_id = i;
-                            break;
-                        }
-                    }
+                // KTRACE("Released texture '%s', now has a reference count of '%i' (auto_release=%s).", name, ref.reference_count, ref.auto_release ? "true" : "false");
+            }
 
-                    // An empty slot was not found, bleat about it and boot out.
-                    if (*out_texture_id == INVALID_ID) {
-                        KFATAL("process_texture_reference - Texture system cannot hold anymore textures. Adjust configuration to allow more.");
-                        return false;
+        } else {
+            // Incrementing. Check if the handle is new or not.
+            if (ref.handle == INVALID_ID) {
+                // This means no texture exists here. Take a free slot from the pool.
+                texture* t = pool_allocator_allocate(&state_ptr->registered_textures, &ref.handle);
+
+                // An empty slot was not found, bleat about it and boot out.
+                if (!t) {
+                    KFATAL("process_texture_reference - Texture system cannot hold anymore textures. Adjust configuration to allow more.");
+                    return false;
+                } else {
+                    *out_texture_handle = ref.handle;
+                    t->id = pool_handle_index(ref.handle);
+                    t->generation = INVALID_ID;
+                    t->type = type;
+                    // Create new texture.
+                    if (skip_load) {
+                        // KTRACE("Load skipped for texture '%s'. This is expected behaviour.");
                     } else {
-                        texture* t = &state_ptr->registered_textures[ref.handle];
-                        t->type = type;
-                        // Create new texture.
-                        if (skip_load) {
-                            // KTRACE("Load skipped for texture '%s'. This is expected behaviour.");
-                        } else {
-                            if (type == TEXTURE_TYPE_CUBE) {
-                                char texture_names[6][TEXTURE_NAME_MAX_LENGTH];
-
-                                // +X,-X,+Y,-Y,+Z,-Z in _cubemap_ space, which is LH y-down
-                                string_format(texture_names[0], "%s_r", name);  // Right texture
-                                string_format(texture_names[1], "%s_l", name);  // Left texture
-                                string_format(texture_names[2], "%s_u", name);  // Up texture
-                                string_format(texture_names[3], "%s_d", name);  // Down texture
-                                string_format(texture_names[4], "%s_f", name);  // Front texture
-                                string_format(texture_names[5], "%s_b", name);  // Back texture
-
-                                if (!load_cube_textures(name, texture_names, t)) {
-                                    *out_texture_id = INVALID_ID;
-                                    KERROR("Failed to load cube texture '%s'.", name);
-                                    return false;
-                                }
-                            } else {
-                                if (!load_texture(name, t)) {
-                                    *out_texture_id = INVALID_ID;
-                                    KERROR("Failed to load texture '%s'.", name);
-                                    return false;
-                                }   
+                        if (type == TEXTURE_TYPE_CUBE) {
+                            char texture_names[6][TEXTURE_NAME_MAX_LENGTH];
+
+                            // +X,-X,+Y,-Y,+Z,-Z in _cubemap_ space, which is LH y-down
+                            string_format(texture_names[0], "%s_r", name);  // Right texture
+                            string_format(texture_names[1], "%s_l", name);  // Left texture
+                            string_format(texture_names[2], "%s_u", name);  // Up texture
+                            string_format(texture_names[3], "%s_d", name);  // Down texture
+                            string_format(texture_names[4], "%s_f", name);  // Front texture
+                            string_format(texture_names[5], "%s_b", name);  // Back texture
+
+                            if (!load_cube_textures(name_id, texture_names, t)) {
+                                pool_allocator_free(&state_ptr->registered_textures, ref.handle);
+                                *out_texture_handle = INVALID_ID;
+                                KERROR("Failed to load cube texture '%s'.", name);
+                                return false;
                             }
-                            t->id = ref.handle;
+                        } else {
+                            if (!load_texture(name_id, t, ref.handle)) {
+                                pool_allocator_free(&state_ptr->registered_textures, ref.handle);
+                                *out_texture_handle = INVALID_ID;
+                                KERROR("Failed to load texture '%s'.", name);
+                                return false;
+                            }   
                         }
-                        // KTRACE("Texture '%s' does not yet exist. Created, and ref_count is now %i.", name, ref.reference_count);
                     }
-                } else {
-                    *out_texture_id = ref.handle;
-                    // KTRACE("Texture '%s' already exists, ref_count increased to %i.", name, ref.reference_count);
+                    // KTRACE("Texture '%s' does not yet exist. Created, and ref_count is now %i.", name, ref.reference_count);
                 }
+            } else {
+                *out_texture_handle = ref.handle;
+                // KTRACE("Texture '%s' already exists, ref_count increased to %i.", name, ref.reference_count);
             }
-
-            // Either way, update the entry.
-            hashtable_set(&state_ptr->registered_texture_table, name_copy, &ref);
-            return true;
         }
 
-        // NOTE: This would only happen in the event something went wrong with the state.
-        KERROR("process_texture_reference failed to acquire id for name '%s'. INVALID_ID returned.", name);
-        return false;
+        // Either way, update the entry. Released textures have theirs removed instead, so
+        // the table only holds textures which exist.
+        if (ref.handle == INVALID_ID) {
+            u64_map_remove(&state_ptr->registered_texture_table, name_id);
+        } else {
+            u64_map_set(&state_ptr->registered_texture_table, name_id, &ref);
+        }
+        return true;
     }
 
     KERROR("process_texture_reference called before texture system is initialized.");
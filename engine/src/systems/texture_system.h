@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/renderer_types.inl"
+#include "core/kname.h"
 
 typedef struct texture_system_config
 {
@@ -23,6 +24,17 @@ void texture_system_shutdown(void* state);
 
 texture* texture_system_acquire(const char* name, b8 auto_release);
 
+/**
+ * @brief Attempts to acquire a texture with the given name, as with texture_system_acquire.
+ * Looks the texture up by the name's id, so is cheaper for callers which keep knames around.
+ *
+ * @param name The name of the texture to acquire.
+ * @param auto_release Indicates if the texture should auto-release when its reference count is 0.
+ * Only takes effect the first time the texture is acquired.
+ * @return A pointer to the loaded texture, or 0 on failure.
+ */
+texture* texture_system_acquire_kname(kname name, b8 auto_release);
+
 /**
  * @brief Attempts to acquire a cubemap texture with the given name. If it has not yet been loaded,
  * this triggers it to load. If the texture is not found, a pointer to the default texture
@@ -60,6 +72,13 @@ texture* texture_system_aquire_writeable(const char* name, u32 width, u32 height
 
 void texture_system_release(const char* name);
 
+/**
+ * @brief Releases a texture with the given name, as with texture_system_release.
+ *
+ * @param name The name of the texture to release.
+ */
+void texture_system_release_kname(kname name);
+
 /**
  * @brief Wraps the provided internal data in a texture structure using the parameters
  * provided. This is best used for when the renderer system creates internal resources
@@ -12,6 +12,7 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Kohi Engine Testbed";
+    out_game->app_config.frame_allocator_size = MEBIBYTES(1);
     out_game->update = game_update;
     out_game->render = game_render;
     out_game->initialize = game_initialize;
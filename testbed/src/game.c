@@ -6,6 +6,7 @@
 #include <core/kstring.h>
 #include <core/input.h>
 #include <core/event.h>
+#include <core/application.h>
 
 #include <math/kmath.h>
 #include <renderer/renderer_types.inl>
@@ -22,14 +23,21 @@ b8 game_initialize(game* game_inst) {
 }
 
 b8 game_update(game* game_inst, f32 delta_time) {
-    static u64 alloc_count = 0;
-    u64 prev_alloc_count = alloc_count;
-    alloc_count = get_memory_alloc_count();
     if (input_is_key_up('M') && input_was_key_down('M')) {
         char* usage = get_memory_usage_str();
         KINFO(usage);
         string_free(usage);
-        KDEBUG("Allocations: %llu (%llu this frame)", alloc_count, alloc_count - prev_alloc_count);
+        KDEBUG("Allocations: %llu (%llu last frame)", get_memory_alloc_count(), application_get_frame_allocation_count());
+    }
+
+    // Toggle allocation tracing. The trace can be summarized with "tools memtrace memory_trace.csv".
+    if (input_is_key_up('K') && input_was_key_down('K')) {
+        if (kmemory_trace_is_active()) {
+            kmemory_trace_stop();
+            kmemory_trace_write("memory_trace.csv");
+        } else if (kmemory_trace_start()) {
+            KDEBUG("Memory tracing started. Press K again to stop and write the trace.");
+        }
     }
 
     // TODO: temp
@@ -0,0 +1,312 @@
+#include "binary_heap_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/binary_heap.h>
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <memory/linear_allocator.h>
+
+typedef struct heap_test_asset {
+    f32 distance;
+    u32 id;
+    u64 payload[4];
+} heap_test_asset;
+
+static b8 less_f32(const void* a, const void* b, void* user_data) {
+    return *(const f32*)a < *(const f32*)b;
+}
+
+// Ties are broken by id, so that the order matches a scan for the first nearest asset.
+static b8 less_asset(const void* a, const void* b, void* user_data) {
+    const heap_test_asset* x = a;
+    const heap_test_asset* y = b;
+    return x->distance < y->distance || (x->distance == y->distance && x->id < y->id);
+}
+
+static u64 bench_random(u64* state) {
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static f32 random_f32(u64* state) {
+    return (f32)(bench_random(state) % 1000000) * 0.01f;
+}
+
+u8 binary_heap_should_pop_in_order() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    binary_heap heap;
+    expect_to_be_true(binary_heap_create(sizeof(f32), 4, less_f32, 0, 0, &heap));
+    expect_should_be(0, binary_heap_length(&heap));
+    expect_should_be(0, binary_heap_peek(&heap));
+    expect_to_be_false(binary_heap_pop(&heap, 0));
+
+    const u32 count = 1000;
+    u64 rng = 0x2545F4914F6CDD1DULL;
+    f32 min = 1e30f;
+    for (u32 i = 0; i < count; ++i) {
+        f32 value = random_f32(&rng);
+        min = value < min ? value : min;
+        expect_to_be_true(binary_heap_push(&heap, &value));
+    }
+    expect_should_be(count, binary_heap_length(&heap));
+    f32 front = *(const f32*)binary_heap_peek(&heap);
+    expect_float_to_be(min, front);
+
+    f32 previous = -1.0f;
+    for (u32 i = 0; i < count; ++i) {
+        f32 value = 0;
+        expect_to_be_true(binary_heap_pop(&heap, &value));
+        expect_to_be_true(value >= previous);
+        previous = value;
+    }
+    expect_to_be_false(binary_heap_pop(&heap, 0));
+
+    // Clearing keeps the heap usable.
+    f32 value = 3.0f;
+    binary_heap_push(&heap, &value);
+    binary_heap_clear(&heap);
+    expect_should_be(0, binary_heap_length(&heap));
+
+    binary_heap_destroy(&heap);
+    expect_should_be(0, heap.elements);
+
+    KDEBUG("The following error messages are intentional.");
+    expect_to_be_false(binary_heap_create(sizeof(f32), 4, 0, 0, 0, &heap));
+    expect_to_be_false(binary_heap_create(0, 4, less_f32, 0, 0, &heap));
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 binary_heap_should_heapify_into_allocator() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    linear_allocator arena;
+    linear_allocator_create(KIBIBYTES(64), 0, &arena);
+    darray_allocator allocator = darray_allocator_linear(&arena);
+
+    binary_heap heap;
+    expect_to_be_true(binary_heap_create(sizeof(heap_test_asset), 0, less_asset, 0, &allocator, &heap));
+    expect_to_be_true((u8*)heap.elements > (u8*)arena.memory && (u8*)heap.elements < (u8*)arena.memory + arena.total_size);
+
+    // A few pushed one at a time, then many more at once.
+    heap_test_asset assets[500];
+    u64 rng = 0x9E3779B97F4A7C15ULL;
+    for (u32 i = 0; i < 500; ++i) {
+        assets[i].distance = random_f32(&rng);
+        assets[i].id = i;
+    }
+    for (u32 i = 0; i < 10; ++i) {
+        binary_heap_push(&heap, &assets[i]);
+    }
+    expect_to_be_true(binary_heap_heapify(&heap, &assets[10], 490));
+    expect_should_be(500, binary_heap_length(&heap));
+
+    b8 popped[500] = {0};
+    f32 previous = -1.0f;
+    heap_test_asset asset;
+    while (binary_heap_pop(&heap, &asset)) {
+        expect_to_be_true(asset.distance >= previous);
+        expect_float_to_be(assets[asset.id].distance, asset.distance);
+        expect_to_be_false(popped[asset.id]);
+        popped[asset.id] = true;
+        previous = asset.distance;
+    }
+    for (u32 i = 0; i < 500; ++i) {
+        expect_to_be_true(popped[i]);
+    }
+
+    binary_heap_destroy(&heap);
+    linear_allocator_destroy(&arena);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 indexed_heap_should_update_and_remove() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    indexed_heap heap;
+    expect_to_be_true(indexed_heap_create(sizeof(f32), 8, less_f32, 0, 0, &heap));
+    expect_should_be(INVALID_ID, indexed_heap_peek(&heap));
+
+    f32 distances[8] = {5.0f, 3.0f, 8.0f, 1.0f, 9.0f, 7.0f, 2.0f, 6.0f};
+    for (u32 i = 0; i < 8; ++i) {
+        expect_to_be_true(indexed_heap_set(&heap, i, &distances[i]));
+    }
+    expect_should_be(8, heap.length);
+    expect_should_be(3, indexed_heap_peek(&heap));
+
+    // Decrease a key to the front, and increase the front's key to the back.
+    f32 value = 0.5f;
+    indexed_heap_set(&heap, 4, &value);
+    expect_should_be(4, indexed_heap_peek(&heap));
+    value = 10.0f;
+    indexed_heap_set(&heap, 4, &value);
+    expect_should_be(3, indexed_heap_peek(&heap));
+    f32 stored = *(const f32*)indexed_heap_get(&heap, 4);
+    expect_float_to_be(10.0f, stored);
+    expect_should_be(8, heap.length);
+
+    // Removing from the middle and the front.
+    expect_to_be_true(indexed_heap_remove(&heap, 6));
+    expect_to_be_false(indexed_heap_contains(&heap, 6));
+    expect_should_be(0, indexed_heap_get(&heap, 6));
+    expect_to_be_false(indexed_heap_remove(&heap, 6));
+    expect_to_be_true(indexed_heap_remove(&heap, 3));
+
+    u32 expected_order[6] = {1, 0, 7, 5, 2, 4};
+    for (u32 i = 0; i < 6; ++i) {
+        u32 id = INVALID_ID;
+        expect_to_be_true(indexed_heap_pop(&heap, &id, &value));
+        expect_should_be(expected_order[i], id);
+        expect_to_be_false(indexed_heap_contains(&heap, id));
+    }
+    expect_to_be_false(indexed_heap_pop(&heap, 0, 0));
+
+    // Clearing leaves every id free to be queued again.
+    for (u32 i = 0; i < 8; ++i) {
+        indexed_heap_set(&heap, i, &distances[i]);
+    }
+    indexed_heap_clear(&heap);
+    expect_should_be(0, heap.length);
+    for (u32 i = 0; i < 8; ++i) {
+        expect_to_be_false(indexed_heap_contains(&heap, i));
+    }
+
+    KDEBUG("The following error message is intentional.");
+    expect_to_be_false(indexed_heap_set(&heap, 8, &value));
+
+    indexed_heap_destroy(&heap);
+    expect_should_be(0, heap.ids);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 binary_heap_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Building a heap of a million keys, one at a time versus all at once.
+    const u32 count = 1000000;
+    f32* values = kallocate(sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    u64 rng = 0x2545F4914F6CDD1DULL;
+    for (u32 i = 0; i < count; ++i) {
+        values[i] = random_f32(&rng);
+    }
+
+    binary_heap heap;
+    binary_heap_create(sizeof(f32), count, less_f32, 0, 0, &heap);
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < count; ++i) {
+        binary_heap_push(&heap, &values[i]);
+    }
+    clock_update(&c);
+    f64 push_elapsed = c.elapsed;
+
+    binary_heap_clear(&heap);
+    clock_start(&c);
+    binary_heap_heapify(&heap, values, count);
+    clock_update(&c);
+    f64 heapify_elapsed = c.elapsed;
+
+    clock_start(&c);
+    f32 previous = -1.0f;
+    b8 ordered = true;
+    f32 value;
+    while (binary_heap_pop(&heap, &value)) {
+        ordered = ordered && value >= previous;
+        previous = value;
+    }
+    clock_update(&c);
+    f64 pop_elapsed = c.elapsed;
+    expect_to_be_true(ordered);
+
+    KINFO("Heap of %u f32: push one by one %.2f ms, heapify %.2f ms, pop all %.2f ms.",
+          count, push_elapsed * 1000.0, heapify_elapsed * 1000.0, pop_elapsed * 1000.0);
+
+    binary_heap_destroy(&heap);
+    kfree(values, sizeof(f32) * count, MEMORY_TAG_ARRAY);
+
+    // A streaming queue: many assets queued by distance, which changes as the camera moves,
+    // while the nearest is taken and replaced. Compared against scanning for the nearest.
+    const u32 asset_count = 4096;
+    const u32 op_count = 100000;
+    heap_test_asset* assets = kallocate(sizeof(heap_test_asset) * asset_count, MEMORY_TAG_ARRAY);
+    indexed_heap queue;
+    indexed_heap_create(sizeof(heap_test_asset), asset_count, less_asset, 0, 0, &queue);
+    rng = 0x9E3779B97F4A7C15ULL;
+    for (u32 i = 0; i < asset_count; ++i) {
+        assets[i].distance = random_f32(&rng);
+        assets[i].id = i;
+        indexed_heap_set(&queue, i, &assets[i]);
+    }
+
+    u64 scan_sum = 0;
+    u64 op_rng = 0x2545F4914F6CDD1DULL;
+    clock_start(&c);
+    for (u32 i = 0; i < op_count; ++i) {
+        // Move one asset, then take the nearest and queue it again further away.
+        u32 moved = (u32)(bench_random(&op_rng) % asset_count);
+        assets[moved].distance = random_f32(&op_rng);
+        u32 nearest = 0;
+        for (u32 j = 1; j < asset_count; ++j) {
+            if (assets[j].distance < assets[nearest].distance) {
+                nearest = j;
+            }
+        }
+        scan_sum += nearest;
+        assets[nearest].distance += 10000.0f;
+    }
+    clock_update(&c);
+    f64 scan_elapsed = c.elapsed;
+
+    u64 heap_sum = 0;
+    op_rng = 0x2545F4914F6CDD1DULL;
+    clock_start(&c);
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 moved = (u32)(bench_random(&op_rng) % asset_count);
+        heap_test_asset asset = *(const heap_test_asset*)indexed_heap_get(&queue, moved);
+        asset.distance = random_f32(&op_rng);
+        indexed_heap_set(&queue, moved, &asset);
+        u32 nearest = INVALID_ID;
+        indexed_heap_pop(&queue, &nearest, &asset);
+        heap_sum += nearest;
+        asset.distance += 10000.0f;
+        indexed_heap_set(&queue, nearest, &asset);
+    }
+    clock_update(&c);
+    f64 heap_elapsed = c.elapsed;
+    expect_should_be(scan_sum, heap_sum);
+
+    KINFO("Reprioritizing %u queued assets: linear scan %.1f ns/op, indexed heap %.1f ns/op.",
+          asset_count, scan_elapsed * 1000000000.0 / op_count, heap_elapsed * 1000000000.0 / op_count);
+
+    indexed_heap_destroy(&queue);
+    kfree(assets, sizeof(heap_test_asset) * asset_count, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
+void binary_heap_register_tests() {
+    test_manager_register_test(binary_heap_should_pop_in_order, "Binary heap should pop in order.");
+    test_manager_register_test(binary_heap_should_heapify_into_allocator, "Binary heap should heapify into an allocator.");
+    test_manager_register_test(indexed_heap_should_update_and_remove, "Indexed heap should update and remove ids.");
+    test_manager_register_benchmark(binary_heap_benchmark, "Binary heap benchmark.");
+}
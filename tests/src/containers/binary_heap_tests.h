@@ -0,0 +1,3 @@
+#pragma once
+
+void binary_heap_register_tests();
@@ -0,0 +1,196 @@
+#include "darray_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <memory/linear_allocator.h>
+#include <memory/scratch_allocator.h>
+
+u8 darray_should_push_range_and_reserve() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u32 values[100];
+    for (u32 i = 0; i < 100; ++i) {
+        values[i] = i;
+    }
+
+    u32* array = darray_create(u32);
+    u32 first = 1000;
+    darray_push(array, first);
+    // The first growth skips straight past the smallest capacities.
+    darray_push(array, first);
+    expect_should_be(DARRAY_MIN_GROWN_CAPACITY, darray_capacity(array));
+    darray_clear(array);
+
+    darray_push_range(array, values, 100);
+    expect_should_be(100, darray_length(array));
+    expect_to_be_true(darray_capacity(array) >= 100);
+    darray_push_range(array, values, 50);
+    expect_should_be(150, darray_length(array));
+    b8 matches = true;
+    for (u32 i = 0; i < 150; ++i) {
+        matches = matches && array[i] == i % 100;
+    }
+    expect_to_be_true(matches);
+
+    // After reserving, pushes do not move the array.
+    darray_reserve_more(array, 1000);
+    expect_to_be_true(darray_capacity(array) >= 1150);
+    u32* before = array;
+    for (u32 i = 0; i < 10; ++i) {
+        darray_push_range(array, values, 100);
+    }
+    expect_should_be(before, array);
+    expect_should_be(1150, darray_length(array));
+
+    darray_shrink_to_fit(array);
+    expect_should_be(1150, darray_capacity(array));
+    expect_should_be(99, array[1149]);
+
+    darray_destroy(array);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 darray_should_resize_uninit() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64* array = darray_create(u64);
+    u64 value = 7;
+    darray_push(array, value);
+
+    darray_resize_uninit(array, 500);
+    expect_should_be(500, darray_length(array));
+    expect_to_be_true(darray_capacity(array) >= 500);
+    // Existing elements are kept, and the new ones may be filled directly.
+    expect_should_be(7, array[0]);
+    for (u64 i = 1; i < 500; ++i) {
+        array[i] = i * 2;
+    }
+    expect_should_be(998, array[499]);
+
+    // Shrinking the length keeps the capacity.
+    u64 capacity = darray_capacity(array);
+    darray_resize_uninit(array, 10);
+    expect_should_be(10, darray_length(array));
+    expect_should_be(capacity, darray_capacity(array));
+
+    darray_destroy(array);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 darray_should_use_caller_allocator() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    linear_allocator arena;
+    linear_allocator_create(KIBIBYTES(64), 0, &arena);
+    darray_allocator allocator = darray_allocator_linear(&arena);
+
+    u32* array = darray_create_with_allocator(u32, 4, &allocator);
+    expect_should_not_be(0, array);
+    // The array lives inside the arena.
+    expect_to_be_true((u8*)array > (u8*)arena.memory && (u8*)array < (u8*)arena.memory + arena.total_size);
+    for (u32 i = 0; i < 1000; ++i) {
+        darray_push(array, i);
+    }
+    expect_should_be(1000, darray_length(array));
+    expect_should_be(999, array[999]);
+    expect_to_be_true((u8*)array > (u8*)arena.memory && (u8*)array < (u8*)arena.memory + arena.total_size);
+
+    // Arenas can't take memory back, so the array is left as is.
+    u64 capacity = darray_capacity(array);
+    darray_shrink_to_fit(array);
+    expect_should_be(capacity, darray_capacity(array));
+    darray_destroy(array);
+    linear_allocator_destroy(&arena);
+
+    // Scratch-backed arrays are released with their scope.
+    scratch_marker marker = scratch_allocator_begin();
+    darray_allocator scratch = darray_allocator_scratch();
+    u32* scratch_array = darray_create_with_allocator(u32, 1, &scratch);
+    u32 values[64] = {};
+    for (u32 i = 0; i < 64; ++i) {
+        darray_push_range(scratch_array, values, 64);
+    }
+    expect_should_be(64 * 64, darray_length(scratch_array));
+    darray_destroy(scratch_array);
+    scratch_allocator_end(marker);
+    scratch_allocator_thread_shutdown();
+
+    memory_system_shutdown();
+    return true;
+}
+
+#define DARRAY_BENCH_COUNT 1000000
+#define DARRAY_BENCH_BATCH 64
+
+u8 darray_push_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    f32 batch[DARRAY_BENCH_BATCH * 3];
+    for (u32 i = 0; i < DARRAY_BENCH_BATCH * 3; ++i) {
+        batch[i] = (f32)i;
+    }
+
+    // Element by element, as OBJ import used to add vertex data.
+    clock c;
+    clock_start(&c);
+    f32* single = darray_create(f32);
+    for (u32 i = 0; i < DARRAY_BENCH_COUNT / DARRAY_BENCH_BATCH; ++i) {
+        for (u32 j = 0; j < DARRAY_BENCH_BATCH * 3; ++j) {
+            darray_push(single, batch[j]);
+        }
+    }
+    clock_update(&c);
+    f64 single_elapsed = c.elapsed;
+
+    clock_start(&c);
+    f32* ranged = darray_create(f32);
+    for (u32 i = 0; i < DARRAY_BENCH_COUNT / DARRAY_BENCH_BATCH; ++i) {
+        darray_push_range(ranged, batch, DARRAY_BENCH_BATCH * 3);
+    }
+    clock_update(&c);
+    f64 range_elapsed = c.elapsed;
+
+    clock_start(&c);
+    u64 total = (u64)(DARRAY_BENCH_COUNT / DARRAY_BENCH_BATCH) * DARRAY_BENCH_BATCH * 3;
+    f32* reserved = darray_create(f32);
+    darray_reserve_more(reserved, total);
+    for (u32 i = 0; i < DARRAY_BENCH_COUNT / DARRAY_BENCH_BATCH; ++i) {
+        darray_push_range(reserved, batch, DARRAY_BENCH_BATCH * 3);
+    }
+    clock_update(&c);
+    f64 reserved_elapsed = c.elapsed;
+
+    expect_should_be(total, darray_length(single));
+    expect_should_be(total, darray_length(ranged));
+    expect_should_be(total, darray_length(reserved));
+    KINFO("Appending %llu floats: darray_push %.3f ms, darray_push_range %.3f ms, reserved + push_range %.3f ms.",
+          total, single_elapsed * 1000.0, range_elapsed * 1000.0, reserved_elapsed * 1000.0);
+
+    darray_destroy(reserved);
+    darray_destroy(ranged);
+    darray_destroy(single);
+    memory_system_shutdown();
+    return true;
+}
+
+void darray_register_tests() {
+    test_manager_register_test(darray_should_push_range_and_reserve, "Darray should push ranges and reserve space.");
+    test_manager_register_test(darray_should_resize_uninit, "Darray should resize without initializing.");
+    test_manager_register_test(darray_should_use_caller_allocator, "Darray should use a caller-supplied allocator.");
+    test_manager_register_benchmark(darray_push_benchmark, "Darray push benchmark.");
+}
@@ -5,6 +5,7 @@
 #include <defines.h>
 #include <containers/freelist.h>
 #include <core/kmemory.h>
+#include <core/clock.h>
 
 u8 freelist_should_create_and_destroy() {
     // NOTE: creating a small size list, which will trigger a warning.
@@ -285,10 +286,287 @@ u8 freelist_should_allocate_to_full_and_fail_to_allocate_more() {
     return true;
 }
 
+u8 freelist_should_coalesce_many_ranges() {
+    freelist list;
+    u64 memory_requirement = 0;
+    const u32 block_count = 4096;
+    const u64 block_size = 256;
+    u64 total_size = block_count * block_size;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    u64 offset = 0;
+    for (u32 i = 0; i < block_count; ++i) {
+        expect_to_be_true(freelist_allocate_block(&list, block_size, &offset));
+        expect_should_be(i * block_size, offset);
+    }
+    expect_should_be(0, freelist_largest_free_block(&list));
+
+    // Freeing every other block leaves thousands of separate ranges, well past the number
+    // the offset tables start out with room for.
+    for (u32 i = 0; i < block_count; i += 2) {
+        expect_to_be_true(freelist_free_block(&list, block_size, i * block_size));
+    }
+    expect_should_be(total_size / 2, freelist_free_space(&list));
+    expect_should_be(block_size, freelist_largest_free_block(&list));
+
+    // Freeing the rest joins them all back up into one range.
+    for (u32 i = 1; i < block_count; i += 2) {
+        expect_to_be_true(freelist_free_block(&list, block_size, i * block_size));
+    }
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_should_be(total_size, freelist_largest_free_block(&list));
+    expect_to_be_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_should_be(0, offset);
+
+    freelist_destroy(&list);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+static u64 bench_random(u64* state) {
+    // xorshift64, so runs are repeatable.
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/*
+ * The sorted, singly-linked first-fit list the freelist used to be, kept here as a
+ * baseline for the benchmark. Nodes come from a fixed array.
+ */
+typedef struct reference_node {
+    u64 offset;
+    u64 size;
+    struct reference_node* next;
+} reference_node;
+
+typedef struct reference_list {
+    reference_node* head;
+    reference_node* unused;
+    reference_node* nodes;
+    u64 free_space;
+} reference_list;
+
+static reference_node* reference_get_node(reference_list* list, u64 offset, u64 size, reference_node* next) {
+    reference_node* node = list->unused;
+    list->unused = node->next;
+    node->offset = offset;
+    node->size = size;
+    node->next = next;
+    return node;
+}
+
+static void reference_return_node(reference_list* list, reference_node* node) {
+    node->next = list->unused;
+    list->unused = node;
+}
+
+static b8 reference_allocate(void* self, u64 size, u64* out_offset) {
+    reference_list* list = self;
+    reference_node* previous = 0;
+    for (reference_node* node = list->head; node; previous = node, node = node->next) {
+        if (node->size < size) {
+            continue;
+        }
+        *out_offset = node->offset;
+        if (node->size == size) {
+            if (previous) {
+                previous->next = node->next;
+            } else {
+                list->head = node->next;
+            }
+            reference_return_node(list, node);
+        } else {
+            node->offset += size;
+            node->size -= size;
+        }
+        list->free_space -= size;
+        return true;
+    }
+    return false;
+}
+
+static b8 reference_free(void* self, u64 size, u64 offset) {
+    reference_list* list = self;
+    reference_node* previous = 0;
+    reference_node* node = list->head;
+    while (node && node->offset < offset) {
+        previous = node;
+        node = node->next;
+    }
+    reference_node* inserted = reference_get_node(list, offset, size, node);
+    if (previous) {
+        previous->next = inserted;
+    } else {
+        list->head = inserted;
+    }
+    if (node && inserted->offset + inserted->size == node->offset) {
+        inserted->size += node->size;
+        inserted->next = node->next;
+        reference_return_node(list, node);
+    }
+    if (previous && previous->offset + previous->size == inserted->offset) {
+        previous->size += inserted->size;
+        previous->next = inserted->next;
+        reference_return_node(list, inserted);
+    }
+    list->free_space += size;
+    return true;
+}
+
+static u64 reference_largest(void* self) {
+    u64 largest = 0;
+    for (reference_node* node = ((reference_list*)self)->head; node; node = node->next) {
+        largest = node->size > largest ? node->size : largest;
+    }
+    return largest;
+}
+
+static u64 reference_free_space(void* self) {
+    return ((reference_list*)self)->free_space;
+}
+
+static b8 tlsf_allocate(void* self, u64 size, u64* out_offset) {
+    return freelist_try_allocate_block(self, size, out_offset);
+}
+
+static b8 tlsf_free(void* self, u64 size, u64 offset) {
+    return freelist_free_block(self, size, offset);
+}
+
+static u64 tlsf_largest(void* self) {
+    return freelist_largest_free_block(self);
+}
+
+static u64 tlsf_free_space(void* self) {
+    return freelist_free_space(self);
+}
+
+typedef struct bench_list {
+    const char* name;
+    void* self;
+    b8 (*allocate)(void* self, u64 size, u64* out_offset);
+    b8 (*free)(void* self, u64 size, u64 offset);
+    u64 (*largest)(void* self);
+    u64 (*free_space)(void* self);
+} bench_list;
+
+#define BENCH_MAX_LIVE 4096
+#define BENCH_OP_COUNT 200000
+// How often fragmentation is sampled, in operations.
+#define BENCH_SAMPLE_INTERVAL 1000
+
+/**
+ * Runs a random alloc/free workload with up to BENCH_MAX_LIVE live blocks of 16B-128KiB,
+ * skewed towards small sizes. The same seed gives both lists the same requests, until
+ * an allocation fails on one and not the other. Fragmentation is reported as
+ * 1 - largest free range / free space, averaged over samples taken during the run.
+ */
+static b8 run_fragmentation_workload(bench_list* l, u64 total_size, u64* offsets, u64* sizes) {
+    u32 live_count = 0;
+    u32 failed_count = 0;
+    u64 rng = 0x2545F4914F6CDD1DULL;
+    f64 fragmentation_sum = 0;
+    u32 sample_count = 0;
+    f64 sample_time = 0;
+
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < BENCH_OP_COUNT; ++i) {
+        b8 do_alloc = live_count == 0 || (live_count < BENCH_MAX_LIVE && (bench_random(&rng) % 100) < 55);
+        if (do_alloc) {
+            u64 size = 16ULL << (bench_random(&rng) % 13);
+            size += bench_random(&rng) % size;
+            u64 offset = 0;
+            if (l->allocate(l->self, size, &offset)) {
+                offsets[live_count] = offset;
+                sizes[live_count] = size;
+                live_count++;
+            } else {
+                failed_count++;
+            }
+        } else {
+            u32 index = bench_random(&rng) % live_count;
+            l->free(l->self, sizes[index], offsets[index]);
+            live_count--;
+            offsets[index] = offsets[live_count];
+            sizes[index] = sizes[live_count];
+        }
+
+        if ((i % BENCH_SAMPLE_INTERVAL) == 0) {
+            // Sampling walks the list, so is left out of the timing.
+            clock sample;
+            clock_start(&sample);
+            u64 free_space = l->free_space(l->self);
+            if (free_space) {
+                fragmentation_sum += 1.0 - (f64)l->largest(l->self) / (f64)free_space;
+                sample_count++;
+            }
+            clock_update(&sample);
+            sample_time += sample.elapsed;
+        }
+    }
+    clock_update(&c);
+    f64 elapsed = c.elapsed - sample_time;
+
+    u64 free_space = l->free_space(l->self);
+    f64 final_fragmentation = free_space ? 1.0 - (f64)l->largest(l->self) / (f64)free_space : 0;
+    KINFO("%s: %u ops in %.4fs (%.1f ns/op), %u failed allocations, %u live, %llu bytes free. Fragmentation %.3f average, %.3f at the end.",
+          l->name, BENCH_OP_COUNT, elapsed, (elapsed * 1000000000.0) / BENCH_OP_COUNT, failed_count, live_count, free_space,
+          sample_count ? fragmentation_sum / sample_count : 0.0, final_fragmentation);
+
+    for (u32 i = 0; i < live_count; ++i) {
+        if (!l->free(l->self, sizes[i], offsets[i])) {
+            return false;
+        }
+    }
+    return l->free_space(l->self) == total_size && l->largest(l->self) == total_size;
+}
+
+u8 freelist_fragmentation_benchmark() {
+    u64 total_size = MEBIBYTES(64);
+    u64* offsets = kallocate(sizeof(u64) * BENCH_MAX_LIVE, MEMORY_TAG_APPLICATION);
+    u64* sizes = kallocate(sizeof(u64) * BENCH_MAX_LIVE, MEMORY_TAG_APPLICATION);
+
+    freelist list;
+    u64 memory_requirement = 0;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    freelist_create(total_size, &memory_requirement, block, &list);
+    bench_list tlsf = {"TLSF freelist", &list, tlsf_allocate, tlsf_free, tlsf_largest, tlsf_free_space};
+    expect_to_be_true(run_fragmentation_workload(&tlsf, total_size, offsets, sizes));
+    freelist_destroy(&list);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    // There can never be more free ranges than live blocks + 1.
+    const u32 node_count = BENCH_MAX_LIVE + 1;
+    reference_list reference = {0};
+    reference.nodes = kallocate(sizeof(reference_node) * node_count, MEMORY_TAG_APPLICATION);
+    for (u32 i = 0; i < node_count; ++i) {
+        reference_return_node(&reference, &reference.nodes[i]);
+    }
+    reference.head = reference_get_node(&reference, 0, total_size, 0);
+    reference.free_space = total_size;
+    bench_list sorted = {"Sorted first-fit list", &reference, reference_allocate, reference_free, reference_largest, reference_free_space};
+    expect_to_be_true(run_fragmentation_workload(&sorted, total_size, offsets, sizes));
+    kfree(reference.nodes, sizeof(reference_node) * node_count, MEMORY_TAG_APPLICATION);
+
+    kfree(offsets, sizeof(u64) * BENCH_MAX_LIVE, MEMORY_TAG_APPLICATION);
+    kfree(sizes, sizeof(u64) * BENCH_MAX_LIVE, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
 void freelist_register_tests() {
     test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
     test_manager_register_test(freelist_should_allocate_one_and_free_one, "Freelist allocate and free one entry.");
     test_manager_register_test(freelist_should_allocate_one_and_free_multi, "Freelist allocate and free multiple entries.");
     test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes.");
     test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more.");
+    test_manager_register_test(freelist_should_coalesce_many_ranges, "Freelist should coalesce many separate ranges.");
+    test_manager_register_benchmark(freelist_fragmentation_benchmark, "Freelist random alloc/free fragmentation benchmark.");
 }
\ No newline at end of file
@@ -4,18 +4,22 @@
 
 #include <defines.h>
 #include <containers/hashtable.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
 
 u8 hashtable_should_create_and_destroy() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
-    expect_should_be(3, table.element_count);
+    // Room is made for at least the requested number of entries.
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     hashtable_destroy(&table);
 
@@ -30,13 +34,13 @@ u8 hashtable_should_set_and_get_successfully() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     u64 testval1 = 23;
     hashtable_set(&table, "test1", &testval1);
@@ -63,13 +67,13 @@ u8 hashtable_should_set_and_get_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct*), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     ht_test_struct t;
     ht_test_struct* testval1 = &t;
@@ -97,13 +101,13 @@ u8 hashtable_should_set_and_get_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(u64), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     u64 testval1 = 23;
     hashtable_set(&table, "test1", &testval1);
@@ -124,13 +128,13 @@ u8 hashtable_should_set_and_get_ptr_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct*), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     ht_test_struct t;
     ht_test_struct* testval1 = &t;
@@ -158,13 +162,13 @@ u8 hashtable_should_set_and_unset_ptr() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct*), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     ht_test_struct t;
     ht_test_struct* testval1 = &t;
@@ -204,13 +208,13 @@ u8 hashtable_try_call_non_ptr_on_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct*), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     KDEBUG("The following 2 error messages are intentional.");
 
@@ -240,13 +244,13 @@ u8 hashtable_try_call_ptr_on_non_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct);
     u64 element_count = 3;
-    ht_test_struct memory[3];
 
-    hashtable_create(element_size, element_count, memory, false, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     KDEBUG("The following 2 error messages are intentional.");
 
@@ -277,13 +281,13 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, memory, true, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_should_not_be(0, table.memory);
     expect_should_be(sizeof(ht_test_struct*), table.element_size);
-    expect_should_be(3, table.element_count);
+    expect_to_be_true(table.element_count >= 3);
+    expect_should_be(0, table.entry_count);
 
     ht_test_struct t;
     ht_test_struct* testval1 = &t;
@@ -318,6 +322,198 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     return true;
 }
 
+#define HT_MANY_COUNT 4096
+
+u8 hashtable_should_grow_and_keep_all_entries() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    hashtable table;
+    // Start with a tiny table so that it has to grow many times.
+    hashtable_create(sizeof(u32), 1, false, &table);
+    u32 initial_slot_count = table.element_count;
+
+    char name[32];
+    for (u32 i = 0; i < HT_MANY_COUNT; ++i) {
+        string_format(name, "texture_%u", i);
+        expect_to_be_true(hashtable_set(&table, name, &i));
+    }
+    expect_should_be(HT_MANY_COUNT, table.entry_count);
+    expect_to_be_true(table.element_count > initial_slot_count);
+    // Load factor should stay at or below 3/4.
+    expect_to_be_true(table.entry_count * 4 <= table.element_count * 3);
+
+    // Every name maps to its own value, i.e. no two names share an entry.
+    for (u32 i = 0; i < HT_MANY_COUNT; ++i) {
+        string_format(name, "texture_%u", i);
+        u32 value = INVALID_ID;
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        expect_should_be(i, value);
+    }
+
+    // Setting an existing name updates it rather than adding another entry.
+    u32 updated = 12345;
+    hashtable_set(&table, "texture_7", &updated);
+    expect_should_be(HT_MANY_COUNT, table.entry_count);
+    u32 value = 0;
+    hashtable_get(&table, "texture_7", &value);
+    expect_should_be(12345, value);
+
+    hashtable_destroy(&table);
+    expect_should_be(0, table.memory);
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 hashtable_should_remove_and_reinsert() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    hashtable table;
+    hashtable_create(sizeof(u32), 16, false, &table);
+
+    char name[32];
+    for (u32 i = 0; i < HT_MANY_COUNT; ++i) {
+        string_format(name, "material_%u", i);
+        hashtable_set(&table, name, &i);
+    }
+
+    // Remove every other entry.
+    for (u32 i = 0; i < HT_MANY_COUNT; i += 2) {
+        string_format(name, "material_%u", i);
+        expect_to_be_true(hashtable_remove(&table, name));
+    }
+    expect_should_be(HT_MANY_COUNT / 2, table.entry_count);
+
+    // Removing again finds nothing.
+    expect_to_be_false(hashtable_remove(&table, "material_0"));
+
+    // Removed entries are gone, and the rest are still reachable.
+    for (u32 i = 0; i < HT_MANY_COUNT; ++i) {
+        string_format(name, "material_%u", i);
+        u32 value = INVALID_ID;
+        b8 found = hashtable_get(&table, name, &value);
+        if (i % 2 == 0) {
+            expect_to_be_false(found);
+            expect_should_be(0, value);
+        } else {
+            expect_to_be_true(found);
+            expect_should_be(i, value);
+        }
+    }
+
+    // Reinsert the removed entries with new values.
+    for (u32 i = 0; i < HT_MANY_COUNT; i += 2) {
+        string_format(name, "material_%u", i);
+        u32 value = i + 1;
+        hashtable_set(&table, name, &value);
+    }
+    expect_should_be(HT_MANY_COUNT, table.entry_count);
+    for (u32 i = 0; i < HT_MANY_COUNT; ++i) {
+        string_format(name, "material_%u", i);
+        u32 value = INVALID_ID;
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        u32 expected = i % 2 == 0 ? i + 1 : i;
+        expect_should_be(expected, value);
+    }
+
+    hashtable_destroy(&table);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 hashtable_should_return_fill_value_for_missing_entries() {
+    hashtable table;
+    hashtable_create(sizeof(u16), 4, false, &table);
+
+    u16 invalid_id = INVALID_ID_U16;
+    hashtable_fill(&table, &invalid_id);
+
+    u16 id = 3;
+    hashtable_set(&table, "world", &id);
+
+    u16 value = 0;
+    expect_to_be_true(hashtable_get(&table, "world", &value));
+    expect_should_be(3, value);
+
+    // Missing names obtain the fill value, even after the table has grown.
+    char name[32];
+    for (u16 i = 0; i < 100; ++i) {
+        string_format(name, "view_%u", i);
+        hashtable_set(&table, name, &i);
+    }
+    expect_to_be_true(hashtable_get(&table, "ui", &value));
+    expect_should_be(INVALID_ID_U16, value);
+
+    // As do removed ones.
+    hashtable_remove(&table, "world");
+    value = 0;
+    expect_to_be_true(hashtable_get(&table, "world", &value));
+    expect_should_be(INVALID_ID_U16, value);
+
+    hashtable_destroy(&table);
+    return true;
+}
+
+u8 hashtable_lookup_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 count = HT_MANY_COUNT;
+    const u32 passes = 16;
+    char(*names)[32] = kallocate(sizeof(char[32]) * count, MEMORY_TAG_ARRAY);
+
+    hashtable table;
+    hashtable_create(sizeof(u32), count, false, &table);
+    for (u32 i = 0; i < count; ++i) {
+        string_format(names[i], "textures/environment/rock_%u", i);
+        hashtable_set(&table, names[i], &i);
+    }
+
+    // Look up every name in the table.
+    u64 sum = 0;
+    clock c;
+    clock_start(&c);
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < count; ++i) {
+            u32 value = 0;
+            hashtable_get(&table, names[i], &value);
+            sum += value;
+        }
+    }
+    clock_update(&c);
+    f64 table_elapsed = c.elapsed;
+    expect_should_be((u64)passes * count * (count - 1) / 2, sum);
+
+    // Compare against a linear search of the names, as a registry without a table would do.
+    sum = 0;
+    clock_start(&c);
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 j = 0; j < count; ++j) {
+            if (strings_equal(names[j], names[i])) {
+                sum += j;
+                break;
+            }
+        }
+    }
+    clock_update(&c);
+    f64 linear_elapsed = c.elapsed;
+    expect_should_be((u64)count * (count - 1) / 2, sum);
+
+    f64 lookups = (f64)passes * count;
+    KINFO("Hashtable lookup of %u names: %.1f ns/lookup (linear search: %.1f ns/lookup), %u slots.",
+          count, table_elapsed / lookups * 1000000000.0, linear_elapsed / count * 1000000000.0, table.element_count);
+
+    hashtable_destroy(&table);
+    kfree(names, sizeof(char[32]) * count, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
 void hashtable_register_tests() {
     test_manager_register_test(hashtable_should_create_and_destroy, "Hashtable should create and destroy");
     test_manager_register_test(hashtable_should_set_and_get_successfully, "Hashtable should set and get");
@@ -328,4 +524,8 @@ void hashtable_register_tests() {
     test_manager_register_test(hashtable_try_call_non_ptr_on_ptr_table, "Hashtable try calling non-pointer functions on pointer type table.");
     test_manager_register_test(hashtable_try_call_ptr_on_non_ptr_table, "Hashtable try calling pointer functions on non-pointer type table.");
     test_manager_register_test(hashtable_should_set_get_and_update_ptr_successfully, "Hashtable Should get pointer, update, and get again successfully.");
+    test_manager_register_test(hashtable_should_grow_and_keep_all_entries, "Hashtable should grow and keep all entries distinct.");
+    test_manager_register_test(hashtable_should_remove_and_reinsert, "Hashtable should remove and reinsert entries.");
+    test_manager_register_test(hashtable_should_return_fill_value_for_missing_entries, "Hashtable should return the fill value for missing entries.");
+    test_manager_register_benchmark(hashtable_lookup_benchmark, "Hashtable lookup benchmark.");
 }
\ No newline at end of file
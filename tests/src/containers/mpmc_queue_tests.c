@@ -0,0 +1,368 @@
+#include "mpmc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/mpmc_queue.h>
+#include <containers/ring_queue.h>
+#include <containers/spsc_queue.h>
+#include <core/clock.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kmutex.h>
+#include <core/kthread.h>
+#include <core/logger.h>
+
+u8 mpmc_queue_should_create_and_destroy() {
+    mpmc_queue queue;
+    expect_to_be_true(mpmc_queue_create(sizeof(u64), 100, &queue));
+
+    // Capacity is rounded up to a power of two.
+    expect_should_be(128, queue.capacity);
+    expect_should_be(sizeof(u64), queue.stride);
+    expect_should_not_be(0, queue.block);
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    mpmc_queue_destroy(&queue);
+
+    expect_should_be(0, queue.block);
+    expect_should_be(0, queue.capacity);
+
+    expect_to_be_false(mpmc_queue_create(0, 16, &queue));
+    expect_to_be_false(mpmc_queue_create(sizeof(u64), 0, &queue));
+    return true;
+}
+
+u8 mpmc_queue_should_enqueue_and_dequeue_in_order() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    mpmc_queue queue;
+    mpmc_queue_create(sizeof(u32), 16, &queue);
+
+    u32 value = 0;
+    expect_to_be_false(mpmc_queue_dequeue(&queue, &value));
+
+    // Go around the ring many times, filling it completely each lap.
+    u32 next_in = 0;
+    u32 next_out = 0;
+    for (u32 lap = 0; lap < 100; ++lap) {
+        while (mpmc_queue_enqueue(&queue, &next_in)) {
+            next_in++;
+        }
+        expect_should_be(queue.capacity, mpmc_queue_length(&queue));
+
+        // Leave a few behind so that the head and tail are out of step with the laps.
+        u32 take = queue.capacity - (lap % 5);
+        for (u32 i = 0; i < take; ++i) {
+            expect_to_be_true(mpmc_queue_dequeue(&queue, &value));
+            expect_should_be(next_out, value);
+            next_out++;
+        }
+    }
+    while (mpmc_queue_dequeue(&queue, &value)) {
+        expect_should_be(next_out, value);
+        next_out++;
+    }
+    expect_should_be(next_in, next_out);
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    mpmc_queue_destroy(&queue);
+    memory_system_shutdown();
+    return true;
+}
+
+#define MPMC_PRODUCER_COUNT 4
+#define MPMC_CONSUMER_COUNT 4
+#define MPMC_ITEMS_PER_PRODUCER 20000
+
+typedef struct mpmc_transfer_params {
+    mpmc_queue* queue;
+    u32 index;
+    // Consumers only: the number of items received, and the sum of their sequence numbers.
+    u64 received;
+    u64 sum;
+    // Consumers only: set if a producer's items were seen out of order.
+    b8 out_of_order;
+    volatile u32* consumed_count;
+    volatile u32* finished_count;
+} mpmc_transfer_params;
+
+static u32 mpmc_producer_run(void* params) {
+    mpmc_transfer_params* p = params;
+    for (u32 i = 0; i < MPMC_ITEMS_PER_PRODUCER; ++i) {
+        // Each item holds the producer's index and its own sequence number.
+        u64 item = ((u64)p->index << 32) | i;
+        while (!mpmc_queue_enqueue(p->queue, &item)) {
+            kthread_yield();
+        }
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+static u32 mpmc_consumer_run(void* params) {
+    mpmc_transfer_params* p = params;
+    i64 last_seen[MPMC_PRODUCER_COUNT];
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT; ++i) {
+        last_seen[i] = -1;
+    }
+
+    const u32 total = MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER;
+    while (katomic_load_u32(p->consumed_count) < total) {
+        u64 item;
+        if (!mpmc_queue_dequeue(p->queue, &item)) {
+            kthread_yield();
+            continue;
+        }
+        katomic_fetch_add_u32(p->consumed_count, 1);
+
+        // Items from any one producer must arrive in the order they were sent.
+        u32 producer = (u32)(item >> 32);
+        i64 sequence = (i64)(item & 0xFFFFFFFF);
+        if (producer >= MPMC_PRODUCER_COUNT || sequence <= last_seen[producer]) {
+            p->out_of_order = true;
+        } else {
+            last_seen[producer] = sequence;
+        }
+        p->received++;
+        p->sum += (u64)sequence;
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+u8 mpmc_queue_should_transfer_across_threads() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Small, so that producers regularly find it full and consumers find it empty.
+    mpmc_queue queue;
+    mpmc_queue_create(sizeof(u64), 64, &queue);
+
+    volatile u32 consumed_count = 0;
+    volatile u32 finished_count = 0;
+    mpmc_transfer_params params[MPMC_PRODUCER_COUNT + MPMC_CONSUMER_COUNT] = {};
+    kthread threads[MPMC_PRODUCER_COUNT + MPMC_CONSUMER_COUNT];
+    for (u32 i = 0; i < MPMC_PRODUCER_COUNT + MPMC_CONSUMER_COUNT; ++i) {
+        params[i].queue = &queue;
+        params[i].index = i;
+        params[i].consumed_count = &consumed_count;
+        params[i].finished_count = &finished_count;
+        b8 producer = i < MPMC_PRODUCER_COUNT;
+        kthread_create(producer ? mpmc_producer_run : mpmc_consumer_run, &params[i], true, &threads[i]);
+    }
+    while (katomic_load_u32(&finished_count) < MPMC_PRODUCER_COUNT + MPMC_CONSUMER_COUNT) {
+        kthread_sleep(0, 1);
+    }
+
+    // Every item was received exactly once.
+    u64 received = 0;
+    u64 sum = 0;
+    for (u32 i = MPMC_PRODUCER_COUNT; i < MPMC_PRODUCER_COUNT + MPMC_CONSUMER_COUNT; ++i) {
+        expect_to_be_false(params[i].out_of_order);
+        received += params[i].received;
+        sum += params[i].sum;
+    }
+    u64 expected_sum = (u64)MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER * (MPMC_ITEMS_PER_PRODUCER - 1) / 2;
+    expect_should_be(MPMC_PRODUCER_COUNT * MPMC_ITEMS_PER_PRODUCER, received);
+    expect_should_be(expected_sum, sum);
+    expect_should_be(0, mpmc_queue_length(&queue));
+
+    mpmc_queue_destroy(&queue);
+    memory_system_shutdown();
+    return true;
+}
+
+#define QUEUE_BENCH_ITEMS 262144
+#define QUEUE_BENCH_MAX_THREADS 16
+
+typedef enum queue_bench_kind {
+    QUEUE_BENCH_MPMC,
+    QUEUE_BENCH_LOCKED,
+    QUEUE_BENCH_SPSC
+} queue_bench_kind;
+
+typedef struct queue_bench {
+    queue_bench_kind kind;
+    mpmc_queue mpmc;
+    spsc_queue spsc;
+    ring_queue ring;
+    kmutex ring_mutex;
+    volatile u32 go;
+    volatile u32 finished_count;
+    volatile u32 consumed_count;
+} queue_bench;
+
+typedef struct queue_bench_params {
+    queue_bench* bench;
+    // The number of items to send if a producer, or 0 if a consumer.
+    u32 produce_count;
+    u64 sum;
+} queue_bench_params;
+
+static b8 bench_enqueue(queue_bench* bench, u64* item) {
+    switch (bench->kind) {
+        case QUEUE_BENCH_MPMC:
+            return mpmc_queue_enqueue(&bench->mpmc, item);
+        case QUEUE_BENCH_SPSC:
+            return spsc_queue_enqueue(&bench->spsc, item);
+        case QUEUE_BENCH_LOCKED:
+        default: {
+            // As the job system used to, taking the lock around each operation.
+            kmutex_lock(&bench->ring_mutex);
+            b8 result = bench->ring.length < bench->ring.capacity && ring_queue_enqueue(&bench->ring, item);
+            kmutex_unlock(&bench->ring_mutex);
+            return result;
+        }
+    }
+}
+
+static b8 bench_dequeue(queue_bench* bench, u64* item) {
+    switch (bench->kind) {
+        case QUEUE_BENCH_MPMC:
+            return mpmc_queue_dequeue(&bench->mpmc, item);
+        case QUEUE_BENCH_SPSC:
+            return spsc_queue_dequeue(&bench->spsc, item);
+        case QUEUE_BENCH_LOCKED:
+        default: {
+            kmutex_lock(&bench->ring_mutex);
+            b8 result = bench->ring.length > 0 && ring_queue_dequeue(&bench->ring, item);
+            kmutex_unlock(&bench->ring_mutex);
+            return result;
+        }
+    }
+}
+
+static u32 queue_bench_run(void* params) {
+    queue_bench_params* p = params;
+    queue_bench* bench = p->bench;
+    while (!katomic_load_u32(&bench->go)) {
+        kthread_yield();
+    }
+
+    u64 item;
+    if (p->produce_count) {
+        for (u32 i = 0; i < p->produce_count; ++i) {
+            item = i;
+            while (!bench_enqueue(bench, &item)) {
+                kthread_yield();
+            }
+        }
+    } else {
+        while (katomic_load_u32(&bench->consumed_count) < QUEUE_BENCH_ITEMS) {
+            if (!bench_dequeue(bench, &item)) {
+                kthread_yield();
+                continue;
+            }
+            katomic_fetch_add_u32(&bench->consumed_count, 1);
+            p->sum += item;
+        }
+    }
+    katomic_fetch_add_u32(&bench->finished_count, 1);
+    return 1;
+}
+
+/**
+ * Passes QUEUE_BENCH_ITEMS items through the queue with half the threads producing and half
+ * consuming, or a single thread doing both in batches. Returns the time taken per item in ns.
+ */
+static f64 queue_bench_measure(queue_bench* bench, u32 thread_count) {
+    bench->go = 0;
+    bench->finished_count = 0;
+    bench->consumed_count = 0;
+
+    clock c;
+    if (thread_count == 1) {
+        u64 item = 0;
+        u64 sum = 0;
+        clock_start(&c);
+        for (u32 i = 0; i < QUEUE_BENCH_ITEMS; i += 64) {
+            for (u32 j = 0; j < 64; ++j) {
+                item = i + j;
+                bench_enqueue(bench, &item);
+            }
+            for (u32 j = 0; j < 64; ++j) {
+                bench_dequeue(bench, &item);
+                sum += item;
+            }
+        }
+        clock_update(&c);
+        if (sum != (u64)QUEUE_BENCH_ITEMS * (QUEUE_BENCH_ITEMS - 1) / 2) {
+            KERROR("Queue benchmark lost items on a single thread.");
+        }
+        return c.elapsed / QUEUE_BENCH_ITEMS * 1000000000.0;
+    }
+
+    u32 producer_count = thread_count / 2;
+    queue_bench_params params[QUEUE_BENCH_MAX_THREADS] = {};
+    kthread threads[QUEUE_BENCH_MAX_THREADS];
+    for (u32 i = 0; i < thread_count; ++i) {
+        params[i].bench = bench;
+        params[i].produce_count = i < producer_count ? QUEUE_BENCH_ITEMS / producer_count : 0;
+        kthread_create(queue_bench_run, &params[i], true, &threads[i]);
+    }
+
+    clock_start(&c);
+    katomic_store_u32(&bench->go, 1);
+    while (katomic_load_u32(&bench->finished_count) < thread_count) {
+        kthread_yield();
+    }
+    clock_update(&c);
+
+    u64 sum = 0;
+    for (u32 i = producer_count; i < thread_count; ++i) {
+        sum += params[i].sum;
+    }
+    u64 per_producer = QUEUE_BENCH_ITEMS / producer_count;
+    if (sum != producer_count * per_producer * (per_producer - 1) / 2) {
+        KERROR("Queue benchmark lost items across %u threads.", thread_count);
+    }
+    return c.elapsed / QUEUE_BENCH_ITEMS * 1000000000.0;
+}
+
+u8 mpmc_queue_contention_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    queue_bench* bench = kallocate(sizeof(queue_bench), MEMORY_TAG_ARRAY);
+    mpmc_queue_create(sizeof(u64), 1024, &bench->mpmc);
+    spsc_queue_create(sizeof(u64), 1024, &bench->spsc);
+    ring_queue_create(sizeof(u64), 1024, 0, &bench->ring);
+    expect_to_be_true(kmutex_create(&bench->ring_mutex));
+
+    for (u32 thread_count = 1; thread_count <= QUEUE_BENCH_MAX_THREADS; thread_count *= 2) {
+        bench->kind = QUEUE_BENCH_MPMC;
+        f64 mpmc_ns = queue_bench_measure(bench, thread_count);
+        bench->kind = QUEUE_BENCH_LOCKED;
+        f64 locked_ns = queue_bench_measure(bench, thread_count);
+        if (thread_count <= 2) {
+            // The single producer, single consumer case.
+            bench->kind = QUEUE_BENCH_SPSC;
+            f64 spsc_ns = queue_bench_measure(bench, thread_count);
+            KINFO("Queue with %2u thread(s): mpmc %.1f ns/item, spsc %.1f ns/item, ring_queue+kmutex %.1f ns/item.",
+                  thread_count, mpmc_ns, spsc_ns, locked_ns);
+        } else {
+            KINFO("Queue with %2u thread(s): mpmc %.1f ns/item, ring_queue+kmutex %.1f ns/item.",
+                  thread_count, mpmc_ns, locked_ns);
+        }
+    }
+
+    kmutex_destroy(&bench->ring_mutex);
+    ring_queue_destroy(&bench->ring);
+    spsc_queue_destroy(&bench->spsc);
+    mpmc_queue_destroy(&bench->mpmc);
+    kfree(bench, sizeof(queue_bench), MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
+void mpmc_queue_register_tests() {
+    test_manager_register_test(mpmc_queue_should_create_and_destroy, "MPMC queue should create and destroy.");
+    test_manager_register_test(mpmc_queue_should_enqueue_and_dequeue_in_order, "MPMC queue should enqueue and dequeue in order.");
+    test_manager_register_test(mpmc_queue_should_transfer_across_threads, "MPMC queue should transfer items across threads.");
+    test_manager_register_benchmark(mpmc_queue_contention_benchmark, "MPMC queue contention benchmark.");
+}
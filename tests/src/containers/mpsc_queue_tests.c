@@ -0,0 +1,138 @@
+#include "mpsc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/mpsc_queue.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+typedef struct test_node {
+    mpsc_queue_node node;
+    u32 producer;
+    u32 value;
+} test_node;
+
+u8 mpsc_queue_should_take_all_in_push_order() {
+    mpsc_queue queue;
+    expect_to_be_true(mpsc_queue_create(&queue));
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+    expect_should_be(0, mpsc_queue_take_all(&queue));
+
+    test_node nodes[8] = {};
+    for (u32 i = 0; i < 8; ++i) {
+        nodes[i].value = i;
+        mpsc_queue_push(&queue, &nodes[i].node);
+    }
+    expect_to_be_false(mpsc_queue_is_empty(&queue));
+
+    // Everything comes out at once, oldest first.
+    mpsc_queue_node* node = mpsc_queue_take_all(&queue);
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+    u32 count = 0;
+    while (node) {
+        u32 value = ((test_node*)node)->value;
+        expect_should_be(count, value);
+        count++;
+        node = node->next;
+    }
+    expect_should_be(8, count);
+
+    // Nodes may be pushed again once taken.
+    mpsc_queue_push(&queue, &nodes[3].node);
+    node = mpsc_queue_take_all(&queue);
+    expect_should_be(&nodes[3].node, node);
+    expect_should_be(0, node->next);
+
+    mpsc_queue_destroy(&queue);
+    return true;
+}
+
+#define MPSC_PRODUCER_COUNT 4
+#define MPSC_ITEMS_PER_PRODUCER 20000
+
+typedef struct mpsc_producer_params {
+    mpsc_queue* queue;
+    test_node* nodes;
+    u32 producer;
+    volatile u32* finished_count;
+} mpsc_producer_params;
+
+static u32 mpsc_producer_run(void* params) {
+    mpsc_producer_params* p = params;
+    for (u32 i = 0; i < MPSC_ITEMS_PER_PRODUCER; ++i) {
+        test_node* n = &p->nodes[i];
+        n->producer = p->producer;
+        n->value = i;
+        mpsc_queue_push(p->queue, &n->node);
+        if ((i % 256) == 0) {
+            kthread_yield();
+        }
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+u8 mpsc_queue_should_take_each_node_once() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    mpsc_queue queue;
+    mpsc_queue_create(&queue);
+    const u64 nodes_size = sizeof(test_node) * MPSC_PRODUCER_COUNT * MPSC_ITEMS_PER_PRODUCER;
+    test_node* nodes = kallocate(nodes_size, MEMORY_TAG_ARRAY);
+
+    volatile u32 finished_count = 0;
+    mpsc_producer_params params[MPSC_PRODUCER_COUNT] = {};
+    kthread threads[MPSC_PRODUCER_COUNT];
+    for (u32 i = 0; i < MPSC_PRODUCER_COUNT; ++i) {
+        params[i].queue = &queue;
+        params[i].nodes = nodes + (u64)i * MPSC_ITEMS_PER_PRODUCER;
+        params[i].producer = i;
+        params[i].finished_count = &finished_count;
+        kthread_create(mpsc_producer_run, &params[i], true, &threads[i]);
+    }
+
+    // This thread is the consumer. Each producer's nodes must come out in the order it
+    // pushed them, so the next value expected from each is tracked.
+    u32 next_value[MPSC_PRODUCER_COUNT] = {};
+    u32 taken = 0;
+    b8 out_of_order = false;
+    while (true) {
+        // Read before taking, so that nothing pushed before the last producer finished is missed.
+        b8 done = katomic_load_u32(&finished_count) == MPSC_PRODUCER_COUNT;
+        mpsc_queue_node* node = mpsc_queue_take_all(&queue);
+        while (node) {
+            test_node* n = (test_node*)node;
+            if (n->value != next_value[n->producer]) {
+                out_of_order = true;
+            }
+            next_value[n->producer] = n->value + 1;
+            taken++;
+            node = node->next;
+        }
+        if (done) {
+            break;
+        }
+        kthread_yield();
+    }
+
+    expect_to_be_false(out_of_order);
+    expect_should_be(MPSC_PRODUCER_COUNT * MPSC_ITEMS_PER_PRODUCER, taken);
+    for (u32 i = 0; i < MPSC_PRODUCER_COUNT; ++i) {
+        expect_should_be(MPSC_ITEMS_PER_PRODUCER, next_value[i]);
+    }
+    expect_to_be_true(mpsc_queue_is_empty(&queue));
+
+    kfree(nodes, nodes_size, MEMORY_TAG_ARRAY);
+    mpsc_queue_destroy(&queue);
+    memory_system_shutdown();
+    return true;
+}
+
+void mpsc_queue_register_tests() {
+    test_manager_register_test(mpsc_queue_should_take_all_in_push_order, "MPSC queue should take all nodes in push order.");
+    test_manager_register_test(mpsc_queue_should_take_each_node_once, "MPSC queue should take each node once.");
+}
@@ -0,0 +1,256 @@
+#include "slot_map_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <containers/slot_map.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <memory/pool_allocator.h>
+
+typedef struct slot_test_element {
+    u32 id;
+    u32 value;
+    u64 payload[6];
+} slot_test_element;
+
+u8 slot_map_should_create_and_destroy() {
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(slot_test_element), 16, &map));
+    expect_should_not_be(0, map.values);
+    expect_should_be(sizeof(slot_test_element), map.stride);
+    expect_should_be(16, map.capacity);
+    expect_should_be(0, map.length);
+    expect_should_be(0, (u64)map.values % 16);
+
+    slot_map_destroy(&map);
+    expect_should_be(0, map.values);
+    expect_should_be(0, map.capacity);
+
+    KDEBUG("The following error messages are intentional.");
+    expect_to_be_false(slot_map_create(0, 16, &map));
+    expect_to_be_false(slot_map_create(sizeof(slot_test_element), 16, 0));
+    return true;
+}
+
+u8 slot_map_handles_should_go_stale_on_erase() {
+    slot_map map;
+    slot_map_create(sizeof(slot_test_element), 4, &map);
+
+    slot_test_element e = {0};
+    u32 handles[3];
+    for (u32 i = 0; i < 3; ++i) {
+        e.id = i;
+        e.value = i * 10;
+        slot_test_element* inserted = slot_map_insert(&map, &e, &handles[i]);
+        expect_should_not_be(0, inserted);
+        expect_should_not_be(INVALID_ID, handles[i]);
+        expect_should_be(i, slot_map_handle_index(handles[i]));
+        expect_should_be(inserted, slot_map_get(&map, handles[i]));
+        expect_should_be(handles[i], slot_map_handle_at(&map, i));
+    }
+    expect_should_be(3, map.length);
+
+    // Erasing the first value moves the last one into its place, without changing its handle.
+    expect_to_be_true(slot_map_erase(&map, handles[0]));
+    expect_should_be(2, map.length);
+    expect_to_be_false(slot_map_contains(&map, handles[0]));
+    expect_should_be(0, slot_map_get(&map, handles[0]));
+    slot_test_element* values = (slot_test_element*)map.values;
+    expect_should_be(2, values[0].id);
+    expect_should_be(1, values[1].id);
+    expect_should_be(&values[0], slot_map_get(&map, handles[2]));
+    expect_should_be(handles[2], slot_map_handle_at(&map, 0));
+    expect_should_be(INVALID_ID, slot_map_handle_at(&map, 2));
+
+    // Erasing twice fails.
+    KDEBUG("The following error message is intentional.");
+    expect_to_be_false(slot_map_erase(&map, handles[0]));
+
+    // As does a handle forged from the free slot's (even) generation.
+    u32 forged = ((slot_map_handle_generation(handles[0]) + 1) << SLOT_MAP_HANDLE_INDEX_BITS) | slot_map_handle_index(handles[0]);
+    expect_to_be_false(slot_map_erase(&map, forged));
+    expect_should_be(0, slot_map_get(&map, forged));
+    expect_should_be(2, map.length);
+
+    // The slot is reused, but the old handle still does not refer to the new value.
+    u32 reused = INVALID_ID;
+    slot_test_element* zeroed = slot_map_insert(&map, 0, &reused);
+    expect_should_be(0, zeroed->id);
+    expect_should_be(0, zeroed->value);
+    expect_should_be(slot_map_handle_index(handles[0]), slot_map_handle_index(reused));
+    expect_should_not_be(handles[0], reused);
+    expect_should_be(0, slot_map_get(&map, handles[0]));
+    expect_should_be(zeroed, slot_map_get(&map, reused));
+
+    expect_should_be(0, slot_map_get(&map, INVALID_ID));
+    expect_to_be_false(slot_map_contains(&map, INVALID_ID));
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+u8 slot_map_should_grow_and_clear() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 count = 5000;
+    slot_map map;
+    slot_map_create(sizeof(u32), 1, &map);
+    u32* handles = kallocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+
+    // Handles stay valid as the map grows.
+    for (u32 i = 0; i < count; ++i) {
+        *(u32*)slot_map_insert(&map, 0, &handles[i]) = i;
+    }
+    expect_should_be(count, map.length);
+    expect_to_be_true(map.capacity >= count);
+    for (u32 i = 0; i < count; ++i) {
+        u32 value = *(u32*)slot_map_get(&map, handles[i]);
+        expect_should_be(i, value);
+    }
+
+    // Erase every other value; the rest stay packed and reachable.
+    for (u32 i = 0; i < count; i += 2) {
+        expect_to_be_true(slot_map_erase(&map, handles[i]));
+    }
+    expect_should_be(count / 2, map.length);
+    u64 sum = 0;
+    for (u32 i = 0; i < map.length; ++i) {
+        u32 value = ((u32*)map.values)[i];
+        expect_should_be(1, value & 1);
+        sum += value;
+    }
+    expect_should_be((u64)(count / 2) * (count / 2), sum);
+    for (u32 i = 1; i < count; i += 2) {
+        u32 value = *(u32*)slot_map_get(&map, handles[i]);
+        expect_should_be(i, value);
+    }
+
+    // Clearing invalidates all handles, and slots are handed out again from the start.
+    u32 capacity = map.capacity;
+    slot_map_clear(&map);
+    expect_should_be(0, map.length);
+    expect_should_be(capacity, map.capacity);
+    for (u32 i = 0; i < count; ++i) {
+        expect_to_be_false(slot_map_contains(&map, handles[i]));
+    }
+    u32 handle = INVALID_ID;
+    slot_map_insert(&map, 0, &handle);
+    expect_should_be(0, slot_map_handle_index(handle));
+
+    kfree(handles, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    slot_map_destroy(&map);
+    memory_system_shutdown();
+    return true;
+}
+
+static u64 bench_random(u64* state) {
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+u8 slot_map_iteration_benchmark() {
+    // Mirrors a registry sized for 65536 entries with only some of them loaded, as the
+    // material and texture systems are. Iterating the pool means visiting every slot.
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 capacity = 65536;
+    const u32 live_count = 4096;
+    const u32 passes = 200;
+
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(slot_test_element), capacity, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(slot_test_element), capacity, &memory_requirement, block, &pool);
+    slot_map map;
+    slot_map_create(sizeof(slot_test_element), capacity, &map);
+    u32* pool_handles = kallocate(sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+    u32* map_handles = kallocate(sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+
+    // Fill both, then release all but live_count at random, so live entries are scattered.
+    for (u32 i = 0; i < capacity; ++i) {
+        ((slot_test_element*)pool_allocator_allocate(&pool, &pool_handles[i]))->value = i;
+        ((slot_test_element*)slot_map_insert(&map, 0, &map_handles[i]))->value = i;
+    }
+    u64 rng = 0x2545F4914F6CDD1DULL;
+    for (u32 i = capacity - 1; i > 0; --i) {
+        u32 j = (u32)(bench_random(&rng) % (i + 1));
+        u32 temp = pool_handles[i];
+        pool_handles[i] = pool_handles[j];
+        pool_handles[j] = temp;
+        temp = map_handles[i];
+        map_handles[i] = map_handles[j];
+        map_handles[j] = temp;
+    }
+    for (u32 i = live_count; i < capacity; ++i) {
+        pool_allocator_free(&pool, pool_handles[i]);
+        slot_map_erase(&map, map_handles[i]);
+    }
+
+    clock c;
+    clock_start(&c);
+    u64 pool_sum = 0;
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < capacity; ++i) {
+            slot_test_element* e = pool_allocator_get_by_index(&pool, i);
+            if (e) {
+                pool_sum += e->value;
+            }
+        }
+    }
+    clock_update(&c);
+    f64 pool_elapsed = c.elapsed;
+
+    clock_start(&c);
+    u64 map_sum = 0;
+    for (u32 pass = 0; pass < passes; ++pass) {
+        slot_test_element* values = (slot_test_element*)map.values;
+        for (u32 i = 0; i < map.length; ++i) {
+            map_sum += values[i].value;
+        }
+    }
+    clock_update(&c);
+    f64 map_elapsed = c.elapsed;
+    expect_should_be(pool_sum, map_sum);
+
+    // Lookups by handle, in random order.
+    clock_start(&c);
+    u64 lookup_sum = 0;
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < live_count; ++i) {
+            lookup_sum += ((slot_test_element*)slot_map_get(&map, map_handles[i]))->value;
+        }
+    }
+    clock_update(&c);
+    f64 lookup_elapsed = c.elapsed;
+    expect_should_be(map_sum, lookup_sum);
+
+    KINFO("Iterating %u live of %u entries: pool %.3f ms/pass, slot map %.3f ms/pass; slot map lookup %.1f ns.",
+          live_count, capacity, pool_elapsed * 1000.0 / passes, map_elapsed * 1000.0 / passes,
+          lookup_elapsed * 1000000000.0 / ((f64)passes * live_count));
+
+    kfree(map_handles, sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+    kfree(pool_handles, sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+    slot_map_destroy(&map);
+    pool_allocator_destroy(&pool);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    memory_system_shutdown();
+    return true;
+}
+
+void slot_map_register_tests() {
+    test_manager_register_test(slot_map_should_create_and_destroy, "Slot map should create and destroy.");
+    test_manager_register_test(slot_map_handles_should_go_stale_on_erase, "Slot map handles go stale once erased.");
+    test_manager_register_test(slot_map_should_grow_and_clear, "Slot map should grow and clear.");
+    test_manager_register_benchmark(slot_map_iteration_benchmark, "Slot map iteration benchmark.");
+}
@@ -0,0 +1,238 @@
+#include "sort_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/sort.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <math/kmath.h>
+#include <memory/scratch_allocator.h>
+
+#define SORT_TEST_COUNT 10000
+
+static u32 random_u32() {
+    // krandom only gives 31 bits at most, so combine two.
+    return ((u32)krandom() << 16) ^ (u32)krandom();
+}
+
+static void start_memory() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    memory_system_initialize(config);
+}
+
+static void stop_memory() {
+    scratch_allocator_thread_shutdown();
+    memory_system_shutdown();
+}
+
+u8 sort_should_sort_u32_and_u64() {
+    start_memory();
+
+    u32* keys = kallocate(sizeof(u32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    u64* wide_keys = kallocate(sizeof(u64) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    u64 sum = 0;
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = random_u32();
+        wide_keys[i] = ((u64)random_u32() << 32) | random_u32();
+        sum += keys[i];
+    }
+
+    // Scratch taken from the thread's scratch stack.
+    radix_sort_u32(keys, SORT_TEST_COUNT, 0);
+    radix_sort_u64(wide_keys, SORT_TEST_COUNT, 0);
+
+    b8 in_order = true;
+    u64 sorted_sum = keys[0];
+    for (u32 i = 1; i < SORT_TEST_COUNT; ++i) {
+        in_order = in_order && keys[i - 1] <= keys[i] && wide_keys[i - 1] <= wide_keys[i];
+        sorted_sum += keys[i];
+    }
+    expect_to_be_true(in_order);
+    // Nothing was lost or duplicated along the way.
+    expect_should_be(sum, sorted_sum);
+
+    // Keys which only differ in their low byte take a single pass, which leaves the
+    // result in the scratch buffer to be copied back.
+    u32 scratch[256];
+    for (u32 i = 0; i < 256; ++i) {
+        keys[i] = 0xABCD0000 | (255 - i);
+    }
+    radix_sort_u32(keys, 256, scratch);
+    in_order = true;
+    for (u32 i = 0; i < 256; ++i) {
+        in_order = in_order && keys[i] == (0xABCD0000 | i);
+    }
+    expect_to_be_true(in_order);
+
+    kfree(wide_keys, sizeof(u64) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    kfree(keys, sizeof(u32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    stop_memory();
+    return true;
+}
+
+u8 sort_should_sort_f32() {
+    start_memory();
+
+    f32 values[] = {3.5f, -0.0f, 0.0f, -1.0f, 1e30f, -1e-30f, 2.0f, -1e30f, 1e-30f, -2.0f};
+    f32 expected[] = {-1e30f, -2.0f, -1.0f, -1e-30f, -0.0f, 0.0f, 1e-30f, 2.0f, 3.5f, 1e30f};
+    u32 count = sizeof(values) / sizeof(f32);
+    radix_sort_f32(values, count, 0);
+    for (u32 i = 0; i < count; ++i) {
+        expect_float_to_be(expected[i], values[i]);
+    }
+    // The zeros keep their signs.
+    expect_to_be_true(sort_key_from_f32(values[4]) < sort_key_from_f32(values[5]));
+
+    // Keys convert back to the same floats.
+    for (u32 i = 0; i < count; ++i) {
+        f32 round_trip = sort_key_to_f32(sort_key_from_f32(expected[i]));
+        expect_float_to_be(expected[i], round_trip);
+    }
+
+    stop_memory();
+    return true;
+}
+
+u8 sort_indexed_should_be_stable() {
+    start_memory();
+
+    // Few distinct keys, so that most are equal to others.
+    f32* keys = kallocate(sizeof(f32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    f32* original = kallocate(sizeof(f32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        keys[i] = (f32)krandom_in_range(-50, 50) * 0.5f;
+        original[i] = keys[i];
+        indices[i] = i;
+    }
+
+    radix_sort_f32_indexed(keys, indices, SORT_TEST_COUNT, 0, 0);
+
+    b8 in_order = true;
+    b8 matches = true;
+    for (u32 i = 0; i < SORT_TEST_COUNT; ++i) {
+        // Each index still refers to the key it was sorted with.
+        matches = matches && original[indices[i]] == keys[i];
+        if (i > 0) {
+            in_order = in_order && keys[i - 1] <= keys[i];
+            // Equal keys keep their original order.
+            if (keys[i - 1] == keys[i]) {
+                in_order = in_order && indices[i - 1] < indices[i];
+            }
+        }
+    }
+    expect_to_be_true(in_order);
+    expect_to_be_true(matches);
+
+    kfree(original, sizeof(f32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    kfree(keys, sizeof(f32) * SORT_TEST_COUNT, MEMORY_TAG_ARRAY);
+    stop_memory();
+    return true;
+}
+
+// The recursive Lomuto quick sort render_view_world previously used, for comparison.
+typedef struct sort_bench_distance {
+    f32 distance;
+    u32 index;
+} sort_bench_distance;
+
+static i32 bench_partition(sort_bench_distance arr[], i32 low_index, i32 high_index) {
+    sort_bench_distance pivot = arr[high_index];
+    i32 i = (low_index - 1);
+    for (i32 j = low_index; j <= high_index - 1; ++j) {
+        if (arr[j].distance > pivot.distance) {
+            ++i;
+            sort_bench_distance temp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = temp;
+        }
+    }
+    sort_bench_distance temp = arr[i + 1];
+    arr[i + 1] = arr[high_index];
+    arr[high_index] = temp;
+    return i + 1;
+}
+
+static void bench_quick_sort(sort_bench_distance arr[], i32 low_index, i32 high_index) {
+    if (low_index < high_index) {
+        i32 partition_index = bench_partition(arr, low_index, high_index);
+        bench_quick_sort(arr, low_index, partition_index - 1);
+        bench_quick_sort(arr, partition_index + 1, high_index);
+    }
+}
+
+// Sorted input takes quadratic time and recursion depth in the quick sort, so it is only
+// measured up to this many elements.
+#define SORT_BENCH_SORTED_MAX 16384
+
+u8 sort_radix_vs_quick_sort_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(128);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 max_count = 1024 * 1024;
+    f32* distances = kallocate(sizeof(f32) * max_count, MEMORY_TAG_ARRAY);
+    sort_bench_distance* pairs = kallocate(sizeof(sort_bench_distance) * max_count, MEMORY_TAG_ARRAY);
+    u32* keys = kallocate(sizeof(u32) * max_count * 4, MEMORY_TAG_ARRAY);
+    u32* indices = keys + max_count;
+    u32* scratch_keys = keys + max_count * 2;
+    u32* scratch_indices = keys + max_count * 3;
+
+    for (u32 count = 1024; count <= max_count; count *= 4) {
+        for (u32 sorted = 0; sorted < 2; ++sorted) {
+            if (sorted && count > SORT_BENCH_SORTED_MAX) {
+                continue;
+            }
+            for (u32 i = 0; i < count; ++i) {
+                // Already sorted back to front, as a scene seen from a still camera would be.
+                distances[i] = sorted ? (f32)(count - i) : fkrandom_in_range(0.0f, 1000.0f);
+            }
+
+            clock c;
+            clock_start(&c);
+            for (u32 i = 0; i < count; ++i) {
+                pairs[i].distance = distances[i];
+                pairs[i].index = i;
+            }
+            bench_quick_sort(pairs, 0, count - 1);
+            clock_update(&c);
+            f64 quick_elapsed = c.elapsed;
+
+            // As render_view_world builds its keys: inverted, to sort far to near.
+            clock_start(&c);
+            for (u32 i = 0; i < count; ++i) {
+                keys[i] = ~sort_key_from_f32(distances[i]);
+                indices[i] = i;
+            }
+            radix_sort_u32_indexed(keys, indices, count, scratch_keys, scratch_indices);
+            clock_update(&c);
+            f64 radix_elapsed = c.elapsed;
+
+            b8 same = true;
+            for (u32 i = 0; i < count; ++i) {
+                same = same && distances[indices[i]] == pairs[i].distance;
+            }
+            expect_to_be_true(same);
+
+            KINFO("Sorting %7u %s distances: radix %8.3f ms, quick sort %9.3f ms.",
+                  count, sorted ? "sorted" : "random", radix_elapsed * 1000.0, quick_elapsed * 1000.0);
+        }
+    }
+
+    kfree(keys, sizeof(u32) * max_count * 4, MEMORY_TAG_ARRAY);
+    kfree(pairs, sizeof(sort_bench_distance) * max_count, MEMORY_TAG_ARRAY);
+    kfree(distances, sizeof(f32) * max_count, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
+void sort_register_tests() {
+    test_manager_register_test(sort_should_sort_u32_and_u64, "Radix sort should sort u32 and u64 keys.");
+    test_manager_register_test(sort_should_sort_f32, "Radix sort should sort f32 keys, including negatives.");
+    test_manager_register_test(sort_indexed_should_be_stable, "Indexed radix sort should be stable.");
+    test_manager_register_benchmark(sort_radix_vs_quick_sort_benchmark, "Radix sort vs quick sort benchmark.");
+}
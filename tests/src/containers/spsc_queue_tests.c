@@ -0,0 +1,114 @@
+#include "spsc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/spsc_queue.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+u8 spsc_queue_should_enqueue_peek_and_dequeue() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    spsc_queue queue;
+    expect_to_be_true(spsc_queue_create(sizeof(u32), 5, &queue));
+    expect_should_be(8, queue.capacity);
+
+    u32 value = 0;
+    expect_to_be_false(spsc_queue_dequeue(&queue, &value));
+    expect_to_be_false(spsc_queue_peek(&queue, &value));
+
+    u32 next_in = 0;
+    u32 next_out = 0;
+    for (u32 lap = 0; lap < 100; ++lap) {
+        while (spsc_queue_enqueue(&queue, &next_in)) {
+            next_in++;
+        }
+        expect_should_be(queue.capacity, spsc_queue_length(&queue));
+
+        // Peeking leaves the value in place.
+        expect_to_be_true(spsc_queue_peek(&queue, &value));
+        expect_should_be(next_out, value);
+
+        u32 take = queue.capacity - (lap % 3);
+        for (u32 i = 0; i < take; ++i) {
+            expect_to_be_true(spsc_queue_dequeue(&queue, &value));
+            expect_should_be(next_out, value);
+            next_out++;
+        }
+    }
+    while (spsc_queue_dequeue(&queue, &value)) {
+        expect_should_be(next_out, value);
+        next_out++;
+    }
+    expect_should_be(next_in, next_out);
+
+    spsc_queue_destroy(&queue);
+    expect_should_be(0, queue.block);
+    memory_system_shutdown();
+    return true;
+}
+
+#define SPSC_ITEM_COUNT 100000
+
+typedef struct spsc_producer_params {
+    spsc_queue* queue;
+    volatile u32* finished;
+} spsc_producer_params;
+
+static u32 spsc_producer_run(void* params) {
+    spsc_producer_params* p = params;
+    for (u32 i = 0; i < SPSC_ITEM_COUNT; ++i) {
+        while (!spsc_queue_enqueue(p->queue, &i)) {
+            kthread_yield();
+        }
+    }
+    katomic_store_u32(p->finished, 1);
+    return 1;
+}
+
+u8 spsc_queue_should_transfer_across_threads() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    spsc_queue queue;
+    spsc_queue_create(sizeof(u32), 64, &queue);
+
+    volatile u32 finished = 0;
+    spsc_producer_params params = {&queue, &finished};
+    kthread thread;
+    kthread_create(spsc_producer_run, &params, true, &thread);
+
+    // Everything arrives, in order, on this thread.
+    u32 expected = 0;
+    b8 in_order = true;
+    while (expected < SPSC_ITEM_COUNT) {
+        u32 value;
+        if (!spsc_queue_dequeue(&queue, &value)) {
+            kthread_yield();
+            continue;
+        }
+        if (value != expected) {
+            in_order = false;
+        }
+        expected++;
+    }
+    expect_to_be_true(in_order);
+    while (!katomic_load_u32(&finished)) {
+        kthread_yield();
+    }
+    expect_should_be(0, spsc_queue_length(&queue));
+
+    spsc_queue_destroy(&queue);
+    memory_system_shutdown();
+    return true;
+}
+
+void spsc_queue_register_tests() {
+    test_manager_register_test(spsc_queue_should_enqueue_peek_and_dequeue, "SPSC queue should enqueue, peek and dequeue in order.");
+    test_manager_register_test(spsc_queue_should_transfer_across_threads, "SPSC queue should transfer items across threads.");
+}
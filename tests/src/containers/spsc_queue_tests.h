@@ -0,0 +1,3 @@
+#pragma once
+
+void spsc_queue_register_tests();
@@ -0,0 +1,224 @@
+#include "typed_container_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <containers/hashtable.h>
+#include <containers/ring_queue.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <math/math_types.h>
+#include <renderer/renderer_types.inl>
+
+DARRAY_DEFINE(u32)
+DARRAY_DEFINE(vertex_3d)
+DARRAY_DEFINE(geometry_render_data)
+RING_QUEUE_DEFINE(vertex_3d)
+HASHTABLE_DEFINE(u64)
+
+u8 typed_darray_should_interoperate() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u32* array = darray_u32_create(1);
+    for (u32 i = 0; i < 100; ++i) {
+        array = darray_u32_push(array, i);
+    }
+    u32 values[] = {100, 101, 102};
+    array = darray_u32_push_range(array, values, 3);
+    expect_should_be(103, darray_u32_length(array));
+
+    // Typed and generic functions work on the same arrays.
+    u32 value = 103;
+    darray_push(array, value);
+    expect_should_be(104, darray_length(array));
+    expect_should_be(103, darray_u32_pop(array));
+    u32 popped = 0;
+    darray_pop(array, &popped);
+    expect_should_be(102, popped);
+    expect_should_be(102, darray_u32_length(array));
+    b8 matches = true;
+    for (u32 i = 0; i < 102; ++i) {
+        matches = matches && array[i] == i;
+    }
+    expect_to_be_true(matches);
+
+    darray_destroy(array);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 typed_ring_queue_and_hashtable_should_interoperate() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    ring_queue queue;
+    ring_queue_create(sizeof(vertex_3d), 8, 0, &queue);
+    vertex_3d v = {};
+    // Wrap around the end of the block a few times.
+    for (u32 i = 0; i < 10; ++i) {
+        v.position.x = (f32)i;
+        expect_to_be_true(ring_queue_vertex_3d_enqueue(&queue, v));
+        if (i % 2) {
+            vertex_3d out;
+            expect_to_be_true(ring_queue_vertex_3d_dequeue(&queue, &out));
+            expect_float_to_be((f32)(i / 2), out.position.x);
+        }
+    }
+    // The generic functions see the same contents.
+    vertex_3d out;
+    expect_to_be_true(ring_queue_dequeue(&queue, &out));
+    expect_float_to_be(5.0f, out.position.x);
+    expect_to_be_true(ring_queue_vertex_3d_peek(&queue, &out));
+    expect_float_to_be(6.0f, out.position.x);
+    ring_queue_destroy(&queue);
+
+    hashtable table;
+    hashtable_create(sizeof(u64), 8, false, &table);
+    expect_to_be_true(hashtable_u64_set(&table, "first", 11));
+    u64 fill = 99;
+    hashtable_fill(&table, &fill);
+    u64 result = 0;
+    expect_to_be_true(hashtable_u64_get(&table, "first", &result));
+    expect_should_be(11, result);
+    hashtable_get(&table, "first", &result);
+    expect_should_be(11, result);
+    // Names not in the table obtain the fill value, as with hashtable_get.
+    expect_to_be_true(hashtable_u64_get(&table, "second", &result));
+    expect_should_be(99, result);
+    hashtable_destroy(&table);
+
+    memory_system_shutdown();
+    return true;
+}
+
+#define TYPED_BENCH_VERTEX_COUNT 1000000
+#define TYPED_BENCH_GEOMETRY_COUNT 200000
+// Arrays are refilled in rounds of this many elements, so that they stay in cache and the
+// cost of each push is measured rather than memory bandwidth.
+#define TYPED_BENCH_ROUND 4000
+
+u8 typed_container_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(256);
+    expect_to_be_true(memory_system_initialize(config));
+
+    clock c;
+    vertex_3d v = {};
+
+    // vertex_3d arrays, as built by geometry generation and loading.
+    clock_start(&c);
+    vertex_3d* generic_vertices = darray_reserve(vertex_3d, TYPED_BENCH_ROUND);
+    for (u32 i = 0; i < TYPED_BENCH_VERTEX_COUNT; ++i) {
+        if (i % TYPED_BENCH_ROUND == 0) {
+            darray_clear(generic_vertices);
+        }
+        v.position.x = (f32)i;
+        darray_push(generic_vertices, v);
+    }
+    clock_update(&c);
+    f64 generic_vertex_elapsed = c.elapsed;
+
+    clock_start(&c);
+    vertex_3d* typed_vertices = darray_vertex_3d_create(TYPED_BENCH_ROUND);
+    for (u32 i = 0; i < TYPED_BENCH_VERTEX_COUNT; ++i) {
+        if (i % TYPED_BENCH_ROUND == 0) {
+            darray_clear(typed_vertices);
+        }
+        v.position.x = (f32)i;
+        typed_vertices = darray_vertex_3d_push(typed_vertices, v);
+    }
+    clock_update(&c);
+    f64 typed_vertex_elapsed = c.elapsed;
+
+    expect_should_be(TYPED_BENCH_ROUND, darray_length(generic_vertices));
+    expect_should_be(TYPED_BENCH_ROUND, darray_length(typed_vertices));
+    expect_float_to_be(generic_vertices[TYPED_BENCH_ROUND - 1].position.x, typed_vertices[TYPED_BENCH_ROUND - 1].position.x);
+
+    // geometry_render_data arrays, as built for render packets.
+    geometry_render_data g = {};
+    g.model = mat4_identity();
+    clock_start(&c);
+    geometry_render_data* generic_geometries = darray_reserve(geometry_render_data, TYPED_BENCH_ROUND);
+    for (u32 i = 0; i < TYPED_BENCH_GEOMETRY_COUNT; ++i) {
+        if (i % TYPED_BENCH_ROUND == 0) {
+            darray_clear(generic_geometries);
+        }
+        g.model.data[12] = (f32)i;
+        darray_push(generic_geometries, g);
+    }
+    clock_update(&c);
+    f64 generic_geometry_elapsed = c.elapsed;
+
+    clock_start(&c);
+    geometry_render_data* typed_geometries = darray_geometry_render_data_create(TYPED_BENCH_ROUND);
+    for (u32 i = 0; i < TYPED_BENCH_GEOMETRY_COUNT; ++i) {
+        if (i % TYPED_BENCH_ROUND == 0) {
+            darray_clear(typed_geometries);
+        }
+        g.model.data[12] = (f32)i;
+        typed_geometries = darray_geometry_render_data_push(typed_geometries, g);
+    }
+    clock_update(&c);
+    f64 typed_geometry_elapsed = c.elapsed;
+
+    expect_should_be(TYPED_BENCH_ROUND, darray_length(typed_geometries));
+    expect_float_to_be(generic_geometries[TYPED_BENCH_ROUND - 1].model.data[12], typed_geometries[TYPED_BENCH_ROUND - 1].model.data[12]);
+
+    // Passing vertices through a ring queue.
+    ring_queue queue;
+    ring_queue_create(sizeof(vertex_3d), 256, 0, &queue);
+    f32 sum = 0;
+    clock_start(&c);
+    for (u32 i = 0; i < TYPED_BENCH_VERTEX_COUNT; i += 128) {
+        for (u32 j = 0; j < 128; ++j) {
+            ring_queue_enqueue(&queue, &typed_vertices[(i + j) % TYPED_BENCH_ROUND]);
+        }
+        for (u32 j = 0; j < 128; ++j) {
+            ring_queue_dequeue(&queue, &v);
+            sum += v.position.x;
+        }
+    }
+    clock_update(&c);
+    f64 generic_queue_elapsed = c.elapsed;
+
+    f32 typed_sum = 0;
+    clock_start(&c);
+    for (u32 i = 0; i < TYPED_BENCH_VERTEX_COUNT; i += 128) {
+        for (u32 j = 0; j < 128; ++j) {
+            ring_queue_vertex_3d_enqueue(&queue, typed_vertices[(i + j) % TYPED_BENCH_ROUND]);
+        }
+        for (u32 j = 0; j < 128; ++j) {
+            ring_queue_vertex_3d_dequeue(&queue, &v);
+            typed_sum += v.position.x;
+        }
+    }
+    clock_update(&c);
+    f64 typed_queue_elapsed = c.elapsed;
+    expect_float_to_be(sum, typed_sum);
+
+    KINFO("Pushing %u vertex_3d: darray_push %.3f ms, typed %.3f ms.",
+          TYPED_BENCH_VERTEX_COUNT, generic_vertex_elapsed * 1000.0, typed_vertex_elapsed * 1000.0);
+    KINFO("Pushing %u geometry_render_data: darray_push %.3f ms, typed %.3f ms.",
+          TYPED_BENCH_GEOMETRY_COUNT, generic_geometry_elapsed * 1000.0, typed_geometry_elapsed * 1000.0);
+    KINFO("Queueing %u vertex_3d: ring_queue %.3f ms, typed %.3f ms.",
+          TYPED_BENCH_VERTEX_COUNT, generic_queue_elapsed * 1000.0, typed_queue_elapsed * 1000.0);
+
+    ring_queue_destroy(&queue);
+    darray_destroy(typed_geometries);
+    darray_destroy(generic_geometries);
+    darray_destroy(typed_vertices);
+    darray_destroy(generic_vertices);
+    memory_system_shutdown();
+    return true;
+}
+
+void typed_container_register_tests() {
+    test_manager_register_test(typed_darray_should_interoperate, "Typed darray should interoperate with darray.");
+    test_manager_register_test(typed_ring_queue_and_hashtable_should_interoperate, "Typed ring queue and hashtable should interoperate.");
+    test_manager_register_benchmark(typed_container_benchmark, "Typed container benchmark.");
+}
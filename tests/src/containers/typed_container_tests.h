@@ -0,0 +1,3 @@
+#pragma once
+
+void typed_container_register_tests();
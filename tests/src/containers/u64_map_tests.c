@@ -0,0 +1,195 @@
+#include "u64_map_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/u64_map.h>
+#include <containers/hashtable.h>
+#include <core/clock.h>
+#include <core/khash.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+
+#define MAP_MANY_COUNT 4096
+
+u8 u64_map_should_create_and_destroy() {
+    u64_map map;
+    expect_to_be_true(u64_map_create(sizeof(u32), 3, &map));
+
+    expect_should_not_be(0, map.ctrl);
+    expect_should_be(sizeof(u32), map.element_size);
+    expect_should_be(U64_MAP_GROUP_SIZE, map.slot_count);
+    expect_should_be(0, map.entry_count);
+
+    u64_map_destroy(&map);
+
+    expect_should_be(0, map.ctrl);
+    expect_should_be(0, map.element_size);
+    expect_should_be(0, map.slot_count);
+
+    return true;
+}
+
+u8 u64_map_should_set_get_and_update() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64_map map;
+    u64_map_create(sizeof(u64), 1, &map);
+
+    // Sequential keys, as ids would be.
+    for (u64 i = 0; i < MAP_MANY_COUNT; ++i) {
+        u64 value = i * 3;
+        expect_to_be_true(u64_map_set(&map, i, &value));
+    }
+    expect_should_be(MAP_MANY_COUNT, map.entry_count);
+    expect_to_be_true(map.entry_count * 8 <= map.slot_count * 7);
+
+    for (u64 i = 0; i < MAP_MANY_COUNT; ++i) {
+        u64 value = 0;
+        expect_to_be_true(u64_map_get(&map, i, &value));
+        expect_should_be(i * 3, value);
+    }
+
+    // Missing keys are not found, and leave the output alone.
+    u64 value = 99;
+    expect_to_be_false(u64_map_get(&map, MAP_MANY_COUNT, &value));
+    expect_should_be(99, value);
+    expect_should_be(0, u64_map_get_ptr(&map, INVALID_ID_U64));
+
+    // Setting an existing key updates it in place.
+    value = 7;
+    u64_map_set(&map, 42, &value);
+    expect_should_be(MAP_MANY_COUNT, map.entry_count);
+    u64* ptr = u64_map_get_ptr(&map, 42);
+    expect_should_not_be(0, ptr);
+    expect_should_be(7, *ptr);
+    *ptr = 8;
+    u64_map_get(&map, 42, &value);
+    expect_should_be(8, value);
+
+    u64_map_destroy(&map);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 u64_map_should_remove_and_reinsert() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64_map map;
+    u64_map_create(sizeof(u32), MAP_MANY_COUNT, &map);
+    u32 slot_count = map.slot_count;
+
+    // Keys which are hashes themselves, as precomputed name hashes would be.
+    for (u32 i = 0; i < MAP_MANY_COUNT; ++i) {
+        u64_map_set(&map, khash_u64(i), &i);
+    }
+    for (u32 i = 0; i < MAP_MANY_COUNT; i += 2) {
+        expect_to_be_true(u64_map_remove(&map, khash_u64(i)));
+    }
+    expect_should_be(MAP_MANY_COUNT / 2, map.entry_count);
+    expect_to_be_false(u64_map_remove(&map, khash_u64(0)));
+
+    for (u32 i = 0; i < MAP_MANY_COUNT; ++i) {
+        u32 value = INVALID_ID;
+        b8 found = u64_map_get(&map, khash_u64(i), &value);
+        if (i % 2 == 0) {
+            expect_to_be_false(found);
+        } else {
+            expect_to_be_true(found);
+            expect_should_be(i, value);
+        }
+    }
+
+    // Churn through many more keys than the map holds at once. Deleted slots are reclaimed
+    // by rehashing, so the map should not need to grow.
+    for (u32 i = MAP_MANY_COUNT; i < MAP_MANY_COUNT * 16; ++i) {
+        u64_map_set(&map, khash_u64(i), &i);
+        u64_map_remove(&map, khash_u64(i));
+    }
+    expect_should_be(MAP_MANY_COUNT / 2, map.entry_count);
+    expect_should_be(slot_count, map.slot_count);
+    for (u32 i = 1; i < MAP_MANY_COUNT; i += 2) {
+        u32 value = INVALID_ID;
+        expect_to_be_true(u64_map_get(&map, khash_u64(i), &value));
+        expect_should_be(i, value);
+    }
+
+    // Clearing removes everything.
+    u64_map_clear(&map);
+    expect_should_be(0, map.entry_count);
+    expect_should_be(0, u64_map_get_ptr(&map, khash_u64(1)));
+
+    u64_map_destroy(&map);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 u64_map_lookup_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 count = MAP_MANY_COUNT;
+    const u32 passes = 16;
+    char(*names)[32] = kallocate(sizeof(char[32]) * count, MEMORY_TAG_ARRAY);
+    u64* keys = kallocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+
+    hashtable table;
+    hashtable_create(sizeof(u32), count, false, &table);
+    u64_map map;
+    u64_map_create(sizeof(u32), count, &map);
+    for (u32 i = 0; i < count; ++i) {
+        string_format(names[i], "textures/environment/rock_%u", i);
+        hashtable_set(&table, names[i], &i);
+        // Keyed by the name's hash, computed once up front.
+        keys[i] = khash_string(names[i]);
+        u64_map_set(&map, keys[i], &i);
+    }
+
+    u64 sum = 0;
+    clock c;
+    clock_start(&c);
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < count; ++i) {
+            u32 value = 0;
+            hashtable_get(&table, names[i], &value);
+            sum += value;
+        }
+    }
+    clock_update(&c);
+    f64 table_elapsed = c.elapsed;
+
+    clock_start(&c);
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < count; ++i) {
+            u32 value = 0;
+            u64_map_get(&map, keys[i], &value);
+            sum += value;
+        }
+    }
+    clock_update(&c);
+    f64 map_elapsed = c.elapsed;
+    expect_should_be((u64)passes * count * (count - 1), sum);
+
+    f64 lookups = (f64)passes * count;
+    KINFO("Lookup of %u entries: u64_map %.1f ns/lookup, string hashtable %.1f ns/lookup.",
+          count, map_elapsed / lookups * 1000000000.0, table_elapsed / lookups * 1000000000.0);
+
+    u64_map_destroy(&map);
+    hashtable_destroy(&table);
+    kfree(keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    kfree(names, sizeof(char[32]) * count, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
+void u64_map_register_tests() {
+    test_manager_register_test(u64_map_should_create_and_destroy, "u64 map should create and destroy.");
+    test_manager_register_test(u64_map_should_set_get_and_update, "u64 map should set, get and update entries.");
+    test_manager_register_test(u64_map_should_remove_and_reinsert, "u64 map should remove and reinsert entries.");
+    test_manager_register_benchmark(u64_map_lookup_benchmark, "u64 map lookup benchmark.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void u64_map_register_tests();
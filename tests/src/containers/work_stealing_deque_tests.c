@@ -0,0 +1,185 @@
+#include "work_stealing_deque_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/work_stealing_deque.h>
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+u8 work_stealing_deque_should_create_and_destroy() {
+    work_stealing_deque deque;
+    expect_to_be_true(work_stealing_deque_create(sizeof(u64), 100, &deque));
+
+    // Capacity is rounded up to a power of two.
+    expect_should_be(128, deque.capacity);
+    expect_should_be(sizeof(u64), deque.stride);
+    expect_should_not_be(0, deque.block);
+    expect_should_be(0, work_stealing_deque_length(&deque));
+
+    work_stealing_deque_destroy(&deque);
+
+    expect_should_be(0, deque.block);
+    expect_should_be(0, deque.capacity);
+
+    expect_to_be_false(work_stealing_deque_create(0, 16, &deque));
+    expect_to_be_false(work_stealing_deque_create(sizeof(u64), 0, &deque));
+    return true;
+}
+
+static b8 accept_odd(const void* value, void* user_data) {
+    return (*(const u32*)value & 1) == 1;
+}
+
+u8 work_stealing_deque_should_pop_newest_and_steal_oldest() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    work_stealing_deque deque;
+    work_stealing_deque_create(sizeof(u32), 8, &deque);
+
+    u32 value = 0;
+    expect_to_be_false(work_stealing_deque_pop(&deque, &value));
+    expect_to_be_false(work_stealing_deque_steal(&deque, &value, 0, 0));
+
+    // Fill it completely.
+    for (u32 i = 0; i < 8; ++i) {
+        expect_to_be_true(work_stealing_deque_push(&deque, &i));
+    }
+    u32 extra = 8;
+    expect_to_be_false(work_stealing_deque_push(&deque, &extra));
+    expect_should_be(8, work_stealing_deque_length(&deque));
+
+    // The owner takes from the bottom, thieves from the top.
+    expect_to_be_true(work_stealing_deque_pop(&deque, &value));
+    expect_should_be(7, value);
+    expect_to_be_true(work_stealing_deque_steal(&deque, &value, 0, 0));
+    expect_should_be(0, value);
+    expect_to_be_true(work_stealing_deque_steal(&deque, &value, 0, 0));
+    expect_should_be(1, value);
+
+    // A refused value stays where it is.
+    expect_to_be_false(work_stealing_deque_steal(&deque, &value, accept_odd, 0));
+    expect_should_be(5, work_stealing_deque_length(&deque));
+    expect_to_be_true(work_stealing_deque_pop(&deque, &value));
+    expect_should_be(6, value);
+
+    // Room freed at the top is reused as the positions wrap around.
+    for (u32 i = 10; i < 14; ++i) {
+        expect_to_be_true(work_stealing_deque_push(&deque, &i));
+    }
+    expect_should_be(8, work_stealing_deque_length(&deque));
+    u32 expected_pops[8] = {13, 12, 11, 10, 5, 4, 3, 2};
+    for (u32 i = 0; i < 8; ++i) {
+        expect_to_be_true(work_stealing_deque_pop(&deque, &value));
+        expect_should_be(expected_pops[i], value);
+    }
+    expect_to_be_false(work_stealing_deque_pop(&deque, &value));
+    expect_should_be(0, work_stealing_deque_length(&deque));
+
+    work_stealing_deque_destroy(&deque);
+    memory_system_shutdown();
+    return true;
+}
+
+#define DEQUE_THIEF_COUNT 3
+#define DEQUE_ITEM_COUNT 100000
+
+typedef struct deque_steal_params {
+    work_stealing_deque* deque;
+    // One flag per item, set by whichever thread took it.
+    volatile u32* taken;
+    volatile u32* taken_count;
+    volatile u32* finished_count;
+    // Set if an item was taken twice.
+    b8 duplicate;
+} deque_steal_params;
+
+static void deque_take(deque_steal_params* p, u32 item) {
+    if (katomic_fetch_add_u32(&p->taken[item], 1) != 0) {
+        p->duplicate = true;
+    }
+    katomic_fetch_add_u32(p->taken_count, 1);
+}
+
+static u32 deque_thief_run(void* params) {
+    deque_steal_params* p = params;
+    while (katomic_load_u32(p->taken_count) < DEQUE_ITEM_COUNT) {
+        u32 item;
+        if (work_stealing_deque_steal(p->deque, &item, 0, 0)) {
+            deque_take(p, item);
+        } else {
+            kthread_yield();
+        }
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+u8 work_stealing_deque_should_hand_out_each_item_once() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Small, so the owner and thieves regularly race for the last item.
+    work_stealing_deque deque;
+    work_stealing_deque_create(sizeof(u32), 16, &deque);
+    volatile u32* taken = kallocate(sizeof(u32) * DEQUE_ITEM_COUNT, MEMORY_TAG_ARRAY);
+
+    volatile u32 taken_count = 0;
+    volatile u32 finished_count = 0;
+    deque_steal_params params[DEQUE_THIEF_COUNT + 1] = {};
+    kthread threads[DEQUE_THIEF_COUNT];
+    for (u32 i = 0; i < DEQUE_THIEF_COUNT + 1; ++i) {
+        params[i].deque = &deque;
+        params[i].taken = taken;
+        params[i].taken_count = &taken_count;
+        params[i].finished_count = &finished_count;
+        if (i < DEQUE_THIEF_COUNT) {
+            kthread_create(deque_thief_run, &params[i], true, &threads[i]);
+        }
+    }
+
+    // This thread is the owner, pushing every item and popping some of them back.
+    deque_steal_params* owner = &params[DEQUE_THIEF_COUNT];
+    for (u32 i = 0; i < DEQUE_ITEM_COUNT; ++i) {
+        while (!work_stealing_deque_push(&deque, &i)) {
+            kthread_yield();
+        }
+        u32 item;
+        if ((i % 3) == 0 && work_stealing_deque_pop(&deque, &item)) {
+            deque_take(owner, item);
+        }
+    }
+    u32 item;
+    while (work_stealing_deque_pop(&deque, &item)) {
+        deque_take(owner, item);
+    }
+    while (katomic_load_u32(&finished_count) < DEQUE_THIEF_COUNT) {
+        kthread_sleep(0, 1);
+    }
+
+    // Every item was taken exactly once.
+    for (u32 i = 0; i < DEQUE_THIEF_COUNT + 1; ++i) {
+        expect_to_be_false(params[i].duplicate);
+    }
+    u32 missing = 0;
+    for (u32 i = 0; i < DEQUE_ITEM_COUNT; ++i) {
+        missing += taken[i] != 1;
+    }
+    expect_should_be(0, missing);
+    expect_should_be(DEQUE_ITEM_COUNT, taken_count);
+
+    kfree((void*)taken, sizeof(u32) * DEQUE_ITEM_COUNT, MEMORY_TAG_ARRAY);
+    work_stealing_deque_destroy(&deque);
+    memory_system_shutdown();
+    return true;
+}
+
+void work_stealing_deque_register_tests() {
+    test_manager_register_test(work_stealing_deque_should_create_and_destroy, "Work-stealing deque should create and destroy.");
+    test_manager_register_test(work_stealing_deque_should_pop_newest_and_steal_oldest, "Work-stealing deque should pop newest and steal oldest.");
+    test_manager_register_test(work_stealing_deque_should_hand_out_each_item_once, "Work-stealing deque should hand out each item once.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void work_stealing_deque_register_tests();
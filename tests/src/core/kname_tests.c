@@ -0,0 +1,176 @@
+#include "kname_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kname.h>
+#include <core/khash.h>
+#include <core/kmemory.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+#include <core/kstring.h>
+
+// Large enough that names span several pages.
+#define KNAME_TEST_COUNT 10000
+
+static void* start_systems() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    if (!memory_system_initialize(config)) {
+        return 0;
+    }
+    u64 requirement = 0;
+    kname_system_initialize(&requirement, 0);
+    void* state = kallocate(requirement, MEMORY_TAG_STRING);
+    if (!kname_system_initialize(&requirement, state)) {
+        return 0;
+    }
+    return state;
+}
+
+static void stop_systems(void* state) {
+    u64 requirement = 0;
+    kname_system_initialize(&requirement, 0);
+    kname_system_shutdown(state);
+    kfree(state, requirement, MEMORY_TAG_STRING);
+    memory_system_shutdown();
+}
+
+u8 kname_should_intern_strings() {
+    void* state = start_systems();
+    expect_should_not_be(0, state);
+
+    kname a = kname_create("Texture.Rock");
+    kname b = kname_create("Texture.Rock");
+    kname c = kname_create("texture.rock");
+    expect_should_not_be(INVALID_KNAME, a);
+    // The same text always gives the same name, and names are case-sensitive.
+    expect_should_be(a, b);
+    expect_should_not_be(a, c);
+    expect_should_be(2, kname_count());
+
+    // The text is a copy, with its hash computed up front.
+    char buffer[32];
+    string_copy(buffer, "Texture.Rock");
+    expect_to_be_true(kname_string_get(a) != buffer);
+    expect_to_be_true(strings_equal("Texture.Rock", kname_string_get(a)));
+    expect_should_be(khash_string("Texture.Rock"), kname_hash_get(a));
+
+    // Invalid names.
+    expect_should_be(INVALID_KNAME, kname_create(0));
+    expect_should_be(INVALID_KNAME, kname_create(""));
+    expect_should_be(0, kname_string_get(INVALID_KNAME));
+    expect_should_be(0, kname_string_get(12345));
+
+    stop_systems(state);
+
+    // Names are not available once the system is shut down.
+    expect_should_be(INVALID_KNAME, kname_create("Texture.Rock"));
+    return true;
+}
+
+u8 kname_find_should_not_intern() {
+    void* state = start_systems();
+    expect_should_not_be(0, state);
+
+    // Unknown text is not given a name by looking it up.
+    expect_should_be(INVALID_KNAME, kname_find("View.Missing"));
+    expect_should_be(0, kname_count());
+
+    kname a = kname_create("View.World");
+    expect_should_be(a, kname_find("View.World"));
+    expect_should_be(INVALID_KNAME, kname_find("view.world"));
+    expect_should_be(INVALID_KNAME, kname_find(0));
+    expect_should_be(INVALID_KNAME, kname_find(""));
+    expect_should_be(1, kname_count());
+
+    stop_systems(state);
+    expect_should_be(INVALID_KNAME, kname_find("View.World"));
+    return true;
+}
+
+u8 kname_should_keep_many_names_stable() {
+    void* state = start_systems();
+    expect_should_not_be(0, state);
+
+    kname* names = kallocate(sizeof(kname) * KNAME_TEST_COUNT, MEMORY_TAG_ARRAY);
+    char text[64];
+    for (u32 i = 0; i < KNAME_TEST_COUNT; ++i) {
+        string_format(text, "Material.Generated.%u", i);
+        names[i] = kname_create(text);
+        expect_should_not_be(INVALID_KNAME, names[i]);
+    }
+    expect_should_be(KNAME_TEST_COUNT, kname_count());
+
+    // Text obtained early remains valid as more names are added.
+    const char* first = kname_string_get(names[0]);
+    for (u32 i = 0; i < KNAME_TEST_COUNT; ++i) {
+        string_format(text, "Material.Generated.%u", i);
+        expect_should_be(names[i], kname_create(text));
+        expect_to_be_true(strings_equal(text, kname_string_get(names[i])));
+    }
+    expect_should_be(first, kname_string_get(names[0]));
+    expect_should_be(KNAME_TEST_COUNT, kname_count());
+
+    kfree(names, sizeof(kname) * KNAME_TEST_COUNT, MEMORY_TAG_ARRAY);
+    stop_systems(state);
+    return true;
+}
+
+#define KNAME_THREAD_COUNT 4
+#define KNAME_THREAD_NAME_COUNT 2000
+
+typedef struct kname_worker_params {
+    kname* names;
+    volatile u32* finished_count;
+} kname_worker_params;
+
+static u32 kname_worker_run(void* params) {
+    kname_worker_params* p = params;
+    char text[64];
+    // Every thread interns the same names, racing one another.
+    for (u32 i = 0; i < KNAME_THREAD_NAME_COUNT; ++i) {
+        string_format(text, "Shader.Uniform.%u", i);
+        p->names[i] = kname_create(text);
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+u8 kname_should_intern_across_threads() {
+    void* state = start_systems();
+    expect_should_not_be(0, state);
+
+    volatile u32 finished_count = 0;
+    kname_worker_params params[KNAME_THREAD_COUNT];
+    kthread threads[KNAME_THREAD_COUNT];
+    for (u32 i = 0; i < KNAME_THREAD_COUNT; ++i) {
+        params[i].names = kallocate(sizeof(kname) * KNAME_THREAD_NAME_COUNT, MEMORY_TAG_ARRAY);
+        params[i].finished_count = &finished_count;
+        kthread_create(kname_worker_run, &params[i], true, &threads[i]);
+    }
+    while (katomic_load_u32(&finished_count) < KNAME_THREAD_COUNT) {
+        kthread_sleep(0, 1);
+    }
+
+    // All threads were given the same name for the same text, and each name once only.
+    expect_should_be(KNAME_THREAD_NAME_COUNT, kname_count());
+    for (u32 i = 0; i < KNAME_THREAD_NAME_COUNT; ++i) {
+        for (u32 t = 1; t < KNAME_THREAD_COUNT; ++t) {
+            expect_should_be(params[0].names[i], params[t].names[i]);
+        }
+    }
+
+    for (u32 i = 0; i < KNAME_THREAD_COUNT; ++i) {
+        kfree(params[i].names, sizeof(kname) * KNAME_THREAD_NAME_COUNT, MEMORY_TAG_ARRAY);
+    }
+    stop_systems(state);
+    return true;
+}
+
+void kname_register_tests() {
+    test_manager_register_test(kname_should_intern_strings, "kname should intern strings.");
+    test_manager_register_test(kname_find_should_not_intern, "kname_find should not intern unknown strings.");
+    test_manager_register_test(kname_should_keep_many_names_stable, "kname should keep many names stable.");
+    test_manager_register_test(kname_should_intern_across_threads, "kname should intern the same names across threads.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void kname_register_tests();
@@ -0,0 +1,69 @@
+#include "ksemaphore_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/ksemaphore.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+
+#define SEMAPHORE_SIGNALLER_COUNT 2
+#define SEMAPHORE_SIGNALS_PER_THREAD 10000
+#define SEMAPHORE_MAX_COUNT 4
+
+typedef struct semaphore_signaller_params {
+    ksemaphore* semaphore;
+    volatile u32* go;
+    volatile u32* succeeded_count;
+    volatile u32* finished_count;
+} semaphore_signaller_params;
+
+static u32 semaphore_signaller_run(void* params) {
+    semaphore_signaller_params* p = params;
+    // Start together, so the signals actually contend.
+    while (!katomic_load_u32(p->go)) {
+        kthread_yield();
+    }
+    for (u32 i = 0; i < SEMAPHORE_SIGNALS_PER_THREAD; ++i) {
+        if (ksemaphore_signal(p->semaphore)) {
+            katomic_fetch_add_u32(p->succeeded_count, 1);
+        }
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+u8 ksemaphore_should_not_exceed_max_count() {
+    ksemaphore semaphore;
+    expect_to_be_true(ksemaphore_create(&semaphore, SEMAPHORE_MAX_COUNT, 0));
+
+    volatile u32 go = 0;
+    volatile u32 succeeded_count = 0;
+    volatile u32 finished_count = 0;
+    semaphore_signaller_params params = {&semaphore, &go, &succeeded_count, &finished_count};
+    kthread threads[SEMAPHORE_SIGNALLER_COUNT];
+    for (u32 i = 0; i < SEMAPHORE_SIGNALLER_COUNT; ++i) {
+        expect_to_be_true(kthread_create(semaphore_signaller_run, &params, true, &threads[i]));
+    }
+    katomic_store_u32(&go, 1);
+    while (katomic_load_u32(&finished_count) != SEMAPHORE_SIGNALLER_COUNT) {
+        kthread_yield();
+    }
+
+    // However the signals interleaved, only max_count of them may have been taken.
+    expect_should_be(SEMAPHORE_MAX_COUNT, katomic_load_u32(&succeeded_count));
+    for (u32 i = 0; i < SEMAPHORE_MAX_COUNT; ++i) {
+        expect_to_be_true(ksemaphore_wait(&semaphore));
+    }
+
+    // Waiting frees up the count again.
+    expect_to_be_true(ksemaphore_signal(&semaphore));
+    expect_to_be_true(ksemaphore_wait(&semaphore));
+
+    ksemaphore_destroy(&semaphore);
+    return true;
+}
+
+void ksemaphore_register_tests() {
+    test_manager_register_test(ksemaphore_should_not_exceed_max_count, "Semaphore should not exceed its max count when signalled from several threads.");
+}
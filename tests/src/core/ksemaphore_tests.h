@@ -0,0 +1,3 @@
+#pragma once
+
+void ksemaphore_register_tests();
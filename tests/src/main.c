@@ -1,25 +1,76 @@
 #include "test_manager.h"
 
 #include "memory/linear_allocator_tests.h"
+#include "memory/kmemory_tests.h"
+#include "memory/dynamic_allocator_tests.h"
+#include "memory/scratch_allocator_tests.h"
+#include "memory/pool_allocator_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/u64_map_tests.h"
+#include "containers/mpmc_queue_tests.h"
+#include "containers/spsc_queue_tests.h"
+#include "containers/sort_tests.h"
+#include "containers/darray_tests.h"
+#include "containers/typed_container_tests.h"
+#include "containers/slot_map_tests.h"
+#include "containers/binary_heap_tests.h"
+#include "containers/work_stealing_deque_tests.h"
+#include "containers/mpsc_queue_tests.h"
+#include "core/kname_tests.h"
+#include "core/ksemaphore_tests.h"
 #include "containers/free_test.h"
+#include "resources/mesh_loader_tests.h"
+#include "systems/job_system_tests.h"
 
 #include <core/logger.h>
+#include <core/kstring.h>
+
+int main(int argc, char** argv) {
+    // Benchmarks are slow and noisy, so are only run when asked for, instead of the tests.
+    b8 run_benchmarks = false;
+    for (i32 i = 1; i < argc; ++i) {
+        if (strings_equal(argv[i], "--benchmarks")) {
+            run_benchmarks = true;
+        }
+    }
+
 
-int main() {
     // Always initalize the test manager first.
     test_manager_init();
 
     // TODO: add test registrations here.
     linear_allocator_register_tests();
     hashtable_register_tests();
+    u64_map_register_tests();
+    mpmc_queue_register_tests();
+    spsc_queue_register_tests();
+    sort_register_tests();
+    darray_register_tests();
+    typed_container_register_tests();
+    slot_map_register_tests();
+    binary_heap_register_tests();
+    work_stealing_deque_register_tests();
+    mpsc_queue_register_tests();
+    kname_register_tests();
+    ksemaphore_register_tests();
     freelist_register_tests();
+    kmemory_register_tests();
+    dynamic_allocator_register_tests();
+    scratch_allocator_register_tests();
+    pool_allocator_register_tests();
+    mesh_loader_register_tests();
+    job_system_register_tests();
 
 
-    KDEBUG("Starting tests...");
+    if (run_benchmarks) {
+        KDEBUG("Starting benchmarks...");
+        test_manager_run_benchmarks();
+    } else {
+        KDEBUG("Starting tests...");
 
-    // Execute tests
-    test_manager_run_tests();
+        // Execute tests
+        test_manager_run_tests();
+    }
 
     return 0;
 }
\ No newline at end of file
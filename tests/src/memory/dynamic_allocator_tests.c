@@ -0,0 +1,95 @@
+#include "dynamic_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/dynamic_allocator.h>
+
+u8 dynamic_allocator_should_serve_small_blocks_from_slabs() {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    u64 total_size = MEBIBYTES(4);
+    expect_to_be_true(dynamic_allocator_create(total_size, &memory_requirement, 0, 0));
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(dynamic_allocator_create(total_size, &memory_requirement, memory, &alloc));
+
+    // Fill more than one slab of the 32-byte class.
+    const u32 count = 4000;
+    void** blocks = kallocate(sizeof(void*) * count, MEMORY_TAG_APPLICATION);
+    for (u32 i = 0; i < count; ++i) {
+        blocks[i] = dynamic_allocator_allocate(&alloc, 20 + (i % 12));
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, ((u64)blocks[i]) % DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT);
+
+        u64 size = 0;
+        u16 alignment = 0;
+        expect_to_be_true(dynamic_allocator_get_size_alignment(&alloc, blocks[i], &size, &alignment));
+        expect_should_be(32, size);
+        expect_should_be(DYNAMIC_ALLOCATOR_SMALL_ALIGNMENT, alignment);
+    }
+
+    dynamic_allocator_slab_usage usage;
+    expect_to_be_true(dynamic_allocator_get_slab_usage(&alloc, dynamic_allocator_size_class_index(32), &usage));
+    expect_should_be(count, usage.used_blocks);
+    expect_should_be(2, usage.slab_count);
+
+    // Blocks must not overlap.
+    for (u32 i = 0; i < count; ++i) {
+        kset_memory(blocks[i], (i32)(i & 0xFF), 32);
+    }
+    for (u32 i = 0; i < count; ++i) {
+        expect_should_be((i & 0xFF), *(u8*)blocks[i]);
+        expect_to_be_true(dynamic_allocator_free(&alloc, blocks[i], 32));
+    }
+
+    // Empty slabs are released from the class.
+    expect_to_be_true(dynamic_allocator_get_slab_usage(&alloc, dynamic_allocator_size_class_index(32), &usage));
+    expect_should_be(0, usage.used_blocks);
+    expect_should_be(0, usage.slab_count);
+    expect_should_be(total_size, dynamic_allocator_free_space(&alloc));
+
+    kfree(blocks, sizeof(void*) * count, MEMORY_TAG_APPLICATION);
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_should_serve_large_blocks_from_freelist() {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    u64 total_size = MEBIBYTES(4);
+    expect_to_be_true(dynamic_allocator_create(total_size, &memory_requirement, 0, 0));
+    void* memory = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(dynamic_allocator_create(total_size, &memory_requirement, memory, &alloc));
+
+    void* block = dynamic_allocator_allocate_aligned(&alloc, 1000, 64);
+    expect_should_not_be(0, block);
+    expect_should_be(0, ((u64)block) % 64);
+    u64 size = 0;
+    u16 alignment = 0;
+    expect_to_be_true(dynamic_allocator_get_size_alignment(&alloc, block, &size, &alignment));
+    expect_should_be(1000, size);
+    expect_should_be(64, alignment);
+
+    // Small sizes with a stricter alignment than slabs can satisfy also go to the freelist.
+    void* aligned_small = dynamic_allocator_allocate_aligned(&alloc, 32, 128);
+    expect_should_be(0, ((u64)aligned_small) % 128);
+    expect_to_be_true(dynamic_allocator_get_size_alignment(&alloc, aligned_small, &size, &alignment));
+    expect_should_be(32, size);
+    expect_should_be(128, alignment);
+
+    expect_to_be_true(dynamic_allocator_free_aligned(&alloc, aligned_small));
+    expect_to_be_true(dynamic_allocator_free_aligned(&alloc, block));
+    expect_should_be(total_size, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void dynamic_allocator_register_tests() {
+    test_manager_register_test(dynamic_allocator_should_serve_small_blocks_from_slabs, "Dynamic allocator serves small blocks from size-class slabs.");
+    test_manager_register_test(dynamic_allocator_should_serve_large_blocks_from_freelist, "Dynamic allocator serves large or strictly aligned blocks from the freelist.");
+}
@@ -0,0 +1,410 @@
+#include "kmemory_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+#include <core/clock.h>
+#include <core/kstring.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>
+#if KPLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+typedef struct alloc_worker_params {
+    u32 iterations;
+    b8 use_cache;
+    // Blocks handed to the main thread to be freed there.
+    void** out_blocks;
+    u32 out_block_count;
+    volatile u32* finished_count;
+} alloc_worker_params;
+
+static u32 alloc_worker_run(void* params) {
+    alloc_worker_params* p = params;
+    if (p->use_cache) {
+        kmemory_thread_cache_initialize();
+    }
+
+    // Keep a handful of blocks live at once, like a loader building up small structures.
+    void* live[16] = {0};
+    u64 sizes[16] = {0};
+    for (u32 i = 0; i < p->iterations; ++i) {
+        u32 slot = i % 16;
+        if (live[slot]) {
+            kfree(live[slot], sizes[slot], MEMORY_TAG_JOB);
+        }
+        sizes[slot] = 8 + ((i * 37) % 248);
+        live[slot] = kallocate(sizes[slot], MEMORY_TAG_JOB);
+        *(u8*)live[slot] = (u8)i;
+    }
+    for (u32 i = 0; i < 16; ++i) {
+        if (live[i]) {
+            kfree(live[i], sizes[i], MEMORY_TAG_JOB);
+        }
+    }
+
+    for (u32 i = 0; i < p->out_block_count; ++i) {
+        p->out_blocks[i] = kallocate(48, MEMORY_TAG_JOB);
+    }
+
+    if (p->use_cache) {
+        kmemory_thread_cache_shutdown();
+    }
+    katomic_fetch_add_u32(p->finished_count, 1);
+    return 1;
+}
+
+static void wait_for_workers(volatile u32* finished_count, u32 thread_count) {
+    while (katomic_load_u32(finished_count) < thread_count) {
+        kthread_sleep(0, 1);
+    }
+}
+
+u8 kmemory_thread_cache_should_balance_across_threads() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(32);
+    expect_to_be_true(memory_system_initialize(config));
+    u64 base_count = get_memory_alloc_count();
+
+    // Blocks allocated on a caching worker thread are freed on this (non-caching) thread.
+    void* blocks[64] = {0};
+    volatile u32 finished_count = 0;
+    alloc_worker_params params = {};
+    params.iterations = 1000;
+    params.use_cache = true;
+    params.out_blocks = blocks;
+    params.out_block_count = 64;
+    params.finished_count = &finished_count;
+    kthread thread;
+    expect_to_be_true(kthread_create(alloc_worker_run, &params, true, &thread));
+    wait_for_workers(&finished_count, 1);
+
+    expect_should_be(base_count + 64, get_memory_alloc_count());
+    for (u32 i = 0; i < 64; ++i) {
+        expect_should_not_be(0, blocks[i]);
+        u64 size = 0;
+        u16 alignment = 0;
+        expect_to_be_true(kmemory_get_size_alignment(blocks[i], &size, &alignment));
+        // Small blocks report their size class.
+        expect_should_be(64, size);
+        kfree(blocks[i], 48, MEMORY_TAG_JOB);
+    }
+    expect_should_be(base_count, get_memory_alloc_count());
+
+    memory_system_shutdown();
+    return true;
+}
+
+static f64 run_alloc_benchmark(u32 thread_count, u32 iterations, b8 use_cache) {
+    volatile u32 finished_count = 0;
+    alloc_worker_params params[16];
+    kthread threads[16];
+
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < thread_count; ++i) {
+        params[i] = (alloc_worker_params){iterations, use_cache, 0, 0, &finished_count};
+        kthread_create(alloc_worker_run, &params[i], true, &threads[i]);
+    }
+    wait_for_workers(&finished_count, thread_count);
+    clock_update(&c);
+    return c.elapsed;
+}
+
+u8 kmemory_thread_cache_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 iterations = 200000;
+    u32 thread_counts[4] = {1, 2, 4, 8};
+    for (u32 i = 0; i < 4; ++i) {
+        u32 count = thread_counts[i];
+        f64 locked = run_alloc_benchmark(count, iterations, false);
+        f64 cached = run_alloc_benchmark(count, iterations, true);
+        f64 ops = (f64)count * iterations * 2;
+        KINFO("kallocate/kfree, %u thread(s): global lock %.2f Mops/s, thread caches %.2f Mops/s",
+              count, ops / locked / 1000000.0, ops / cached / 1000000.0);
+    }
+
+    memory_system_shutdown();
+    return true;
+}
+
+// Obtains the resident set size of the process in bytes, or 0 if unknown.
+static u64 get_resident_bytes() {
+#if KPLATFORM_LINUX
+    u64 total_pages = 0;
+    u64 resident_pages = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    i32 read = fscanf(f, "%llu %llu", &total_pages, &resident_pages);
+    fclose(f);
+    return read == 2 ? resident_pages * sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+u8 kmemory_startup_should_commit_lazily() {
+    if (!get_resident_bytes()) {
+        KWARN("Resident memory size is not available on this platform. Skipping test.");
+        return BYPASS;
+    }
+
+    // Same size as the application uses.
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(256);
+
+    u64 rss_before = get_resident_bytes();
+    clock c;
+    clock_start(&c);
+    expect_to_be_true(memory_system_initialize(config));
+    clock_update(&c);
+    u64 rss_startup = get_resident_bytes();
+
+    // A large block is committed once used, and handed back to the OS once freed.
+    const u64 large_size = MEBIBYTES(64);
+    u8* large = kallocate(large_size, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, large);
+    large[large_size - 1] = 1;
+    u64 rss_allocated = get_resident_bytes();
+    kfree(large, large_size, MEMORY_TAG_ARRAY);
+    u64 rss_freed = get_resident_bytes();
+
+    KINFO("Memory system startup (%llu MiB heap): %.3f ms, RSS +%llu KiB. 64 MiB block: RSS +%llu KiB when used, %llu KiB after free.",
+          config.total_alloc_size / MEBIBYTES(1), c.elapsed * 1000.0, (rss_startup - rss_before) / 1024,
+          (rss_allocated - rss_startup) / 1024, rss_freed > rss_startup ? (rss_freed - rss_startup) / 1024 : 0);
+
+    // Nowhere near the whole heap is touched at startup, and the block's pages are released.
+    expect_to_be_true(rss_startup - rss_before < MEBIBYTES(64));
+    expect_to_be_true(rss_allocated - rss_freed > large_size / 2);
+
+    // A block reused after being decommitted reads as zero.
+    u8* again = kallocate(large_size, MEMORY_TAG_ARRAY);
+    expect_should_be(0, again[large_size - 1]);
+    kfree(again, large_size, MEMORY_TAG_ARRAY);
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 kmemory_heap_should_grow_and_release_chunks() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(4);
+    expect_to_be_true(memory_system_initialize(config));
+    expect_should_be(1, get_memory_chunk_count());
+
+    // Allocating well beyond the initial size adds chunks.
+    const u64 block_size = MEBIBYTES(1);
+    const u32 block_count = 16;
+    u8* blocks[16];
+    for (u32 i = 0; i < block_count; ++i) {
+        blocks[i] = kallocate(block_size, MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, blocks[i]);
+        blocks[i][0] = (u8)i;
+        blocks[i][block_size - 1] = (u8)i;
+    }
+    u32 grown_chunk_count = get_memory_chunk_count();
+    expect_to_be_true(grown_chunk_count > 1);
+
+    // A block larger than a whole chunk is given a chunk of its own.
+    const u64 huge_size = MEBIBYTES(32);
+    u8* huge = kallocate(huge_size, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, huge);
+    huge[huge_size - 1] = 1;
+    expect_should_be(grown_chunk_count + 1, get_memory_chunk_count());
+
+    // Such a chunk is sized to fit just its block, not twice over, so another big block gets
+    // a chunk of its own as well. Its alignment padding is accounted for.
+    const u64 exact_size = MEBIBYTES(32) - KIBIBYTES(1);
+    u8* exact = kallocate_aligned(exact_size, 256, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, exact);
+    expect_should_be(0, (u64)exact % 256);
+    exact[exact_size - 1] = 1;
+    expect_should_be(grown_chunk_count + 2, get_memory_chunk_count());
+    kfree_aligned(exact, exact_size, 256, MEMORY_TAG_ARRAY);
+    expect_should_be(grown_chunk_count + 1, get_memory_chunk_count());
+
+    // Blocks are routed back to the chunks they came from.
+    u64 size = 0;
+    u16 alignment = 0;
+    for (u32 i = 0; i < block_count; ++i) {
+        expect_to_be_true(kmemory_get_size_alignment(blocks[i], &size, &alignment));
+        expect_should_be(block_size, size);
+        expect_should_be(i, blocks[i][0]);
+        expect_should_be(i, blocks[i][block_size - 1]);
+    }
+
+    // Empty chunks are released, leaving only the initial one.
+    kfree(huge, huge_size, MEMORY_TAG_ARRAY);
+    expect_should_be(grown_chunk_count, get_memory_chunk_count());
+    for (u32 i = 0; i < block_count; ++i) {
+        kfree(blocks[i], block_size, MEMORY_TAG_ARRAY);
+    }
+    expect_should_be(1, get_memory_chunk_count());
+    expect_should_be(0, get_memory_alloc_count());
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 kallocate_flags_should_be_honoured() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Untracked blocks are left out of the stats.
+    u64 alloc_count = get_memory_alloc_count();
+    void* untracked = kallocate_with_flags(4096, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNTRACKED);
+    expect_should_not_be(0, untracked);
+    expect_should_be(alloc_count, get_memory_alloc_count());
+
+    // The cache line hint raises the alignment.
+    u8* aligned = kallocate_with_flags(100, 4, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_CACHE_ALIGNED);
+    expect_should_be(0, (u64)aligned % KALLOCATE_CACHE_LINE_SIZE);
+    expect_should_be(alloc_count + 1, get_memory_alloc_count());
+
+    // Uninitialized blocks keep whatever was there before.
+    const u64 size = KIBIBYTES(64);
+    u8* dirty = kallocate_with_flags(size, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNINITIALIZED);
+    kset_memory(dirty, 0xAB, size);
+    kfree(dirty, size, MEMORY_TAG_ARRAY);
+    u8* reused = kallocate_with_flags(size, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNINITIALIZED);
+    expect_should_be(dirty, reused);
+    expect_should_be(0xAB, reused[size / 2]);
+    kfree(reused, size, MEMORY_TAG_ARRAY);
+
+    // While zeroed ones are cleared.
+    u8* zeroed = kallocate(size, MEMORY_TAG_ARRAY);
+    expect_should_be(dirty, zeroed);
+    expect_should_be(0, zeroed[size / 2]);
+    kfree(zeroed, size, MEMORY_TAG_ARRAY);
+
+    kfree_with_flags(aligned, 100, 4, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_CACHE_ALIGNED);
+    kfree_with_flags(untracked, 0, 1, MEMORY_TAG_ARRAY, KALLOCATE_FLAG_UNTRACKED);
+    expect_should_be(alloc_count, get_memory_alloc_count());
+
+    memory_system_shutdown();
+    return true;
+}
+
+static f64 run_copy_benchmark(const u8* source, u64 size, u32 iterations, kallocate_flag_bits flags) {
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < iterations; ++i) {
+        u8* block = kallocate_with_flags(size, 1, MEMORY_TAG_ARRAY, flags);
+        kcopy_memory(block, source, size);
+        kfree_with_flags(block, size, 1, MEMORY_TAG_ARRAY, flags);
+    }
+    clock_update(&c);
+    return c.elapsed;
+}
+
+u8 kallocate_uninitialized_benchmark() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Below the size at which freed pages are handed back to the OS, so the same
+    // committed block is reused each time and only the allocator's writes are measured.
+    const u64 size = KIBIBYTES(768);
+    const u32 iterations = 4000;
+    u8* source = kallocate(size, MEMORY_TAG_ARRAY);
+    kset_memory(source, 0x5A, size);
+
+    // Warm up the block first.
+    run_copy_benchmark(source, size, 10, KALLOCATE_FLAG_ZEROED);
+    f64 zeroed = run_copy_benchmark(source, size, iterations, KALLOCATE_FLAG_ZEROED);
+    f64 uninitialized = run_copy_benchmark(source, size, iterations, KALLOCATE_FLAG_UNINITIALIZED);
+
+    f64 gib = (f64)size * iterations / (f64)GIBIBYTES(1);
+    KINFO("Allocate and copy %llu KiB: zeroed %.2f us/op (%.2f GiB/s), uninitialized %.2f us/op (%.2f GiB/s).",
+          size / 1024, zeroed * 1000000.0 / iterations, gib / zeroed,
+          uninitialized * 1000000.0 / iterations, gib / uninitialized);
+
+    kfree(source, size, MEMORY_TAG_ARRAY);
+    memory_system_shutdown();
+    return true;
+}
+
+#if KMEMORY_TRACE_ENABLED == 1
+static b8 ends_with(const char* str, const char* suffix) {
+    u64 length = string_length(str);
+    u64 suffix_length = string_length(suffix);
+    return length >= suffix_length && strings_equal(str + length - suffix_length, suffix);
+}
+#endif
+
+u8 kmemory_trace_should_record_callsites() {
+#if KMEMORY_TRACE_ENABLED == 1
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Nothing is recorded until the trace is started.
+    void* before = kallocate(64, MEMORY_TAG_ARRAY);
+    expect_to_be_true(kmemory_trace_start());
+    kmemory_trace_frame_mark();
+    u32 alloc_line = __LINE__ + 1;
+    void* block = kallocate(128, MEMORY_TAG_ARRAY);
+    u32 free_line = __LINE__ + 1;
+    kfree(block, 128, MEMORY_TAG_ARRAY);
+    kmemory_trace_stop();
+    kfree(before, 64, MEMORY_TAG_ARRAY);
+
+    const char* path = "kmemory_trace_test.csv";
+    expect_to_be_true(kmemory_trace_write(path));
+
+    file_handle f;
+    expect_to_be_true(filesystem_open(path, FILE_MODE_READ, false, &f));
+    char line_buf[1024] = "";
+    char* p = &line_buf[0];
+    u64 line_length = 0;
+    u32 line_count = 0;
+    // Each line ends with the size, tag and callsite of the event.
+    char alloc_suffix[512];
+    char free_suffix[512];
+    string_format(alloc_suffix, ",128,ARRAY,%u,%s", alloc_line, __FILE__);
+    string_format(free_suffix, ",128,ARRAY,%u,%s", free_line, __FILE__);
+    b8 found_alloc = false;
+    b8 found_free = false;
+    while (filesystem_read_line(&f, 1023, &p, &line_length)) {
+        line_count++;
+        char* trimmed = string_trim(line_buf);
+        found_alloc |= ends_with(trimmed, alloc_suffix);
+        found_free |= ends_with(trimmed, free_suffix);
+    }
+    filesystem_close(&f);
+    remove(path);
+
+    // The header, then one allocation and one free.
+    expect_should_be(3, line_count);
+    expect_to_be_true(found_alloc);
+    expect_to_be_true(found_free);
+
+    memory_system_shutdown();
+    return true;
+#else
+    KWARN("Memory tracing is not enabled in this build. Skipping test.");
+    return BYPASS;
+#endif
+}
+
+void kmemory_register_tests() {
+    test_manager_register_test(kmemory_thread_cache_should_balance_across_threads, "Thread cache allocations freed on another thread keep stats balanced.");
+    test_manager_register_benchmark(kmemory_thread_cache_benchmark, "Benchmark kallocate throughput with and without thread caches.");
+    test_manager_register_test(kmemory_startup_should_commit_lazily, "Memory system commits its heap lazily and releases large freed blocks.");
+    test_manager_register_test(kmemory_heap_should_grow_and_release_chunks, "Memory system heap grows in chunks and releases them once empty.");
+    test_manager_register_test(kallocate_flags_should_be_honoured, "kallocate_with_flags honours the uninitialized, untracked and cache aligned flags.");
+    test_manager_register_benchmark(kallocate_uninitialized_benchmark, "Benchmark allocate and copy with and without zeroing.");
+    test_manager_register_test(kmemory_trace_should_record_callsites, "Memory tracing records the callsites of allocations and frees.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void kmemory_register_tests();
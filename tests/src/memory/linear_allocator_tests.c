@@ -4,6 +4,7 @@
 
 #include <defines.h>
 
+#include <core/kmemory.h>
 #include <memory/linear_allocator.h>
 
 u8 linear_allocator_should_create_and_destroy() {
@@ -108,10 +109,94 @@ u8 linear_allocator_multi_allocation_all_space_then_free() {
     return true;
 }
 
+u8 linear_allocator_free_to_nested_markers() {
+    linear_allocator alloc;
+    linear_allocator_create(1024, 0, &alloc);
+
+    linear_allocator_allocate(&alloc, 16);
+    linear_allocator_marker outer = linear_allocator_get_marker(&alloc);
+    u8* a = linear_allocator_allocate(&alloc, 32);
+    a[0] = 0xFF;
+
+    linear_allocator_marker inner = linear_allocator_get_marker(&alloc);
+    linear_allocator_allocate(&alloc, 64);
+    expect_should_be(112, alloc.allocated);
+
+    // Freeing the inner scope keeps the outer scope's allocations.
+    linear_allocator_free_to_marker(&alloc, inner);
+    expect_should_be(48, alloc.allocated);
+    expect_should_be(0xFF, a[0]);
+
+    // Freeing the outer scope zeroes what it held, and the space is reused.
+    linear_allocator_free_to_marker(&alloc, outer);
+    expect_should_be(16, alloc.allocated);
+    expect_should_be(0, a[0]);
+    expect_should_be(a, linear_allocator_allocate(&alloc, 32));
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_aligned_allocation() {
+    linear_allocator alloc;
+    linear_allocator_create(1024, 0, &alloc);
+
+    // Misalign the next allocation.
+    linear_allocator_allocate(&alloc, 1);
+
+    void* block = linear_allocator_allocate_aligned(&alloc, 64, 64);
+    expect_should_not_be(0, block);
+    expect_should_be(0, (u64)block % 64);
+    expect_should_be((u64)block + 64, (u64)alloc.memory + alloc.allocated);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_overflow_until_free_all() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(4);
+    expect_to_be_true(memory_system_initialize(config));
+
+    linear_allocator alloc;
+    linear_allocator_create(256, 0, &alloc);
+    alloc.allow_overflow = true;
+
+    void* inside = linear_allocator_allocate(&alloc, 200);
+    expect_should_not_be(0, inside);
+
+    // Neither fits in what is left, so both come from the memory system.
+    u64 alloc_count = get_memory_alloc_count();
+    u8* overflow = linear_allocator_allocate(&alloc, 100);
+    expect_should_not_be(0, overflow);
+    expect_should_be(0, overflow[0]);
+    expect_should_be(0, overflow[99]);
+    u8* aligned = linear_allocator_allocate_aligned(&alloc, 1024, 256);
+    expect_should_not_be(0, aligned);
+    expect_should_be(0, (u64)aligned % 256);
+    expect_should_be(alloc_count + 2, get_memory_alloc_count());
+    expect_should_be(200, alloc.allocated);
+    expect_should_be(1124, alloc.overflow_allocated);
+
+    linear_allocator_free_all(&alloc);
+    expect_should_be(alloc_count, get_memory_alloc_count());
+    expect_should_be(0, alloc.overflow_allocated);
+    expect_should_be(0, alloc.overflow_blocks);
+
+    linear_allocator_destroy(&alloc);
+    memory_system_shutdown();
+    return true;
+}
+
 void linear_allocator_register_tests() {
     test_manager_register_test(linear_allocator_should_create_and_destroy, "Linear allocator should create and destroy");
     test_manager_register_test(linear_allocator_single_allocation_all_space, "Linear allocator single alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_all_space, "Linear allocator multi alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_over_allocate, "Linear allocator try over allocate");
     test_manager_register_test(linear_allocator_multi_allocation_all_space_then_free, "Linear allocator allocated should be 0 after free_all");
+    test_manager_register_test(linear_allocator_free_to_nested_markers, "Linear allocator frees nested scopes back to their markers");
+    test_manager_register_test(linear_allocator_aligned_allocation, "Linear allocator aligned allocation is aligned");
+    test_manager_register_test(linear_allocator_overflow_until_free_all, "Linear allocator overflows to the memory system until free_all");
 }
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "pool_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <memory/pool_allocator.h>
+
+typedef struct pool_test_element {
+    u32 id;
+    u32 value;
+    u64 payload[6];
+} pool_test_element;
+
+u8 pool_allocator_should_create_and_destroy() {
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    expect_to_be_true(pool_allocator_create(sizeof(pool_test_element), 16, &memory_requirement, 0, 0));
+    expect_to_be_true(memory_requirement >= sizeof(pool_test_element) * 16);
+
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(pool_allocator_create(sizeof(pool_test_element), 16, &memory_requirement, block, &pool));
+    expect_should_not_be(0, pool.memory);
+    expect_should_be(16, pool_allocator_capacity(&pool));
+    expect_should_be(0, pool_allocator_live_count(&pool));
+
+    pool_allocator_destroy(&pool);
+    expect_should_be(0, pool.memory);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    // Elements too small to hold a free list link are rejected.
+    KDEBUG("The following error messages are intentional.");
+    expect_should_be(false, pool_allocator_create(2, 16, &memory_requirement, 0, 0));
+    expect_should_be(false, pool_allocator_create(sizeof(pool_test_element), 0, &memory_requirement, 0, 0));
+    expect_should_be(false, pool_allocator_create(sizeof(pool_test_element), POOL_ALLOCATOR_MAX_ELEMENT_COUNT + 1, &memory_requirement, 0, 0));
+    return true;
+}
+
+u8 pool_allocator_handles_should_go_stale_on_free() {
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(pool_test_element), 4, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(pool_test_element), 4, &memory_requirement, block, &pool);
+
+    u32 handle = INVALID_ID;
+    pool_test_element* e = pool_allocator_allocate(&pool, &handle);
+    expect_should_not_be(0, e);
+    expect_should_not_be(INVALID_ID, handle);
+    expect_should_be(0, pool_handle_index(handle));
+    expect_should_be(0, (u64)e % POOL_ALLOCATOR_ALIGNMENT);
+    expect_should_be(e, pool_allocator_get(&pool, handle));
+    expect_should_be(e, pool_allocator_get_by_index(&pool, 0));
+    expect_should_be(handle, pool_allocator_handle_at(&pool, 0));
+    e->value = 42;
+    e->payload[5] = 0xFFFF;
+
+    expect_to_be_true(pool_allocator_free(&pool, handle));
+    expect_should_be(0, pool_allocator_live_count(&pool));
+    expect_should_be(0, pool_allocator_get(&pool, handle));
+    expect_should_be(0, pool_allocator_get_by_index(&pool, 0));
+    expect_should_be(INVALID_ID, pool_allocator_handle_at(&pool, 0));
+
+    KDEBUG("The following error message is intentional.");
+    expect_should_be(false, pool_allocator_free(&pool, handle));
+
+    // The slot is reused, zeroed, under a new handle which the old one does not match.
+    u32 new_handle = INVALID_ID;
+    pool_test_element* reused = pool_allocator_allocate(&pool, &new_handle);
+    expect_should_be(e, reused);
+    expect_should_not_be(handle, new_handle);
+    expect_should_be(0, reused->value);
+    expect_should_be(0, reused->payload[5]);
+    expect_should_be(0, pool_allocator_get(&pool, handle));
+    expect_should_be(reused, pool_allocator_get(&pool, new_handle));
+
+    pool_allocator_destroy(&pool);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 pool_allocator_should_reject_free_slots() {
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(pool_test_element), 8, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(pool_test_element), 8, &memory_requirement, block, &pool);
+
+    // A never-acquired slot has generation 0, so its bare index looks like a handle to it.
+    expect_should_be(0, pool_allocator_get(&pool, 5));
+    KDEBUG("The following error messages are intentional.");
+    expect_should_be(false, pool_allocator_free(&pool, 5));
+    expect_should_be(0, pool_allocator_live_count(&pool));
+
+    // Nor is a handle built from a freed slot's (even) generation accepted.
+    u32 handle = INVALID_ID;
+    pool_allocator_allocate(&pool, &handle);
+    pool_allocator_free(&pool, handle);
+    u32 forged = ((u32)(pool_handle_generation(handle) + 1) << POOL_HANDLE_INDEX_BITS) | pool_handle_index(handle);
+    expect_should_be(0, pool_allocator_get(&pool, forged));
+    expect_should_be(false, pool_allocator_free(&pool, forged));
+
+    // Every slot is still handed out exactly once.
+    pool_test_element* seen[8] = {0};
+    for (u32 i = 0; i < 8; ++i) {
+        u32 h = INVALID_ID;
+        seen[i] = pool_allocator_allocate(&pool, &h);
+        expect_should_not_be(0, seen[i]);
+        for (u32 j = 0; j < i; ++j) {
+            expect_should_not_be(seen[j], seen[i]);
+        }
+    }
+    u32 extra = INVALID_ID;
+    expect_should_be(0, pool_allocator_allocate(&pool, &extra));
+
+    pool_allocator_destroy(&pool);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 pool_allocator_should_fill_and_free_all() {
+    const u32 count = 64;
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(u32), count, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(u32), count, &memory_requirement, block, &pool);
+
+    u32 handles[64];
+    for (u32 i = 0; i < count; ++i) {
+        u32* e = pool_allocator_allocate(&pool, &handles[i]);
+        expect_should_not_be(0, e);
+        expect_should_be(i, pool_handle_index(handles[i]));
+        *e = i;
+    }
+    expect_should_be(count, pool_allocator_live_count(&pool));
+
+    // Full.
+    u32 handle = 0;
+    expect_should_be(0, pool_allocator_allocate(&pool, &handle));
+    expect_should_be(INVALID_ID, handle);
+
+    for (u32 i = 0; i < count; ++i) {
+        u32* e = pool_allocator_get(&pool, handles[i]);
+        expect_should_not_be(0, e);
+        expect_should_be(i, *e);
+    }
+
+    // Freed slots are reused most recent first.
+    expect_to_be_true(pool_allocator_free(&pool, handles[10]));
+    expect_to_be_true(pool_allocator_free(&pool, handles[20]));
+    expect_should_not_be(0, pool_allocator_allocate(&pool, &handle));
+    expect_should_be(20, pool_handle_index(handle));
+    expect_should_not_be(0, pool_allocator_allocate(&pool, &handle));
+    expect_should_be(10, pool_handle_index(handle));
+
+    pool_allocator_free_all(&pool);
+    expect_should_be(0, pool_allocator_live_count(&pool));
+    for (u32 i = 0; i < count; ++i) {
+        expect_should_be(0, pool_allocator_get(&pool, handles[i]));
+    }
+    expect_should_be(0, pool_allocator_get(&pool, handle));
+
+    // Everything is available again.
+    for (u32 i = 0; i < count; ++i) {
+        expect_should_not_be(0, pool_allocator_allocate(&pool, &handle));
+    }
+    expect_should_be(count, pool_allocator_live_count(&pool));
+
+    pool_allocator_destroy(&pool);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+static u64 bench_random(u64* state) {
+    // xorshift64, so runs are repeatable.
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+u8 pool_allocator_acquire_release_benchmark() {
+    // Mirrors the texture system: up to 65536 entries, kept mostly full, with
+    // random releases and acquires. Compared against scanning for a free id.
+    const u32 capacity = 65536;
+    const u32 live_target = 60000;
+    const u32 op_count = 20000;
+
+    pool_allocator pool;
+    u64 memory_requirement = 0;
+    pool_allocator_create(sizeof(pool_test_element), capacity, &memory_requirement, 0, 0);
+    void* block = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    pool_allocator_create(sizeof(pool_test_element), capacity, &memory_requirement, block, &pool);
+    pool_test_element* scan_array = kallocate(sizeof(pool_test_element) * capacity, MEMORY_TAG_APPLICATION);
+    u32* handles = kallocate(sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+
+    for (u32 i = 0; i < capacity; ++i) {
+        scan_array[i].id = i < live_target ? i : INVALID_ID;
+    }
+    for (u32 i = 0; i < live_target; ++i) {
+        pool_allocator_allocate(&pool, &handles[i]);
+    }
+
+    u64 rng = 0x2545F4914F6CDD1DULL;
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 index = bench_random(&rng) % live_target;
+        scan_array[index].id = INVALID_ID;
+        for (u32 j = 0; j < capacity; ++j) {
+            if (scan_array[j].id == INVALID_ID) {
+                scan_array[j].id = j;
+                break;
+            }
+        }
+    }
+    clock_update(&c);
+    f64 scan_elapsed = c.elapsed;
+
+    rng = 0x2545F4914F6CDD1DULL;
+    clock_start(&c);
+    for (u32 i = 0; i < op_count; ++i) {
+        u32 index = bench_random(&rng) % live_target;
+        pool_allocator_free(&pool, handles[index]);
+        pool_allocator_allocate(&pool, &handles[index]);
+    }
+    clock_update(&c);
+    f64 pool_elapsed = c.elapsed;
+
+    KINFO("Acquire/release of %u of %u slots: linear scan %.1f ns/op, pool %.1f ns/op.",
+          live_target, capacity, (scan_elapsed * 1000000000.0) / op_count, (pool_elapsed * 1000000000.0) / op_count);
+
+    expect_should_be(live_target, pool_allocator_live_count(&pool));
+    for (u32 i = 0; i < live_target; ++i) {
+        expect_should_not_be(0, pool_allocator_get(&pool, handles[i]));
+    }
+
+    kfree(handles, sizeof(u32) * capacity, MEMORY_TAG_APPLICATION);
+    kfree(scan_array, sizeof(pool_test_element) * capacity, MEMORY_TAG_APPLICATION);
+    pool_allocator_destroy(&pool);
+    kfree(block, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void pool_allocator_register_tests() {
+    test_manager_register_test(pool_allocator_should_create_and_destroy, "Pool allocator should create and destroy.");
+    test_manager_register_test(pool_allocator_handles_should_go_stale_on_free, "Pool allocator handles go stale once freed.");
+    test_manager_register_test(pool_allocator_should_reject_free_slots, "Pool allocator rejects handles to free slots.");
+    test_manager_register_test(pool_allocator_should_fill_and_free_all, "Pool allocator fills, reuses and frees all.");
+    test_manager_register_benchmark(pool_allocator_acquire_release_benchmark, "Pool allocator acquire/release benchmark.");
+}
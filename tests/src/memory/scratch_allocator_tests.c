@@ -0,0 +1,51 @@
+#include "scratch_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/scratch_allocator.h>
+
+u8 scratch_allocator_should_grow_and_reuse_chunks() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    scratch_marker outer = scratch_allocator_begin();
+    u8* small = scratch_allocator_allocate(128, 16);
+    expect_should_not_be(0, small);
+    expect_should_be(0, (u64)small % 16);
+    small[0] = 0xAB;
+
+    // Larger than the first chunk, so a new one must be added.
+    scratch_marker inner = scratch_allocator_begin();
+    u8* large = scratch_allocator_allocate(MEBIBYTES(3), 16);
+    expect_should_not_be(0, large);
+    large[MEBIBYTES(3) - 1] = 0xCD;
+    scratch_allocator_end(inner);
+
+    // The outer scope's memory is untouched by the inner one ending.
+    expect_should_be(0xAB, small[0]);
+
+    // Chunks are kept, so a repeat of the same pattern makes no new allocations.
+    u64 alloc_count = get_memory_total_alloc_count();
+    inner = scratch_allocator_begin();
+    u8* large_again = scratch_allocator_allocate(MEBIBYTES(3), 16);
+    expect_should_be(large, large_again);
+    expect_should_be(0, large_again[MEBIBYTES(3) - 1]);
+    scratch_allocator_end(inner);
+    expect_should_be(alloc_count, get_memory_total_alloc_count());
+
+    scratch_allocator_end(outer);
+
+    scratch_allocator_thread_shutdown();
+    expect_should_be(0, get_memory_alloc_count());
+    memory_system_shutdown();
+
+    return true;
+}
+
+void scratch_allocator_register_tests() {
+    test_manager_register_test(scratch_allocator_should_grow_and_reuse_chunks, "Scratch allocator grows into new chunks and reuses them.");
+}
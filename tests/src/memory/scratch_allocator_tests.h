@@ -0,0 +1,3 @@
+#pragma once
+
+void scratch_allocator_register_tests();
@@ -0,0 +1,82 @@
+#include "mesh_loader_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <core/clock.h>
+#include <memory/scratch_allocator.h>
+#include <platform/filesystem.h>
+#include <systems/resource_system.h>
+
+#include <stdio.h>  // remove
+
+// Tests run from the bin folder, same as the testbed.
+#define BENCH_ASSET_BASE_PATH "../assets"
+#define BENCH_MESH_NAME "falcon"
+#define BENCH_OBJ_PATH BENCH_ASSET_BASE_PATH "/models/" BENCH_MESH_NAME ".obj"
+#define BENCH_KSM_PATH BENCH_ASSET_BASE_PATH "/models/" BENCH_MESH_NAME ".ksm"
+
+u8 mesh_loader_obj_import_benchmark() {
+    if (!filesystem_exists(BENCH_OBJ_PATH)) {
+        KWARN("mesh_loader_obj_import_benchmark - '%s' not found, skipping.", BENCH_OBJ_PATH);
+        return BYPASS;
+    }
+
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(512);
+    expect_to_be_true(memory_system_initialize(config));
+
+    resource_system_config resource_config;
+    resource_config.asset_base_path = BENCH_ASSET_BASE_PATH;
+    resource_config.max_loader_count = 32;
+    u64 resource_state_size = 0;
+    resource_system_initialize(&resource_state_size, 0, resource_config);
+    void* resource_state = kallocate(resource_state_size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(resource_system_initialize(&resource_state_size, resource_state, resource_config));
+
+    // The loader prefers the binary version once one exists, so remove it before
+    // each run to force an import. It is left behind only if it was there already.
+    b8 had_ksm = filesystem_exists(BENCH_KSM_PATH);
+
+    const u32 iterations = 10;
+    u32 geometry_count = 0;
+    u64 alloc_count = 0;
+    clock c;
+    f64 elapsed = 0;
+    for (u32 i = 0; i < iterations; ++i) {
+        remove(BENCH_KSM_PATH);
+
+        u64 start_alloc_count = get_memory_total_alloc_count();
+        clock_start(&c);
+        resource mesh_resource;
+        b8 result = resource_system_load(BENCH_MESH_NAME, RESOURCE_TYPE_MESH, 0, &mesh_resource);
+        clock_update(&c);
+        elapsed += c.elapsed;
+        alloc_count += get_memory_total_alloc_count() - start_alloc_count;
+
+        expect_to_be_true(result);
+        geometry_count = mesh_resource.data_size;
+        resource_system_unload(&mesh_resource);
+    }
+    expect_should_not_be(0, geometry_count);
+
+    if (!had_ksm) {
+        remove(BENCH_KSM_PATH);
+    }
+
+    KINFO("OBJ import of '%s' (%u geometries): %.3f ms avg over %u runs, %llu allocations per import.",
+          BENCH_MESH_NAME, geometry_count, (elapsed / iterations) * 1000.0, iterations, alloc_count / iterations);
+
+    resource_system_shutdown(resource_state);
+    kfree(resource_state, resource_state_size, MEMORY_TAG_APPLICATION);
+    scratch_allocator_thread_shutdown();
+    memory_system_shutdown();
+    return true;
+}
+
+void mesh_loader_register_tests() {
+    test_manager_register_benchmark(mesh_loader_obj_import_benchmark, "Benchmark importing an OBJ mesh through the resource system.");
+}
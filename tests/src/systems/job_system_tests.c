@@ -0,0 +1,578 @@
+#include "job_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/clock.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+#include <core/kmemory.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+
+#define JOB_TEST_THREAD_COUNT 2
+// The frame time the main thread is simulated at.
+#define JOB_TEST_FRAME_MS 16
+// How long to wait for jobs before failing, in frames.
+#define JOB_TEST_MAX_FRAMES 1000
+
+typedef struct job_test_params {
+    volatile u32* counter;
+    u32 index;
+    f64 submit_time;
+    f64* start_times;
+} job_test_params;
+
+static volatile u32 callback_count = 0;
+
+static void* start_job_system_with(u8 thread_count, u32* type_masks) {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    if (!memory_system_initialize(config)) {
+        return 0;
+    }
+    u64 requirement = 0;
+    job_system_initialize(&requirement, 0, 0, 0);
+    void* state = kallocate(requirement, MEMORY_TAG_JOB);
+    if (!job_system_initialize(&requirement, state, thread_count, type_masks)) {
+        return 0;
+    }
+    return state;
+}
+
+static void* start_job_system() {
+    // Mirrors the application's layout on a machine with few cores.
+    u32 type_masks[JOB_TEST_THREAD_COUNT] = {JOB_TYPE_GENERAL | JOB_TYPE_GPU_RESOURCE, JOB_TYPE_GENERAL | JOB_TYPE_RESOURCE_LOAD};
+    return start_job_system_with(JOB_TEST_THREAD_COUNT, type_masks);
+}
+
+static void stop_job_system(void* state) {
+    u64 requirement = 0;
+    job_system_initialize(&requirement, 0, 0, 0);
+    job_system_shutdown(state);
+    kfree(state, requirement, MEMORY_TAG_JOB);
+    memory_system_shutdown();
+}
+
+static b8 counting_job_start(void* params, void* result_data) {
+    job_test_params* p = params;
+    katomic_fetch_add_u32(p->counter, 1);
+    return true;
+}
+
+static b8 timed_job_start(void* params, void* result_data) {
+    job_test_params* p = params;
+    p->start_times[p->index] = platform_get_absolute_time();
+    katomic_fetch_add_u32(p->counter, 1);
+    return true;
+}
+
+static void counting_job_success(void* result_data) {
+    callback_count++;
+}
+
+// Runs frames on the main thread until the counter reaches count, or too many frames pass.
+static b8 update_until(volatile u32* counter, u32 count, u32 frame_ms) {
+    for (u32 frame = 0; frame < JOB_TEST_MAX_FRAMES; ++frame) {
+        if (katomic_load_u32(counter) >= count) {
+            return true;
+        }
+        platform_sleep(frame_ms);
+        job_system_update();
+    }
+    return false;
+}
+
+u8 job_system_should_run_all_jobs() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    const u32 per_kind = 50;
+    volatile u32 counter = 0;
+    callback_count = 0;
+    job_type types[3] = {JOB_TYPE_GENERAL, JOB_TYPE_RESOURCE_LOAD, JOB_TYPE_GPU_RESOURCE};
+    job_priority priorities[3] = {JOB_PRIORITY_LOW, JOB_PRIORITY_NORMAL, JOB_PRIORITY_HIGH};
+    for (u32 t = 0; t < 3; ++t) {
+        for (u32 p = 0; p < 3; ++p) {
+            for (u32 i = 0; i < per_kind; ++i) {
+                job_test_params params = {&counter, i, 0, 0};
+                job_info job = job_create_priority(counting_job_start, counting_job_success, 0, &params, sizeof(job_test_params), 0, types[t], priorities[p]);
+                job_system_submit(job);
+            }
+        }
+    }
+
+    u32 total = per_kind * 9;
+    expect_to_be_true(update_until(&counter, total, 1));
+    // Success callbacks are run on the main thread by job_system_update.
+    for (u32 frame = 0; frame < JOB_TEST_MAX_FRAMES && callback_count < total; ++frame) {
+        platform_sleep(1);
+        job_system_update();
+    }
+    expect_should_be(total, counter);
+    expect_should_be(total, callback_count);
+
+    stop_job_system(state);
+    return true;
+}
+
+u8 job_system_latency_benchmark() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    // One job submitted each frame, as when textures are requested one at a time.
+    const u32 single_count = 20;
+    f64 start_times[64];
+    volatile u32 counter = 0;
+    f64 total_latency = 0;
+    f64 max_latency = 0;
+    for (u32 i = 0; i < single_count; ++i) {
+        job_test_params params = {&counter, i, platform_get_absolute_time(), start_times};
+        job_system_submit(job_create(timed_job_start, 0, 0, &params, sizeof(job_test_params), 0));
+        expect_to_be_true(update_until(&counter, i + 1, JOB_TEST_FRAME_MS));
+        f64 latency = start_times[i] - params.submit_time;
+        total_latency += latency;
+        max_latency = latency > max_latency ? latency : max_latency;
+    }
+
+    // A burst of jobs at once, as when a scene's meshes are all requested together.
+    const u32 burst_count = 64;
+    counter = 0;
+    f64 burst_submit_time = platform_get_absolute_time();
+    for (u32 i = 0; i < burst_count; ++i) {
+        job_test_params params = {&counter, i, burst_submit_time, start_times};
+        job_system_submit(job_create(timed_job_start, 0, 0, &params, sizeof(job_test_params), 0));
+    }
+    expect_to_be_true(update_until(&counter, burst_count, JOB_TEST_FRAME_MS));
+    f64 burst_last_start = 0;
+    for (u32 i = 0; i < burst_count; ++i) {
+        burst_last_start = start_times[i] > burst_last_start ? start_times[i] : burst_last_start;
+    }
+
+    KINFO("Job submit-to-start latency at %u ms frames: average %.3f ms, max %.3f ms. Burst of %u jobs all started after %.3f ms.",
+          JOB_TEST_FRAME_MS, total_latency * 1000.0 / single_count, max_latency * 1000.0, burst_count, (burst_last_start - burst_submit_time) * 1000.0);
+
+    stop_job_system(state);
+    return true;
+}
+
+u8 job_system_should_wait_on_counter() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    const u32 count = 200;
+    volatile u32 counter = 0;
+    job_counter jobs = {0};
+    for (u32 i = 0; i < count; ++i) {
+        job_test_params params = {&counter, i, 0, 0};
+        job_info job = job_create(counting_job_start, 0, 0, &params, sizeof(job_test_params), 0);
+        job.counter = &jobs;
+        job_system_submit(job);
+    }
+    // The main thread helps with the jobs while it waits.
+    job_wait(&jobs);
+    expect_should_be(0, jobs.remaining);
+    expect_should_be(count, counter);
+
+    stop_job_system(state);
+    return true;
+}
+
+typedef struct dependency_test_params {
+    volatile u32* counter;
+    // Where to record the counter when the job starts.
+    u32* out_seen;
+    u32 child_count;
+} dependency_test_params;
+
+static b8 recording_job_start(void* params, void* result_data) {
+    dependency_test_params* p = params;
+    *p->out_seen = katomic_load_u32(p->counter);
+    katomic_fetch_add_u32(p->counter, 1);
+    return true;
+}
+
+// Splits into children and waits for them from the job thread, as a loader splitting its work would.
+static b8 splitting_job_start(void* params, void* result_data) {
+    dependency_test_params* p = params;
+    job_counter children = {0};
+    for (u32 i = 0; i < p->child_count; ++i) {
+        job_test_params child = {p->counter, i, 0, 0};
+        job_info job = job_create(counting_job_start, 0, 0, &child, sizeof(job_test_params), 0);
+        job.counter = &children;
+        job_system_submit(job);
+    }
+    job_wait(&children);
+    return katomic_load_u32(&children.remaining) == 0;
+}
+
+u8 job_system_should_run_dependents_after_dependencies() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    // Several jobs which each split into children, then one which must see all of their work.
+    const u32 parent_count = 6;
+    const u32 child_count = 20;
+    volatile u32 counter = 0;
+    job_counter parents = {0};
+    for (u32 i = 0; i < parent_count; ++i) {
+        dependency_test_params params = {&counter, 0, child_count};
+        job_info job = job_create(splitting_job_start, 0, 0, &params, sizeof(dependency_test_params), 0);
+        job.counter = &parents;
+        job_system_submit(job);
+    }
+
+    u32 seen_by_first = INVALID_ID;
+    u32 seen_by_second = INVALID_ID;
+    job_counter first = {0};
+    job_counter second = {0};
+    dependency_test_params params = {&counter, &seen_by_first, 0};
+    job_info first_job = job_create(recording_job_start, 0, 0, &params, sizeof(dependency_test_params), 0);
+    first_job.counter = &first;
+    first_job.dependency = &parents;
+
+    job_system_submit(first_job);
+
+    // Depends on a job which is itself still held back.
+    params.out_seen = &seen_by_second;
+    job_info second_job = job_create(recording_job_start, 0, 0, &params, sizeof(dependency_test_params), 0);
+    second_job.counter = &second;
+    second_job.dependency = &first;
+    job_system_submit(second_job);
+
+    job_wait(&second);
+    u32 total = parent_count * child_count;
+    expect_should_be(total, seen_by_first);
+    expect_should_be(total + 1, seen_by_second);
+    expect_should_be(total + 2, counter);
+    expect_should_be(0, parents.remaining);
+    expect_should_be(0, first.remaining);
+
+    stop_job_system(state);
+    return true;
+}
+
+u8 job_system_should_run_jobs_inline_when_not_running() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+
+    // Without the job system, jobs run as they are submitted, callbacks included.
+    volatile u32 counter = 0;
+    callback_count = 0;
+    job_counter jobs = {0};
+    job_test_params params = {&counter, 0, 0, 0};
+    job_info job = job_create(counting_job_start, counting_job_success, 0, &params, sizeof(job_test_params), 0);
+    job.counter = &jobs;
+    job_system_submit(job);
+    expect_should_be(1, counter);
+    expect_should_be(1, callback_count);
+    expect_should_be(0, jobs.remaining);
+    job_wait(&jobs);
+
+    memory_system_shutdown();
+    return true;
+}
+
+// A small amount of work per job, so that scheduling dominates.
+static b8 small_job_start(void* params, void* result_data) {
+    job_test_params* p = params;
+    u32 x = p->index;
+    for (u32 i = 0; i < 200; ++i) {
+        x = x * 1664525u + 1013904223u;
+    }
+    p->start_times[0] = (f64)x;
+    katomic_fetch_add_u32(p->counter, 1);
+    return true;
+}
+
+// Fans out into child jobs from the job thread, as a job splitting its work would.
+static b8 spawning_job_start(void* params, void* result_data) {
+    job_test_params* p = params;
+    for (u32 i = 0; i < p->index; ++i) {
+        job_test_params child = {p->counter, i, 0, p->start_times};
+        job_system_submit(job_create(small_job_start, 0, 0, &child, sizeof(job_test_params), 0));
+    }
+    katomic_fetch_add_u32(p->counter, 1);
+    return true;
+}
+
+u8 job_system_throughput_benchmark() {
+    const u32 rounds = 8;
+    const u32 root_count = 32;
+    const u32 child_count = 24;
+    const u32 per_round = root_count * (child_count + 1);
+    u8 thread_counts[3] = {1, 2, 4};
+    u32 type_masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    f64 sink = 0;
+
+    for (u32 c = 0; c < 3; ++c) {
+        void* state = start_job_system_with(thread_counts[c], type_masks);
+        expect_should_not_be(0, state);
+
+        volatile u32 counter = 0;
+        clock timer;
+        clock_start(&timer);
+        for (u32 round = 0; round < rounds; ++round) {
+            u32 target = per_round * (round + 1);
+            for (u32 i = 0; i < root_count; ++i) {
+                job_test_params params = {&counter, child_count, 0, &sink};
+                job_system_submit(job_create(spawning_job_start, 0, 0, &params, sizeof(job_test_params), 0));
+            }
+            // Spin rather than sleep, so the time measured is the job system's alone.
+            u64 spins = 0;
+            while (katomic_load_u32(&counter) < target && spins < 100000000) {
+                job_system_update();
+                kthread_yield();
+                spins++;
+            }
+            u32 done = katomic_load_u32(&counter);
+            expect_should_be(target, done);
+        }
+        clock_update(&timer);
+
+        u32 total = per_round * rounds;
+        KINFO("Job throughput with %u thread(s): %u small jobs in %.3f ms (%.0f ns/job).",
+              thread_counts[c], total, timer.elapsed * 1000.0, timer.elapsed * 1000000000.0 / total);
+        stop_job_system(state);
+    }
+    return true;
+}
+
+static void mark_range(u32 begin, u32 end, void* context) {
+    u8* visits = context;
+    for (u32 i = begin; i < end; ++i) {
+        visits[i]++;
+    }
+}
+
+static void sum_range(u32 begin, u32 end, void* context, void* partial) {
+    u64 sum = *(u64*)partial;
+    for (u32 i = begin; i < end; ++i) {
+        sum += i;
+    }
+    *(u64*)partial = sum;
+}
+
+static void sum_combine(void* a, const void* b, void* context) {
+    *(u64*)a += *(const u64*)b;
+}
+
+// Runs the range checks, with or without the job system running.
+static b8 check_parallel_ranges() {
+    const u32 count = 100003;
+    u8* visits = kallocate(count, MEMORY_TAG_ARRAY);
+    u32 grains[4] = {0, 1, 7, 4096};
+    for (u32 g = 0; g < 4; ++g) {
+        kzero_memory(visits, count);
+        job_parallel_for(count, grains[g], mark_range, visits);
+        u32 wrong = 0;
+        for (u32 i = 0; i < count; ++i) {
+            wrong += visits[i] != 1;
+        }
+        expect_should_be(0, wrong);
+
+        u64 identity = 0;
+        u64 sum = 1;
+        job_parallel_reduce(count, grains[g], sizeof(u64), &identity, sum_range, sum_combine, 0, &sum);
+        u64 expected = (u64)count * (count - 1) / 2;
+        expect_should_be(expected, sum);
+    }
+
+    // An empty range does nothing, and reduces to the identity.
+    job_parallel_for(0, 0, mark_range, visits);
+    u64 identity = 42;
+    u64 sum = 0;
+    job_parallel_reduce(0, 0, sizeof(u64), &identity, sum_range, sum_combine, 0, &sum);
+    expect_should_be(42, sum);
+
+    kfree(visits, count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 job_parallel_for_should_cover_range_once() {
+    memory_system_configuration config = {};
+    config.total_alloc_size = MEBIBYTES(16);
+    expect_to_be_true(memory_system_initialize(config));
+    // Without the job system, the calling thread runs every chunk.
+    expect_to_be_true(check_parallel_ranges());
+    memory_system_shutdown();
+
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+    expect_to_be_true(check_parallel_ranges());
+    stop_job_system(state);
+    return true;
+}
+
+typedef struct parallel_bench_data {
+    f32* in;
+    f32* out;
+} parallel_bench_data;
+
+KINLINE f32 bench_transform(f32 x) {
+    return x * x * 0.5f + x * 3.0f - 1.0f;
+}
+
+static void transform_range(u32 begin, u32 end, void* context) {
+    parallel_bench_data* data = context;
+    for (u32 i = begin; i < end; ++i) {
+        data->out[i] = bench_transform(data->in[i]);
+    }
+}
+
+static void sum_f32_range(u32 begin, u32 end, void* context, void* partial) {
+    parallel_bench_data* data = context;
+    f64 sum = *(f64*)partial;
+    for (u32 i = begin; i < end; ++i) {
+        sum += data->in[i];
+    }
+    *(f64*)partial = sum;
+}
+
+static void sum_f64_combine(void* a, const void* b, void* context) {
+    *(f64*)a += *(const f64*)b;
+}
+
+u8 job_parallel_for_benchmark() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    const u32 count = 1 << 20;
+    const u32 passes = 20;
+    parallel_bench_data data;
+    data.in = kallocate(sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    data.out = kallocate(sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < count; ++i) {
+        data.in[i] = (f32)(i % 1000) * 0.001f;
+    }
+
+    clock c;
+    clock_start(&c);
+    f64 serial_sum = 0;
+    for (u32 pass = 0; pass < passes; ++pass) {
+        for (u32 i = 0; i < count; ++i) {
+            data.out[i] = bench_transform(data.in[i]);
+        }
+    }
+    clock_update(&c);
+    f64 serial_for = c.elapsed;
+    clock_start(&c);
+    for (u32 pass = 0; pass < passes; ++pass) {
+        serial_sum = 0;
+        for (u32 i = 0; i < count; ++i) {
+            serial_sum += data.in[i];
+        }
+    }
+    clock_update(&c);
+    f64 serial_reduce = c.elapsed;
+    KINFO("Serial loops over %u floats: transform %.3f ms, sum %.3f ms.", count, serial_for * 1000.0 / passes, serial_reduce * 1000.0 / passes);
+
+    u32 grains[5] = {0, 256, 4096, 65536, 262144};
+    for (u32 g = 0; g < 5; ++g) {
+        clock_start(&c);
+        for (u32 pass = 0; pass < passes; ++pass) {
+            job_parallel_for(count, grains[g], transform_range, &data);
+        }
+        clock_update(&c);
+        f64 parallel_for = c.elapsed;
+
+        f64 identity = 0;
+        f64 sum = 0;
+        clock_start(&c);
+        for (u32 pass = 0; pass < passes; ++pass) {
+            job_parallel_reduce(count, grains[g], sizeof(f64), &identity, sum_f32_range, sum_f64_combine, &data, &sum);
+        }
+        clock_update(&c);
+        f64 parallel_reduce = c.elapsed;
+        // Chunks sum in a different order, so only expect it to be close.
+        expect_float_to_be(serial_sum, sum);
+
+        KINFO("Parallel loops with %u threads, grain %u: transform %.3f ms, sum %.3f ms.",
+              JOB_TEST_THREAD_COUNT, grains[g], parallel_for * 1000.0 / passes, parallel_reduce * 1000.0 / passes);
+    }
+
+    kfree(data.out, sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    kfree(data.in, sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    stop_job_system(state);
+    return true;
+}
+
+static volatile u64 result_sum = 0;
+
+static b8 result_job_start(void* params, void* result_data) {
+    job_test_params* p = params;
+    *(u32*)result_data = p->index;
+    return true;
+}
+
+static void result_job_success(void* result_data) {
+    result_sum += *(u32*)result_data;
+    callback_count++;
+}
+
+u8 job_system_should_deliver_every_result() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    // More results than ever used to fit, all left for a single update to process.
+    const u32 batch_count = 8;
+    const u32 batch_size = 500;
+    callback_count = 0;
+    result_sum = 0;
+    for (u32 b = 0; b < batch_count; ++b) {
+        job_counter counter = {0};
+        for (u32 i = 0; i < batch_size; ++i) {
+            job_test_params params = {0, b * batch_size + i, 0, 0};
+            job_info job = job_create(result_job_start, result_job_success, 0, &params, sizeof(job_test_params), sizeof(u32));
+            job.counter = &counter;
+            job_system_submit(job);
+        }
+        job_wait(&counter);
+    }
+    expect_should_be(0, callback_count);
+
+    job_system_update();
+    u32 total = batch_count * batch_size;
+    expect_should_be(total, callback_count);
+    u64 expected_sum = (u64)total * (total - 1) / 2;
+    expect_should_be(expected_sum, result_sum);
+
+    // Nothing is left over for the next update.
+    job_system_update();
+    expect_should_be(total, callback_count);
+
+    stop_job_system(state);
+    return true;
+}
+
+u8 job_system_idle_update_benchmark() {
+    void* state = start_job_system();
+    expect_should_not_be(0, state);
+
+    // The cost of an update on a frame where no jobs have finished.
+    const u32 updates = 100000;
+    clock c;
+    clock_start(&c);
+    for (u32 i = 0; i < updates; ++i) {
+        job_system_update();
+    }
+    clock_update(&c);
+    KINFO("Idle job_system_update: %.1f ns per update.", c.elapsed * 1000000000.0 / updates);
+
+    stop_job_system(state);
+    return true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(job_system_should_run_all_jobs, "Job system should run all jobs and callbacks.");
+    test_manager_register_test(job_system_should_wait_on_counter, "Job system should wait on a job counter.");
+    test_manager_register_test(job_system_should_run_dependents_after_dependencies, "Job system should run dependent jobs after their dependencies.");
+    test_manager_register_test(job_system_should_run_jobs_inline_when_not_running, "Job system should run jobs inline when not running.");
+    test_manager_register_test(job_system_should_deliver_every_result, "Job system should deliver every result.");
+    test_manager_register_test(job_parallel_for_should_cover_range_once, "Job parallel for and reduce should cover the range once.");
+    test_manager_register_benchmark(job_system_latency_benchmark, "Job system latency benchmark.");
+    test_manager_register_benchmark(job_system_throughput_benchmark, "Job system throughput benchmark.");
+    test_manager_register_benchmark(job_parallel_for_benchmark, "Job parallel for benchmark.");
+    test_manager_register_benchmark(job_system_idle_update_benchmark, "Job system idle update benchmark.");
+}
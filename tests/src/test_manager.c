@@ -11,9 +11,11 @@ typedef struct test_entry {
 } test_entry;
 
 static test_entry* tests;
+static test_entry* benchmarks;
 
 void test_manager_init() {
     tests = darray_create(test_entry);
+    benchmarks = darray_create(test_entry);
 }
 
 void test_manager_register_test(u8 (*PFN_test)(), char* desc) {
@@ -23,12 +25,19 @@ void test_manager_register_test(u8 (*PFN_test)(), char* desc) {
     darray_push(tests, e);
 }
 
-void test_manager_run_tests() {
+void test_manager_register_benchmark(u8 (*PFN_test)(), char* desc) {
+    test_entry e;
+    e.func = PFN_test;
+    e.desc = desc;
+    darray_push(benchmarks, e);
+}
+
+static void run_entries(test_entry* entries) {
     u32 passed = 0;
     u32 failed = 0;
     u32 skipped = 0;
 
-    u32 count = darray_length(tests);
+    u32 count = darray_length(entries);
 
     clock total_time;
     clock_start(&total_time);
@@ -36,16 +45,16 @@ void test_manager_run_tests() {
     for (u32 i = 0; i < count; ++i) {
         clock test_time;
         clock_start(&test_time);
-        u8 result = tests[i].func();
+        u8 result = entries[i].func();
         clock_update(&test_time);
 
         if (result == true) {
             ++passed;
         } else if (result == BYPASS) {
-            KWARN("[SKIPPED]: %s", tests[i].desc);
+            KWARN("[SKIPPED]: %s", entries[i].desc);
             ++skipped;
         } else {
-            KERROR("[FAILED]: %s", tests[i].desc);
+            KERROR("[FAILED]: %s", entries[i].desc);
             ++failed;
         }
         char status[20];
@@ -57,4 +66,12 @@ void test_manager_run_tests() {
     clock_stop(&total_time);
 
     KINFO("Results: %d passed, %d failed, %d skipped.", passed, failed, skipped);
+}
+
+void test_manager_run_tests() {
+    run_entries(tests);
+}
+
+void test_manager_run_benchmarks() {
+    run_entries(benchmarks);
 }
\ No newline at end of file
@@ -10,4 +10,12 @@ void test_manager_init();
 
 void test_manager_register_test(PFN_test, char* desc);
 
-void test_manager_run_tests();
\ No newline at end of file
+/**
+ * Registers a timing run. These are kept out of the regular test run, and are only
+ * executed by test_manager_run_benchmarks (i.e. when tests is run with --benchmarks).
+ */
+void test_manager_register_benchmark(PFN_test, char* desc);
+
+void test_manager_run_tests();
+
+void test_manager_run_benchmarks();
\ No newline at end of file
@@ -1,12 +1,16 @@
 #include <defines.h>
 #include <core/logger.h>
 #include <core/kstring.h>
+#include <core/kmemory.h>
+#include <containers/darray.h>
+#include <platform/filesystem.h>
 
-// For executing shell commands.
+// For executing shell commands, and sorting.
 #include <stdlib.h>
 
 void print_help();
 i32 process_shaders(i32 argc, char** argv);
+i32 process_memory_trace(i32 argc, char** argv);
 
 i32 main(i32 argc, char** argv) {
     // The first arg is always the program itself.
@@ -19,6 +23,8 @@ i32 main(i32 argc, char** argv) {
     // The second argument tells us what mode to go into.
     if (strings_equali(argv[1], "buildshaders") || strings_equali(argv[1], "bshaders")) {
         return process_shaders(argc, argv);
+    } else if (strings_equali(argv[1], "memtrace")) {
+        return process_memory_trace(argc, argv);
     } else {
         KERROR("Unrecognized argument '%s'.", argv[1]);
         print_help();
@@ -83,6 +89,209 @@ i32 process_shaders(i32 argc, char** argv) {
     return 0;
 }
 
+/** @brief The totals for a single callsite in a memory trace. */
+typedef struct callsite_stats {
+    char* file;
+    u32 line;
+    u64 alloc_count;
+    u64 alloc_bytes;
+    u64 free_count;
+} callsite_stats;
+
+/** @brief Maps callsites to their stats using open addressing. */
+typedef struct callsite_table {
+    // Indices into stats plus one, or 0 for empty slots.
+    u32* slots;
+    u32 capacity;
+    // darray
+    callsite_stats* stats;
+} callsite_table;
+
+static u32 callsite_hash(const char* file, u32 line) {
+    u32 hash = 2166136261u;
+    for (const char* c = file; *c; ++c) {
+        hash = (hash ^ (u8)*c) * 16777619u;
+    }
+    return (hash ^ line) * 16777619u;
+}
+
+static void callsite_table_grow(callsite_table* table) {
+    u32 old_capacity = table->capacity;
+    u32* old_slots = table->slots;
+    table->capacity = old_capacity ? old_capacity * 2 : 1024;
+    table->slots = kallocate(sizeof(u32) * table->capacity, MEMORY_TAG_ARRAY);
+    u32 count = darray_length(table->stats);
+    for (u32 i = 0; i < count; ++i) {
+        u32 slot = callsite_hash(table->stats[i].file, table->stats[i].line) & (table->capacity - 1);
+        while (table->slots[slot]) {
+            slot = (slot + 1) & (table->capacity - 1);
+        }
+        table->slots[slot] = i + 1;
+    }
+    if (old_slots) {
+        kfree(old_slots, sizeof(u32) * old_capacity, MEMORY_TAG_ARRAY);
+    }
+}
+
+static callsite_stats* callsite_table_get(callsite_table* table, const char* file, u32 line) {
+    u32 slot = callsite_hash(file, line) & (table->capacity - 1);
+    while (table->slots[slot]) {
+        callsite_stats* stats = &table->stats[table->slots[slot] - 1];
+        if (stats->line == line && strings_equal(stats->file, file)) {
+            return stats;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    // First time this callsite is seen.
+    callsite_stats new_stats = {string_duplicate(file), line, 0, 0, 0};
+    darray_push(table->stats, new_stats);
+    u32 count = darray_length(table->stats);
+    table->slots[slot] = count;
+    if (count * 2 > table->capacity) {
+        callsite_table_grow(table);
+    }
+    return &table->stats[count - 1];
+}
+
+static i32 compare_callsites_by_count(const void* a, const void* b) {
+    u64 count_a = ((const callsite_stats*)a)->alloc_count;
+    u64 count_b = ((const callsite_stats*)b)->alloc_count;
+    return count_a < count_b ? 1 : (count_a > count_b ? -1 : 0);
+}
+
+// Splits a line of comma-separated values in place. The last field takes the rest of the line.
+static u32 split_fields(char* line, char** fields, u32 max_fields) {
+    u32 count = 0;
+    fields[count++] = line;
+    for (char* c = line; *c && count < max_fields; ++c) {
+        if (*c == ',') {
+            *c = 0;
+            fields[count++] = c + 1;
+        }
+    }
+    return count;
+}
+
+i32 process_memory_trace(i32 argc, char** argv) {
+    if (argc < 3) {
+        KERROR("Memory trace mode requires the path of a trace written by kmemory_trace_write.");
+        return -3;
+    }
+    u64 top_count = 20;
+    if (argc > 3 && !string_to_u64(argv[3], &top_count)) {
+        KERROR("Invalid callsite count '%s'.", argv[3]);
+        return -3;
+    }
+
+    memory_system_configuration memory_config = {};
+    memory_config.total_alloc_size = MEBIBYTES(64);
+    if (!memory_system_initialize(memory_config)) {
+        KERROR("Failed to initialize memory system.");
+        return -4;
+    }
+
+    file_handle f;
+    if (!filesystem_open(argv[2], FILE_MODE_READ, false, &f)) {
+        KERROR("Unable to open memory trace '%s'.", argv[2]);
+        memory_system_shutdown();
+        return -4;
+    }
+
+    callsite_table table = {};
+    table.stats = darray_create(callsite_stats);
+    callsite_table_grow(&table);
+    // The number of allocations made in each frame.
+    u64* frame_allocs = darray_create(u64);
+
+    char line_buf[2048] = "";
+    char* p = &line_buf[0];
+    u64 line_length = 0;
+    u64 line_number = 0;
+    u64 total_allocs = 0;
+    u64 total_bytes = 0;
+    u64 total_frees = 0;
+    u64 first_frame = INVALID_ID_U64;
+    u64 last_frame = 0;
+    while (filesystem_read_line(&f, 2047, &p, &line_length)) {
+        line_number++;
+        // Skip the header.
+        if (line_number == 1) {
+            continue;
+        }
+        char* trimmed = string_trim(line_buf);
+
+        // frame,time,thread,event,block,size,tag,line,file
+        char* fields[9];
+        if (split_fields(trimmed, fields, 9) != 9) {
+            KWARN("Skipping malformed line %llu of the trace.", line_number);
+            continue;
+        }
+        u64 frame = 0;
+        u64 size = 0;
+        u32 line = 0;
+        string_to_u64(fields[0], &frame);
+        string_to_u64(fields[5], &size);
+        string_to_u32(fields[7], &line);
+
+        callsite_stats* stats = callsite_table_get(&table, fields[8], line);
+        if (strings_equal(fields[3], "alloc")) {
+            stats->alloc_count++;
+            stats->alloc_bytes += size;
+            total_allocs++;
+            total_bytes += size;
+            while (darray_length(frame_allocs) <= frame) {
+                u64 zero = 0;
+                darray_push(frame_allocs, zero);
+            }
+            frame_allocs[frame]++;
+        } else {
+            stats->free_count++;
+            total_frees++;
+        }
+        first_frame = frame < first_frame ? frame : first_frame;
+        last_frame = frame > last_frame ? frame : last_frame;
+    }
+    filesystem_close(&f);
+
+    if (first_frame == INVALID_ID_U64) {
+        KWARN("The memory trace '%s' holds no events.", argv[2]);
+        first_frame = 0;
+    }
+    u64 frame_count = last_frame - first_frame + 1;
+    u64 peak_frame = 0;
+    for (u64 i = 0; i < darray_length(frame_allocs); ++i) {
+        if (frame_allocs[i] > frame_allocs[peak_frame]) {
+            peak_frame = i;
+        }
+    }
+    u64 peak_allocs = darray_length(frame_allocs) ? frame_allocs[peak_frame] : 0;
+    KINFO("%llu allocations (%llu bytes) and %llu frees over %llu frame(s). %.1f allocations per frame, peaking at %llu in frame %llu.",
+          total_allocs, total_bytes, total_frees, frame_count, (f64)total_allocs / frame_count, peak_allocs, peak_frame);
+
+    u32 callsite_count = darray_length(table.stats);
+    qsort(table.stats, callsite_count, sizeof(callsite_stats), compare_callsites_by_count);
+    KINFO("Top allocating callsites:");
+    KINFO("  allocs/frame    bytes/frame      allocs       frees  callsite");
+    for (u32 i = 0; i < callsite_count && i < top_count; ++i) {
+        callsite_stats* stats = &table.stats[i];
+        if (!stats->alloc_count) {
+            break;
+        }
+        KINFO("%14.2f %14.1f %11llu %11llu  %s:%u", (f64)stats->alloc_count / frame_count, (f64)stats->alloc_bytes / frame_count,
+              stats->alloc_count, stats->free_count, stats->file, stats->line);
+    }
+
+    for (u32 i = 0; i < callsite_count; ++i) {
+        string_free(table.stats[i].file);
+    }
+    kfree(table.slots, sizeof(u32) * table.capacity, MEMORY_TAG_ARRAY);
+    darray_destroy(table.stats);
+    darray_destroy(frame_allocs);
+    memory_system_shutdown();
+    return 0;
+}
+
 void print_help() {
 #ifdef KPLATFORM_WINDOWS
     const char* extension = ".exe";
@@ -99,6 +308,10 @@ void print_help() {
                     should be provided that all end in <stage>.glsl, where <stage> is\n\
                     replaced by one of the following supported stages:\n\
                         vert, frag, geom, comp\n\
-                    The compiled .spv file is output to the same path as the input file.\n",
-        extension);
+                    The compiled .spv file is output to the same path as the input file.\n\
+    memtrace     -  Summarizes a memory trace written by kmemory_trace_write, listing\n\
+                    the callsites making the most allocations per frame. For example:\n\
+                        tools%s memtrace memory_trace.csv [count]\n\
+                    where count is the number of callsites to list (default 20).\n",
+        extension, extension);
 }
\ No newline at end of file